@@ -8,6 +8,9 @@
 #include <color_spinor_field_order.h>
 #include <gauge_field.h>
 #include <gauge_field_order.h>
+#include <type_traits>
+#include <new>
+#include <vector>
 
 using namespace quda;
 
@@ -20,8 +23,9 @@ __constant__ char cGammaMap[cSize];    //- constant-memory buffer for mapping Ga
 template <typename Float, QudaFieldOrder fieldOrder>
 using Fermion = colorspinor::FieldOrderCB<Float, N_SPIN_, N_COLOR_, 1, fieldOrder>;
 
-template <typename Float>
-using Gauge = typename gauge_mapper<Float,QUDA_RECONSTRUCT_NO>::type;
+//- Gauge-field accessor, with reconstruct-12/8 only 12/8 reals per link are read and the rest is rebuilt in registers
+template <typename Float, QudaReconstructType recon = QUDA_RECONSTRUCT_NO>
+using Gauge = typename gauge_mapper<Float,recon>::type;
 
 template <typename Float>
 using Vector = ColorSpinor<Float,N_COLOR_,N_SPIN_>;
@@ -175,12 +179,12 @@ struct ConvertIdxArg{
 
 
 
-template <typename Float, QudaFieldOrder order>
+template <typename Float, QudaFieldOrder order, QudaReconstructType recon = QUDA_RECONSTRUCT_NO>
 struct CovDispVecArg : public ArgGeom {
 
   Fermion<Float, order> dst;
   Fermion<Float, order> src;
-  Gauge<Float> U;
+  Gauge<Float, recon> U;
   
   MuGiqBool extendedGauge;
   
@@ -195,4 +199,48 @@ struct CovDispVecArg : public ArgGeom {
 
 
 
+//- Argument Structure for the batched covariant displacements, each link is applied to all nVec vectors.
+//- The field accessors cannot be default-constructed, so they are constructed in place
+template <typename Float, QudaFieldOrder order, QudaReconstructType recon = QUDA_RECONSTRUCT_NO>
+struct CovDispVecBatchArg : public ArgGeom {
+
+  typedef Fermion<Float, order> F;
+  typedef typename std::aligned_storage<sizeof(F), alignof(F)>::type FStorage;
+
+  FStorage dstMem[DISPLACE_BATCH_DEVICE_];
+  FStorage srcMem[DISPLACE_BATCH_DEVICE_];
+  Gauge<Float, recon> U;
+  int nVec;
+
+  MuGiqBool extendedGauge;
+
+  //- Faces of the whole batch, packed for and received from the neighbour in a single message,
+  //- layout: site-inside-face-inside-vector. Set by the caller when the displacement direction is partitioned
+  complex<Float> *ghostSend;
+  complex<Float> *ghostRecv;
+  int faceVolume;
+
+  CovDispVecBatchArg(std::vector<ColorSpinorField*> &dst_, std::vector<ColorSpinorField*> &src_, cudaGaugeField &U_)
+    : ArgGeom(U_),
+      U(U_),
+      nVec(static_cast<int>(src_.size())),
+      extendedGauge((U_.GhostExchange() == QUDA_GHOST_EXCHANGE_EXTENDED) ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE),
+      ghostSend(nullptr), ghostRecv(nullptr), faceVolume(0)
+  {
+    if(nVec > DISPLACE_BATCH_DEVICE_ || dst_.size() != src_.size())
+      errorQuda("%s: Got %zu/%zu vectors, batches of up to %d vectors are supported\n", __func__,
+		src_.size(), dst_.size(), DISPLACE_BATCH_DEVICE_);
+    for(int i=0;i<nVec;i++){
+      new (&dstMem[i]) F(*dst_[i]);
+      new (&srcMem[i]) F(*src_[i]);
+    }
+  }
+
+  __device__ __host__ inline F& dst(int i){ return *reinterpret_cast<F*>(&dstMem[i]); }
+  __device__ __host__ inline F& src(int i){ return *reinterpret_cast<F*>(&srcMem[i]); }
+
+  ~CovDispVecBatchArg() {}
+};
+
+
 #endif // _CONTRACT_UTIL_CUH
@@ -0,0 +1,93 @@
+#ifndef _DIRAC_HOST_H
+#define _DIRAC_HOST_H
+
+/**
+ * @file dirac_host.h
+ * @brief Host (CPU, OpenMP + MPI) Wilson-clover Dirac operator, the host counterpart of QUDA's DiracM/DiracMdagM
+ *
+ * M = A - kappa * sum_mu [ (1 - gamma_mu) U_mu(x) psi(x+mu) + (1 + gamma_mu) U_mu^dag(x-mu) psi(x-mu) ]
+ * in the DeGrand-Rossi basis, gamma_5 = diag(1,1,-1,-1), with the conventions of QUDA's Wilson operator. The site term
+ * A is the identity for Wilson fermions, or the clover term (identity included) for Wilson-clover fermions.
+ */
+
+#include <host_operator_mugiq.h>
+#include <displace_host.h>
+
+
+//- Reals per site of the clover term: two 6x6 Hermitian chiral blocks (spins 0,1 and spins 2,3), each stored as its
+//- 6 real diagonal elements followed by the 15 complex elements of its strict lower triangle, row by row.
+//- The index of spin s and color c within a block is 3*(s%2) + c
+#define CLOVER_SITE_LEN_ 72
+
+
+/** Wilson-clover operator on host color-spinor fields. The hopping term is the star stencil of the displacements:
+ *  the eight transported neighbours of a site, for a batch of vectors, are gathered in one visit with the halos of all
+ *  the directions posted together, and are spin-projected and summed into the output right there, without storing
+ *  the displaced vectors. Mdag swaps the spin projectors (gamma_5 M gamma_5), MdagM and MMdag chain the two, and
+ *  with gamma5 the result is multiplied by gamma_5, e.g. the Hermitian gamma_5 M of the deflation
+ */
+template <typename Float>
+class HostWilsonCloverOperator : public HostOperator<Float> {
+
+private:
+
+  const HostGeom &geom;
+  DisplaceHost<Float> disp;        // Links, neighbour table and halo exchange of the hopping term
+
+  Float kappa;
+  std::vector<Float> clover;       // Clover term, CLOVER_SITE_LEN_ reals per site, empty for Wilson fermions
+
+  MuGiqEigOperator opType;
+  MuGiqBool gamma5;
+
+  std::vector<HostColorSpinorField<Float>*> tmp;  // Intermediate vectors of MdagM and MMdag
+
+  class HoppingSink;
+
+public:
+
+  /** @brief Operator with the links gaugePtr and, if cloverPtr is not null, the clover term cloverPtr, both in the
+   *  precision cpuPrec and in even/odd site order
+   */
+  HostWilsonCloverOperator(const HostGeom &geom_, void *gaugePtr[], QudaPrecision cpuPrec, double kappa_,
+			   void *cloverPtr = nullptr, MuGiqEigOperator opType_ = MUGIQ_EIG_OPERATOR_M,
+			   MuGiqBool gamma5_ = MUGIQ_BOOL_FALSE);
+  ~HostWilsonCloverOperator();
+
+  HostWilsonCloverOperator(const HostWilsonCloverOperator &) = delete;
+  HostWilsonCloverOperator& operator=(const HostWilsonCloverOperator &) = delete;
+
+  /** @brief Load the links and the clover term of a new configuration
+   */
+  void loadGauge(void *gaugePtr[], QudaPrecision cpuPrec);
+  void loadClover(void *cloverPtr, QudaPrecision cpuPrec);
+
+  void setOperator(MuGiqEigOperator opType_, MuGiqBool gamma5_ = MUGIQ_BOOL_FALSE);
+  MuGiqEigOperator OpType() const { return opType; }
+  MuGiqBool Gamma5() const { return gamma5; }
+
+  Float Kappa() const { return kappa; }
+  bool HasClover() const { return !clover.empty(); }
+
+  const HostGeom& Geom() const { return geom; }
+
+  /** @brief out[i] = M in[i] (dagger = false) or Mdag in[i] (dagger = true), in batches of the displacement batch size
+   */
+  void applyM(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in,
+	      bool dagger = false);
+
+  /** @brief out[i] = A in[i], with the operator set by setOperator
+   */
+  void apply(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in);
+
+  DisplaceHost<Float>& getDisplace(){ return disp; }
+};
+
+
+/** @brief x = gamma_5 x in the DeGrand-Rossi basis
+ */
+template <typename Float>
+void applyGamma5Host(HostColorSpinorField<Float> &x);
+
+
+#endif // _DIRAC_HOST_H
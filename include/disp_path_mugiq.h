@@ -0,0 +1,183 @@
+#ifndef _DISP_PATH_MUGIQ_H
+#define _DISP_PATH_MUGIQ_H
+
+/**
+ * @file disp_path_mugiq.h
+ * @brief Displacement paths of the non-local loops, compiled into a trie so that hops are shared across entries
+ *
+ * Every requested loop trace is a path of single-site hops, each in one of the DisplaceFlag directions:
+ * the straight entries (+z:1,8) and the general paths (+z+z+x-z, staples) alike.
+ * Paths with a common prefix share the corresponding nodes of the trie, so that each eigenvector walks the
+ * trie once, depth-first, and every hop is performed once. The walk is compiled into a schedule of
+ * hop and contraction operations on a small pool of vector slots, executed by the GPU and host loops alike.
+ * Sibling hops +d and -d from the same node are issued as one pair, so that the host performs them with a single
+ * fused stencil and halo exchange. Symmetric covariant derivatives are leaves of the root, computed in one pass.
+ * Optionally, the one-hop leaves of a node (e.g. +x:1;-x:1;...;-t:1) are served by a single star-stencil operation,
+ * which contracts the transported neighbours without storing them.
+ */
+
+#include <util_mugiq.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+
+/** @brief Parse a displacement string (+x,-x,...,-t) into a DisplaceFlag, DispFlagNone if it cannot be parsed
+ */
+DisplaceFlag parseDisplaceFlag(const std::string &dStr);
+
+/** @brief Displacement string of a DisplaceFlag
+ */
+std::string displaceFlagString(DisplaceFlag flag);
+
+/** @brief Parse a general displacement path, a sequence of hops such as +z+z+x-z or the staple +x+y-x.
+ *  Returns false if the path is empty or cannot be parsed
+ */
+bool parseDispPath(const std::string &pathStr, std::vector<DisplaceFlag> &hops);
+
+/** @brief Parse a direction string (x,y,z,t) into a DisplaceDir, DispDirNone if it cannot be parsed
+ */
+DisplaceDir parseDisplaceDir(const std::string &dStr);
+
+inline DisplaceDir displaceFlagDir(DisplaceFlag flag){
+  return static_cast<DisplaceDir>(static_cast<int>(flag) / 2);
+}
+
+inline DisplaceSign displaceFlagSign(DisplaceFlag flag){
+  return (static_cast<int>(flag) % 2 == 0) ? DispSignPlus : DispSignMinus;
+}
+
+inline DisplaceFlag displaceFlag(DisplaceDir dir, DisplaceSign sign){
+  return static_cast<DisplaceFlag>(2*static_cast<int>(dir) + (sign == DispSignPlus ? 0 : 1));
+}
+
+inline DisplaceFlag oppositeDisplaceFlag(DisplaceFlag flag){
+  return static_cast<DisplaceFlag>(static_cast<int>(flag) ^ 1);
+}
+
+
+//- Node of the displacement-path trie
+struct DispPathNode {
+
+  DisplaceFlag hop;              // hop from the parent node, the + direction of a derivative node
+  int parent;                    // parent node, -1 for the root
+  int depth;                     // number of hops from the root
+  bool deriv;                    // symmetric covariant derivative along hop instead of a hop, has no children
+  std::vector<int> child;        // child nodes, in insertion order
+  std::vector<int> loopIdx;      // loop traces requested at this node
+
+  DispPathNode(DisplaceFlag hop_, int parent_, int depth_, bool deriv_=false) :
+    hop(hop_), parent(parent_), depth(depth_), deriv(deriv_) {}
+};
+
+
+//- One operation of the compiled trie walk
+//- DISP_PATH_OP_HOP: slot[dst] = hop(slot[src]), DISP_PATH_OP_CONTRACT: eigenvector with slot[src] into the traces of node
+//- DISP_PATH_OP_HOP_PAIR: slot[dst] = hop(slot[src]) and slot[dst2] = -hop(slot[src]), with hop in the + direction
+//- DISP_PATH_OP_DERIV: slot[dst] = (hop(slot[src]) - (-hop)(slot[src]))/2
+//- DISP_PATH_OP_STAR: eigenvector with hop(slot[src]) into the traces of each of the StarLeaves(node)
+struct DispPathOp {
+
+  DispPathOpType type;
+  DisplaceFlag hop;   // hop, all but DISP_PATH_OP_CONTRACT
+  int src;            // source slot, slot 0 is the un-displaced eigenvector
+  int dst;            // destination slot, all but DISP_PATH_OP_CONTRACT
+  int node;           // trie node
+  int dst2;           // destination slot of the -hop, DISP_PATH_OP_HOP_PAIR only
+  int node2;          // trie node of the -hop, DISP_PATH_OP_HOP_PAIR only
+};
+
+
+class DispPathTrie {
+
+private:
+
+  std::vector<DispPathNode> node;  // node[0] is the root (no displacement)
+  std::vector<DispPathOp> sched;   // compiled depth-first walk
+  int nSlot;                       // number of vector slots used by the walk, including slot 0
+
+  long long nHopNaive;             // hops per eigenvector when every entry is displaced from scratch
+
+  int nLoop;                       // number of loop traces
+
+  bool compiled;                   // whether sched is up to date with the trie
+  bool fusePairs;                  // whether sibling +d/-d hops are issued as DISP_PATH_OP_HOP_PAIR
+  bool useStar;                    // whether the one-hop leaves of a node are issued as DISP_PATH_OP_STAR
+
+  int childNode(int n, DisplaceFlag hop);  // child of node n along hop, added if not present
+  void addLoop(int n, int iLoop);
+  void compile();
+
+  //- The children of node n in walk order, the +d/-d siblings paired as (+d child, -d child), (child, -1) otherwise
+  std::vector<std::pair<int,int>> childSteps(int n) const;
+
+public:
+
+  DispPathTrie();
+
+  /** @brief Add a path of hops, whose loop trace is stored at index iLoop
+   */
+  void addPath(const std::vector<DisplaceFlag> &hops, int iLoop);
+
+  /** @brief Add a straight entry, e.g. +z:start,stop, whose loop traces are stored at loopOffset + (length - start).
+   *  This is the current displacement-entry schedule, which performs stop hops per eigenvector
+   */
+  void addStraightEntry(DisplaceFlag flag, int start, int stop, int loopOffset);
+
+  /** @brief Add the symmetric covariant derivative along dir of the eigenvector, whose loop trace is stored at iLoop
+   */
+  void addDerivative(DisplaceDir dir, int iLoop);
+
+  /** @brief Build the trie of the ultra-local trace (loop index 0), of the straight displacement entries,
+   *  of the general paths, whose loop traces are stored at pathOffset, pathOffset+1,...
+   *  and of the symmetric derivatives (x,y,z,t), whose loop traces are stored at derivOffset, derivOffset+1,...
+   */
+  static DispPathTrie fromEntries(const std::vector<std::string> &dispString,
+				  const std::vector<int> &dispStart, const std::vector<int> &dispStop,
+				  const std::vector<int> &nLoopOffset,
+				  const std::vector<std::string> &dispPath = std::vector<std::string>(), int pathOffset = 0,
+				  const std::vector<std::string> &dispDeriv = std::vector<std::string>(), int derivOffset = 0);
+
+  /** @brief Whether sibling +d/-d hops are issued as a single DISP_PATH_OP_HOP_PAIR (default), at the cost of
+   *  holding one more slot while the subtree of the +d hop is walked. The pairs are fused on the host only, the device
+   *  loop turns them off
+   */
+  void setFusePairs(bool fuse){ if(fuse != fusePairs) compiled = false; fusePairs = fuse; }
+
+  /** @brief Whether the one-hop leaves of a node, when there are at least two of them, are issued as a single
+   *  DISP_PATH_OP_STAR instead of one hop and one contraction each (default false, host loop only)
+   */
+  void setStar(bool star){ if(star != useStar) compiled = false; useStar = star; }
+
+  /** @brief The leaf children of node n served by its DISP_PATH_OP_STAR, empty if there is none
+   */
+  std::vector<int> StarLeaves(int n) const;
+
+  const std::vector<DispPathNode>& Nodes() const { return node; }
+
+  /** @brief The depth-first walk: the operations, in order, for one (batch of) eigenvector(s)
+   */
+  const std::vector<DispPathOp>& Schedule();
+
+  /** @brief Number of vector slots used by the walk, including the un-displaced eigenvector in slot 0
+   */
+  int NSlot();
+
+  /** @brief Single-direction hops per eigenvector, a derivative counts as two
+   */
+  int NHop() const;
+  long long NHopNaive() const { return nHopNaive; }
+
+  /** @brief Number of +d/-d hop pairs issued with a single fused stencil
+   */
+  int NPair() const;
+  int MaxDepth() const;
+  int NLoop() const { return nLoop; }
+
+  /** @brief Report of the hops per eigenvector of the trie walk against the per-entry schedule
+   */
+  void printReport(const char *label) const;
+};
+
+
+#endif // _DISP_PATH_MUGIQ_H
@@ -6,10 +6,93 @@
 #include <eigsolve_mugiq.h>
 #include <util_mugiq.h>
 #include <gauge_field.h>
+#include <displace_host.h>
+#include <disp_path_mugiq.h>
 
 using namespace quda;
 
 
+//- Stream, events and device argument buffer of the displacement kernels. They are created once with the
+//- displacement object and reused by every call, so that no call allocates or synchronizes the device on setup
+struct DisplaceStream {
+
+  cudaStream_t stream;     // non-blocking stream of the interior/boundary kernels
+  cudaEvent_t evInput;     // recorded on the default stream, orders the kernels after the producers of the input
+  cudaEvent_t evStart;     // interior kernel start
+  cudaEvent_t evInterior;  // interior kernel end
+  cudaEvent_t evBndStart;  // boundary kernel start
+  cudaEvent_t evBoundary;  // boundary kernel end
+  cudaEvent_t evPacked;    // the packed faces of a batch have reached the host
+  void *arg_d;             // device copy of the kernel argument structure
+  size_t argBytes;         // size of arg_d
+
+  //- Packed faces of a batch of vectors, sent and received in one message per displacement
+  void *ghostSend_d, *ghostRecv_d;
+  void *ghostSend_h, *ghostRecv_h; // pinned
+  size_t ghostBytes;               // size of each of the four buffers
+
+  DisplaceStream() : stream(0), arg_d(nullptr), argBytes(0),
+		     ghostSend_d(nullptr), ghostRecv_d(nullptr), ghostSend_h(nullptr), ghostRecv_h(nullptr), ghostBytes(0) {
+    cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+    cudaEventCreateWithFlags(&evInput, cudaEventDisableTiming);
+    cudaEventCreateWithFlags(&evPacked, cudaEventDisableTiming);
+    cudaEventCreate(&evStart);
+    cudaEventCreate(&evInterior);
+    cudaEventCreate(&evBndStart);
+    cudaEventCreate(&evBoundary);
+  }
+
+  ~DisplaceStream(){
+    if(arg_d) cudaFree(arg_d);
+    freeGhostBuffers();
+    cudaEventDestroy(evInput);
+    cudaEventDestroy(evPacked);
+    cudaEventDestroy(evStart);
+    cudaEventDestroy(evInterior);
+    cudaEventDestroy(evBndStart);
+    cudaEventDestroy(evBoundary);
+    cudaStreamDestroy(stream);
+  }
+
+  DisplaceStream(const DisplaceStream&) = delete;
+  DisplaceStream& operator=(const DisplaceStream&) = delete;
+
+  /** @brief Device argument buffer of at least bytes, grown (and only then re-allocated) when needed
+   */
+  void* argBuffer(size_t bytes){
+    if(bytes > argBytes){
+      if(arg_d) cudaFree(arg_d);
+      cudaMalloc(&arg_d, bytes);
+      checkCudaError();
+      argBytes = bytes;
+    }
+    return arg_d;
+  }
+
+  /** @brief Face buffers of at least bytes each, grown (and only then re-allocated) when needed
+   */
+  void ghostBuffers(size_t bytes){
+    if(bytes <= ghostBytes) return;
+    freeGhostBuffers();
+    cudaMalloc(&ghostSend_d, bytes);
+    cudaMalloc(&ghostRecv_d, bytes);
+    cudaMallocHost(&ghostSend_h, bytes);
+    cudaMallocHost(&ghostRecv_h, bytes);
+    checkCudaError();
+    ghostBytes = bytes;
+  }
+
+  void freeGhostBuffers(){
+    if(ghostSend_d) cudaFree(ghostSend_d);
+    if(ghostRecv_d) cudaFree(ghostRecv_d);
+    if(ghostSend_h) cudaFreeHost(ghostSend_h);
+    if(ghostRecv_h) cudaFreeHost(ghostRecv_h);
+    ghostSend_d = ghostRecv_d = ghostSend_h = ghostRecv_h = nullptr;
+    ghostBytes = 0;
+  }
+};
+
+
 template <typename F, QudaFieldOrder order>
 class Displace {
 
@@ -18,7 +101,6 @@ private:
   template <typename Float, QudaFieldOrder fieldOrder>
   friend class Loop_Mugiq;
   
-  const std::vector<std::string> DisplaceFlagArray {"+x","-x","+y","-y","+z","-z","+t","-t"} ;
   const char *DisplaceTypeArray[N_DISPLACE_TYPES] = {"Covariant"};
   
   const char *DisplaceDirArray[N_DIM_]  = {"x", "y", "z", "t"};
@@ -38,21 +120,34 @@ private:
   //- The extended gauge field that will be used for covariant derivative (displacement) of color-spinor fields
   cudaGaugeField *gaugeField; 
 
-  //- Auxilliary color-spinor-field used for displacements
+  //- Auxilliary color-spinor-field used for displacements, the spare buffer of the in-place displacements
   ColorSpinorField *auxDispVec;
 
+  //- Auxilliary color-spinor-fields used for the batched displacements, created on first use
+  std::vector<ColorSpinorField*> auxDispVecBatch;
+
   //- This prevents redundant halo exchange (as set in QUDA)
   static const MuGiqBool redundantComms = MUGIQ_BOOL_FALSE;
 
   //- Range/Size of extended Halos
   int exRng[N_DIM_];
+
+  //- Stream, events and argument buffer of the displacement kernels, so that they overlap with the halo exchange
+  DisplaceStream dispStream;
+
+  //- Per-stage timing of the displacements
+  DisplaceProfile profile;
+
+  //- Whether the displacements with compressed links have been checked against the uncompressed ones
+  MuGiqBool reconChecked;
   
   
   /** @brief Create a new Gauge Field (it's different from the one used for the MG environment!)
    */
   cudaGaugeField *createCudaGaugeField();
   
-  /** @brief Create a new Gauge Field with Extended Halos (taking corners into account)
+  /** @brief Create a new Gauge Field with Extended Halos (taking corners into account).
+   *  With recon = QUDA_RECONSTRUCT_12/8 the links are stored compressed, in the native order of the accessor
    */
   void createExtendedCudaGaugeField(bool copyGauge=true,
 				    bool redundant_comms=redundantComms ? true : false,
@@ -80,13 +175,42 @@ private:
   void resetAuxDispVec(ColorSpinorField *fineEvec);
 
   
-  /** @brief Perform the displacement
+  /** @brief Perform one displacement step in place. The hop is written into the spare buffer auxDispVec and the handles
+   *  are rotated, i.e. on return displacedEvec points to the displaced vector and auxDispVec to the former input.
+   *  Both buffers are created with ColorSpinorField::Create, the caller owns whichever of them it holds
+   */
+  void doVectorDisplacement(DisplaceType dispType, ColorSpinorField *&displacedEvec, int idisp);
+
+  /** @brief Perform one displacement step in place on a batch of up to BatchSize() vectors, each link is loaded once
+   *  for all of them. The handles of displacedEvec are rotated with those of auxDispVecBatch
+   */
+  void doVectorDisplacement(DisplaceType dispType, std::vector<ColorSpinorField*> &displacedEvec, int idisp);
+
+  /** @brief Perform one hop of a batch of up to BatchSize() vectors into the vectors of dst, dst[i] = U(x)*src[i](x+hop).
+   *  This is the step of the displacement-path trie walk, src is left untouched
+   */
+  void doVectorDisplacement(DisplaceType dispType, std::vector<ColorSpinorField*> &dst,
+			    std::vector<ColorSpinorField*> &src, DisplaceFlag hop);
+
+  /** @brief Symmetric covariant derivative of a batch of up to BatchSize() vectors into the vectors of dst,
+   *  dst[i] = (U_d(x)*src[i](x+d) - U_d^\dag(x-d)*src[i](x-d))/2, src is left untouched
+   */
+  void doVectorDerivative(DisplaceType dispType, std::vector<ColorSpinorField*> &dst,
+			  std::vector<ColorSpinorField*> &src, DisplaceDir dir);
+
+  /** @brief Number of vectors displaced together by the batched displacements
+   */
+  int BatchSize() const { return DISPLACE_BATCH_DEVICE_; }
+
+  /** @brief Make sure the spare buffer aux can take the place of v, i.e. it is (re-)created with the parameters of v
    */
-  void doVectorDisplacement(DisplaceType dispType, ColorSpinorField *displacedEvec, int idisp);
+  void matchAuxDispVec(ColorSpinorField *&aux, const ColorSpinorField &v);
 
-  /** @brief Swap the auxilliary displaced vector with the output displaced vector
+  /** @brief With compressed links, compare the displacements of src in all directions against those with an
+   *  uncompressed copy of the gauge field, once. The relative deviation is reported. Runs only with QUDA_DEBUG_VERBOSE,
+   *  as it allocates an uncompressed extended gauge field
    */
-  void swapAuxDispVec(ColorSpinorField *displacedEvec);
+  void checkLinkReconstruction(ColorSpinorField *src);
 
   
 
@@ -96,6 +220,10 @@ public:
   Displace(MugiqLoopParam *loopParams_, ColorSpinorField *csf, QudaPrecision coarsePrec_);
   ~Displace();
 
+  /** @brief Copy the links of a new (QDP-ordered host) gauge field into the existing extended gauge field
+   */
+  void loadGauge(void *gauge_[]);
+
 
 };
 
@@ -105,9 +233,20 @@ public:
 
 
 /** @brief Perform a covariant displacement of the form dst(x) = U_d(x)*src(x+d) - src(x)
+ *  The interior sites are computed on ds.stream while the halos of src are exchanged, the boundary sites afterwards.
+ *  The kernels wait for the work queued on the default stream when the call is made, i.e. for the producers of src
  */
 template <typename Float, QudaFieldOrder order>
 void performCovariantDisplacementVector(ColorSpinorField *dst, ColorSpinorField *src, cudaGaugeField *gauge,
-					DisplaceDir dispDir, DisplaceSign dispSign);
+					DisplaceDir dispDir, DisplaceSign dispSign,
+					DisplaceStream &ds, DisplaceProfile *profile=nullptr);
+
+/** @brief Batched version of performCovariantDisplacementVector, dst[i] = U_d(x)*src[i](x+d) for up to
+ *  DISPLACE_BATCH_DEVICE_ vectors, with one kernel launch per stage for the whole batch
+ */
+template <typename Float, QudaFieldOrder order>
+void performCovariantDisplacementVectorBatch(std::vector<ColorSpinorField*> &dst, std::vector<ColorSpinorField*> &src,
+					     cudaGaugeField *gauge, DisplaceDir dispDir, DisplaceSign dispSign,
+					     DisplaceStream &ds, DisplaceProfile *profile=nullptr);
 
 #endif // _DISPLACE_H
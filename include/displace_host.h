@@ -0,0 +1,249 @@
+#ifndef _DISPLACE_HOST_H
+#define _DISPLACE_HOST_H
+
+/**
+ * @file displace_host.h
+ * @brief Host (CPU, OpenMP + MPI) implementation of the covariant displacements
+ */
+
+#include <host_field_mugiq.h>
+
+
+//- Per-stage timing (in seconds) of the displacements, accumulated over calls
+struct DisplaceProfile {
+
+  double pack;      // pack faces and post the non-blocking halo messages
+  double interior;  // interior stencil, overlaps with the halo messages in flight
+  double wait;      // wait for the halos after the interior pass, i.e. exposed communication
+  double boundary;  // boundary stencil, after the halos have arrived
+  double total;     // total time of the displacements
+  long long nCall;  // number of displacements
+
+  DisplaceProfile() : pack(0), interior(0), wait(0), boundary(0), total(0), nCall(0) {}
+
+  void reset(){ pack = interior = wait = boundary = total = 0; nCall = 0; }
+
+  void print(const char *label) const {
+    printfQuda("%s: Displacement profile over %lld calls (sec):\n", label, nCall);
+    printfQuda("  pack/post = %e , interior = %e , wait = %e , boundary = %e , total = %e\n",
+	       pack, interior, wait, boundary, total);
+  }
+};
+
+
+/** @brief Perform a covariant displacement of the form dst(x) = U_d(x)*src(x+d) (dispSign = +)
+ *         or dst(x) = U_d^\dag(x-d)*src(x-d) (dispSign = -) on host fields.
+ *  The halo messages are posted first; the interior sites, which do not need any ghosts, are computed
+ *  while the messages are in flight, and the boundary sites after they have arrived.
+ *  With overlapComms = false the halos are waited for before the interior pass (reference, no overlap).
+ */
+template <typename Float>
+void performCovariantDisplacementVectorHost(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+					    const HostGaugeField<Float> &gauge, HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile = nullptr,
+					    MuGiqBool overlapComms = MUGIQ_BOOL_TRUE);
+
+
+/** Neighbour table of the host displacements, built once per geometry.
+ *  For each DispFlag direction f = 2*dir + (dispSign == - ? 1 : 0), nbr[f][idx] is the even/odd index of the
+ *  neighbouring site of idx, or -(faceIndex+1) if the neighbour lies in the ghost zone.
+ *  For dispSign = - the link U_d(x-d) is stored on the same neighbouring site (or on the ghost links).
+ */
+struct HostNbrTable {
+
+  const HostGeom &geom;
+
+  std::vector<int> nbr[N_DISPLACE_FLAGS];       // neighbouring site of each site
+  std::vector<int> interior[N_DISPLACE_FLAGS];  // sites whose neighbour is local
+  std::vector<int> boundary[N_DISPLACE_FLAGS];  // sites whose neighbour is in the ghost zone, by faceIndex
+
+  std::vector<int> interiorSym[N_DIM_];  // sites whose +d and -d neighbours are both local
+  std::vector<int> boundarySym[N_DIM_];  // sites with a +d or a -d neighbour in the ghost zone
+
+  std::vector<int> interiorAll;          // sites whose neighbours in all directions are local
+  std::vector<int> boundaryAll;          // sites with a neighbour in the ghost zone in some direction
+
+  explicit HostNbrTable(const HostGeom &geom_);
+
+  static int flagIndex(DisplaceDir dispDir, DisplaceSign dispSign){
+    return 2*static_cast<int>(dispDir) + (dispSign == DispSignPlus ? 0 : 1);
+  }
+};
+
+
+/** @brief Same as above, with the neighbours taken from a precomputed table instead of the site coordinates.
+ *  The results are bit-identical to those of the coordinate-based version.
+ */
+template <typename Float>
+void performCovariantDisplacementVectorHost(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile = nullptr,
+					    MuGiqBool overlapComms = MUGIQ_BOOL_TRUE);
+
+
+/** @brief Batched displacement of the vectors src[i] into dst[i]: each link is loaded once and applied to all
+ *  the vectors, and the halos of all the vectors travel in a single message per direction.
+ *  The results are bit-identical to those of the single-vector versions.
+ */
+template <typename Float>
+void performCovariantDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &dst,
+					    std::vector<HostColorSpinorField<Float>*> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile = nullptr,
+					    MuGiqBool overlapComms = MUGIQ_BOOL_TRUE);
+
+
+/** @brief Fused displacement of the vectors src[i] by +d and -d, dstPlus[i](x) = U_d(x)*src[i](x+d) and
+ *  dstMinus[i](x) = U_d^\dag(x-d)*src[i](x-d). Both halo messages are posted together and waited for once, and each
+ *  site is visited once for both directions, loading its two links once for all the vectors.
+ *  With symType = DISPLACE_SYM_DERIV, dstPlus[i] receives the symmetric covariant derivative
+ *  (U_d(x)*src[i](x+d) - U_d^\dag(x-d)*src[i](x-d))/2 instead, and dstMinus is not used.
+ *  The results are bit-identical to those of two separate displacements.
+ */
+template <typename Float>
+void performSymmetricDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &dstPlus,
+					    std::vector<HostColorSpinorField<Float>*> &dstMinus,
+					    std::vector<HostColorSpinorField<Float>*> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSymType symType,
+					    DisplaceProfile *profile = nullptr,
+					    MuGiqBool overlapComms = MUGIQ_BOOL_TRUE);
+
+
+/** Consumer of the star stencil. site() is called once per site, concurrently for different sites, with the
+ *  transported neighbours w[(iFlag*nVec + iv)*SPINOR_SITE_LEN_ + SPINOR_SITE_IDX(s,c)] = hop_iFlag(src[iv])(idx)
+ */
+template <typename Float>
+struct HostStarSink {
+  virtual ~HostStarSink() {}
+  virtual void site(int idx, const std::complex<Float> *w) = 0;
+};
+
+
+/** @brief Star stencil: the one-hop displacements of the vectors src[i] along all the given flags, handed to sink
+ *  site by site instead of being stored. The halo messages of all the flags are posted together and waited for once,
+ *  and each site gathers its whole neighbourhood in one visit. The neighbours are bit-identical to those of the
+ *  separate displacements
+ */
+template <typename Float>
+void performStarDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &src, const std::vector<DisplaceFlag> &flags,
+				       HostStarSink<Float> &sink,
+				       const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+				       HostHaloExchange<Float> &halo,
+				       DisplaceProfile *profile = nullptr,
+				       MuGiqBool overlapComms = MUGIQ_BOOL_TRUE);
+
+
+//- Host counterpart of the Displace class, holds the host gauge field used for the displacements
+template <typename Float>
+class DisplaceHost {
+
+private:
+
+  const HostGeom &geom;
+
+  HostGaugeField<Float> *gauge;   // Gauge field used for the displacements
+  HostNbrTable nbrTable;          // Neighbours of the sites in each displacement direction
+  HostHaloExchange<Float> halo;   // Halo exchange of the displaced vectors
+
+  DisplaceProfile profile;        // Per-stage timing
+
+  MuGiqBool overlapComms;         // Whether to overlap the halo exchange with the interior stencil
+  MuGiqBool useNbrTable;          // Whether to use the neighbour table, or compute the neighbours from the coordinates
+  int batchSize;                  // Number of vectors displaced together by the batched displacements
+
+  //- Straight Wilson line W_l(x) = U_d(x)U_d(x+d)...U_d(x+(l-1)d), or the product of the U_d^\dag(x-kd) for dispSign = -,
+  //- stored as one row-major 3x3 matrix per site, GAUGE_SITE_IDX(c1,c2)
+  struct WilsonLine {
+    DisplaceFlag flag;
+    int length;
+    std::vector<std::complex<Float>> W;
+  };
+  std::vector<WilsonLine> wLine;
+
+  int findWilsonLine(DisplaceFlag flag, int length) const;
+
+public:
+
+  /** @brief Create the host gauge field, stored with the link reconstruction recon (18, 12 or 8 reals per link)
+   */
+  DisplaceHost(const HostGeom &geom_, void *gaugePtr[], QudaPrecision cpuPrec,
+	       MuGiqBool overlapComms_ = MUGIQ_BOOL_TRUE, QudaReconstructType recon = QUDA_RECONSTRUCT_NO);
+  ~DisplaceHost();
+
+  /** @brief Load the links of a new gauge configuration into the existing gauge field
+   */
+  void loadGauge(void *gaugePtr[], QudaPrecision cpuPrec);
+
+  /** @brief Perform one displacement step dst = U_d src(x+d) / U_d^\dag src(x-d)
+   */
+  void doVectorDisplacement(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+			    DisplaceDir dispDir, DisplaceSign dispSign);
+
+  /** @brief Displace a block of vectors, in batches of BatchSize() vectors
+   */
+  void doVectorDisplacement(std::vector<HostColorSpinorField<Float>*> &dst, std::vector<HostColorSpinorField<Float>*> &src,
+			    DisplaceDir dispDir, DisplaceSign dispSign);
+
+  /** @brief Displace a block of vectors in place by one hop: the hop is written into spare and the handles of vec and
+   *  spare are rotated, so that successive hops only move the data of the stencil itself (no zeroing, no copies)
+   */
+  void doVectorHop(std::vector<HostColorSpinorField<Float>*> &vec, std::vector<HostColorSpinorField<Float>*> &spare,
+		   DisplaceDir dispDir, DisplaceSign dispSign);
+
+  /** @brief Displace a block of vectors by +d and -d with the fused stencil, in batches of BatchSize() vectors.
+   *  With symType = DISPLACE_SYM_DERIV dstPlus receives the symmetric covariant derivative and dstMinus is not used
+   */
+  void doSymmetricDisplacement(std::vector<HostColorSpinorField<Float>*> &dstPlus,
+			       std::vector<HostColorSpinorField<Float>*> &dstMinus,
+			       std::vector<HostColorSpinorField<Float>*> &src,
+			       DisplaceDir dispDir, DisplaceSymType symType = DISPLACE_SYM_PAIR);
+
+  /** @brief Star stencil of a batch of vectors along the given flags into sink
+   */
+  void doStarDisplacement(std::vector<HostColorSpinorField<Float>*> &src, const std::vector<DisplaceFlag> &flags,
+			  HostStarSink<Float> &sink);
+
+  /** @brief Request the straight Wilson line of the given direction and length, computed with computeWilsonLines
+   *  and whenever a gauge field is loaded. Returns false if the line is too long for the depth-length halo exchange,
+   *  i.e. longer than the local extent of a partitioned dimension
+   */
+  bool addWilsonLine(DisplaceFlag flag, int length);
+
+  /** @brief Bytes of a table of nLine Wilson lines on the geometry geom_
+   */
+  static size_t wilsonLineBytes(const HostGeom &geom_, long long nLine){
+    return static_cast<size_t>(nLine) * geom_.volume * GAUGE_SITE_LEN_ * sizeof(std::complex<Float>);
+  }
+  size_t WilsonLineBytes() const { return wilsonLineBytes(geom, wLine.size()); }
+
+  /** @brief Compute the requested Wilson lines from the current gauge field, one hop at a time
+   */
+  void computeWilsonLines();
+
+  /** @brief Displace a block of vectors by length hops in one step, dst(x) = W_length(x) src(x +/- length*d).
+   *  With exchange = true the ghosts of src are exchanged with depth length, otherwise the ghosts of a previous
+   *  exchange of at least that depth are reused (e.g. for all the lengths of a displacement entry, longest first)
+   */
+  void doWilsonLineDisplacement(std::vector<HostColorSpinorField<Float>*> &dst, std::vector<HostColorSpinorField<Float>*> &src,
+				DisplaceFlag flag, int length, MuGiqBool exchange = MUGIQ_BOOL_TRUE);
+
+  int BatchSize() const { return batchSize; }
+  void setBatchSize(int k){ batchSize = (k > 0) ? k : 1; }
+
+  void setOverlapComms(MuGiqBool overlap){ overlapComms = overlap; }
+  void setUseNbrTable(MuGiqBool use){ useNbrTable = use; }
+
+  const HostGaugeField<Float>& getGauge() const { return *gauge; }
+  HostHaloExchange<Float>& getHalo(){ return halo; }
+  DisplaceProfile& getProfile(){ return profile; }
+};
+
+
+#endif // _DISPLACE_HOST_H
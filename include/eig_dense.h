@@ -0,0 +1,48 @@
+#ifndef _EIG_DENSE_H
+#define _EIG_DENSE_H
+
+/**
+ * @file eig_dense.h
+ * @brief Dense Hermitian eigensolver for operators small enough to be assembled as a matrix
+ *
+ * The matrix is held in column blocks of the local rows of each process, gathered on the root and diagonalized there,
+ * and the local rows of the eigenvectors are scattered back. With MUGIQ_LAPACK the eigenpairs come from LAPACK's
+ * zheevr (MRRR, multi-threaded through the BLAS it is linked with), otherwise from a cyclic Jacobi method.
+ */
+
+#include <util_mugiq.h>
+#include <mpi.h>
+#include <complex>
+#include <vector>
+
+
+/** @brief Whether the eigenpairs of an operator of global dimension dim are computed with the dense solver.
+ *  Without LAPACK the Jacobi sweeps are only affordable for much smaller operators
+ */
+inline bool denseEigSelected(int nEv, double dim, double ratio = DENSE_EIG_RATIO_){
+#ifdef MUGIQ_LAPACK
+  const double maxDim = DENSE_EIG_MAX_DIM_;
+#else
+  const double maxDim = DENSE_EIG_MAX_DIM_JACOBI_;
+#endif
+  return dim <= maxDim && nEv > ratio * dim;
+}
+
+
+/** @brief The nEv eigenpairs in the part spec of the spectrum of the Hermitian matrix A of dimension n, column-major
+ *  and overwritten. The eigenvalues w are sorted as QUDA's eigensolvers sort them (SR/SM ascending, LR/LM descending),
+ *  the eigenvectors are the columns of Z, n x nEv column-major
+ */
+void denseEigHermitian(int n, std::vector<std::complex<double>> &A, MuGiqEigSpectrum spec, int nEv,
+		       std::vector<double> &w, std::vector<std::complex<double>> &Z);
+
+
+/** @brief Distributed front end of denseEigHermitian. Every process holds the localLen rows of the matrix it owns in
+ *  Aloc, localLen x dim column-major, the global row index being rank*localLen + the local one, and gets the same rows
+ *  of the eigenvectors in Zloc, localLen x nEv column-major. The eigenvalues are returned on all the processes
+ */
+void denseEigDistributed(int localLen, std::vector<std::complex<double>> &Aloc, MuGiqEigSpectrum spec, int nEv,
+			 std::vector<double> &w, std::vector<std::complex<double>> &Zloc, MPI_Comm comm);
+
+
+#endif // _EIG_DENSE_H
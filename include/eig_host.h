@@ -0,0 +1,94 @@
+#ifndef _EIG_HOST_H
+#define _EIG_HOST_H
+
+/**
+ * @file eig_host.h
+ * @brief Host (CPU, OpenMP + MPI) eigenpair utilities on host fields
+ */
+
+#include <host_operator_mugiq.h>
+#include <prolong_host.h>
+#include <eig_dense.h>
+
+
+/** @brief Rayleigh quotients lambda[i] = v_i^dag A v_i / ||v_i|| and residuals res[i] = ||A v_i - lambda[i] v_i||
+ *  of the vectors eVecs under op, the host counterpart of Eigsolve_Mugiq::computeEvals (where A = gamma_5 M).
+ *  The vectors are taken in blocks of nBatch: the operator is applied to the whole block, and the quotients, norms and
+ *  residuals of the block come from two fused sweeps and two reductions over the processes
+ */
+template <typename Float>
+void computeEvalsHost(HostOperator<Float> &op, const std::vector<HostColorSpinorField<Float>*> &eVecs,
+		      std::vector<std::complex<double>> &lambda, std::vector<double> &res, int nBatch = EVALS_BATCH_HOST_);
+
+
+/** @brief The eVecs.size() eigenpairs in the part spec of the spectrum of the Hermitian operator op, with the dense
+ *  solver of eig_dense.h. The operator is assembled column by column, applying it to blocks of nBatch unit vectors, and
+ *  the eigenvectors are normalized
+ */
+template <typename Float>
+void eigsolveDenseHost(HostOperator<Float> &op, std::vector<HostColorSpinorField<Float>*> &eVecs, std::vector<double> &evals,
+		       MuGiqEigSpectrum spec, int nBatch = DENSE_EIG_BATCH_HOST_);
+
+
+/** Deflation projection on host fields, the host counterpart of Eigsolve_Mugiq::projectVectors:
+ *    out_j = sum_i evecs_i * dot(evecs_i, op * in_j) / eval_i
+ *  where op is gamma_5 times the fine operator. With a prolongator the eigenvectors live on its coarsest lattice, and
+ *  op * in_j is restricted to it and the result prolongated back. The sources are taken in batches of
+ *  PROJECT_BATCH_HOST_: each batch is restricted together, and projected with one sweep over the eigenvectors for the
+ *  eigenvectors-by-sources inner products, a single reduction over the processes, and one sweep for the multi-axpy.
+ *  Both sweeps go over tiles of sites, with one matrix product per tile (see host_blas_mugiq.h).
+ *  The eigenvectors may be kept in compressed storage (see evec_compress_mugiq.h), each tile of each eigenvector is then
+ *  decoded on the fly in both sweeps, and no uncompressed copy is made
+ */
+template <typename Float>
+class HostProjector {
+
+private:
+
+  HostOperator<Float> &op;
+  HostProlongator<Float> *P;
+  const std::vector<HostColorSpinorField<Float>*> *eVecs;   // Uncompressed eigenvectors, or
+  const std::vector<HostCompressedField<Float>*> *eVecsC;   // compressed eigenvectors
+  std::vector<std::complex<double>> evals;
+
+  int nLevel;  // Levels of the prolongator, 0 for fine eigenvectors
+  int nEv;
+  const HostGeom *gEv;  // Lattice of the eigenvectors
+  int siteLen;          // Complex numbers per site of the eigenvectors
+
+  //- Scratch fields of a batch of sources on each lattice, tmp[lev][j], kept across calls
+  std::vector<std::vector<HostColorSpinorField<Float>*>> tmp;
+
+  std::vector<std::complex<double>> s;  // Inner products of a batch, s[i*nSrc + j]
+
+  void createTmp(int nVec);
+  void checkEvecs();
+
+  /** @brief The rows of the nEv eigenvectors from site x0 on as the columns of E, rows x nEv column-major, decoded if
+   *  the eigenvectors are compressed
+   */
+  inline void loadEvecTile(std::complex<Float> *E, int x0, int rows) const {
+    for(int i=0;i<nEv;i++){
+      std::complex<Float> *e = E + static_cast<size_t>(i)*rows;
+      if(eVecs) std::copy((*eVecs)[i]->Site(x0), (*eVecs)[i]->Site(x0) + rows, e);
+      else
+	for(int r=0;r<rows;r+=siteLen) (*eVecsC)[i]->decodeSite(e + r, x0 + r/siteLen, 0, siteLen);
+    }
+  }
+
+public:
+
+  HostProjector(HostOperator<Float> &op_, HostProlongator<Float> *P_, const std::vector<HostColorSpinorField<Float>*> &eVecs_,
+		const std::vector<std::complex<double>> &evals_);
+  HostProjector(HostOperator<Float> &op_, HostProlongator<Float> *P_, const std::vector<HostCompressedField<Float>*> &eVecs_,
+		const std::vector<std::complex<double>> &evals_);
+  ~HostProjector();
+
+  HostProjector(const HostProjector &) = delete;
+  HostProjector& operator=(const HostProjector &) = delete;
+
+  void projectVectors(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in);
+};
+
+
+#endif // _EIG_HOST_H
@@ -6,6 +6,8 @@
 #include <color_spinor_field.h>  //- From QUDA
 #include <mg_mugiq.h>
 #include <enum_mugiq.h>
+#include <evec_cache_mugiq.h>
+#include <eig_dense.h>
 
 using namespace quda;
 
@@ -22,6 +24,19 @@ struct MugiqEigParam {
   int nEv;    // Number of eigenvectors we want
   int nKr;    // Size of Krylov Space
   double tol; // Tolerance of the eigensolve
+
+  // The dense solver is used when nEv exceeds denseRatio times the dimension of the operator (see eig_dense.h)
+  double denseRatio;
+
+  // Whether the eigenpairs of MdagM and MMdag are computed with the host thick-restart Lanczos (see lanczos_host.h)
+  // instead of QUDA's TRLM, with the same nKr, tol and polynomial acceleration parameters
+  MuGiqBool useHostEigsolver;
+
+  // Host links and clover term of the fine Wilson(-clover) operator, and their precision. The host eigensolver, the
+  // eigenvalues and the projection run on the host Wilson-clover operator built from them (see dirac_host.h)
+  void *hostGauge[N_DIM_];
+  void *hostClover;
+  QudaPrecision hostPrec;
   
   // Polynomial acceleration parameters
   MuGiqBool use_poly_acc;
@@ -30,17 +45,22 @@ struct MugiqEigParam {
   double a_max;
   
   // Eig-params constructor for use with MG eigensolves
-  MugiqEigParam(QudaEigParam *QudaEigParams_) :
+  MugiqEigParam(QudaEigParam *QudaEigParams_, const MugiqEigOptions &eigOptions = MugiqEigOptions()) :
     QudaEigParams(QudaEigParams_),
     diracType(MUGIQ_EIG_OPERATOR_INVALID),
     nEv(QudaEigParams_->nEv),
     nKr(QudaEigParams_->nKr),
     tol(QudaEigParams_->tol),
+    denseRatio(eigOptions.denseRatio < 0 ? DENSE_EIG_RATIO_ : eigOptions.denseRatio),
+    useHostEigsolver(eigOptions.hostEigsolver),
+    hostClover(eigOptions.hostClover),
+    hostPrec(eigOptions.hostPrec),
     use_poly_acc(QudaEigParams->use_poly_acc == QUDA_BOOLEAN_YES ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE),
     poly_acc_deg(0),
     a_min(0),
     a_max(0)
   {
+    for(int d=0;d<N_DIM_;d++) hostGauge[d] = eigOptions.hostGauge[d];
     if(use_poly_acc){
       poly_acc_deg = QudaEigParams->poly_deg;
       a_min = QudaEigParams->a_min;
@@ -51,6 +71,9 @@ struct MugiqEigParam {
 };
 
 
+//- Host operator and host eigenvectors of the eigensolve, see eigsolve_mugiq.cpp
+class HostEigBackend;
+
 	
 class Eigsolve_Mugiq {
 
@@ -76,6 +99,7 @@ private:
   const Dirac *dirac;
   DiracMatrix *mat; // The Dirac operator whose eigenpairs we are computing
   DiracMatrix *matFine; // The Dirac operator whose eigenpairs we are computing
+  DiracMatrix *matDirect; // M of the Dirac operator, for the eigenvalues and their residuals
 
   //- This switch is required so that the dirac object is NOT
   //- deleted when NOT created within Eigsolve.
@@ -93,13 +117,63 @@ private:
   std::vector<double> *eVals_sigma; 
 
   std::vector<ColorSpinorField *> tmpCSF; // Temporary field(s)
+
+  //- Scratch fields of the projection, projTmp[lev][j] for source j of a batch on level lev (0 is the fine level),
+  //- kept across calls
+  std::vector<std::vector<ColorSpinorField *>> projTmp;
   
   std::vector<double> *evals_res;
 
+  //- Host Wilson-clover operator and host copies of the eigenvectors, when the host links are given and the operator
+  //- agrees with the device one. The host eigensolve, eigenvalues and projection then run on it
+  HostEigBackend *hostBackend;
+
   // Whether we are computing eigenpairs of the coarse Dirac operator
   // (significant only when using Multigrid, default true) 
   MuGiqBool computeCoarse; 
 
+  /** @brief Header of the eigenvector cache of this rank for the current eigenvectors
+   */
+  EvecCacheHeader evecCacheHeader(uint64_t gaugeChecksum);
+
+  /** @brief Create the scratch fields of the projection for batches of nVec sources, if not there yet
+   */
+  void createProjectTmp(int nVec);
+  void freeProjectTmp();
+
+  /** @brief Whether the eigenpairs are computed with the dense solver, and for which part of the spectrum
+   */
+  MuGiqBool useDenseEigsolve(MuGiqEigSpectrum &spec);
+
+  /** @brief Compute the eigenpairs by assembling the operator as a dense matrix on the host, one unit vector at a time
+   */
+  void computeEvecsDense(MuGiqEigSpectrum spec);
+
+  /** @brief With useHostEigsolver, create the host backend if the host links are given, the operator is the fine
+   *  Wilson(-clover) one, and the host operator agrees with the device one on a random vector. Otherwise the device
+   *  operator is used throughout
+   */
+  void createHostBackend();
+
+  /** @brief Compare the host operator with the device one on a random vector, the host backend is dropped when they
+   *  disagree, e.g. for other links, clover term or boundary conditions
+   */
+  void checkHostBackend();
+
+  /** @brief Compute eigenvalues and their residuals on the device, in batches of EVALS_BATCH_DEVICE_ eigenvectors, with
+   *  two block reductions per batch
+   */
+  void computeEvalsDevice();
+
+  /** @brief Whether the eigenpairs are computed with the host thick-restart Lanczos
+   */
+  MuGiqBool useHostEigsolve(MuGiqEigSpectrum &spec);
+
+  /** @brief Compute the eigenpairs on the host Wilson-clover operator, with the thick-restart Lanczos or with the dense
+   *  solver, and copy the eigenvectors to the device fields
+   */
+  void computeEvecsHost(MuGiqEigSpectrum spec, MuGiqBool dense);
+
   
 public:
   Eigsolve_Mugiq(MugiqEigParam *eigParams_,
@@ -136,6 +210,17 @@ public:
   */
   void createNewDiracMatrix();
   
+  /** @brief Free the Dirac matrices, they refer to the Dirac operator of the current gauge field. With MG this must be
+   *  done before the hierarchy is updated
+   */
+  void freeOperator();
+
+  /** @brief Rebuild the gauge-dependent objects for the gauge field now loaded in QUDA: the Dirac operator (with MG the
+   *  one of the updated hierarchy), the Dirac matrices, and the links and clover term of the host operator, given by
+   *  hostGauge and hostClover. The eigenvector storage, the scratch fields and the host geometry are kept
+   */
+  void loadGauge(void *hostGauge[], void *hostClover);
+
   /** @brief Perform basic checks based on parameter structure input values
    */
   void makeChecks();
@@ -148,7 +233,7 @@ public:
    */
   void computeEvecs();
 
-  /** @brief Compute eigenvalues
+  /** @brief Compute eigenvalues and their residuals, on the host operator with the host backend, otherwise on the device
    */
   void computeEvals();
   
@@ -156,10 +241,27 @@ public:
    */
   void projectVector(ColorSpinorField &out, ColorSpinorField &in);
 
+  /** @brief Perform the projection for a block of sources, out_j = \sum_i evecs_i * dot(evecs_i*,\gamma_5 * fine_op * in_j) / eval_i.
+   *  The sources are restricted together in batches of PROJECT_BATCH_DEVICE_, and projected with one
+   *  eigenvectors-by-sources inner product and one multi-axpy per batch. With the host backend the projection is
+   *  done on the host operator and eigenvectors (see eig_host.h)
+   */
+  void projectVectors(std::vector<ColorSpinorField *> &out, std::vector<ColorSpinorField *> &in);
+
   /** @brief Compute eigenvalues
    */
   void printEvals();
 
+  /** @brief Save the eigenpairs to the per-rank cache files of base, for the gauge field with checksum gaugeChecksum
+   */
+  void saveEvecs(const std::string &base, uint64_t gaugeChecksum);
+
+  /** @brief Load the eigenpairs from the per-rank cache files of base, if they are present on all ranks and match the
+   *  eigenvectors and the gauge field. The vectors are copied from the mapped files straight into the field storage
+   *  @return Whether the eigenpairs were loaded, otherwise they must be computed
+   */
+  MuGiqBool loadEvecs(const std::string &base, uint64_t gaugeChecksum);
+
   /** @brief Accessor to get approx. right singular vector of the given fine/coarse operator
    */
   std::vector<ColorSpinorField *> &getEvecs(){ return eVecs;}
@@ -173,6 +275,10 @@ public:
    */
   std::vector<double>* getEvalsRes(){ return evals_res;}
 
+  /** @brief Whether the eigenvalues and the projection run on the host Wilson-clover operator
+   */
+  MuGiqBool HostBackend() const { return hostBackend ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE; }
+
   /** @brief Accessor to get the Multigrid environment structure
    */
   MG_Mugiq* getMGEnv(){ return mg_env;}
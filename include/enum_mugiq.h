@@ -41,6 +41,52 @@ extern "C" {
      LOOP_CALC_TYPE_INVALID = MUGIQ_INVALID_ENUM
     } LoopCalcType;
 
+  typedef enum MuGiqGridPlan_s
+    {
+     MUGIQ_GRID_PLAN_NONE,     //- Use the process grid given by the user
+     MUGIQ_GRID_PLAN_REPORT,   //- Report the estimated cost of all process grids, keep the user grid
+     MUGIQ_GRID_PLAN_APPLY,    //- Run on the process grid with the lowest estimated cost
+     MUGIQ_GRID_PLAN_INVALID = MUGIQ_INVALID_ENUM
+    } MuGiqGridPlan;
+
+  typedef enum MuGiqCommStage_s
+    {
+     MUGIQ_STAGE_OTHER = 0,        //- Anything not attributed to one of the stages below
+     MUGIQ_STAGE_SETUP,            //- Communicators, gauge-field halos and other set-up
+     MUGIQ_STAGE_DISPLACE_HALO,    //- Displacements of the eigenvectors (halo exchange and stencil)
+     MUGIQ_STAGE_MOM_REDUCE,       //- Reduction of the momentum-projected loop over the space processes
+     MUGIQ_STAGE_GATHER,           //- Gather over the time processes and broadcast of the momentum-space loop
+     MUGIQ_STAGE_HDF5_IO,          //- HDF5 (collective) I/O
+     MUGIQ_STAGE_N,                //- Number of stages, keep it after the last stage
+     MUGIQ_STAGE_INVALID = MUGIQ_INVALID_ENUM
+    } MuGiqCommStage;
+
+  typedef enum MuGiqEvecCacheMode_s
+    {
+     MUGIQ_EVEC_CACHE_NONE = 0,   //- Always compute the eigenpairs
+     MUGIQ_EVEC_CACHE_SAVE,       //- Compute the eigenpairs and save them to the cache
+     MUGIQ_EVEC_CACHE_LOAD,       //- Load the eigenpairs if a matching cache is present, otherwise compute and save them
+     MUGIQ_EVEC_CACHE_INVALID = MUGIQ_INVALID_ENUM
+    } MuGiqEvecCacheMode;
+
+  typedef enum MuGiqEvecCompression_s
+    {
+     MUGIQ_EVEC_COMPRESS_NONE = 0,   //- Eigenvectors stored in the working precision
+     MUGIQ_EVEC_COMPRESS_HALF,       //- 16-bit fixed point with one scale per site
+     MUGIQ_EVEC_COMPRESS_QUARTER,    //- 8-bit fixed point with one scale per site
+     MUGIQ_EVEC_COMPRESS_BF16,       //- bfloat16
+     MUGIQ_EVEC_COMPRESS_INVALID = MUGIQ_INVALID_ENUM
+    } MuGiqEvecCompression;
+
+  typedef enum MuGiqEigSpectrum_s
+    {
+     MUGIQ_SPECTRUM_SR = 0,   //- Smallest real part
+     MUGIQ_SPECTRUM_LR,       //- Largest real part
+     MUGIQ_SPECTRUM_SM,       //- Smallest magnitude
+     MUGIQ_SPECTRUM_LM,       //- Largest magnitude
+     MUGIQ_SPECTRUM_INVALID = MUGIQ_INVALID_ENUM
+    } MuGiqEigSpectrum;
+
   typedef enum DisplaceType_s
     {
      DISPLACE_TYPE_COVARIANT = 0,      //- Perform a Covariant displacement
@@ -85,6 +131,23 @@ extern "C" {
   } DisplaceSign;  
 
 
+  typedef enum DispPathOpType_s {
+    DISP_PATH_OP_HOP      = 0,   //- Displace a vector slot by one hop into another slot
+    DISP_PATH_OP_CONTRACT = 1,   //- Contract the eigenvector with a (displaced) vector slot
+    DISP_PATH_OP_HOP_PAIR = 2,   //- Displace a vector slot by +d and -d into two slots, with a single fused stencil
+    DISP_PATH_OP_DERIV    = 3,   //- Symmetric covariant derivative of a vector slot into another slot
+    DISP_PATH_OP_STAR     = 4,   //- Displace a vector slot to all the one-hop leaves of a node and contract, in one sweep
+    DISP_PATH_OP_INVALID  = MUGIQ_INVALID_ENUM
+  } DispPathOpType;
+
+
+  typedef enum DisplaceSymType_s {
+    DISPLACE_SYM_PAIR  = 0,   //- dstPlus = U_d(x)src(x+d) and dstMinus = U_d^dag(x-d)src(x-d)
+    DISPLACE_SYM_DERIV = 1,   //- dst = (U_d(x)src(x+d) - U_d^dag(x-d)src(x-d))/2, the symmetric covariant derivative
+    DISPLACE_SYM_INVALID = MUGIQ_INVALID_ENUM
+  } DisplaceSymType;
+
+
   typedef enum MuGiqBoundaryDirection_s
     { MUGIQ_BOUNDARY_BACKWARD = 0,
       MUGIQ_BOUNDARY_FORWARD  = 1,
@@ -0,0 +1,123 @@
+#ifndef _EVEC_CACHE_MUGIQ_H
+#define _EVEC_CACHE_MUGIQ_H
+
+/**
+ * @file evec_cache_mugiq.h
+ * @brief On-disk cache of the eigenpairs, one memory-mapped binary file per rank
+ *
+ * File layout: the header, the eigenvalues (QUDA eigenvalues, eigenvalues, residuals, singular values), and from
+ * dataOffset, a multiple of EVEC_CACHE_ALIGN_, the raw storage of the nEv vectors, vecBytes each.
+ * The vectors are stored as they are laid out in the fields, so they can only be reloaded into fields of the same
+ * lattice, level, precision and field order, which the header records.
+ */
+
+#include <util_mugiq.h>
+#include <enum_quda.h>
+#include <mpi.h>
+#include <stdint.h>
+#include <complex>
+#include <string>
+#include <vector>
+
+
+struct EvecCacheHeader {
+
+  char magic[8];               // EVEC_CACHE_MAGIC_, not null-terminated
+  int32_t version;             // EVEC_CACHE_VERSION_
+  int32_t lL[N_DIM_];          // local lattice dimensions of the vectors
+  int32_t totalL[N_DIM_];      // global lattice dimensions of the vectors
+  int32_t commCoord[N_DIM_];   // coordinates of the rank within the process grid
+  int32_t level;               // MG level of the vectors, 0 for the fine lattice
+  int32_t precision;           // bytes per real number
+  int32_t fieldOrder;          // QudaFieldOrder of the vector storage
+  int32_t nEv;                 // number of eigenpairs
+  int64_t vecBytes;            // bytes of each vector
+  uint64_t gaugeChecksum;      // checksum of the gauge configuration, see gaugeChecksumMugiq
+  int64_t dataOffset;          // byte offset of the first vector
+
+  EvecCacheHeader();
+  EvecCacheHeader(const int lL_[], const int totalL_[], const int commCoord_[], int level_, int precision_,
+		  int fieldOrder_, int nEv_, long long vecBytes_, uint64_t gaugeChecksum_);
+
+  /** @brief Whether a cache with this header can be loaded where expect is needed, otherwise why not
+   */
+  bool matches(const EvecCacheHeader &expect, std::string &why) const;
+};
+
+
+//- The eigenvalues stored along with the vectors
+struct EvecCacheEvals {
+  std::vector<std::complex<double>> evalsQuda;  // eigenvalues of the QUDA eigensolver
+  std::vector<std::complex<double>> evals;      // eigenvalues of gamma_5 times the operator
+  std::vector<double> res;                      // residuals of the eigenvalues
+  std::vector<double> sigma;                    // singular values, zero if not computed
+};
+
+
+/** Memory-mapped eigenvector cache file of one rank.
+ *  The vectors are accessed in place through Vector(): when saving they are written straight into the mapping,
+ *  when loading they are read from it (e.g. copied to device fields, or wrapped by host fields) without a staging buffer.
+ *  Read mappings are private, writes to them never reach the file.
+ */
+class EvecCacheFile {
+
+private:
+
+  std::string fname;
+  int fd;
+  char *map;
+  size_t mapBytes;
+  bool writeMode;
+
+  void unmap();
+
+public:
+
+  /** @brief Create the cache file fname_ for the eigenpairs described by header, which is written to it
+   */
+  EvecCacheFile(const std::string &fname_, const EvecCacheHeader &header);
+
+  /** @brief Map the existing cache file fname_, Valid() is false if it is absent or not a valid cache file
+   */
+  explicit EvecCacheFile(const std::string &fname_);
+
+  EvecCacheFile(const EvecCacheFile &) = delete;
+  EvecCacheFile& operator=(const EvecCacheFile &) = delete;
+
+  ~EvecCacheFile();
+
+  bool Valid() const { return map != nullptr; }
+  const EvecCacheHeader& Header() const { return *reinterpret_cast<const EvecCacheHeader*>(map); }
+
+  void* Vector(int n);
+  const void* Vector(int n) const;
+
+  void setEvals(const EvecCacheEvals &ev);
+  void getEvals(EvecCacheEvals &ev) const;
+
+  /** @brief Flush the mapping of a created file to disk
+   */
+  void sync();
+
+  /** @brief Byte offset of the vectors for nEv eigenpairs
+   */
+  static int64_t DataOffset(int nEv);
+};
+
+
+/** @brief Name of the cache file of rank, base_rankNNNNN.evc
+ */
+std::string evecCacheFileName(const std::string &base, int rank);
+
+/** @brief Checksum of the QDP-ordered host gauge field gauge, with local volume volume and precision prec,
+ *  summed over the ranks of comm. Every link element and its position enter, the result is exact and independent
+ *  of the order of the reduction
+ */
+uint64_t gaugeChecksumMugiq(void *gauge[], QudaPrecision prec, long long volume, MPI_Comm comm);
+
+/** @brief Whether ok holds on all ranks of comm
+ */
+bool evecCacheAllRanks(bool ok, MPI_Comm comm);
+
+
+#endif // _EVEC_CACHE_MUGIQ_H
@@ -0,0 +1,121 @@
+#ifndef _EVEC_COMPRESS_MUGIQ_H
+#define _EVEC_COMPRESS_MUGIQ_H
+
+/**
+ * @file evec_compress_mugiq.h
+ * @brief Compressed host storage of eigenvectors, decoded on the fly
+ *
+ * With MUGIQ_EVEC_COMPRESS_HALF and MUGIQ_EVEC_COMPRESS_QUARTER every real number is stored as a 16-bit or 8-bit
+ * fixed-point number with one scale per site, the largest absolute value of the site, as QUDA's half and quarter
+ * precision fields. With MUGIQ_EVEC_COMPRESS_BF16 every real number is rounded to bfloat16, the upper half of a float.
+ */
+
+#include <host_field_mugiq.h>
+#include <stdint.h>
+#include <cstring>
+#include <cmath>
+
+
+//- Bytes per real number of the compressed storage
+inline int evecCompressBytes(MuGiqEvecCompression comp){
+  switch(comp){
+  case MUGIQ_EVEC_COMPRESS_HALF:    return sizeof(int16_t);
+  case MUGIQ_EVEC_COMPRESS_QUARTER: return sizeof(int8_t);
+  case MUGIQ_EVEC_COMPRESS_BF16:    return sizeof(uint16_t);
+  default: errorQuda("%s: Unsupported eigenvector compression %d\n", __func__, static_cast<int>(comp));
+  }
+  return 0;
+}
+
+inline const char* evecCompressName(MuGiqEvecCompression comp){
+  switch(comp){
+  case MUGIQ_EVEC_COMPRESS_NONE:    return "none";
+  case MUGIQ_EVEC_COMPRESS_HALF:    return "half";
+  case MUGIQ_EVEC_COMPRESS_QUARTER: return "quarter";
+  case MUGIQ_EVEC_COMPRESS_BF16:    return "bf16";
+  default: return "invalid";
+  }
+}
+
+
+/** Host color-spinor field of nSpin x nColor complex numbers per site in compressed storage, same site order as
+ *  HostColorSpinorField. The fields are written with encode, and read either whole with decode or site by site with
+ *  decodeSite, e.g. inside the loops that consume them, so that no uncompressed copy is needed
+ */
+template <typename Float>
+class HostCompressedField {
+
+private:
+
+  const HostGeom &geom;
+
+  int nSpin;
+  int nColor;
+  int siteLen;    // complex numbers per site
+  MuGiqEvecCompression comp;
+
+  std::vector<char> data;    // 2*siteLen compressed real numbers per site
+  std::vector<float> scale;  // scale of each site, fixed-point storage only
+
+  //- Largest integer of the fixed-point storage
+  static constexpr float maxHalf = 32767.0f;
+  static constexpr float maxQuarter = 127.0f;
+
+  static inline Float bf16ToFloat(uint16_t h){
+    const uint32_t u = static_cast<uint32_t>(h) << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return static_cast<Float>(f);
+  }
+
+public:
+
+  HostCompressedField(const HostGeom &geom_, MuGiqEvecCompression comp_, int nSpin_=N_SPIN_, int nColor_=N_COLOR_);
+
+  HostCompressedField(const HostCompressedField &) = delete;
+  HostCompressedField& operator=(const HostCompressedField &) = delete;
+
+  const HostGeom& Geom() const { return geom; }
+  int Nspin() const { return nSpin; }
+  int Ncolor() const { return nColor; }
+  int SiteLength() const { return siteLen; }
+  MuGiqEvecCompression Compression() const { return comp; }
+
+  /** @brief Bytes of the compressed storage, scales included
+   */
+  size_t Bytes() const { return data.size() + scale.size() * sizeof(float); }
+
+  void encode(const HostColorSpinorField<Float> &in);
+  void decode(HostColorSpinorField<Float> &out) const;
+
+  /** @brief Decode the complex numbers [offset, offset+len) of site idx into out
+   */
+  inline void decodeSite(std::complex<Float> *out, int idx, int offset, int len) const {
+    const long long r0 = 2 * (static_cast<long long>(idx) * siteLen + offset);
+    if(comp == MUGIQ_EVEC_COMPRESS_HALF){
+      const int16_t *q = reinterpret_cast<const int16_t*>(data.data()) + r0;
+      const Float s = static_cast<Float>(scale[idx]) / static_cast<Float>(maxHalf);
+      for(int i=0;i<len;i++) out[i] = std::complex<Float>(s * q[2*i], s * q[2*i+1]);
+    }
+    else if(comp == MUGIQ_EVEC_COMPRESS_QUARTER){
+      const int8_t *q = reinterpret_cast<const int8_t*>(data.data()) + r0;
+      const Float s = static_cast<Float>(scale[idx]) / static_cast<Float>(maxQuarter);
+      for(int i=0;i<len;i++) out[i] = std::complex<Float>(s * q[2*i], s * q[2*i+1]);
+    }
+    else{
+      const uint16_t *q = reinterpret_cast<const uint16_t*>(data.data()) + r0;
+      for(int i=0;i<len;i++) out[i] = std::complex<Float>(bf16ToFloat(q[2*i]), bf16ToFloat(q[2*i+1]));
+    }
+  }
+
+  /** @brief Local (not globally reduced) inner product (this, x), decoding this site by site
+   */
+  std::complex<double> cDotLocal(const HostColorSpinorField<Float> &x) const;
+
+  /** @brief y += a * this, decoding this site by site
+   */
+  void caxpy(std::complex<Float> a, HostColorSpinorField<Float> &y) const;
+};
+
+
+#endif // _EVEC_COMPRESS_MUGIQ_H
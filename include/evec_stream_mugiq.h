@@ -0,0 +1,107 @@
+#ifndef _EVEC_STREAM_MUGIQ_H
+#define _EVEC_STREAM_MUGIQ_H
+
+/**
+ * @file evec_stream_mugiq.h
+ * @brief Out-of-core streaming of host eigenvectors from an eigenvector cache file
+ *
+ * Only a ring of a few vectors is resident. A background thread reads the vectors from the file, in order,
+ * into the free slots of the ring while the consumer works on the earlier ones, so the number of eigenvectors
+ * is bound by the disk rather than by the memory.
+ */
+
+#include <host_field_mugiq.h>
+#include <evec_cache_mugiq.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+//- Timing (in seconds) and volume of a stream, accumulated over its passes
+struct EvecStreamProfile {
+
+  double read;      // time the prefetch thread spent reading vectors
+  double wait;      // time the consumer waited for a vector, i.e. exposed I/O
+  double total;     // time from the start to the end of the passes
+  long long bytes;  // bytes read
+
+  EvecStreamProfile() : read(0), wait(0), total(0), bytes(0) {}
+
+  void print(const char *label) const {
+    printfQuda("%s: Streamed %.1f MB in %e sec, %.1f MB/s sustained (read %e sec, exposed wait %e sec)\n", label,
+	       bytes / (1024.0*1024.0), total, total > 0 ? bytes / (1024.0*1024.0) / total : 0.0, read, wait);
+  }
+};
+
+
+/** Stream of the eigenvectors of a cache file written by EvecCacheFile, in space-spin-color order.
+ *  The vectors of a pass are acquired and released strictly in order; acquire blocks until the vector is resident,
+ *  release hands its slot back to the prefetch thread
+ */
+template <typename Float>
+class HostEvecStream {
+
+private:
+
+  const HostGeom &geom;
+  std::string fname;
+  int fd;
+
+  EvecCacheHeader header;
+  EvecCacheEvals evals;
+
+  int ringSize;
+  std::vector<HostColorSpinorField<Float>*> ring;
+
+  //- State of the current pass, [first, end) are the vectors streamed, shared with the prefetch thread under mtx
+  int first, end;
+  int loaded;     // vectors [first, loaded) have been read
+  int released;   // vectors [first, released) have been released by the consumer
+  bool stopFlag;
+  double tStart;
+
+  std::thread prefetch;
+  std::mutex mtx;
+  std::condition_variable cv;
+
+  EvecStreamProfile profile;
+
+  void prefetchLoop();
+  void readVector(int n, HostColorSpinorField<Float> &v);
+
+public:
+
+  /** @brief Stream the cache file fname_, whose header must match expect, through a ring of ringSize_ vectors
+   */
+  HostEvecStream(const HostGeom &geom_, const std::string &fname_, const EvecCacheHeader &expect, int ringSize_);
+  ~HostEvecStream();
+
+  HostEvecStream(const HostEvecStream &) = delete;
+  HostEvecStream& operator=(const HostEvecStream &) = delete;
+
+  int NEv() const { return header.nEv; }
+  int RingSize() const { return ringSize; }
+  const EvecCacheEvals& Evals() const { return evals; }
+
+  /** @brief Start a pass over the vectors [first_, first_+count), the prefetch thread begins filling the ring
+   */
+  void start(int first_, int count);
+
+  /** @brief Wait for the end of the pass, all its vectors must have been released
+   */
+  void finish();
+
+  /** @brief The resident vector n of the current pass, blocks until it has been read
+   */
+  HostColorSpinorField<Float>* acquire(int n);
+
+  /** @brief Release vector n, the oldest acquired one, its slot is refilled by the prefetch thread
+   */
+  void release(int n);
+
+  const EvecStreamProfile& Profile() const { return profile; }
+  void resetProfile() { profile = EvecStreamProfile(); }
+};
+
+
+#endif // _EVEC_STREAM_MUGIQ_H
@@ -0,0 +1,124 @@
+#ifndef _FARM_MUGIQ_H
+#define _FARM_MUGIQ_H
+
+/**
+ * @file farm_mugiq.h
+ * @brief Ensemble task farming: MPI_COMM_WORLD is split into groups of processes, each group runs
+ * the whole MuGiq pipeline on one gauge configuration at a time, taken from a shared work queue
+ */
+
+#include <mpi.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** @brief The communicator MuGiq works on. This is the communicator QUDA was initialized on,
+ * i.e. MPI_COMM_WORLD, or the group communicator when running in farming mode
+ */
+MPI_Comm getCommMugiq();
+
+
+//- Split of MPI_COMM_WORLD into nGroups groups of consecutive world ranks
+struct FarmComm {
+
+  MPI_Comm group = MPI_COMM_NULL; //- Communicator of the group, the QUDA grid is built on it
+  int nGroups = 1;                //- Number of groups
+  int groupId = 0;                //- Group of this process
+  int groupRank = 0;              //- Rank within the group
+  int groupSize = 1;              //- Number of processes per group
+  int worldRank = 0;
+  int worldSize = 1;
+
+  /** @brief Split MPI_COMM_WORLD, collective over MPI_COMM_WORLD
+   * @param[in] nGroups_ Number of groups, it must divide the number of processes
+   */
+  explicit FarmComm(int nGroups_);
+  ~FarmComm();
+
+  FarmComm(const FarmComm &) = delete;
+  FarmComm& operator=(const FarmComm &) = delete;
+};
+
+
+/**
+ * @brief Work queue with dynamic assignment: a task counter lives in an MPI window on world rank 0,
+ * the group leaders take the next task with an atomic fetch-and-add whenever their group is done
+ * with the previous one. Faster groups therefore process more tasks.
+ */
+class FarmQueue {
+
+private:
+
+  const FarmComm &farm;
+
+  long long nTask;        //- Total number of tasks
+  long long *counter;     //- Next free task, only allocated on world rank 0
+  MPI_Win win;
+
+  std::vector<long long> done; //- Tasks processed by this group
+
+public:
+
+  /** @brief Create the queue, collective over MPI_COMM_WORLD
+   */
+  FarmQueue(const FarmComm &farm_, long long nTask_);
+  ~FarmQueue();
+
+  FarmQueue(const FarmQueue &) = delete;
+  FarmQueue& operator=(const FarmQueue &) = delete;
+
+  /** @brief Get the next task of the group, collective over the group communicator
+   * @return Index of the task, or -1 when the queue is empty
+   */
+  long long next();
+
+  /** @brief Tasks processed by this group so far
+   */
+  const std::vector<long long>& tasksDone() const { return done; }
+
+  /** @brief Print which group processed which task, collective over MPI_COMM_WORLD
+   */
+  void report() const;
+};
+
+
+/** @brief Read a list of tasks from a text file, one per line. Empty lines and lines starting with # are skipped
+ */
+std::vector<std::string> readFarmTaskList(const std::string &fname);
+
+
+//- One gauge configuration of the task list, a line of the form <gauge file> [<loop gauge file>]
+struct FarmTask {
+  long long index;            //- Position in the task list
+  std::string gaugeFile;
+  std::string loopGaugeFile;  //- Gauge field of the displacements, the gauge file itself if not given
+  std::string tag;            //- The gauge filename without directory and extension, it tags the output files
+};
+
+/** @brief Output file of a farmed task: the tag is inserted before the extension
+ */
+std::string farmFileName(const std::string &fname, const std::string &tag);
+
+/** @brief Tag of a farmed task: the gauge filename without directory and extension
+ */
+std::string farmTaskTag(const std::string &gaugeFile);
+
+
+/** @brief Initialize MPI, split MPI_COMM_WORLD into nGroups groups and build the QUDA comms grid gridSize
+ * on the communicator of the group. The output of each group is prefixed with its index.
+ * Use it instead of the usual communications initialization, with QUDA built with MPI communications
+ */
+FarmComm* initFarmCommsMuGiq(int nGroups, int *argc, char ***argv, const int gridSize[]);
+
+/** @brief Finalize the QUDA comms grid, free the group communicator and finalize MPI. To be called after endQuda(),
+ * instead of the usual communications finalization, since QUDA uses the group communicator until it is torn down
+ */
+void finalizeFarmCommsMuGiq(FarmComm *farm);
+
+/** @brief Process the tasks of the file taskList: the groups take tasks from a FarmQueue and call run on each one
+ * until the queue is empty, then the assignment of the tasks is reported. Collective over MPI_COMM_WORLD
+ */
+void runFarmMuGiq(const FarmComm &farm, const std::string &taskList, const std::function<void(const FarmTask&)> &run);
+
+
+#endif // _FARM_MUGIQ_H
@@ -0,0 +1,93 @@
+#ifndef _GRID_PLANNER_MUGIQ_H
+#define _GRID_PLANNER_MUGIQ_H
+
+/**
+ * @file grid_planner_mugiq.h
+ * @brief Selection of the process grid from the communication workload of a loop calculation
+ *
+ * The planner depends neither on QUDA nor on MPI/CUDA, so that it can run before the communications
+ * are initialized, and standalone (see tests/grid_planner.cpp).
+ */
+
+#include <enum_mugiq.h>
+#include <string>
+#include <vector>
+
+#define GRID_PLAN_NDIM 4
+
+
+//- Communication workload of a loop calculation, it does not depend on the process grid
+struct GridPlanWorkload {
+
+  int L[GRID_PLAN_NDIM];                // global lattice dimensions
+  int nProcs;                           // total number of processes
+  int nEv;                              // number of eigenvectors, each one is displaced separately
+  int Nmom;                             // number of momenta in the momentum projection
+  int nLoop;                            // number of loop traces (ultra-local plus displaced)
+  long long nHops[GRID_PLAN_NDIM];      // one-hop displacements per eigenvector in each direction
+  int siteBytes;                        // bytes of one color-spinor site
+  int cplxBytes;                        // bytes of one complex number of the loop data
+  MuGiqBool haloAllDims;                // whether every hop exchanges the ghosts of all partitioned dimensions (QUDA exchangeGhost)
+  double alpha;                         // latency per message (sec)
+  double beta;                          // inverse bandwidth (sec/byte)
+
+  GridPlanWorkload();
+
+  /** @brief Add the displacement entries in the form of --displace-entry-string, e.g. +z:1,8;-x:3
+   *  Returns false if the entries could not be parsed
+   */
+  bool addDisplaceEntries(const std::string &entries);
+
+  /** @brief Add the general displacement paths in the form of --displace-path-string, e.g. +z+z+x-z;+x+y-x
+   *  Returns false if the paths could not be parsed
+   */
+  bool addDisplacePaths(const std::string &paths);
+
+  /** @brief Add the symmetric covariant derivatives in the form of --displace-derivative-string, e.g. z;t
+   *  Each one displaces the eigenvector by +d and -d. Returns false if the directions could not be parsed
+   */
+  bool addDisplaceDerivatives(const std::string &derivs);
+
+  /** @brief Set the precision of the eigenvectors and the loop data (sizeof(float) or sizeof(double))
+   */
+  void setPrecision(int realBytes);
+};
+
+
+//- Estimated communication cost of a process grid, per process and for the whole calculation
+struct GridPlanCost {
+
+  int grid[GRID_PLAN_NDIM];   // process grid
+  int lL[GRID_PLAN_NDIM];     // local lattice dimensions
+
+  double haloBytes;           // bytes sent by the displacement halo exchanges
+  long long haloMsgs;         // messages sent by the displacement halo exchanges
+  double reduceBytes;         // bytes of the momentum reduction over the ranks sharing a time coordinate
+  double gatherBytes;         // bytes gathered over the time ranks
+  double bcastBytes;          // bytes of the final broadcast
+
+  double haloTime;            // alpha-beta estimate of the halo exchanges (sec)
+  double momTime;             // alpha-beta estimate of reduction, gather and broadcast (sec)
+  double total;
+};
+
+
+/** @brief Cost of a given process grid. The grid must be compatible with the workload
+ */
+GridPlanCost gridPlanCost(const GridPlanWorkload &w, const int grid[]);
+
+/** @brief Whether grid divides the lattice into even local dimensions and uses exactly w.nProcs processes
+ */
+bool gridPlanValid(const GridPlanWorkload &w, const int grid[]);
+
+/** @brief Costs of all process grids compatible with the workload, cheapest first
+ */
+std::vector<GridPlanCost> planProcessGrid(const GridPlanWorkload &w);
+
+/** @brief Human-readable summary of the nShow cheapest grids, compared with the grid given by the user (may be NULL)
+ */
+std::string gridPlanReport(const GridPlanWorkload &w, const std::vector<GridPlanCost> &plans,
+			   const int userGrid[], int nShow);
+
+
+#endif // _GRID_PLANNER_MUGIQ_H
@@ -0,0 +1,36 @@
+#ifndef _HOST_BLAS_MUGIQ_H
+#define _HOST_BLAS_MUGIQ_H
+
+/**
+ * @file host_blas_mugiq.h
+ * @brief Dense matrix products of the host code path
+ *
+ * Blocks of host fields enter as column-major matrices, one field per column and one row per complex number of a
+ * tile of sites: the inner products of a block with another are then one GEMM per tile, as the device path computes
+ * them with blas::cDotProduct. With MUGIQ_LAPACK the products are the BLAS cgemm/zgemm, otherwise a loop nest
+ * whose inner loop runs over the rows of a column.
+ */
+
+#include <util_mugiq.h>
+#include <complex>
+#include <algorithm>
+
+
+/** @brief C = alpha op(A) B + beta C, column-major, with op(A) = A (m x k) for transA = 'N', or A^dag with A k x m
+ *  for transA = 'C'. B is k x n and C m x n
+ */
+template <typename Float>
+void gemmHost(char transA, int m, int n, int k, std::complex<Float> alpha, const std::complex<Float> *A, int lda,
+	      const std::complex<Float> *B, int ldb, std::complex<Float> beta, std::complex<Float> *C, int ldc);
+
+
+/** @brief Sites per tile when nCol fields of siteLen complex numbers per site share a tile of the matrix products,
+ *  so that the packed tile takes about HOST_GEMM_TILE_BYTES_
+ */
+template <typename Float>
+inline int gemmTileSites(int nCol, int siteLen, int volume){
+  const size_t siteBytes = static_cast<size_t>(nCol) * siteLen * sizeof(std::complex<Float>);
+  return std::max(1, std::min(volume, static_cast<int>(HOST_GEMM_TILE_BYTES_ / siteBytes)));
+}
+
+#endif // _HOST_BLAS_MUGIQ_H
@@ -0,0 +1,349 @@
+#ifndef _HOST_FIELD_MUGIQ_H
+#define _HOST_FIELD_MUGIQ_H
+
+/**
+ * @file host_field_mugiq.h
+ * @brief Host (CPU) lattice fields used by the host implementations of the MuGiq kernels
+ *
+ * Sites follow the QUDA even/odd (checkerboard) ordering, so that host fields can be
+ * compared element-by-element against the corresponding GPU fields.
+ */
+
+#include <util_mugiq.h>
+#include <enum_quda.h>
+#include <mpi.h>
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+
+//- Geometry of the local lattice and of the process grid, used by all host fields
+struct HostGeom {
+
+  int lL[N_DIM_];             // local lattice dimensions (full, not checkerboarded)
+  int commDim[N_DIM_];        // whether a given dimension is partitioned
+  int commCoord[N_DIM_];      // coordinates of this process within the process grid
+  int nbrRank[N_DIM_][2];     // neighbouring ranks, [dim][MUGIQ_BOUNDARY_BACKWARD/FORWARD]
+  MPI_Comm comm;              // the communicator the neighbouring ranks refer to
+
+  int volume;                 // full-site local volume
+  int volumeCB;               // checkerboarded volume
+  int faceVolume[N_DIM_];     // full-site volume of the face perpendicular to each dimension
+
+  HostGeom(const int lL_[], const int commDim_[], const int commCoord_[], const int nbrRank_[][2], MPI_Comm comm_);
+
+  /** @brief Geometry of the local lattice within the current QUDA process grid
+   */
+  explicit HostGeom(const int lL_[]);
+
+  /** @brief Local coordinates of checkerboard site x_cb with parity pty (same as QUDA's getCoords)
+   */
+  inline void getCoords(int x[], int x_cb, int pty) const {
+    int za = x_cb / (lL[0] >> 1);
+    int zb = za / lL[1];
+    x[1] = za - zb * lL[1];
+    x[3] = zb / lL[2];
+    x[2] = zb - x[3] * lL[2];
+    int x1odd = (x[1] + x[2] + x[3] + pty) & 1;
+    x[0] = 2 * x_cb + x1odd - za * lL[0];
+  }
+
+  /** @brief Checkerboard index of local coordinates x (same as QUDA's linkIndex)
+   */
+  inline int cbIndex(const int x[]) const {
+    return (((x[3] * lL[2] + x[2]) * lL[1] + x[1]) * lL[0] + x[0]) >> 1;
+  }
+
+  inline int parity(const int x[]) const { return (x[0] + x[1] + x[2] + x[3]) & 1; }
+
+  /** @brief Even/odd site index, pty*volumeCB + x_cb
+   */
+  inline int siteIndex(const int x[]) const { return parity(x) * volumeCB + cbIndex(x); }
+
+  /** @brief Lexicographic index of x within the face perpendicular to dim
+   */
+  inline int faceIndex(const int x[], int dim) const {
+    int idx = 0;
+    for(int d=N_DIM_-1;d>=0;d--){
+      if(d == dim) continue;
+      idx = idx * lL[d] + x[d];
+    }
+    return idx;
+  }
+
+  /** @brief Inverse of faceIndex, x[dim] is left untouched
+   */
+  inline void faceCoords(int x[], int fIdx, int dim) const {
+    for(int d=0;d<N_DIM_;d++){
+      if(d == dim) continue;
+      x[d] = fIdx % lL[d];
+      fIdx /= lL[d];
+    }
+  }
+
+  /** @brief Whether the neighbour of x in the dispSign direction of dim lies in another process
+   */
+  inline bool isBoundary(const int x[], int dim, DisplaceSign dispSign) const {
+    if(!commDim[dim]) return false;
+    return (dispSign == DispSignPlus) ? (x[dim] == lL[dim]-1) : (x[dim] == 0);
+  }
+
+  void print() const;
+};
+
+
+/** Host color-spinor field of nSpin x nColor complex numbers per site.
+ *  Storage order is spin-color-inside-site, sites in even/odd order: (pty*volumeCB + x_cb)*siteLen + SPINOR_SITE_IDX(s,c)
+ *  Ghost zones hold up to 'depth' slices of the neighbouring processes in each dimension and direction,
+ *  ordered as faceIndex + faceVolume*layer, where layer is the distance from the local boundary minus one.
+ */
+template <typename Float>
+class HostColorSpinorField {
+
+private:
+
+  const HostGeom &geom;
+
+  int nSpin;
+  int nColor;
+  int siteLen;    // complex numbers per site
+
+  std::complex<Float> *v;  // field data
+  MuGiqBool ownData;       // whether v was allocated by the field
+
+  int ghostDepth[N_DIM_][2];
+  std::vector<std::complex<Float>> ghost[N_DIM_][2];
+
+public:
+
+  HostColorSpinorField(const HostGeom &geom_, int nSpin_=N_SPIN_, int nColor_=N_COLOR_);
+
+  /** @brief Wrap existing storage of the right length, the field does not take ownership
+   */
+  HostColorSpinorField(const HostGeom &geom_, int nSpin_, int nColor_, std::complex<Float> *v_);
+
+  HostColorSpinorField(const HostColorSpinorField &) = delete;
+  HostColorSpinorField& operator=(const HostColorSpinorField &) = delete;
+
+  ~HostColorSpinorField();
+
+  const HostGeom& Geom() const { return geom; }
+  int Nspin() const { return nSpin; }
+  int Ncolor() const { return nColor; }
+  int SiteLength() const { return siteLen; }
+  long long Length() const { return static_cast<long long>(geom.volume) * siteLen; }
+  size_t Bytes() const { return Length() * sizeof(std::complex<Float>); }
+
+  std::complex<Float>* V() { return v; }
+  const std::complex<Float>* V() const { return v; }
+
+  std::complex<Float>* Site(int idx) { return v + static_cast<long long>(idx) * siteLen; }
+  const std::complex<Float>* Site(int idx) const { return v + static_cast<long long>(idx) * siteLen; }
+  std::complex<Float>* Site(int x_cb, int pty) { return Site(pty*geom.volumeCB + x_cb); }
+  const std::complex<Float>* Site(int x_cb, int pty) const { return Site(pty*geom.volumeCB + x_cb); }
+
+  /** @brief Make sure that the ghost zone (dim,bnd) can hold depth slices
+   */
+  void allocateGhost(int dim, int bnd, int depth);
+
+  int GhostDepth(int dim, int bnd) const { return ghostDepth[dim][bnd]; }
+  std::complex<Float>* Ghost(int dim, int bnd) { return ghost[dim][bnd].data(); }
+  const std::complex<Float>* GhostSite(int dim, int bnd, int gIdx) const {
+    return ghost[dim][bnd].data() + static_cast<long long>(gIdx) * siteLen;
+  }
+
+  void zero();
+  void copy(const HostColorSpinorField &src);
+
+  /** @brief Local (not globally reduced) squared norm
+   */
+  double norm2Local() const;
+};
+
+
+/** Host gauge field, links are 3x3 row-major complex matrices stored as
+ *  links[dir][(pty*volumeCB + x_cb)*LinkLength() + GAUGE_SITE_IDX(c1,c2)]
+ *  The ghost links are U_dir(x-dir) for the sites on the backward boundary (x[dir] == 0) of partitioned dimensions,
+ *  stored by faceIndex.
+ *  With QUDA_RECONSTRUCT_12 only the first two rows are stored, with QUDA_RECONSTRUCT_8 the phases of U(0,0) and U(2,0)
+ *  followed by U(0,1), U(0,2), U(1,0), as in QUDA. The remaining elements are rebuilt by Link() from the unitarity of
+ *  the links, which must be SU(3) up to a sign on the last slice of each direction (e.g. anti-periodic boundaries in time).
+ */
+template <typename Float>
+class HostGaugeField {
+
+private:
+
+  const HostGeom &geom;
+
+  QudaReconstructType recon;  // Link compression
+  int linkLen;                // Complex numbers stored per link, 9, 6 or 4
+
+  std::vector<std::complex<Float>> links[N_DIM_];
+  std::vector<std::complex<Float>> ghostLinks[N_DIM_];
+
+  Float lastSliceSign[N_DIM_];  // Sign of the links of each direction on the last local slice, compressed links only
+  Float ghostSign[N_DIM_];      // Sign of the ghost links, i.e. of the last slice of the backward neighbour
+
+  void packLink(std::complex<Float> *out, const std::complex<Float> U[]) const;
+
+  //- Rebuild the full link from the stored rows/parameters, for an SU(3) link times sign
+  inline void unpackLink(std::complex<Float> U[], const std::complex<Float> *in, Float sign) const {
+    typedef std::complex<Float> C;
+    if(recon == QUDA_RECONSTRUCT_12){
+      for(int i=0;i<2*N_COLOR_;i++) U[i] = sign * in[i];
+    }
+    else{ //- QUDA_RECONSTRUCT_8
+      const C a01 = in[1], a02 = in[2], b00 = in[3];
+      const Float rowSum = std::norm(a01) + std::norm(a02);
+      const C a00 = std::polar(std::sqrt(std::max(static_cast<Float>(1.0) - rowSum, static_cast<Float>(0.0))), in[0].real());
+      const C c00 = std::polar(std::sqrt(std::max(static_cast<Float>(1.0) - std::norm(a00) - std::norm(b00), static_cast<Float>(0.0))),
+			       in[0].imag());
+      const Float rInv = static_cast<Float>(1.0) / rowSum;
+      const C A = std::conj(a00) * b00;
+      const C B = std::conj(a00) * c00;
+      U[GAUGE_SITE_IDX(0,0)] = sign * a00;
+      U[GAUGE_SITE_IDX(0,1)] = sign * a01;
+      U[GAUGE_SITE_IDX(0,2)] = sign * a02;
+      U[GAUGE_SITE_IDX(1,0)] = sign * b00;
+      U[GAUGE_SITE_IDX(1,1)] = -sign * rInv * (std::conj(c00) * std::conj(a02) + A * a01);
+      U[GAUGE_SITE_IDX(1,2)] =  sign * rInv * (std::conj(c00) * std::conj(a01) - A * a02);
+      U[GAUGE_SITE_IDX(2,0)] = sign * c00;
+      U[GAUGE_SITE_IDX(2,1)] =  sign * rInv * (std::conj(b00) * std::conj(a02) - B * a01);
+      U[GAUGE_SITE_IDX(2,2)] = -sign * rInv * (std::conj(b00) * std::conj(a01) + B * a02);
+      return;
+    }
+    //- Third row of an SU(3) matrix, the complex conjugate of the cross product of the first two
+    const C *a = U;
+    const C *b = U + N_COLOR_;
+    U[GAUGE_SITE_IDX(2,0)] = sign * std::conj(a[1]*b[2] - a[2]*b[1]);
+    U[GAUGE_SITE_IDX(2,1)] = sign * std::conj(a[2]*b[0] - a[0]*b[2]);
+    U[GAUGE_SITE_IDX(2,2)] = sign * std::conj(a[0]*b[1] - a[1]*b[0]);
+  }
+
+public:
+
+  /** @brief Create the field from the QDP-ordered host gauge field passed to the interface.
+   *  With gauge = nullptr the links are only allocated, and are set later with loadGauge
+   */
+  HostGaugeField(const HostGeom &geom_, void *gauge[], QudaPrecision cpuPrec,
+		 QudaReconstructType recon_ = QUDA_RECONSTRUCT_NO);
+  ~HostGaugeField() {}
+
+  /** @brief (Re-)load the link variables from a QDP-ordered host gauge field and exchange the ghost links
+   */
+  void loadGauge(void *gauge[], QudaPrecision cpuPrec);
+
+  /** @brief Blocking exchange of the backward ghost links
+   */
+  void exchangeGhost();
+
+  const HostGeom& Geom() const { return geom; }
+  QudaReconstructType Reconstruct() const { return recon; }
+  int LinkLength() const { return linkLen; }
+
+  /** @brief Bytes of the stored links, including the ghost links
+   */
+  size_t Bytes() const;
+
+  /** @brief The stored (possibly compressed) link data of site idx
+   */
+  const std::complex<Float>* LinkData(int dir, int idx) const {
+    return links[dir].data() + static_cast<long long>(idx) * linkLen;
+  }
+  const std::complex<Float>* GhostLinkData(int dir, int fIdx) const {
+    return ghostLinks[dir].data() + static_cast<long long>(fIdx) * linkLen;
+  }
+
+  /** @brief The full 3x3 link U_dir of site idx. Uncompressed links are returned in place, compressed ones are
+   *  rebuilt into buf
+   */
+  const std::complex<Float>* Link(int dir, int idx, std::complex<Float> buf[GAUGE_SITE_LEN_]) const {
+    if(recon == QUDA_RECONSTRUCT_NO) return LinkData(dir, idx);
+    Float sign = 1.0;
+    if(lastSliceSign[dir] < 0){
+      int x[N_DIM_];
+      const int pty = idx / geom.volumeCB;
+      geom.getCoords(x, idx - pty*geom.volumeCB, pty);
+      if(x[dir] == geom.lL[dir]-1) sign = lastSliceSign[dir];
+    }
+    unpackLink(buf, LinkData(dir, idx), sign);
+    return buf;
+  }
+  const std::complex<Float>* GhostLink(int dir, int fIdx, std::complex<Float> buf[GAUGE_SITE_LEN_]) const {
+    if(recon == QUDA_RECONSTRUCT_NO) return GhostLinkData(dir, fIdx);
+    unpackLink(buf, GhostLinkData(dir, fIdx), ghostSign[dir]);
+    return buf;
+  }
+};
+
+
+/** Non-blocking halo exchange of host color-spinor fields.
+ *  A displacement in the dispSign direction of dim needs the ghost zone on the same side,
+ *  i.e. dispSign = + reads the forward ghost zone, which is filled with the first depth slices of the forward neighbour.
+ */
+template <typename Float>
+class HostHaloExchange {
+
+private:
+
+  std::vector<MPI_Request> req;
+  std::vector<std::complex<Float>> sendBuf[N_DIM_][2];
+
+  //- Batched exchanges receive the faces of all vectors in one buffer, which is unpacked into their ghost zones by wait()
+  std::vector<std::complex<Float>> recvBuf[N_DIM_][2];
+  std::vector<HostColorSpinorField<Float>*> unpackVec[N_DIM_][2];
+  int unpackDepth[N_DIM_][2];
+
+  MPI_Datatype dataTypeMPI;
+
+  //- Longest message posted at once, in elements, at most INT_MAX as MPI counts are int
+  long long maxMsgLen;
+
+  long long nMsg;     // MPI_Isend posted since the last resetCounters
+  long long nBytes;   // bytes of these sends
+
+  /** @brief Post the MPI_Irecv/MPI_Isend pairs of a message of msgLen elements, split in chunks of at most maxMsgLen
+   */
+  void post(std::complex<Float> *recv, std::complex<Float> *send, long long msgLen, int src, int dest, int tag, MPI_Comm comm);
+
+public:
+
+  HostHaloExchange();
+  ~HostHaloExchange();
+
+  /** @brief Set the longest message posted at once, in elements. The default is INT_MAX, smaller values exercise
+   *  the splitting of long messages
+   */
+  void setMaxMessageLength(long long n);
+
+  /** @brief Pack the face and post the MPI_Irecv/MPI_Isend pair needed for a displacement of x in (dim, dispSign)
+   */
+  void start(HostColorSpinorField<Float> &x, int dim, DisplaceSign dispSign, int depth=1);
+
+  /** @brief Same as above for a batch of vectors, the faces of all of them travel in a single message
+   */
+  void start(std::vector<HostColorSpinorField<Float>*> &x, int dim, DisplaceSign dispSign, int depth=1);
+
+  /** @brief Wait until all posted messages have completed, and unpack the batched ones
+   */
+  void wait();
+
+  /** @brief Whether there are messages in flight
+   */
+  bool inFlight() const { return !req.empty(); }
+
+  /** @brief Messages sent, and their bytes, since construction or the last resetCounters
+   */
+  long long Messages() const { return nMsg; }
+  long long MessageBytes() const { return nBytes; }
+  void resetCounters(){ nMsg = nBytes = 0; }
+};
+
+
+//- Wall-clock time in seconds, used for host profiling
+inline double hostTimer(){ return MPI_Wtime(); }
+
+
+#endif // _HOST_FIELD_MUGIQ_H
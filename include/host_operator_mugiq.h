@@ -0,0 +1,34 @@
+#ifndef _HOST_OPERATOR_MUGIQ_H
+#define _HOST_OPERATOR_MUGIQ_H
+
+/**
+ * @file host_operator_mugiq.h
+ * @brief Base class of the linear operators acting on host color-spinor fields
+ */
+
+#include <host_field_mugiq.h>
+
+
+/** Linear operator on host color-spinor fields, applied to blocks of vectors at a time, so that the operators that
+ *  load data per site (e.g. the links of a stencil) load it once for the whole block
+ */
+template <typename Float>
+class HostOperator {
+
+public:
+
+  virtual ~HostOperator() {}
+
+  /** @brief Geometry, spins and colors of the fields the operator acts on
+   */
+  virtual const HostGeom& Geom() const = 0;
+  virtual int Nspin() const { return N_SPIN_; }
+  virtual int Ncolor() const { return N_COLOR_; }
+
+  /** @brief out[i] = A in[i] for all the vectors of the block, out and in must not overlap
+   */
+  virtual void apply(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in) = 0;
+};
+
+
+#endif // _HOST_OPERATOR_MUGIQ_H
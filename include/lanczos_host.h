@@ -0,0 +1,83 @@
+#ifndef _LANCZOS_HOST_H
+#define _LANCZOS_HOST_H
+
+/**
+ * @file lanczos_host.h
+ * @brief Host (CPU, OpenMP + MPI) thick-restart Lanczos eigensolver for Hermitian operators
+ */
+
+#include <host_operator_mugiq.h>
+
+
+//- Parameters of the host Lanczos, the knobs of MugiqEigParam
+struct HostLanczosParam {
+
+  int nEv = 0;        // Number of eigenpairs wanted
+  int nKr = 0;        // Size of the Krylov space, at least nEv + 2
+  double tol = 1e-10; // Residual of the converged Ritz pairs, relative to the largest Ritz value
+  int maxRestarts = 1000;
+  MuGiqEigSpectrum spectrum = MUGIQ_SPECTRUM_SR;  // SR or LR
+
+  // Chebyshev polynomial acceleration, suppresses [a_min, a_max] so that the wanted eigenvalues are the largest of the
+  // polynomial of the operator. Each Lanczos step then takes poly_acc_deg applications of the operator: it pays off
+  // when the basis is tight (nKr about 1.5 nEv), where plain restarts converge slowly, with a low degree (3-4) and
+  // a_min near the 2 nEv-th eigenvalue. With a roomy basis (nKr >= 2 nEv) plain Lanczos takes as few applications
+  MuGiqBool use_poly_acc = MUGIQ_BOOL_FALSE;
+  int poly_acc_deg = 0;
+  double a_min = 0;
+  double a_max = 0;
+};
+
+
+/** Thick-restart Lanczos (Wu & Simon) with full reorthogonalization on host fields, the host counterpart of QUDA's
+ *  TRLM. The basis is stored as one column-major matrix K, and its products go through host_blas_mugiq.h, one GEMM
+ *  per tile of sites. Each Lanczos vector is orthogonalized against the whole basis by classical Gram-Schmidt twice,
+ *  each pass being K^dag w, a single reduction over the processes and w -= K d. At a restart the wanted Ritz vectors
+ *  are formed as K Q, which reads the basis once
+ */
+template <typename Float>
+class HostLanczos {
+
+private:
+
+  HostOperator<Float> &op;
+  HostLanczosParam param;
+
+  long long len;                                     // Local complex numbers of a vector
+  std::vector<std::complex<Float>> basis;            // Storage of the Krylov basis, vector i at basis[i*len]
+  std::vector<HostColorSpinorField<Float>*> kSpace;  // Krylov basis, nKr + 1 vectors
+  std::vector<HostColorSpinorField<Float>*> cheb;    // Chebyshev recurrence vectors
+
+  int nRestart;
+  int nConv;       // converged eigenpairs of the operator
+  long long nOp;   // applications of the operator
+
+  //- out = p(A) in, with p the Chebyshev polynomial or the identity
+  void applyPoly(HostColorSpinorField<Float> &out, HostColorSpinorField<Float> &in);
+
+  //- Orthogonalize w against kSpace[0, n), h[i] accumulates the projections
+  void orthogonalize(HostColorSpinorField<Float> &w, int n, std::vector<std::complex<double>> &h);
+
+  //- kSpace[k] = sum_j kSpace[j] Q[k*m + j] for k < nOut, j < m, in place
+  void rotateBasis(const std::vector<std::complex<double>> &Q, int m, int nOut, std::vector<HostColorSpinorField<Float>*> &out);
+
+public:
+
+  HostLanczos(HostOperator<Float> &op_, const HostLanczosParam &param_);
+  ~HostLanczos();
+
+  HostLanczos(const HostLanczos &) = delete;
+  HostLanczos& operator=(const HostLanczos &) = delete;
+
+  /** @brief The nEv wanted eigenpairs of the operator: eVecs are overwritten with the normalized eigenvectors, evals
+   *  and res receive their Rayleigh quotients with the operator (not the polynomial) and their residuals
+   */
+  void solve(std::vector<HostColorSpinorField<Float>*> &eVecs, std::vector<double> &evals, std::vector<double> &res);
+
+  int Restarts() const { return nRestart; }
+  int Converged() const { return nConv; }
+  long long OpApplications() const { return nOp; }
+};
+
+
+#endif // _LANCZOS_HOST_H
@@ -0,0 +1,251 @@
+#ifndef _LOOP_HOST_H
+#define _LOOP_HOST_H
+
+/**
+ * @file loop_host.h
+ * @brief Host (CPU, OpenMP + MPI) implementation of the loop computation and the host backend of the loop session
+ *
+ * The data buffers follow the same index order as those of Loop_Mugiq, so that the host and GPU results
+ * can be compared element-by-element.
+ */
+
+#include <mugiq.h>
+#include <host_field_mugiq.h>
+#include <displace_host.h>
+#include <disp_path_mugiq.h>
+#include <loop_session.h>
+#include <evec_cache_mugiq.h>
+#include <evec_stream_mugiq.h>
+#include <evec_compress_mugiq.h>
+#include <functional>
+
+
+//- Parameters of the host loop computation, the host counterpart of Loop_Mugiq::LoopComputeParam
+struct LoopHostParam {
+
+  int Nmom;                     // Number of Momenta
+  LoopFTSign FTSign;            // Sign of the Fourier Transform
+  std::vector<int> momMatrix;   // Momenta Matrix, MOM_MATRIX_IDX(id,im)
+
+  MuGiqBool doMomProj;          // whether to do Momentum projection
+  MuGiqBool doNonLocal;         // whether to compute loop for non-local currents
+
+  int localL[N_DIM_];           // local dimensions
+  int totalL[N_DIM_];           // global dimensions
+  int locT;                     // local  time dimension
+  int totT;                     // global time dimension
+  long long locV4;              // local volume
+  long long locV3;              // local 3d volume (no time)
+
+  int nDispEntries;                     // Number of displacement entries
+  std::vector<std::string> dispEntry;   // The displacement entry, e.g. +z:1,8
+  std::vector<std::string> dispString;  // The displacement string, e.g. +z,-x, etc
+  std::vector<DisplaceDir> dispDir;     // Direction of each displacement entry
+  std::vector<DisplaceSign> dispSign;   // Sign of each displacement entry
+  std::vector<int> dispStart;           // Displacement start
+  std::vector<int> dispStop;            // Displacement stop
+  std::vector<int> nLoopPerEntry;       // Number of loop traces per displacement entry
+  std::vector<int> nLoopOffset;         // Number of loop traces up to given entry
+
+  int nDispPaths;                       // Number of general displacement paths
+  std::vector<std::string> dispPath;    // The displacement paths, e.g. +z+z+x-z
+  int dispPathOffset;                   // Loop trace of the first path, the paths follow the displacement entries
+
+  int nDispDerivs;                      // Number of symmetric covariant derivatives
+  std::vector<std::string> dispDeriv;   // The derivative directions, e.g. z
+  int dispDerivOffset;                  // Loop trace of the first derivative, the derivatives follow the paths
+
+  double wilsonLineBudget;                // Memory budget (MB) of the straight Wilson-line tables
+  std::vector<MuGiqBool> useWilsonLine;   // Whether each displacement entry is displaced with the Wilson-line tables
+
+  int nLoop; // Total number of loop traces
+  int nData; // Total number of loop data (nLoop*Ngamma)
+
+  LoopHostParam(const MugiqLoopParam *loopParams, const HostGeom &geom);
+};
+
+
+template <typename Float>
+class LoopHost {
+
+private:
+
+  const HostGeom &geom;
+
+  LoopHostParam *cPrm;
+
+  DisplaceHost<Float> *displace;  // Host displacements, only with non-local currents
+
+  DispPathTrie pathTrie;          // Displacement paths of all loop traces
+
+  //- Communicators for the momentum projection, as in Loop_Mugiq
+  MPI_Comm COMM_SPACE;
+  MPI_Comm COMM_TIME;
+  MuGiqBool IamTimeProcess;
+
+  //- Gamma matrix coefficients and the G -> g5*G mapping of the output
+  std::complex<Float> gRowValue[N_GAMMA_][N_SPIN_];
+  int gColumnIndex[N_GAMMA_][N_SPIN_];
+  int gMapIndex[N_GAMMA_];
+  Float gMapSign[N_GAMMA_];
+
+  //- Data buffers, same order as the Loop_Mugiq ones
+  std::vector<std::complex<Float>> dataPos;        // Position-space loop, volume-inside-gamma-inside-nLoop
+  std::vector<std::complex<Float>> dataPosMP;      // Position-space loop, time-inside-nData-inside-volume3d
+  std::vector<std::complex<Float>> phaseMatrix;    // Phase matrix, volume3d-inside-Nmom
+  std::vector<std::complex<Float>> dataMom_h;      // Local momentum projection
+  std::vector<std::complex<Float>> dataMom;        // Momentum projection summed over space processes
+  std::vector<std::complex<Float>> dataMom_bcast;  // Global momentum projection, available on all processes
+
+  std::vector<std::vector<HostColorSpinorField<Float>*>> vSlot;  // Displaced eigenvectors, one batch per slot 1,...,NSlot-1 of the trie walk
+  std::vector<HostColorSpinorField<Float>*> vLine;               // Eigenvectors displaced with a Wilson line, one batch
+  std::vector<HostColorSpinorField<Float>*> vDecode;             // Decoded compressed eigenvectors, one batch
+
+  MPI_Datatype dataTypeMPI;
+
+  //- Star-stencil sink, contracts the transported neighbours of a site with the eigenvectors
+  struct StarContraction;
+
+  void setupComms();
+  void createGammaCoeff();
+  void createPhaseMatrix();
+
+  /** @brief loopData(x) += inv_sigma * Tr[ l^\dag Gamma r ] for all Gamma matrices, l and r being the sites x of vL and vR
+   */
+  inline void contractSite(std::complex<Float> *loopData, int x, const std::complex<Float> *l, const std::complex<Float> *r,
+			   Float inv_sigma) const;
+
+  /** @brief loopData(x) += 1/sigma * Tr[ vL(x)^\dag Gamma vR(x) ] for all Gamma matrices
+   */
+  void performLoopContraction(std::complex<Float> *loopData, const HostColorSpinorField<Float> &vL,
+			      const HostColorSpinorField<Float> &vR_, Float sigma);
+
+  void performMomentumProjection();
+
+  /** @brief Add the traces of the batch of eigenvectors evB, with singular values sigB, to the position-space loop
+   */
+  void contractBatch(const std::vector<HostColorSpinorField<Float>*> &evB, const std::vector<double> &sigB);
+
+  /** @brief Copy the duplicate traces and project the loop to momentum space, once all the batches are contracted
+   */
+  void finishLoop();
+
+  /** @brief Serve the displacement entries with straight Wilson-line tables if they fit in the memory budget
+   */
+  void setupWilsonLines();
+
+public:
+
+  /** @brief Set up the geometry-dependent state, the gauge field is loaded with loadGauge
+   */
+  LoopHost(const MugiqLoopParam *loopParams, const HostGeom &geom_);
+  ~LoopHost();
+
+  LoopHost(const LoopHost &) = delete;
+  LoopHost& operator=(const LoopHost &) = delete;
+
+  /** @brief Load the links used for the displacements
+   */
+  void loadGauge(void *gauge[], QudaPrecision cpuPrec);
+
+  /** @brief Contract the one-hop leaves of the trie with the star stencil (default off). It is slower than the fused
+   *  hop pairs on the lattices measured so far, so it is not a loop parameter; kept to check it against them
+   */
+  void setStarStencil(MuGiqBool star);
+
+  /** @brief Compute the loop from the eigenpairs, sigma are the singular values (the loop is scaled with 1/sigma)
+   */
+  void computeLoop(const std::vector<HostColorSpinorField<Float>*> &eVecs, const std::vector<double> &sigma);
+
+  /** @brief Compute the loop from the first sigma.size() eigenvectors of stream, which are read from disk while the
+   *  earlier ones are contracted. The result is identical to that of computeLoop
+   */
+  void computeLoopStream(HostEvecStream<Float> &stream, const std::vector<double> &sigma);
+
+  /** @brief Compute the loop from compressed eigenvectors, each batch is decoded just before it is contracted.
+   *  The result is that of computeLoop with the decoded eigenvectors
+   */
+  void computeLoopCompressed(const std::vector<HostCompressedField<Float>*> &eVecs, const std::vector<double> &sigma);
+
+  /** @brief Reference of computeLoop in the former entry-major order: for every loop trace, each eigenvector is
+   *  displaced from scratch, one hop and one vector at a time. Only meant to check the eigenvector-major order of
+   *  computeLoop, whose traces agree with these up to the rounding of the Wilson-line tables
+   */
+  void computeLoopReference(const std::vector<HostColorSpinorField<Float>*> &eVecs, const std::vector<double> &sigma);
+
+  /** @brief Write the momentum-space loop data in HDF5 format
+   */
+  void writeLoopsHDF5(const std::string &fnameMom);
+
+  const LoopHostParam& getParams() const { return *cPrm; }
+  const std::vector<std::complex<Float>>& getPosData() const { return dataPos; }
+  const std::vector<std::complex<Float>>& getMomData() const { return dataMom_bcast; }
+  DisplaceHost<Float>* getDisplace(){ return displace; }
+  const DispPathTrie& getPathTrie() const { return pathTrie; }
+};
+
+
+/** Source of the eigenpairs of a gauge configuration for the host backend: fills the (allocated) eigenvectors
+ *  and the singular values for the QDP-ordered host gauge field passed to the session
+ */
+template <typename Float>
+using HostEigenSource = std::function<void(void *gauge[],
+					   std::vector<HostColorSpinorField<Float>*> &eVecs,
+					   std::vector<double> &sigma)>;
+
+
+//- Host backend of the loop session, the loop environment and the eigenvector storage are kept for the whole session
+template <typename Float>
+class LoopSessionHost : public LoopSessionBackend {
+
+private:
+
+  MugiqLoopParam loopParams;
+  const HostGeom &geom;
+  QudaPrecision cpuPrec;    // Precision of the host gauge fields passed to loadGauge
+
+  int nEv;
+  HostEigenSource<Float> eigenSource;
+
+  LoopHost<Float> *loop;
+  void *gauge[N_DIM_];      // Gauge field of the current configuration, owned by the caller
+  std::vector<HostColorSpinorField<Float>*> eVecs;
+  std::vector<HostCompressedField<Float>*> eVecsCompressed;  // Eigenvectors during the loop computation, with loopParams.evecCompression
+  std::vector<double> sigma;
+
+  /** @brief Header of the eigenvector cache of this rank, the host eigenvectors are in space-spin-color order
+   */
+  EvecCacheHeader evecCacheHeader(uint64_t gaugeChecksum) const;
+
+  /** @brief Allocate the eigenvectors when they are first needed, they are never resident when streamed from the cache
+   */
+  void createEvecs();
+
+  /** @brief Compute the loop from the eigenpairs ev, sg, compressed first if loopParams.evecCompression is set,
+   *  in which case the uncompressed eigenvectors of the session are freed
+   */
+  void runLoop(const std::vector<HostColorSpinorField<Float>*> &ev, const std::vector<double> &sg);
+
+public:
+
+  LoopSessionHost(const MugiqLoopParam *loopParams_, const HostGeom &geom_, QudaPrecision cpuPrec_,
+		  int nEv_, HostEigenSource<Float> eigenSource_);
+
+  const char* name() const { return "host"; }
+
+  void setup();
+  void loadGauge(void *gaugePtr[]);
+
+  /** @brief Compute the loop of the current configuration. With loopParams.evecCacheMode the eigenpairs are saved to
+   *  the cache, or taken from it: the cached eigenvectors are host fields on the mapped file, so they are never copied,
+   *  or with loopParams.evecStreamRing they are streamed from the file through a ring of that many vectors
+   */
+  void computeLoop();
+  void writeLoop(const std::string &fnameMom, const std::string &fnamePos);
+  void teardown();
+
+  LoopHost<Float>* getLoop(){ return loop; }
+};
+
+
+#endif // _LOOP_HOST_H
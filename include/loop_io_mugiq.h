@@ -0,0 +1,40 @@
+#ifndef _LOOP_IO_MUGIQ_H
+#define _LOOP_IO_MUGIQ_H
+
+/**
+ * @file loop_io_mugiq.h
+ * @brief Output of the loop data, shared by the GPU and the host loop computations
+ */
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+
+//- Layout of the momentum-space loop data buffer
+struct LoopMomLayout {
+
+  int Nmom;                             // Number of momenta
+  std::vector<int> momMatrix;           // Momenta, MOM_MATRIX_IDX(id,im)
+  int nDispEntries;                     // Number of displacement entries
+  std::vector<std::string> dispString;  // The displacement string of each entry, e.g. +z
+  std::vector<int> dispStart;           // Displacement start of each entry
+  std::vector<int> dispStop;            // Displacement stop of each entry
+  std::vector<std::string> dispPath;    // General displacement paths, their loop traces follow those of the entries
+  std::vector<std::string> dispDeriv;   // Symmetric covariant derivatives, their loop traces follow those of the paths
+  int nLoop;                            // Total number of loop traces
+  int locT;                             // Local  time dimension
+  int totT;                             // Global time dimension
+  int tCoord;                           // Time coordinate of the process
+};
+
+
+/** @brief Write the globally reduced momentum-space loop data in HDF5 format.
+ *  dataMom holds (re,im) pairs in the order t + locT*ig + locT*nGamma*iL + locT*nGamma*nLoop*im.
+ *  The file is opened with MPI-IO on comm.
+ */
+template <typename Float>
+void writeLoopMomHDF5(const std::string &fname, const LoopMomLayout &lay, const Float *dataMom, MPI_Comm comm);
+
+
+#endif // _LOOP_IO_MUGIQ_H
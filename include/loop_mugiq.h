@@ -5,6 +5,7 @@
 #include <eigsolve_mugiq.h>
 #include <util_mugiq.h>
 #include <displace.h>
+#include <prolong_host.h>
 #include <mpi.h>
 
 using namespace quda;
@@ -19,11 +20,23 @@ private:
   LoopComputeParam *cPrm; // Loop computation Parameter structure
 
   Displace<Float,fieldOrder> *displace;  // structure holding the displacements
+
+  DispPathTrie pathTrie;  // Displacement paths of all loop traces
   
   Eigsolve_Mugiq *eigsolve; // The eigsolve object (This class is a friend of Eigsolve_Mugiq)
 
   ColorSpinorField *refVec; // Reference vector, whose parameters will be used throughout the class
 
+  //- Scratch fields of the prolongation, one fine field and one per coarse level, created on first use
+  std::vector<ColorSpinorField*> prolongTmp;
+
+  //- Batched host prolongation: the fine host geometry, the prolongator with host copies of the null vectors,
+  //- and the host (space-spin-color) copies of a batch of coarse and fine eigenvectors, created on first use
+  HostGeom *hostGeom = nullptr;
+  HostProlongator<Float> *hostProlong = nullptr;
+  std::vector<ColorSpinorField*> hostProlongCoarse;
+  std::vector<ColorSpinorField*> hostProlongFine;
+
   //- MPI/Communication-related parameters for "space" processes
   //- These are the processes that have the same time-coordinate
   MPI_Comm COMM_SPACE; //- The Communicator for "space" processes
@@ -84,6 +97,20 @@ private:
    */
   void prolongateEvec(ColorSpinorField *fineEvec, ColorSpinorField *coarseEvec);
 
+  /** @brief Prolongate a batch of coarse eigenvectors, on the host with cPrm->hostProlong and one by one otherwise
+   */
+  void prolongateEvec(std::vector<ColorSpinorField*> &fineEvec, const std::vector<ColorSpinorField*> &coarseEvec);
+
+  /** @brief Create the host prolongator on first use and copy the null vectors of the current MG hierarchy to it
+   */
+  void loadHostProlongator();
+  void freeHostProlongator();
+
+  /** @brief Create the scratch fields of the prolongation in precision coarsePrec, unless they exist already
+   */
+  void createProlongTmp(QudaPrecision coarsePrec);
+  void freeProlongTmp();
+
   
   /** @brief Print the Parameters of the Loop computation
    */
@@ -123,6 +150,16 @@ public:
   Loop_Mugiq(MugiqLoopParam *loopParams_, Eigsolve_Mugiq *eigsolve_);
   ~Loop_Mugiq();
 
+  /** @brief Reuse the environment for a new gauge configuration: the geometry-dependent state
+   *  (communicators, buffers, phase matrix, gamma coefficients) is kept, the eigensolver and
+   *  the links of the displacements are replaced
+   */
+  void resetConfig(MugiqLoopParam *loopParams_, Eigsolve_Mugiq *eigsolve_);
+
+  /** @brief Set the output switches and filenames
+   */
+  void resetOutput(MugiqLoopParam *loopParams_);
+
   
   /** @brief Write the Loop data in an HDF5 file (called from the interface)
    */
@@ -148,10 +185,11 @@ struct Loop_Mugiq<Float, fieldOrder>::LoopComputeParam {
   LoopFTSign FTSign;                        // Sign of the Fourier Transform
   int *momMatrix;                           // Momenta Matrix, follows lexicographic order momDim-inside-Nmom
   
-  int max_depth;                // maximum depth of transverse shift length (for later)
+  int max_depth;                // maximum number of hops of the displaced vectors, over the entries and the paths
 
   MuGiqBool doMomProj;          // whether to do Momentum projection, if false then the position-space trace will be saved
   MuGiqBool doNonLocal;         // whether to compute loop for non-local currents
+  MuGiqBool hostProlong;        // whether the coarse eigenvectors are prolongated in batches on the host
 
   int localL[N_DIM_];           // local dimensions
   int totalL[N_DIM_];           // global dimensions
@@ -176,6 +214,14 @@ struct Loop_Mugiq<Float, fieldOrder>::LoopComputeParam {
   std::vector<int> nLoopPerEntry;       // Number of loop traces per displacement entry = dispStop - dispStart +1
   std::vector<int> nLoopOffset;         // Number of loop traces up to given entry
 
+  int nDispPaths;                       // Number of general displacement paths
+  std::vector<std::string> dispPath;    // The displacement paths, e.g. +z+z+x-z
+  int dispPathOffset;                   // Loop trace of the first path, the paths follow the displacement entries
+
+  int nDispDerivs;                      // Number of symmetric covariant derivatives
+  std::vector<std::string> dispDeriv;   // The derivative directions, e.g. z
+  int dispDerivOffset;                  // Loop trace of the first derivative, the derivatives follow the paths
+
   int nLoop; // Total number of loop traces
   int nData; // Total number of loop data (nLoop*Ngamma)
   
@@ -188,6 +234,7 @@ struct Loop_Mugiq<Float, fieldOrder>::LoopComputeParam {
     max_depth(0),
     doMomProj(loopParams->doMomProj),
     doNonLocal(loopParams->doNonLocal),
+    hostProlong(loopParams->hostProlongation),
     localL{0,0,0,0},
     totalL{0,0,0,0},
     nParity(x->SiteSubset()),
@@ -196,6 +243,10 @@ struct Loop_Mugiq<Float, fieldOrder>::LoopComputeParam {
     locV4(1), locV3(1), totV3(1),
     calcType(loopParams->calcType),
     nDispEntries(0),
+    nDispPaths(0),
+    dispPathOffset(0),
+    nDispDerivs(0),
+    dispDerivOffset(0),
     nLoop(0), nData(0),
     init(MUGIQ_BOOL_FALSE)
   {
@@ -245,9 +296,33 @@ struct Loop_Mugiq<Float, fieldOrder>::LoopComputeParam {
 	for(int is=0;is<id;is++)
 	  osum += nLoopPerEntry.at(is);
 	nLoopOffset.push_back(osum);
-	
+
+	max_depth = std::max(max_depth, dispStop.at(id));
       } //- for disp entries
       nLoop += 1; // Don't forget ultra-local case!!
+
+      //- The general paths, one loop trace each
+      nDispPaths = loopParams->disp_path.size();
+      dispPathOffset = nLoop;
+      for(int ip=0;ip<nDispPaths;ip++){
+	std::vector<DisplaceFlag> hops;
+	if(!parseDispPath(loopParams->disp_path.at(ip), hops))
+	  errorQuda("Cannot parse displacement path %d = %s\n", ip, loopParams->disp_path.at(ip).c_str());
+	dispPath.push_back(loopParams->disp_path.at(ip));
+	max_depth = std::max(max_depth, static_cast<int>(hops.size()));
+      }
+      nLoop += nDispPaths;
+
+      //- The symmetric covariant derivatives, one loop trace each
+      nDispDerivs = loopParams->disp_deriv.size();
+      dispDerivOffset = nLoop;
+      for(int id=0;id<nDispDerivs;id++){
+	if(parseDisplaceDir(loopParams->disp_deriv.at(id)) == DispDirNone)
+	  errorQuda("Cannot parse derivative direction %d = %s\n", id, loopParams->disp_deriv.at(id).c_str());
+	dispDeriv.push_back(loopParams->disp_deriv.at(id));
+	max_depth = std::max(max_depth, 1);
+      }
+      nLoop += nDispDerivs;
     }
     else{
       nDispEntries = 0; //- only ultra-local
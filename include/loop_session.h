@@ -0,0 +1,99 @@
+#ifndef _LOOP_SESSION_H
+#define _LOOP_SESSION_H
+
+/**
+ * @file loop_session.h
+ * @brief Persistent loop session, reused across a stream of gauge configurations
+ *
+ * A session is created once per run: the geometry-dependent state (communicators, data buffers,
+ * phase matrix, gamma coefficients, extended gauge-field storage) is set up with it and lives until
+ * the session is destroyed. For each gauge configuration only the gauge-dependent state is rebuilt
+ * (gauge field, multigrid null space and coarse operators, eigenpairs).
+ * The computation itself is carried out by a backend, on the GPU (QUDA) or on the host.
+ */
+
+#include <string>
+
+
+//- Backend of a loop session
+class LoopSessionBackend {
+
+public:
+
+  virtual ~LoopSessionBackend() {}
+
+  /** @brief Name of the backend, used in the reports
+   */
+  virtual const char* name() const = 0;
+
+  /** @brief Set up the geometry-dependent state, called once when the session is created
+   */
+  virtual void setup() = 0;
+
+  /** @brief Load a new gauge configuration and rebuild the gauge-dependent state
+   * @param[in] gauge The QDP-ordered host gauge field used for the displacements
+   */
+  virtual void loadGauge(void *gauge[]) = 0;
+
+  /** @brief Compute the eigenpairs and the loop for the gauge configuration currently loaded
+   */
+  virtual void computeLoop() = 0;
+
+  /** @brief Write the loop data of the gauge configuration currently loaded
+   */
+  virtual void writeLoop(const std::string &fnameMom, const std::string &fnamePos) = 0;
+
+  /** @brief Free the geometry-dependent state, called once when the session is destroyed
+   */
+  virtual void teardown() = 0;
+};
+
+
+//- Timing (in seconds) and counters of a session
+struct LoopSessionStats {
+
+  int nConfig;       // Number of processed configurations
+  double setup;      // Geometry-dependent set-up, paid once
+  double loadGauge;  // Gauge-dependent set-up, paid per configuration
+  double compute;    // Eigenpairs and loop computation
+  double write;      // Output
+  double teardown;   // Free the geometry-dependent state
+
+  LoopSessionStats() : nConfig(0), setup(0), loadGauge(0), compute(0), write(0), teardown(0) {}
+
+  void print(const char *label) const;
+};
+
+
+class LoopSession {
+
+private:
+
+  LoopSessionBackend *backend; // The session owns the backend
+
+  LoopSessionStats stats;
+
+public:
+
+  /** @brief Create the session and set up the geometry-dependent state of the backend
+   */
+  explicit LoopSession(LoopSessionBackend *backend_);
+
+  /** @brief Free the backend and print the session statistics
+   */
+  ~LoopSession();
+
+  LoopSession(const LoopSession &) = delete;
+  LoopSession& operator=(const LoopSession &) = delete;
+
+  /** @brief Process one gauge configuration: load it, compute the loop and write it
+   */
+  void processConfig(void *gauge[], const std::string &fnameMom, const std::string &fnamePos);
+
+  const LoopSessionStats& getStats() const { return stats; }
+
+  LoopSessionBackend* getBackend(){ return backend; }
+};
+
+
+#endif // _LOOP_SESSION_H
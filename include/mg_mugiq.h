@@ -1,6 +1,7 @@
 #ifndef _MG_MUGIQ_H
 #define _MG_MUGIQ_H
 
+#include <quda.h>
 #include <multigrid.h> //- The QUDA MG header file
 
 using namespace quda;
@@ -33,7 +34,15 @@ struct MG_Mugiq {
     profile(profile_)
   {
     mg_solver = new multigrid_solver(*mgParams, profile);
-    
+    setOperators();
+
+    mgInit = true;
+  }
+
+  
+  /** @brief Get the coarse Dirac operator and the transfer operators from the MG hierarchy
+   */
+  void setOperators(){
     diracCoarse = mg_solver->mg->getDiracCoarse();
     if(typeid(*diracCoarse) != typeid(DiracCoarse)) errorQuda("The Coarse Dirac operator must not be preconditioned!\n");
 
@@ -51,11 +60,15 @@ struct MG_Mugiq {
       transfer[1] = mg_solver->mg->getTransferCoarse();
       transfer[2] = mg_solver->mg->getTransferCoarsest();
     }
+  }
 
-    mgInit = true;
+  /** @brief Update the MG hierarchy for the gauge field currently loaded, the allocations of the hierarchy are kept
+   */
+  void update(){
+    updateMultigridQuda(mg_solver, mgParams);
+    setOperators();
   }
 
-  
   virtual ~MG_Mugiq(){
     if (mg_solver) delete mg_solver;
     mg_solver = nullptr;
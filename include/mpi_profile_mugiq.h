@@ -0,0 +1,58 @@
+#ifndef _MPI_PROFILE_MUGIQ_H
+#define _MPI_PROFILE_MUGIQ_H
+
+/**
+ * @file mpi_profile_mugiq.h
+ * @brief Optional MPI profiling layer (CMake option MUGIQ_MPI_PROFILE)
+ *
+ * When enabled, libmugiq interposes the MPI functions through the PMPI interface and attributes the
+ * time, bytes and number of calls of each of them to the active MuGiq stage. The per-rank counters are
+ * aggregated into a min/avg/max table when MPI is finalized and written in JSON format to the file given
+ * by the environment variable MUGIQ_MPI_PROFILE_FILE (default mugiq_mpi_profile.json).
+ * The counters may be updated by MPI calls from any thread, e.g. from within OpenMP regions. The stage stack is
+ * shared by all the threads of a rank, the calls of every thread are charged to the stage active on the rank.
+ * When disabled, the stage functions below are no-ops.
+ */
+
+#include <enum_mugiq.h>
+
+#define N_MUGIQ_STAGES_ static_cast<int>(MUGIQ_STAGE_N)
+
+
+#ifdef MUGIQ_MPI_PROFILE
+
+/** @brief Make stage the active one, until the matching mpiProfilePopStage
+ */
+void mpiProfilePushStage(MuGiqCommStage stage);
+
+/** @brief Return to the stage that was active before the last mpiProfilePushStage
+ */
+void mpiProfilePopStage();
+
+/** @brief Aggregate the counters of all ranks and write them to fname (rank 0). Collective over MPI_COMM_WORLD
+ */
+void mpiProfileReport(const char *fname);
+
+#else
+
+inline void mpiProfilePushStage(MuGiqCommStage) {}
+inline void mpiProfilePopStage() {}
+inline void mpiProfileReport(const char *) {}
+
+#endif
+
+
+//- Scoped stage, the stage is active during the lifetime of the object
+class MPIProfileStage {
+
+public:
+
+  explicit MPIProfileStage(MuGiqCommStage stage){ mpiProfilePushStage(stage); }
+  ~MPIProfileStage(){ mpiProfilePopStage(); }
+
+  MPIProfileStage(const MPIProfileStage &) = delete;
+  MPIProfileStage& operator=(const MPIProfileStage &) = delete;
+};
+
+
+#endif // _MPI_PROFILE_MUGIQ_H
@@ -21,6 +21,18 @@ extern "C" {
   //- Should be more than enough
   //#define MAX_DISPLACE_ENTRIES 40
   
+  /* Structure that holds the MuGiq-specific parameters of the eigensolve, i.e. those not in QudaEigParam
+   */
+  typedef struct MugiqEigOptions_s {
+
+    double denseRatio = -1.0; //- The dense solver is used when nEv exceeds denseRatio times the operator dimension, negative for the default (DENSE_EIG_RATIO_)
+    MuGiqBool hostEigsolver = MUGIQ_BOOL_FALSE; //- Run the eigensolve of the fine MdagM/MMdag, its eigenvalues and the projection on the host Wilson-clover operator
+    void *hostGauge[4] = {nullptr, nullptr, nullptr, nullptr}; //- Host links (QDP order) of the host Wilson-clover operator, null for none
+    void *hostClover = nullptr; //- Host clover term (packed order) of the host Wilson-clover operator, null for Wilson fermions
+    QudaPrecision hostPrec = QUDA_DOUBLE_PRECISION; //- Precision of hostGauge and hostClover
+
+  } MugiqEigOptions;
+
   /* Structure that holds parameters related to the calculation of
    * disconnected quark loops.
    * Will be extended according to compuation demands
@@ -41,6 +53,15 @@ extern "C" {
     std::string fname_pos_h5;
     std::vector<int> disp_start;
     std::vector<int> disp_stop;
+    std::vector<std::string> disp_path; //- General displacement paths, e.g. +z+z+x-z
+    std::vector<std::string> disp_deriv; //- Symmetric covariant derivatives (x,y,z,t), one loop trace each
+    double wilsonLineBudget = 0.0; //- Memory (MB) for straight Wilson-line tables of the host loop, 0 to displace hop by hop
+    MuGiqBool hostProlongation = MUGIQ_BOOL_FALSE; //- Prolongate the coarse eigenvectors in batches on the host, with host copies of the null vectors
+    MuGiqEvecCacheMode evecCacheMode = MUGIQ_EVEC_CACHE_NONE; //- Whether to save the eigenpairs to the on-disk cache, or load them from it
+    std::string evecCacheFile; //- Base name of the per-rank eigenvector cache files
+    MuGiqEvecCompression evecCompression = MUGIQ_EVEC_COMPRESS_NONE; //- Host backend: storage of the eigenvectors during the loop computation
+    int evecStreamRing = 0; //- Host backend: number of resident eigenvectors when streaming them from the cache, 0 keeps them all resident
+    MugiqEigOptions eigOptions; //- MuGiq-specific parameters of the eigensolve
     void *gauge[4];
     QudaGaugeParam *gauge_param;
     
@@ -56,13 +77,15 @@ extern "C" {
   /** MuGiq interface function that computes eigenvectors and eigenvalues of coarse operators using MG
    * @param mgParams  Contains all MG metadata regarding the type of eigensolve.
    * @param eigParams Contains all metadata regarding the type of solve.
+   * @param eigOptions MuGiq-specific parameters of the eigensolve
    */
-  void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam eigParams);
+  void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam eigParams, MugiqEigOptions eigOptions);
 
   /** MuGiq interface function that computes eigenvectors and eigenvalues of the Dirac operator
    * @param eigParams Contains all metadata regarding the type of solve.
+   * @param eigOptions MuGiq-specific parameters of the eigensolve
    */
-  void computeEvecsMuGiq(QudaEigParam eigParams);
+  void computeEvecsMuGiq(QudaEigParam eigParams, MugiqEigOptions eigOptions);
   
 #ifdef __cplusplus
 }
@@ -81,4 +104,30 @@ void computeLoop(QudaMultigridParam mgParams, QudaEigParam eigParams, MugiqLoopP
 		 MuGiqBool computeCoarse, MuGiqBool useMG);
 
 
+class LoopSession;
+
+/** MuGiq interface function that creates a loop session, to be reused for a stream of gauge configurations
+ *  on the same lattice. The parameter structures are copied, the structures they point to must outlive the session.
+ * @param mgParams  Contains all MG metadata regarding the type of eigensolve.
+ * @param eigParams Contains all metadata regarding the type of solve.
+ * @param loopParams Contains all metadata regarding the loop calculation
+ * @param computeCoarse Whether to compute eigenvectors of the coarse Dirac operator
+ * @param useMG Whether to use Multigrid for computing the loop
+ */
+template <typename Float>
+LoopSession* newLoopSessionMuGiq(QudaMultigridParam *mgParams, QudaEigParam *eigParams, MugiqLoopParam *loopParams,
+				 MuGiqBool computeCoarse, MuGiqBool useMG);
+
+/** MuGiq interface function that computes the loop of a gauge configuration within a session.
+ *  The gauge (and clover) field of the configuration must have been loaded with loadGaugeQuda (loadCloverQuda)
+ * @param session The session
+ * @param loopParams Only the gauge field for the displacements and the output filenames are taken from here
+ */
+void computeLoopSessionMuGiq(LoopSession *session, MugiqLoopParam *loopParams);
+
+/** MuGiq interface function that destroys a loop session
+ */
+void destroyLoopSessionMuGiq(LoopSession *session);
+
+
 #endif // _MUGIQ_H
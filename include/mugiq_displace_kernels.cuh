@@ -6,7 +6,19 @@
 using namespace quda;
 
 template <typename Float, typename Arg, QudaFieldOrder order>
-__global__ void covariantDisplacementVector_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+__global__ void covariantDisplacementVectorInterior_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBoundary_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchInterior_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchBoundary_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchPack_kernel(Arg *arg, DisplaceDir dispDir, DisplaceSign dispSign);
 
 
 #endif // _MUGIQ_DISPLACE_KERNELS_CUH
@@ -0,0 +1,110 @@
+#ifndef _PROLONG_HOST_H
+#define _PROLONG_HOST_H
+
+/**
+ * @file prolong_host.h
+ * @brief Host (CPU, OpenMP) implementation of the MG prolongation of blocks of vectors
+ *
+ * The prolongator of level lev maps the fields of lattice lev+1 to those of lattice lev (lattice 0 is the fine one):
+ *   out(x, s, c) = sum_v V(x, s, c, v) * in(x / geoBlock, s / spinBlock, v)
+ * where V holds the block-orthonormalized null vectors of the level. The null vectors follow the QUDA
+ * space-spin-color order, V[((pty*volumeCB + x_cb)*nSpin + s)*nColor*nVec + c*nVec + v], and the fields are in
+ * the spin basis of the null vectors.
+ */
+
+#include <host_field_mugiq.h>
+#include <evec_compress_mugiq.h>
+
+
+template <typename Float>
+class HostProlongator {
+
+private:
+
+  const HostGeom &fineGeom;
+
+  int nLevel;  // Number of transfer operators, i.e. of coarse lattices
+
+  std::vector<HostGeom*> coarseGeom;   // Geometry of the coarse lattices, coarseGeom[lev] is lattice lev+1
+  std::vector<int> geoBlock;           // Geometric block of each level, geoBlock[N_DIM_*lev + d]
+  std::vector<int> spinBlock;          // Spin block of each level
+  std::vector<int> nVec;               // Null vectors of each level, i.e. colors of lattice lev+1
+  std::vector<int> nSpin;              // Spins of each lattice, nLevel+1 entries
+  std::vector<int> nColor;             // Colors of each lattice, nLevel+1 entries
+
+  std::vector<std::vector<std::complex<Float>>> V;  // Host copies of the null vectors of each level
+  std::vector<std::vector<int>> coarseIdx;          // Coarse site of each fine site of each level
+  std::vector<std::vector<int>> blockOffset;        // Fine sites of coarse site ic of each level are
+  std::vector<std::vector<int>> blockSites;         //   blockSites[lev][blockOffset[lev][ic] ... blockOffset[lev][ic+1]-1]
+
+  //- Scratch fields of the intermediate lattices, scratch[lev] is on lattice lev, created on first use
+  std::vector<std::vector<HostColorSpinorField<Float>*>> scratch;
+
+  void checkLevel(int lev, const char *func) const {
+    if(lev < 0 || lev >= nLevel) errorQuda("%s: Invalid prolongation level %d, there are %d levels\n", func, lev, nLevel);
+  }
+
+  void checkFields(const std::vector<HostColorSpinorField<Float>*> &out, int lev, const char *func) const;
+
+  /** @brief Prolongation kernel of one level for k vectors, coarseSite(j, ic, sc, buf) returns the nVec colors of
+   *  spin sc of coarse site ic of input vector j, in buf if they must be decoded
+   */
+  template <typename CoarseSite>
+  void prolongateLevel(std::vector<HostColorSpinorField<Float>*> &out, int k, int lev, CoarseSite coarseSite);
+
+  template <typename CoarseVec>
+  void prolongateChain(std::vector<HostColorSpinorField<Float>*> &fine, const std::vector<CoarseVec*> &coarse);
+
+public:
+
+  /** @brief Prolongator of nLevel_ levels from fine lattice geom_ with the MG block structure of each level,
+   *  geoBlock_[lev][d], spinBlock_[lev] and nVec_[lev]. The null vectors are set with setNullVectors
+   */
+  HostProlongator(const HostGeom &geom_, int nLevel_, const int geoBlock_[][N_DIM_], const int spinBlock_[], const int nVec_[]);
+  ~HostProlongator();
+
+  HostProlongator(const HostProlongator &) = delete;
+  HostProlongator& operator=(const HostProlongator &) = delete;
+
+  int NLevel() const { return nLevel; }
+
+  /** @brief Geometry, spins and colors of lattice l, with l = 0 the fine lattice and l = NLevel() the coarsest one
+   */
+  const HostGeom& Geom(int l) const { return (l == 0) ? fineGeom : *coarseGeom.at(l-1); }
+  int Nspin(int l) const { return nSpin.at(l); }
+  int Ncolor(int l) const { return nColor.at(l); }
+
+  /** @brief Copy the null vectors of level lev from a host buffer of precision prec, in space-spin-color order
+   */
+  void setNullVectors(int lev, const void *Vin, QudaPrecision prec);
+
+  std::complex<Float>* NullVectors(int lev) { checkLevel(lev, __func__); return V[lev].data(); }
+
+  /** @brief Prolongate the vectors in, on lattice lev+1, to out, on lattice lev.
+   *  The null vectors of each site are loaded once for the whole block of vectors
+   */
+  void prolongate(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in, int lev);
+
+  /** @brief Prolongate the vectors coarse, on the coarsest lattice, through all levels to fine, on the fine lattice
+   */
+  void prolongate(std::vector<HostColorSpinorField<Float>*> &fine, const std::vector<HostColorSpinorField<Float>*> &coarse);
+
+  /** @brief As above, for compressed input vectors, which are decoded site by site as they are read
+   */
+  void prolongate(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostCompressedField<Float>*> &in, int lev);
+  void prolongate(std::vector<HostColorSpinorField<Float>*> &fine, const std::vector<HostCompressedField<Float>*> &coarse);
+
+  /** @brief Restrict the vectors in, on lattice lev, to out, on lattice lev+1, with the adjoint of the prolongator:
+   *  out(xc, sc, v) = sum_{x in block xc, s in spin block sc, c} conj(V(x, s, c, v)) * in(x, s, c)
+   */
+  void restrictVectors(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in, int lev);
+
+  /** @brief Bytes of the null vectors of all levels
+   */
+  size_t Bytes() const;
+
+  void freeScratch();
+};
+
+
+#endif // _PROLONG_HOST_H
@@ -35,6 +35,35 @@
 #define N_DISPLACE_TYPES 1
 #define N_DISPLACE_SIGNS 2
 
+//- Block sizes of the batched displacements, i.e. how many vectors share each link load
+#define DISPLACE_BATCH_HOST_ 8
+#define DISPLACE_BATCH_DEVICE_ 4
+
+//- Block sizes of the eigenvalue and residual computation, i.e. how many eigenvectors share each block reduction
+#define EVALS_BATCH_HOST_ 16
+#define EVALS_BATCH_DEVICE_ 8
+
+//- Block sizes of the deflation projection, i.e. how many sources share each pass over the eigenvectors
+#define PROJECT_BATCH_HOST_ 16
+#define PROJECT_BATCH_DEVICE_ 8
+
+//- Bytes of the tiles of sites that the host matrix products of blocks of fields are packed in (host_blas_mugiq.h)
+#define HOST_GEMM_TILE_BYTES_ (512*1024)
+
+//- Dense eigensolver of small (coarsest-level) operators: it is used when nEv/dim exceeds DENSE_EIG_RATIO_ and the
+//- dimension does not exceed DENSE_EIG_MAX_DIM_ (DENSE_EIG_MAX_DIM_JACOBI_ for the O(dim^3)-per-sweep Jacobi fallback
+//- without LAPACK), the operator is assembled from blocks of DENSE_EIG_BATCH_HOST_ unit vectors
+#define DENSE_EIG_RATIO_ 0.1
+#define DENSE_EIG_MAX_DIM_ 8192
+#define DENSE_EIG_MAX_DIM_JACOBI_ 512
+#define DENSE_EIG_BATCH_HOST_ 16
+
+//- Eigenvector cache files: magic string and format version of the header, and alignment of the vector data,
+//- so that each vector starts on a page boundary of the memory-mapped file
+#define EVEC_CACHE_MAGIC_ "MUGIQEVC"
+#define EVEC_CACHE_VERSION_ 1
+#define EVEC_CACHE_ALIGN_ 4096
+
 
 //- Memory info utiliry functions
 void printCPUMemInfo();
@@ -2,6 +2,9 @@
 #include <mugiq_util_kernels.cuh>
 #include <mugiq_contract_kernels.cuh>
 #include <mugiq_displace_kernels.cuh>
+#include <displace.h>
+#include <farm_mugiq.h>
+#include <climits>
 
 template <typename Float>
 void copyGammaCoeffStructToSymbol(){
@@ -168,50 +171,236 @@ void exchangeGhostVec(ColorSpinorField *x){
   x->exchangeGhost((QudaParity)(1), nFace, 0); //- first argument is redundant when nParity = 2. nFace MUST be 1 for now.
 }
 
-template <typename Float, QudaFieldOrder order>
-void performCovariantDisplacementVector(ColorSpinorField *dst, ColorSpinorField *src, cudaGaugeField *gauge,
-					DisplaceDir dispDir, DisplaceSign dispSign){
-  exchangeGhostVec(src);
+//- The argument buffer and events come from ds and are reused across calls. The kernels are ordered after the
+//- work already queued on the default stream (the producers of src) through ds.evInput, not by a synchronizing copy
+template <typename Float, QudaFieldOrder order, QudaReconstructType recon>
+static void covariantDisplacementVector(ColorSpinorField *dst, ColorSpinorField *src, cudaGaugeField *gauge,
+					DisplaceDir dispDir, DisplaceSign dispSign,
+					DisplaceStream &ds, DisplaceProfile *profile){
 
-  typedef CovDispVecArg<Float,order> DispArg;
+  typedef CovDispVecArg<Float,order,recon> DispArg;
 
   DispArg arg(*dst, *src, *gauge);
-  DispArg *arg_d;
-  cudaMalloc((void**)&(arg_d), sizeof(arg));
+  if(arg.nParity != 2) errorQuda("%s: This function supports only Full Site Subset fields!\n", __func__);
+
+  DispArg *arg_d = static_cast<DispArg*>(ds.argBuffer(sizeof(arg)));
+  cudaStream_t stream = ds.stream;
+
+  const int dir = static_cast<int>(dispDir);
+  const bool partitioned = arg.commDim[dir];
+
+  double t0 = hostTimer();
+
+  cudaEventRecord(ds.evInput, 0);
+  cudaStreamWaitEvent(stream, ds.evInput, 0);
+  cudaMemcpyAsync(arg_d, &arg, sizeof(arg), cudaMemcpyHostToDevice, stream);
+
+  //- Interior sites do not need the halos of src, launch them asynchronously on the displacement stream...
+  dim3 blockDim(THREADS_PER_BLOCK, arg.nParity, 1);
+  dim3 gridDim((arg.volumeCB + blockDim.x -1)/blockDim.x, 1, 1);
+
+  cudaEventRecord(ds.evStart, stream);
+  covariantDisplacementVectorInterior_kernel<Float, DispArg, order><<<gridDim,blockDim,0,stream>>>(arg_d, dispDir, dispSign);
+  cudaEventRecord(ds.evInterior, stream);
   checkCudaError();
-  cudaMemcpy(arg_d, &arg, sizeof(arg), cudaMemcpyHostToDevice);
+  double t1 = hostTimer();
+
+  //- ...exchange the halos while the interior kernel runs...
+  if(partitioned) exchangeGhostVec(src);
+  double t2 = hostTimer();
+
+  //- ...and complete the face perpendicular to the displacement direction once they have arrived
+  cudaEventRecord(ds.evBndStart, stream);
+  if(partitioned){
+    const int faceVolume = arg.volume / arg.dim[dir];
+    dim3 blockDimB(THREADS_PER_BLOCK, 1, 1);
+    dim3 gridDimB((faceVolume + blockDimB.x -1)/blockDimB.x, 1, 1);
+    covariantDisplacementVectorBoundary_kernel<Float, DispArg, order><<<gridDimB,blockDimB,0,stream>>>(arg_d, dispDir, dispSign);
+  }
+  cudaEventRecord(ds.evBoundary, stream);
+  cudaStreamSynchronize(stream);
   checkCudaError();
+  double t3 = hostTimer();
+
+  if(profile){
+    float msInterior = 0, msBoundary = 0;
+    cudaEventElapsedTime(&msInterior, ds.evStart, ds.evInterior);
+    cudaEventElapsedTime(&msBoundary, ds.evBndStart, ds.evBoundary);
+    profile->pack     += t1 - t0;
+    profile->wait     += t2 - t1;
+    profile->interior += 1.0e-3 * msInterior;
+    profile->boundary += 1.0e-3 * msBoundary;
+    profile->total    += t3 - t0;
+    profile->nCall++;
+  }
+}
 
+
+template <typename Float, QudaFieldOrder order, QudaReconstructType recon>
+static void covariantDisplacementVectorBatch(std::vector<ColorSpinorField*> &dst, std::vector<ColorSpinorField*> &src,
+					     cudaGaugeField *gauge, DisplaceDir dispDir, DisplaceSign dispSign,
+					     DisplaceStream &ds, DisplaceProfile *profile){
+
+  typedef CovDispVecBatchArg<Float,order,recon> DispArg;
+
+  DispArg arg(dst, src, *gauge);
   if(arg.nParity != 2) errorQuda("%s: This function supports only Full Site Subset fields!\n", __func__);
 
+  DispArg *arg_d = static_cast<DispArg*>(ds.argBuffer(sizeof(arg)));
+  cudaStream_t stream = ds.stream;
+
+  const int dir = static_cast<int>(dispDir);
+  const bool partitioned = arg.commDim[dir];
+
+  //- The faces of the whole batch travel in one message, packed into the buffers of ds
+  const int faceVolume = arg.volume / arg.dim[dir];
+  const size_t ghostBytes = sizeof(complex<Float>) * N_SPIN_*N_COLOR_ * faceVolume * arg.nVec;
+  if(partitioned){
+    if(ghostBytes > static_cast<size_t>(INT_MAX))
+      errorQuda("%s: Batched ghost message of %zu bytes exceeds the MPI count limit\n", __func__, ghostBytes);
+    ds.ghostBuffers(ghostBytes);
+    arg.ghostSend = static_cast<complex<Float>*>(ds.ghostSend_d);
+    arg.ghostRecv = static_cast<complex<Float>*>(ds.ghostRecv_d);
+    arg.faceVolume = faceVolume;
+  }
+  dim3 blockDimB(THREADS_PER_BLOCK, 1, 1);
+  dim3 gridDimB((faceVolume + blockDimB.x -1)/blockDimB.x, 1, 1);
+
+  double t0 = hostTimer();
+
+  cudaEventRecord(ds.evInput, 0);
+  cudaStreamWaitEvent(stream, ds.evInput, 0);
+  cudaMemcpyAsync(arg_d, &arg, sizeof(arg), cudaMemcpyHostToDevice, stream);
 
+  //- Pack the faces of all the vectors into one buffer and start its copy to the host...
+  if(partitioned){
+    covariantDisplacementVectorBatchPack_kernel<Float, DispArg, order><<<gridDimB,blockDimB,0,stream>>>(arg_d, dispDir, dispSign);
+    cudaMemcpyAsync(ds.ghostSend_h, ds.ghostSend_d, ghostBytes, cudaMemcpyDeviceToHost, stream);
+    cudaEventRecord(ds.evPacked, stream);
+  }
+
+  //- ...the interior sites of all the vectors in one launch, each thread loads its link once...
   dim3 blockDim(THREADS_PER_BLOCK, arg.nParity, 1);
   dim3 gridDim((arg.volumeCB + blockDim.x -1)/blockDim.x, 1, 1);
 
-  covariantDisplacementVector_kernel<Float, DispArg, order><<<gridDim,blockDim>>>(arg_d, dispDir, dispSign);
-  cudaDeviceSynchronize();
+  cudaEventRecord(ds.evStart, stream);
+  covariantDisplacementVectorBatchInterior_kernel<Float, DispArg, order><<<gridDim,blockDim,0,stream>>>(arg_d, dispDir, dispSign);
+  cudaEventRecord(ds.evInterior, stream);
   checkCudaError();
+  double t1 = hostTimer();
+
+  //- ...a single message per displacement carries the faces of the batch while the interior kernel runs. For
+  //- dispSign = + the forward neighbour's first slices are received and ours go backwards, and the other way round
+  if(partitioned){
+    const int bnd  = (dispSign == DispSignPlus) ? static_cast<int>(MUGIQ_BOUNDARY_FORWARD) : static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+    const int src_r  = comm_neighbor_rank(bnd, dir);
+    const int dest_r = comm_neighbor_rank(1-bnd, dir);
+    const int tag = 300 + 2*dir + bnd;
+    MPI_Comm comm = getCommMugiq();
+
+    MPI_Request r[2];
+    MPI_Irecv(ds.ghostRecv_h, static_cast<int>(ghostBytes), MPI_BYTE, src_r, tag, comm, &r[0]);
+    cudaEventSynchronize(ds.evPacked);
+    MPI_Isend(ds.ghostSend_h, static_cast<int>(ghostBytes), MPI_BYTE, dest_r, tag, comm, &r[1]);
+    MPI_Waitall(2, r, MPI_STATUSES_IGNORE);
+    cudaMemcpyAsync(ds.ghostRecv_d, ds.ghostRecv_h, ghostBytes, cudaMemcpyHostToDevice, stream);
+  }
+  double t2 = hostTimer();
+
+  //- ...and the faces of all the vectors are completed in one launch
+  cudaEventRecord(ds.evBndStart, stream);
+  if(partitioned)
+    covariantDisplacementVectorBatchBoundary_kernel<Float, DispArg, order><<<gridDimB,blockDimB,0,stream>>>(arg_d, dispDir, dispSign);
+  cudaEventRecord(ds.evBoundary, stream);
+  cudaStreamSynchronize(stream);
+  checkCudaError();
+  double t3 = hostTimer();
+
+  if(profile){
+    float msInterior = 0, msBoundary = 0;
+    cudaEventElapsedTime(&msInterior, ds.evStart, ds.evInterior);
+    cudaEventElapsedTime(&msBoundary, ds.evBndStart, ds.evBoundary);
+    profile->pack     += t1 - t0;
+    profile->wait     += t2 - t1;
+    profile->interior += 1.0e-3 * msInterior;
+    profile->boundary += 1.0e-3 * msBoundary;
+    profile->total    += t3 - t0;
+    profile->nCall    += arg.nVec;
+  }
+}
 
-  cudaFree(arg_d);
-  arg_d = nullptr;
 
+//- The gauge accessor is chosen from the reconstruction of the displacement gauge field
+template <typename Float, QudaFieldOrder order>
+void performCovariantDisplacementVector(ColorSpinorField *dst, ColorSpinorField *src, cudaGaugeField *gauge,
+					DisplaceDir dispDir, DisplaceSign dispSign,
+					DisplaceStream &ds, DisplaceProfile *profile){
+  switch(gauge->Reconstruct()){
+  case QUDA_RECONSTRUCT_NO:
+    covariantDisplacementVector<Float,order,QUDA_RECONSTRUCT_NO>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  case QUDA_RECONSTRUCT_12:
+    covariantDisplacementVector<Float,order,QUDA_RECONSTRUCT_12>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  case QUDA_RECONSTRUCT_8:
+    covariantDisplacementVector<Float,order,QUDA_RECONSTRUCT_8>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  default: errorQuda("%s: Unsupported link reconstruction %d\n", __func__, static_cast<int>(gauge->Reconstruct()));
+  }
+}
+
+
+template <typename Float, QudaFieldOrder order>
+void performCovariantDisplacementVectorBatch(std::vector<ColorSpinorField*> &dst, std::vector<ColorSpinorField*> &src,
+					     cudaGaugeField *gauge, DisplaceDir dispDir, DisplaceSign dispSign,
+					     DisplaceStream &ds, DisplaceProfile *profile){
+  switch(gauge->Reconstruct()){
+  case QUDA_RECONSTRUCT_NO:
+    covariantDisplacementVectorBatch<Float,order,QUDA_RECONSTRUCT_NO>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  case QUDA_RECONSTRUCT_12:
+    covariantDisplacementVectorBatch<Float,order,QUDA_RECONSTRUCT_12>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  case QUDA_RECONSTRUCT_8:
+    covariantDisplacementVectorBatch<Float,order,QUDA_RECONSTRUCT_8>(dst, src, gauge, dispDir, dispSign, ds, profile); break;
+  default: errorQuda("%s: Unsupported link reconstruction %d\n", __func__, static_cast<int>(gauge->Reconstruct()));
+  }
 }
 
 
 template void performCovariantDisplacementVector<float,QUDA_FLOAT2_FIELD_ORDER> (ColorSpinorField *dst,
 										 ColorSpinorField *src,
 										 cudaGaugeField *gauge,
-										 DisplaceDir dispDir, DisplaceSign dispSign);
+										 DisplaceDir dispDir, DisplaceSign dispSign,
+										 DisplaceStream &ds, DisplaceProfile *profile);
 template void performCovariantDisplacementVector<float,QUDA_FLOAT4_FIELD_ORDER> (ColorSpinorField *dst,
 										 ColorSpinorField *src,
 										 cudaGaugeField *gauge,
-										 DisplaceDir dispDir, DisplaceSign dispSign);
+										 DisplaceDir dispDir, DisplaceSign dispSign,
+										 DisplaceStream &ds, DisplaceProfile *profile);
 template void performCovariantDisplacementVector<double,QUDA_FLOAT2_FIELD_ORDER>(ColorSpinorField *dst,
 										 ColorSpinorField *src,
 										 cudaGaugeField *gauge,
-										 DisplaceDir dispDir, DisplaceSign dispSign);
+										 DisplaceDir dispDir, DisplaceSign dispSign,
+										 DisplaceStream &ds, DisplaceProfile *profile);
 template void performCovariantDisplacementVector<double,QUDA_FLOAT4_FIELD_ORDER>(ColorSpinorField *dst,
 										 ColorSpinorField *src,
 										 cudaGaugeField *gauge,
-										 DisplaceDir dispDir, DisplaceSign dispSign);
+										 DisplaceDir dispDir, DisplaceSign dispSign,
+										 DisplaceStream &ds, DisplaceProfile *profile);
+template void performCovariantDisplacementVectorBatch<float,QUDA_FLOAT2_FIELD_ORDER> (std::vector<ColorSpinorField*> &dst,
+										      std::vector<ColorSpinorField*> &src,
+										      cudaGaugeField *gauge,
+										      DisplaceDir dispDir, DisplaceSign dispSign,
+										      DisplaceStream &ds, DisplaceProfile *profile);
+template void performCovariantDisplacementVectorBatch<float,QUDA_FLOAT4_FIELD_ORDER> (std::vector<ColorSpinorField*> &dst,
+										      std::vector<ColorSpinorField*> &src,
+										      cudaGaugeField *gauge,
+										      DisplaceDir dispDir, DisplaceSign dispSign,
+										      DisplaceStream &ds, DisplaceProfile *profile);
+template void performCovariantDisplacementVectorBatch<double,QUDA_FLOAT2_FIELD_ORDER>(std::vector<ColorSpinorField*> &dst,
+										      std::vector<ColorSpinorField*> &src,
+										      cudaGaugeField *gauge,
+										      DisplaceDir dispDir, DisplaceSign dispSign,
+										      DisplaceStream &ds, DisplaceProfile *profile);
+template void performCovariantDisplacementVectorBatch<double,QUDA_FLOAT4_FIELD_ORDER>(std::vector<ColorSpinorField*> &dst,
+										      std::vector<ColorSpinorField*> &src,
+										      cudaGaugeField *gauge,
+										      DisplaceDir dispDir, DisplaceSign dispSign,
+										      DisplaceStream &ds, DisplaceProfile *profile);
 //----------------------------------------------------------------------------
@@ -0,0 +1,209 @@
+#include <dirac_host.h>
+
+
+//- Non-zero element of each row of the gamma matrices in the DeGrand-Rossi basis:
+//- (gamma_mu psi)(s) = gammaCoef[mu][s] * psi(gammaCol[mu][s]), the coefficient being one of 1, -1, i, -i
+static const int gammaCol[N_DIM_][N_SPIN_] = {{3, 2, 1, 0},
+					      {3, 2, 1, 0},
+					      {2, 3, 0, 1},
+					      {2, 3, 0, 1}};
+
+static const int gammaCoef[N_DIM_][N_SPIN_][2] = {{{0, 1}, {0, 1}, {0,-1}, {0,-1}},    // gamma_x
+						  {{-1,0}, {1, 0}, {1, 0}, {-1,0}},    // gamma_y
+						  {{0, 1}, {0,-1}, {0,-1}, {0, 1}},    // gamma_z
+						  {{1, 0}, {1, 0}, {1, 0}, {1, 0}}};   // gamma_t
+
+
+//- y = A x on one site, A being the two Hermitian chiral blocks of the clover term cl
+template <typename Float>
+inline static void applyCloverSite(Float *y, const Float *cl, const Float *x){
+  const int bLen = SPINOR_SITE_LEN_ / 2;
+  for(int b=0;b<2;b++){
+    const Float *d = cl + b*CLOVER_SITE_LEN_/2;
+    const Float *l = d + bLen;
+    const Float *xb = x + 2*b*bLen;
+    Float *yb = y + 2*b*bLen;
+    for(int i=0;i<bLen;i++){
+      Float re = d[i]*xb[2*i], im = d[i]*xb[2*i+1];
+      for(int j=0;j<bLen;j++){
+	if(j == i) continue;
+	//- A_ij from the lower triangle, conjugated above the diagonal
+	const int k = (i > j) ? i*(i-1)/2 + j : j*(j-1)/2 + i;
+	const Float ar = l[2*k], ai = (i > j) ? l[2*k+1] : -l[2*k+1];
+	re += ar*xb[2*j]   - ai*xb[2*j+1];
+	im += ar*xb[2*j+1] + ai*xb[2*j];
+      }
+      yb[2*i]   = re;
+      yb[2*i+1] = im;
+    }
+  }
+}
+
+
+//- Consumer of the star stencil that applies the site term and the spin-projected hopping term to each site
+template <typename Float>
+class HostWilsonCloverOperator<Float>::HoppingSink : public HostStarSink<Float> {
+
+  std::vector<HostColorSpinorField<Float>*> &out;
+  const std::vector<HostColorSpinorField<Float>*> &in;
+  const Float *clover;
+  Float kappa;
+  Float sgn;   // 1 for M, -1 for Mdag, whose projectors are swapped
+  int nVec;
+
+public:
+
+  HoppingSink(std::vector<HostColorSpinorField<Float>*> &out_, const std::vector<HostColorSpinorField<Float>*> &in_,
+	      const Float *clover_, Float kappa_, bool dagger) :
+    out(out_), in(in_), clover(clover_), kappa(kappa_), sgn(dagger ? -1.0 : 1.0), nVec(static_cast<int>(in_.size())) {}
+
+  void site(int idx, const std::complex<Float> *w){
+    const int nReal = 2*SPINOR_SITE_LEN_;
+    for(int iv=0;iv<nVec;iv++){
+      const Float *x = reinterpret_cast<const Float*>(in[iv]->Site(idx));
+      Float *y = reinterpret_cast<Float*>(out[iv]->Site(idx));
+
+      //- (1 - sgn gamma_mu) w_+mu + (1 + sgn gamma_mu) w_-mu = (w_+mu + w_-mu) - sgn gamma_mu (w_+mu - w_-mu)
+      Float h[nReal];
+      for(int r=0;r<nReal;r++) h[r] = 0.0;
+      for(int mu=0;mu<N_DIM_;mu++){
+	const Float *wp = reinterpret_cast<const Float*>(w + ((2*mu)*nVec + iv)*SPINOR_SITE_LEN_);
+	const Float *wm = reinterpret_cast<const Float*>(w + ((2*mu+1)*nVec + iv)*SPINOR_SITE_LEN_);
+	for(int s=0;s<N_SPIN_;s++){
+	  const int t = gammaCol[mu][s];
+	  const Float gr = sgn * gammaCoef[mu][s][0], gi = sgn * gammaCoef[mu][s][1];
+	  Float *hs = h + 2*SPINOR_SITE_IDX(s,0);
+	  const Float *ps = wp + 2*SPINOR_SITE_IDX(s,0), *ms = wm + 2*SPINOR_SITE_IDX(s,0);
+	  const Float *pt = wp + 2*SPINOR_SITE_IDX(t,0), *mt = wm + 2*SPINOR_SITE_IDX(t,0);
+#pragma omp simd
+	  for(int c=0;c<N_COLOR_;c++){
+	    const Float dr = pt[2*c] - mt[2*c], di = pt[2*c+1] - mt[2*c+1];
+	    hs[2*c]   += ps[2*c]   + ms[2*c]   - (gr*dr - gi*di);
+	    hs[2*c+1] += ps[2*c+1] + ms[2*c+1] - (gr*di + gi*dr);
+	  }
+	}
+      }
+
+      if(clover) applyCloverSite(y, clover + static_cast<size_t>(idx)*CLOVER_SITE_LEN_, x);
+      else for(int r=0;r<nReal;r++) y[r] = x[r];
+#pragma omp simd
+      for(int r=0;r<nReal;r++) y[r] -= kappa * h[r];
+    }
+  }
+};
+
+
+template <typename Float>
+HostWilsonCloverOperator<Float>::HostWilsonCloverOperator(const HostGeom &geom_, void *gaugePtr[], QudaPrecision cpuPrec,
+							  double kappa_, void *cloverPtr, MuGiqEigOperator opType_,
+							  MuGiqBool gamma5_) :
+  geom(geom_),
+  disp(geom_, gaugePtr, cpuPrec),
+  kappa(static_cast<Float>(kappa_)),
+  opType(opType_),
+  gamma5(gamma5_)
+{
+  setOperator(opType_, gamma5_);
+  if(cloverPtr) loadClover(cloverPtr, cpuPrec);
+}
+
+
+template <typename Float>
+HostWilsonCloverOperator<Float>::~HostWilsonCloverOperator(){
+  for(auto v: tmp) delete v;
+}
+
+
+template <typename Float>
+void HostWilsonCloverOperator<Float>::loadGauge(void *gaugePtr[], QudaPrecision cpuPrec){
+  disp.loadGauge(gaugePtr, cpuPrec);
+}
+
+
+template <typename Float>
+void HostWilsonCloverOperator<Float>::loadClover(void *cloverPtr, QudaPrecision cpuPrec){
+  const size_t len = static_cast<size_t>(geom.volume) * CLOVER_SITE_LEN_;
+  clover.resize(len);
+  if(cpuPrec == QUDA_DOUBLE_PRECISION){
+    const double *c = static_cast<const double*>(cloverPtr);
+    for(size_t i=0;i<len;i++) clover[i] = static_cast<Float>(c[i]);
+  }
+  else if(cpuPrec == QUDA_SINGLE_PRECISION){
+    const float *c = static_cast<const float*>(cloverPtr);
+    for(size_t i=0;i<len;i++) clover[i] = static_cast<Float>(c[i]);
+  }
+  else errorQuda("%s: Unsupported precision %d\n", __func__, static_cast<int>(cpuPrec));
+}
+
+
+template <typename Float>
+void HostWilsonCloverOperator<Float>::setOperator(MuGiqEigOperator opType_, MuGiqBool gamma5_){
+  if(opType_ != MUGIQ_EIG_OPERATOR_M && opType_ != MUGIQ_EIG_OPERATOR_Mdag &&
+     opType_ != MUGIQ_EIG_OPERATOR_MdagM && opType_ != MUGIQ_EIG_OPERATOR_MMdag)
+    errorQuda("%s: Unsupported operator type %d\n", __func__, static_cast<int>(opType_));
+  opType = opType_;
+  gamma5 = gamma5_;
+}
+
+
+template <typename Float>
+void HostWilsonCloverOperator<Float>::applyM(std::vector<HostColorSpinorField<Float>*> &out,
+					     const std::vector<HostColorSpinorField<Float>*> &in, bool dagger){
+
+  const size_t nVec = in.size();
+  if(out.size() != nVec) errorQuda("%s: Got %zu output and %zu input vectors\n", __func__, out.size(), nVec);
+  for(size_t i=0;i<nVec;i++)
+    if(&(in[i]->Geom()) != &geom || &(out[i]->Geom()) != &geom ||
+       in[i]->Nspin() != N_SPIN_ || in[i]->Ncolor() != N_COLOR_ || out[i]->Nspin() != N_SPIN_ || out[i]->Ncolor() != N_COLOR_)
+      errorQuda("%s: Vector %zu is not a color-spinor field of the operator lattice\n", __func__, i);
+
+  std::vector<DisplaceFlag> flags;
+  for(int f=0;f<N_DISPLACE_FLAGS;f++) flags.push_back(static_cast<DisplaceFlag>(f));
+
+  const size_t nBatch = disp.BatchSize();
+  for(size_t i0=0;i0<nVec;i0+=nBatch){
+    const size_t kB = std::min(nBatch, nVec - i0);
+    std::vector<HostColorSpinorField<Float>*> inB(in.begin()+i0, in.begin()+i0+kB), outB(out.begin()+i0, out.begin()+i0+kB);
+    HoppingSink sink(outB, inB, clover.empty() ? nullptr : clover.data(), kappa, dagger);
+    disp.doStarDisplacement(inB, flags, sink);
+  }
+}
+
+
+template <typename Float>
+void HostWilsonCloverOperator<Float>::apply(std::vector<HostColorSpinorField<Float>*> &out,
+					    const std::vector<HostColorSpinorField<Float>*> &in){
+
+  const size_t nVec = in.size();
+  if(opType == MUGIQ_EIG_OPERATOR_MdagM || opType == MUGIQ_EIG_OPERATOR_MMdag){
+    while(tmp.size() < nVec) tmp.push_back(new HostColorSpinorField<Float>(geom));
+    std::vector<HostColorSpinorField<Float>*> t(tmp.begin(), tmp.begin()+nVec);
+    const bool daggerFirst = (opType == MUGIQ_EIG_OPERATOR_MMdag);
+    applyM(t, in, daggerFirst);
+    applyM(out, t, !daggerFirst);
+  }
+  else applyM(out, in, opType == MUGIQ_EIG_OPERATOR_Mdag);
+
+  if(gamma5)
+    for(auto v: out) applyGamma5Host(*v);
+}
+
+
+template <typename Float>
+void applyGamma5Host(HostColorSpinorField<Float> &x){
+  const int nSpin = x.Nspin(), nColor = x.Ncolor();
+  if(nSpin != N_SPIN_) errorQuda("%s: gamma_5 needs %d spins, the field has %d\n", __func__, N_SPIN_, nSpin);
+#pragma omp parallel for
+  for(int i=0;i<x.Geom().volume;i++){
+    std::complex<Float> *v = x.Site(i);
+    for(int s=N_SPIN_/2;s<N_SPIN_;s++)
+      for(int c=0;c<nColor;c++) v[c + nColor*s] = -v[c + nColor*s];
+  }
+}
+
+
+template class HostWilsonCloverOperator<float>;
+template class HostWilsonCloverOperator<double>;
+
+template void applyGamma5Host<float>(HostColorSpinorField<float> &x);
+template void applyGamma5Host<double>(HostColorSpinorField<double> &x);
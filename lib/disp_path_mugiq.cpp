@@ -0,0 +1,272 @@
+#include <disp_path_mugiq.h>
+#include <functional>
+#include <algorithm>
+
+static const std::vector<std::string> dispFlagArray {"+x","-x","+y","-y","+z","-z","+t","-t"};
+static const std::vector<std::string> dispDirArray {"x","y","z","t"};
+
+
+DisplaceFlag parseDisplaceFlag(const std::string &dStr){
+  for(int i=0;i<N_DISPLACE_FLAGS;i++)
+    if(dStr == dispFlagArray.at(i)) return static_cast<DisplaceFlag>(i);
+  return DispFlagNone;
+}
+
+
+std::string displaceFlagString(DisplaceFlag flag){
+  const int f = static_cast<int>(flag);
+  return (f >= 0 && f < N_DISPLACE_FLAGS) ? dispFlagArray.at(f) : std::string("none");
+}
+
+
+bool parseDispPath(const std::string &pathStr, std::vector<DisplaceFlag> &hops){
+  hops.clear();
+  if(pathStr.empty() || pathStr.size() % 2 != 0) return false;
+  for(size_t i=0;i<pathStr.size();i+=2){
+    DisplaceFlag flag = parseDisplaceFlag(pathStr.substr(i, 2));
+    if(flag == DispFlagNone) return false;
+    hops.push_back(flag);
+  }
+  return true;
+}
+
+
+DisplaceDir parseDisplaceDir(const std::string &dStr){
+  for(int i=0;i<N_DIM_;i++)
+    if(dStr == dispDirArray.at(i)) return static_cast<DisplaceDir>(i);
+  return DispDirNone;
+}
+//---------------------------------------------------------------------------
+
+
+DispPathTrie::DispPathTrie() :
+  nSlot(1),
+  nHopNaive(0),
+  nLoop(0),
+  compiled(false),
+  fusePairs(true),
+  useStar(false)
+{
+  node.push_back(DispPathNode(DispFlagNone, -1, 0));
+}
+
+
+int DispPathTrie::childNode(int n, DisplaceFlag hop){
+
+  if(static_cast<int>(hop) < 0 || static_cast<int>(hop) >= N_DISPLACE_FLAGS)
+    errorQuda("%s: Invalid displacement flag %d\n", __func__, static_cast<int>(hop));
+
+  for(auto c: node[n].child) if(node[c].hop == hop && !node[c].deriv) return c;
+
+  const int c = static_cast<int>(node.size());
+  node.push_back(DispPathNode(hop, n, node[n].depth + 1));
+  node[n].child.push_back(c);
+  compiled = false;
+  return c;
+}
+
+
+void DispPathTrie::addLoop(int n, int iLoop){
+  node[n].loopIdx.push_back(iLoop);
+  nLoop = std::max(nLoop, iLoop + 1);
+  compiled = false;
+}
+
+
+void DispPathTrie::addPath(const std::vector<DisplaceFlag> &hops, int iLoop){
+
+  int n = 0;
+  for(auto hop: hops) n = childNode(n, hop);
+  addLoop(n, iLoop);
+
+  nHopNaive += hops.size();
+}
+
+
+void DispPathTrie::addStraightEntry(DisplaceFlag flag, int start, int stop, int loopOffset){
+
+  if(start < 1 || stop < start) errorQuda("%s: Invalid displacement lengths %d,%d\n", __func__, start, stop);
+
+  //- All lengths of the entry are prefixes of the longest one, the per-entry schedule performs stop hops
+  int n = 0;
+  for(int d=1;d<=stop;d++){
+    n = childNode(n, flag);
+    if(d >= start) addLoop(n, loopOffset + d - start);
+  }
+
+  nHopNaive += stop;
+}
+
+
+void DispPathTrie::addDerivative(DisplaceDir dir, int iLoop){
+
+  if(static_cast<int>(dir) < 0 || static_cast<int>(dir) >= N_DIM_)
+    errorQuda("%s: Invalid derivative direction %d\n", __func__, static_cast<int>(dir));
+
+  const DisplaceFlag hop = displaceFlag(dir, DispSignPlus);
+  int n = -1;
+  for(auto c: node[0].child) if(node[c].hop == hop && node[c].deriv) n = c;
+  if(n < 0){
+    n = static_cast<int>(node.size());
+    node.push_back(DispPathNode(hop, 0, 1, true));
+    node[0].child.push_back(n);
+  }
+  addLoop(n, iLoop);
+
+  nHopNaive += 2;
+}
+
+
+DispPathTrie DispPathTrie::fromEntries(const std::vector<std::string> &dispString,
+				       const std::vector<int> &dispStart, const std::vector<int> &dispStop,
+				       const std::vector<int> &nLoopOffset,
+				       const std::vector<std::string> &dispPath, int pathOffset,
+				       const std::vector<std::string> &dispDeriv, int derivOffset){
+  DispPathTrie trie;
+  trie.addPath(std::vector<DisplaceFlag>(), 0); //- ultra-local
+  for(size_t id=0;id<dispString.size();id++){
+    DisplaceFlag flag = parseDisplaceFlag(dispString.at(id));
+    if(flag == DispFlagNone) errorQuda("%s: Cannot parse given displacement string = %s.\n", __func__, dispString.at(id).c_str());
+    trie.addStraightEntry(flag, dispStart.at(id), dispStop.at(id), nLoopOffset.at(id));
+  }
+  for(size_t ip=0;ip<dispPath.size();ip++){
+    std::vector<DisplaceFlag> hops;
+    if(!parseDispPath(dispPath.at(ip), hops)) errorQuda("%s: Cannot parse given displacement path = %s.\n", __func__, dispPath.at(ip).c_str());
+    trie.addPath(hops, pathOffset + static_cast<int>(ip));
+  }
+  for(size_t id=0;id<dispDeriv.size();id++){
+    DisplaceDir dir = parseDisplaceDir(dispDeriv.at(id));
+    if(dir == DispDirNone) errorQuda("%s: Cannot parse given derivative direction = %s.\n", __func__, dispDeriv.at(id).c_str());
+    trie.addDerivative(dir, derivOffset + static_cast<int>(id));
+  }
+  return trie;
+}
+
+
+std::vector<int> DispPathTrie::StarLeaves(int n) const {
+  std::vector<int> leaf;
+  if(!useStar) return leaf;
+  for(auto c: node[n].child) if(!node[c].deriv && node[c].child.empty()) leaf.push_back(c);
+  if(leaf.size() < 2) leaf.clear();
+  return leaf;
+}
+
+
+std::vector<std::pair<int,int>> DispPathTrie::childSteps(int n) const {
+
+  const std::vector<int> &ch = node[n].child;
+  const std::vector<int> leaf = StarLeaves(n);
+  std::vector<std::pair<int,int>> step;
+  std::vector<bool> used(ch.size(), false);
+  for(size_t i=0;i<ch.size();i++) used[i] = (std::find(leaf.begin(), leaf.end(), ch[i]) != leaf.end());
+  for(size_t i=0;i<ch.size();i++){
+    if(used[i]) continue;
+    used[i] = true;
+    int c = ch[i], c2 = -1;
+    if(fusePairs && !node[c].deriv){
+      for(size_t j=i+1;j<ch.size();j++){
+	if(used[j] || node[ch[j]].deriv || node[ch[j]].hop != oppositeDisplaceFlag(node[c].hop)) continue;
+	c2 = ch[j];
+	used[j] = true;
+	break;
+      }
+      if(c2 >= 0 && displaceFlagSign(node[c].hop) == DispSignMinus) std::swap(c, c2);
+    }
+    step.push_back(std::make_pair(c, c2));
+  }
+  return step;
+}
+
+
+void DispPathTrie::compile(){
+
+  sched.clear();
+
+  //- Slots are recycled as soon as the walk leaves the subtree of their node: a slot is released when the hop
+  //- to the last child of its node has been issued, so that a straight path runs on two slots.
+  //- The -d slot of a hop pair is held while the subtree of the +d hop is walked
+  std::vector<int> freeSlot;
+  int nUsed = 1;
+  auto acquire = [&](){
+    if(freeSlot.empty()) return nUsed++;
+    int s = freeSlot.back();
+    freeSlot.pop_back();
+    return s;
+  };
+
+  std::function<void(int,int)> walk = [&](int n, int slot){
+    if(!node[n].loopIdx.empty()) sched.push_back({DISP_PATH_OP_CONTRACT, DispFlagNone, slot, -1, n, -1, -1});
+    if(!StarLeaves(n).empty()) sched.push_back({DISP_PATH_OP_STAR, DispFlagNone, slot, -1, n, -1, -1});
+    const std::vector<std::pair<int,int>> step = childSteps(n);
+    for(size_t i=0;i<step.size();i++){
+      const int c = step[i].first;
+      const int c2 = step[i].second;
+      const int cSlot = acquire();
+      const int cSlot2 = (c2 >= 0) ? acquire() : -1;
+      if(c2 >= 0) sched.push_back({DISP_PATH_OP_HOP_PAIR, node[c].hop, slot, cSlot, c, cSlot2, c2});
+      else sched.push_back({node[c].deriv ? DISP_PATH_OP_DERIV : DISP_PATH_OP_HOP, node[c].hop, slot, cSlot, c, -1, -1});
+      if(i == step.size()-1 && slot > 0){
+	freeSlot.push_back(slot);
+	slot = -1;
+      }
+      walk(c, cSlot);
+      if(c2 >= 0) walk(c2, cSlot2);
+    }
+    if(slot > 0) freeSlot.push_back(slot);
+  };
+  walk(0, 0);
+
+  nSlot = nUsed;
+  compiled = true;
+}
+
+
+const std::vector<DispPathOp>& DispPathTrie::Schedule(){
+  if(!compiled) compile();
+  return sched;
+}
+
+
+int DispPathTrie::NSlot(){
+  if(!compiled) compile();
+  return nSlot;
+}
+
+
+int DispPathTrie::NHop() const {
+  int h = 0;
+  for(size_t n=1;n<node.size();n++) h += node[n].deriv ? 2 : 1;
+  return h;
+}
+
+
+int DispPathTrie::NPair() const {
+  int p = 0;
+  for(size_t n=0;n<node.size();n++)
+    for(const auto &st: childSteps(n)) if(st.second >= 0) p++;
+  return p;
+}
+
+
+int DispPathTrie::MaxDepth() const {
+  int d = 0;
+  for(const auto &n: node) d = std::max(d, n.depth);
+  return d;
+}
+
+
+void DispPathTrie::printReport(const char *label) const {
+  const long long saved = nHopNaive - NHop();
+  printfQuda("%s: Displacement path trie with %d nodes, maximum depth %d, %d loop traces\n",
+	     label, static_cast<int>(node.size()), MaxDepth(), nLoop);
+  printfQuda("%s: Hops per eigenvector: %lld per displacement entry, %d with the trie (%lld saved, %.1f%%)\n",
+	     label, nHopNaive, NHop(), saved, nHopNaive > 0 ? 100.0 * saved / nHopNaive : 0.0);
+  const int nPair = NPair();
+  if(nPair > 0) printfQuda("%s: %d +/- hop pairs are issued as one fused stencil each\n", label, nPair);
+  int nStar = 0, nLeaf = 0;
+  for(size_t n=0;n<node.size();n++){
+    const int l = static_cast<int>(StarLeaves(n).size());
+    if(l > 0){ nStar++; nLeaf += l; }
+  }
+  if(nStar > 0) printfQuda("%s: %d one-hop leaves are contracted by %d star stencils\n", label, nLeaf, nStar);
+}
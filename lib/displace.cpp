@@ -1,4 +1,6 @@
 #include <displace.h>
+#include <mpi_profile_mugiq.h>
+#include <algorithm>
 
 
 template <typename F, QudaFieldOrder order>
@@ -8,18 +10,23 @@ Displace<F,order>::Displace(MugiqLoopParam *loopParams_, ColorSpinorField *csf_,
   gaugePtr{loopParams_->gauge[0],loopParams_->gauge[1],loopParams_->gauge[2],loopParams_->gauge[3]},
   qGaugePrm(loopParams_->gauge_param),
   gaugeField(nullptr),
-  auxDispVec(nullptr)
+  auxDispVec(nullptr),
+  reconChecked(MUGIQ_BOOL_FALSE)
 {
 
   printfQuda("%s: Precision is %s\n", __func__, typeid(F) == typeid(float) ? "single" : "double");
+
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
   
   for (int d=0;d<N_DIM_;d++) exRng[d] = 2 * (redundantComms || commDimPartitioned(d));
 
-  //-Create the gauge field with extended ghost exchange, will be used for displacements
-  createExtendedCudaGaugeField();
+  //-Create the gauge field with extended ghost exchange, will be used for displacements,
+  //-its links are compressed according to the reconstruction of the gauge parameters
+  createExtendedCudaGaugeField(true, redundantComms ? true : false, qGaugePrm->reconstruct);
 
-  printfQuda("%s: Gauge field has%s extended Halo exchange\n", __func__,
-	     gaugeField->GhostExchange() == QUDA_GHOST_EXCHANGE_EXTENDED ? "" : " NOT");
+  printfQuda("%s: Gauge field has%s extended Halo exchange, link reconstruction %d\n", __func__,
+	     gaugeField->GhostExchange() == QUDA_GHOST_EXCHANGE_EXTENDED ? "" : " NOT",
+	     static_cast<int>(gaugeField->Reconstruct()));
   
   //- Create a color spinor field to hold the displaced vector
   ColorSpinorParam csParam(*csf_);
@@ -34,6 +41,8 @@ Displace<F,order>::~Displace(){
   for(int i=0;i<N_DIM_;i++) gaugePtr[i] = nullptr;
   if(gaugeField) delete gaugeField;
   if(auxDispVec) delete auxDispVec;
+  for(auto v: auxDispVecBatch) if(v) delete v;
+  if(profile.nCall > 0) profile.print("Displace");
 }
 
 
@@ -45,20 +54,28 @@ void Displace<F,order>::resetAuxDispVec(ColorSpinorField *fineEvec){
 
 
 template <typename F, QudaFieldOrder order>
-void Displace<F,order>::swapAuxDispVec(ColorSpinorField *displacedEvec){
-  ColorSpinorField *tmp = displacedEvec;
-  *displacedEvec = *auxDispVec;
-  *auxDispVec = *tmp; //- This might as well be neglected
+void Displace<F,order>::matchAuxDispVec(ColorSpinorField *&aux, const ColorSpinorField &v){
+  if(aux && aux->Precision() == v.Precision() && aux->FieldOrder() == v.FieldOrder() &&
+     aux->Volume() == v.Volume() && aux->SiteSubset() == v.SiteSubset()) return;
+  if(aux) delete aux;
+  ColorSpinorParam csParam(v);
+  csParam.create = QUDA_NULL_FIELD_CREATE;
+  aux = ColorSpinorField::Create(csParam);
 }
 
 
+//- The interior and boundary kernels write every site of the output, so the spare buffers are never zeroed,
+//- and a hop in place only rotates the handles of the input and the spare buffer, no field is copied
 template <typename F, QudaFieldOrder order>
-void Displace<F,order>::doVectorDisplacement(DisplaceType dispType, ColorSpinorField *displacedEvec, int idisp){
+void Displace<F,order>::doVectorDisplacement(DisplaceType dispType, ColorSpinorField *&displacedEvec, int idisp){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
 
   if(dispType == DISPLACE_TYPE_COVARIANT){
-    blas::zero(*auxDispVec);
-    performCovariantDisplacementVector<F, order>(auxDispVec, displacedEvec, gaugeField, dispDir, dispSign);
-    swapAuxDispVec(displacedEvec);
+    matchAuxDispVec(auxDispVec, *displacedEvec);
+    performCovariantDisplacementVector<F, order>(auxDispVec, displacedEvec, gaugeField, dispDir, dispSign,
+						 dispStream, &profile);
+    std::swap(displacedEvec, auxDispVec);
     printfQuda("%s: Step-%02d of a Covariant displacement done\n", __func__, idisp);
   }
   else{
@@ -67,6 +84,77 @@ void Displace<F,order>::doVectorDisplacement(DisplaceType dispType, ColorSpinorF
 }
 
 
+template <typename F, QudaFieldOrder order>
+void Displace<F,order>::doVectorDisplacement(DisplaceType dispType, std::vector<ColorSpinorField*> &displacedEvec, int idisp){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+
+  const int nVec = static_cast<int>(displacedEvec.size());
+  if(nVec > BatchSize()) errorQuda("%s: Got %d vectors, batches of up to %d vectors are supported\n", __func__, nVec, BatchSize());
+
+  if(dispType == DISPLACE_TYPE_COVARIANT){
+    if(static_cast<int>(auxDispVecBatch.size()) < nVec) auxDispVecBatch.resize(nVec, nullptr);
+    for(int i=0;i<nVec;i++) matchAuxDispVec(auxDispVecBatch[i], *displacedEvec[i]);
+    std::vector<ColorSpinorField*> aux(auxDispVecBatch.begin(), auxDispVecBatch.begin()+nVec);
+    performCovariantDisplacementVectorBatch<F, order>(aux, displacedEvec, gaugeField, dispDir, dispSign,
+						      dispStream, &profile);
+    for(int i=0;i<nVec;i++) std::swap(displacedEvec[i], auxDispVecBatch[i]);
+    printfQuda("%s: Step-%02d of a Covariant displacement done for a batch of %d vectors\n", __func__, idisp, nVec);
+  }
+  else{
+    errorQuda("Unsupported Displacement type %d", static_cast<int>(dispType));
+  }
+}
+
+
+template <typename F, QudaFieldOrder order>
+void Displace<F,order>::doVectorDisplacement(DisplaceType dispType, std::vector<ColorSpinorField*> &dst,
+					     std::vector<ColorSpinorField*> &src, DisplaceFlag hop){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+
+  const int nVec = static_cast<int>(src.size());
+  if(nVec > BatchSize()) errorQuda("%s: Got %d vectors, batches of up to %d vectors are supported\n", __func__, nVec, BatchSize());
+  if(static_cast<int>(dst.size()) != nVec) errorQuda("%s: Got %zu output vectors for %d input vectors\n", __func__, dst.size(), nVec);
+
+  if(dispType == DISPLACE_TYPE_COVARIANT){
+    performCovariantDisplacementVectorBatch<F, order>(dst, src, gaugeField, displaceFlagDir(hop), displaceFlagSign(hop),
+						      dispStream, &profile);
+    if(getVerbosity() >= QUDA_VERBOSE)
+      printfQuda("%s: Covariant %s hop done for a batch of %d vectors\n", __func__, displaceFlagString(hop).c_str(), nVec);
+  }
+  else{
+    errorQuda("Unsupported Displacement type %d", static_cast<int>(dispType));
+  }
+}
+
+
+template <typename F, QudaFieldOrder order>
+void Displace<F,order>::doVectorDerivative(DisplaceType dispType, std::vector<ColorSpinorField*> &dst,
+					   std::vector<ColorSpinorField*> &src, DisplaceDir dir){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+
+  const int nVec = static_cast<int>(src.size());
+  if(nVec > BatchSize()) errorQuda("%s: Got %d vectors, batches of up to %d vectors are supported\n", __func__, nVec, BatchSize());
+  if(static_cast<int>(dst.size()) != nVec) errorQuda("%s: Got %zu output vectors for %d input vectors\n", __func__, dst.size(), nVec);
+
+  if(dispType == DISPLACE_TYPE_COVARIANT){
+    if(static_cast<int>(auxDispVecBatch.size()) < nVec) auxDispVecBatch.resize(nVec, nullptr);
+    for(int i=0;i<nVec;i++) matchAuxDispVec(auxDispVecBatch[i], *src[i]);
+    std::vector<ColorSpinorField*> aux(auxDispVecBatch.begin(), auxDispVecBatch.begin()+nVec);
+    performCovariantDisplacementVectorBatch<F, order>(dst, src, gaugeField, dir, DispSignPlus, dispStream, &profile);
+    performCovariantDisplacementVectorBatch<F, order>(aux, src, gaugeField, dir, DispSignMinus, dispStream, &profile);
+    for(int i=0;i<nVec;i++) blas::axpby(-0.5, *aux[i], 0.5, *dst[i]);
+    if(getVerbosity() >= QUDA_VERBOSE)
+      printfQuda("%s: Symmetric covariant derivative along %s done for a batch of %d vectors\n", __func__, DisplaceDirArray[dir], nVec);
+  }
+  else{
+    errorQuda("Unsupported Displacement type %d", static_cast<int>(dispType));
+  }
+}
+
+
 template <typename F, QudaFieldOrder order>
 cudaGaugeField* Displace<F,order>::createCudaGaugeField(){
 
@@ -76,7 +164,7 @@ cudaGaugeField* Displace<F,order>::createCudaGaugeField(){
   GaugeField *cpuGaugeField = static_cast<GaugeField*>(new quda::cpuGaugeField(gParam));
 
   gParam.create         = QUDA_NULL_FIELD_CREATE;
-  gParam.reconstruct    = qGaugePrm->reconstruct;
+  gParam.reconstruct    = QUDA_RECONSTRUCT_NO; // The links are compressed, if at all, when copied to the extended field
   gParam.ghostExchange  = QUDA_GHOST_EXCHANGE_PAD;
   gParam.pad            = qGaugePrm->ga_pad * 2;  // It's originally defined with half-volume
   gParam.order          = QUDA_QDP_GAUGE_ORDER;//QUDA_FLOAT2_GAUGE_ORDER;
@@ -110,10 +198,16 @@ void Displace<F,order>::createExtendedCudaGaugeField(bool copyGauge, bool redund
   for (int dir=0;dir<N_DIM_;dir++) y[dir] = tmpGauge->X()[dir] + 2*exRng[dir];
   int pad = 0;
 
-  GaugeFieldParam gParamEx(y, tmpGauge->Precision(), recon != QUDA_RECONSTRUCT_INVALID ? recon : tmpGauge->Reconstruct(), pad,
+  if(recon == QUDA_RECONSTRUCT_INVALID) recon = tmpGauge->Reconstruct();
+  if(recon != QUDA_RECONSTRUCT_NO && recon != QUDA_RECONSTRUCT_12 && recon != QUDA_RECONSTRUCT_8)
+    errorQuda("%s: Unsupported link reconstruction %d for the displacements\n", __func__, static_cast<int>(recon));
+
+  GaugeFieldParam gParamEx(y, tmpGauge->Precision(), recon, pad,
 			   tmpGauge->Geometry(), QUDA_GHOST_EXCHANGE_EXTENDED);
   gParamEx.create = QUDA_ZERO_FIELD_CREATE;
-  gParamEx.order = tmpGauge->Order();
+  //- Compressed links are read through gauge_mapper, i.e. in the native order, FLOAT2 (double) or FLOAT4 (single)
+  if(recon == QUDA_RECONSTRUCT_NO) gParamEx.order = tmpGauge->Order();
+  else gParamEx.order = (typeid(F) == typeid(double)) ? QUDA_FLOAT2_GAUGE_ORDER : QUDA_FLOAT4_GAUGE_ORDER;
   gParamEx.siteSubset = QUDA_FULL_SITE_SUBSET;
   gParamEx.t_boundary = tmpGauge->TBoundary();
   gParamEx.nFace = 1;
@@ -134,16 +228,71 @@ void Displace<F,order>::createExtendedCudaGaugeField(bool copyGauge, bool redund
 }
 
 
+template <typename F, QudaFieldOrder order>
+void Displace<F,order>::checkLinkReconstruction(ColorSpinorField *src){
+
+  //- The check needs a full uncompressed copy of the extended gauge field, it is a debugging aid only
+  if(getVerbosity() < QUDA_DEBUG_VERBOSE) return;
+  if(reconChecked || gaugeField->Reconstruct() == QUDA_RECONSTRUCT_NO) return;
+
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+
+  //- Temporary uncompressed copy of the current links
+  cudaGaugeField *gaugeRecon = gaugeField;
+  createExtendedCudaGaugeField(true, redundantComms ? true : false, QUDA_RECONSTRUCT_NO);
+  cudaGaugeField *gaugeFull = gaugeField;
+  gaugeField = gaugeRecon;
+
+  ColorSpinorParam csParam(*src);
+  csParam.create = QUDA_ZERO_FIELD_CREATE;
+  ColorSpinorField *dstFull  = ColorSpinorField::Create(csParam);
+  ColorSpinorField *dstRecon = ColorSpinorField::Create(csParam);
+
+  double maxDev = 0.0;
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    const DisplaceFlag flag = static_cast<DisplaceFlag>(f);
+    performCovariantDisplacementVector<F, order>(dstFull,  src, gaugeFull,  displaceFlagDir(flag), displaceFlagSign(flag), dispStream);
+    performCovariantDisplacementVector<F, order>(dstRecon, src, gaugeRecon, displaceFlagDir(flag), displaceFlagSign(flag), dispStream);
+    const double norm2 = blas::norm2(*dstFull);
+    const double dev2  = blas::xmyNorm(*dstFull, *dstRecon); //- dstRecon = dstFull - dstRecon
+    if(norm2 > 0) maxDev = std::max(maxDev, sqrt(dev2 / norm2));
+  }
+
+  const double tol = (typeid(F) == typeid(double)) ? 1e-10 : 1e-4;
+  printfQuda("%s: Max relative deviation of the displacements with reconstruct-%d links from the uncompressed ones: %e\n",
+	     __func__, static_cast<int>(gaugeRecon->Reconstruct()), maxDev);
+  if(maxDev > tol)
+    warningQuda("%s: Deviation above %e, the links may not be SU(3), use QUDA_RECONSTRUCT_NO for the displacements\n", __func__, tol);
+
+  delete dstFull;
+  delete dstRecon;
+  delete gaugeFull;
+  reconChecked = MUGIQ_BOOL_TRUE;
+}
+
+
+template <typename F, QudaFieldOrder order>
+void Displace<F,order>::loadGauge(void *gauge_[]){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+
+  for(int d=0;d<N_DIM_;d++) gaugePtr[d] = gauge_[d];
+
+  cudaGaugeField *tmpGauge = createCudaGaugeField();
+  copyExtendedGauge(*gaugeField, *tmpGauge, QUDA_CUDA_FIELD_LOCATION);
+  gaugeField->exchangeExtendedGhost(exRng, redundantComms ? true : false);
+
+  delete tmpGauge;
+  tmpGauge = nullptr;
+
+  printfQuda("%s: Links of the extended Gauge Field for Displacements updated\n", __func__);
+}
+
+
 template <typename F, QudaFieldOrder order>
 DisplaceFlag Displace<F,order>::WhichDisplaceFlag(){
   
-  DisplaceFlag dFlag = DispFlagNone;
-  for(int i=0;i<N_DISPLACE_FLAGS;i++){
-    if( dispString == DisplaceFlagArray.at(i) ){
-      dFlag = static_cast<DisplaceFlag>(i);
-      break;
-    }
-  }
+  DisplaceFlag dFlag = parseDisplaceFlag(dispString);
   if(dFlag == DispFlagNone) errorQuda("%s: Cannot parse given displacement string = %s.\n", __func__, dispString_c);
   return dFlag;
 }
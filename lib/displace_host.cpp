@@ -0,0 +1,875 @@
+#include <displace_host.h>
+#include <mpi_profile_mugiq.h>
+#include <disp_path_mugiq.h>
+#include <algorithm>
+
+//- Load the link U (dagger = false) or U^\dag (dagger = true) into separate real and imaginary parts
+template <typename Float>
+inline static void loadLink(Float ur[N_COLOR_][N_COLOR_], Float ui[N_COLOR_][N_COLOR_],
+			    const std::complex<Float> *U, bool dagger){
+  const Float *u = reinterpret_cast<const Float*>(U);
+  for(int i=0;i<N_COLOR_;i++)
+    for(int j=0;j<N_COLOR_;j++){
+      const int ij = dagger ? GAUGE_SITE_IDX(j,i) : GAUGE_SITE_IDX(i,j);
+      ur[i][j] = u[2*ij];
+      ui[i][j] = dagger ? -u[2*ij+1] : u[2*ij+1];
+    }
+}
+
+
+//- out(s) = u * in(s) for all four spins at once, with u loaded by loadLink.
+//- The spinor is transposed to color-major order so that the product vectorizes over the spins.
+template <typename Float>
+inline static void applyLink(std::complex<Float> *out, const Float ur[N_COLOR_][N_COLOR_], const Float ui[N_COLOR_][N_COLOR_],
+			     const std::complex<Float> *in){
+
+  const Float *v = reinterpret_cast<const Float*>(in);
+  Float *w = reinterpret_cast<Float*>(out);
+
+  Float vr[N_COLOR_][N_SPIN_], vi[N_COLOR_][N_SPIN_];
+  for(int s=0;s<N_SPIN_;s++)
+    for(int c=0;c<N_COLOR_;c++){
+      vr[c][s] = v[2*SPINOR_SITE_IDX(s,c)];
+      vi[c][s] = v[2*SPINOR_SITE_IDX(s,c)+1];
+    }
+
+  Float wr[N_COLOR_][N_SPIN_], wi[N_COLOR_][N_SPIN_];
+  for(int i=0;i<N_COLOR_;i++){
+#pragma omp simd
+    for(int s=0;s<N_SPIN_;s++){
+      Float re = 0.0, im = 0.0;
+      for(int j=0;j<N_COLOR_;j++){
+	const Float pr = ur[i][j]*vr[j][s] - ui[i][j]*vi[j][s];
+	const Float pi = ur[i][j]*vi[j][s] + ui[i][j]*vr[j][s];
+	re += pr;
+	im += pi;
+      }
+      wr[i][s] = re;
+      wi[i][s] = im;
+    }
+  }
+
+  for(int s=0;s<N_SPIN_;s++)
+    for(int c=0;c<N_COLOR_;c++){
+      w[2*SPINOR_SITE_IDX(s,c)]   = wr[c][s];
+      w[2*SPINOR_SITE_IDX(s,c)+1] = wi[c][s];
+    }
+}
+
+
+//- out(s) = U * in(s) (dagger = false) or U^\dag * in(s) (dagger = true), for each spin s.
+//- All host engines go through loadLink/applyLink, so that their results agree bit by bit.
+template <typename Float>
+inline static void linkTimesSpinor(std::complex<Float> *out, const std::complex<Float> *U,
+				   const std::complex<Float> *in, bool dagger){
+  Float ur[N_COLOR_][N_COLOR_], ui[N_COLOR_][N_COLOR_];
+  loadLink<Float>(ur, ui, U, dagger);
+  applyLink<Float>(out, ur, ui, in);
+}
+
+
+//- Displace the vector at site x (even/odd index idx) by one hop, the neighbour may be in the ghost zone
+template <typename Float>
+inline static void covariantDisplaceSite(HostColorSpinorField<Float> &dst, const HostColorSpinorField<Float> &src,
+					 const HostGaugeField<Float> &U, const int x[], int idx,
+					 int dir, DisplaceSign dispSign){
+  const HostGeom &geom = src.Geom();
+  const std::complex<Float> *link = nullptr;
+  const std::complex<Float> *vec  = nullptr;
+  std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+
+  int y[N_DIM_] = {x[0], x[1], x[2], x[3]};
+  if(dispSign == DispSignPlus){ //- U_d(x) * src(x+d)
+    link = U.Link(dir, idx, ubuf);
+    y[dir] = x[dir] + 1;
+    if(y[dir] == geom.lL[dir]){
+      if(geom.commDim[dir]) vec = src.GhostSite(dir, static_cast<int>(MUGIQ_BOUNDARY_FORWARD), geom.faceIndex(x, dir));
+      else{
+	y[dir] = 0;
+	vec = src.Site(geom.siteIndex(y));
+      }
+    }
+    else vec = src.Site(geom.siteIndex(y));
+  }
+  else{ //- U_d^\dag(x-d) * src(x-d)
+    y[dir] = x[dir] - 1;
+    if(y[dir] < 0){
+      if(geom.commDim[dir]){
+	const int fIdx = geom.faceIndex(x, dir);
+	vec  = src.GhostSite(dir, static_cast<int>(MUGIQ_BOUNDARY_BACKWARD), fIdx);
+	link = U.GhostLink(dir, fIdx, ubuf);
+      }
+      else{
+	y[dir] = geom.lL[dir] - 1;
+	const int nbrIdx = geom.siteIndex(y);
+	vec  = src.Site(nbrIdx);
+	link = U.Link(dir, nbrIdx, ubuf);
+      }
+    }
+    else{
+      const int nbrIdx = geom.siteIndex(y);
+      vec  = src.Site(nbrIdx);
+      link = U.Link(dir, nbrIdx, ubuf);
+    }
+  }
+
+  linkTimesSpinor<Float>(dst.Site(idx), link, vec, dispSign == DispSignMinus);
+}
+
+
+template <typename Float>
+void performCovariantDisplacementVectorHost(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+					    const HostGaugeField<Float> &gauge, HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile, MuGiqBool overlapComms){
+
+  if(src.Nspin() != N_SPIN_ || src.Ncolor() != N_COLOR_ || dst.Nspin() != N_SPIN_ || dst.Ncolor() != N_COLOR_)
+    errorQuda("%s: Displacements are supported only for Nspin = %d, Ncolor = %d fields\n", __func__, N_SPIN_, N_COLOR_);
+  if(&dst == &src) errorQuda("%s: Displacement cannot be performed in place\n", __func__);
+
+  const HostGeom &geom = src.Geom();
+  const int dir = static_cast<int>(dispDir);
+  const bool partitioned = geom.commDim[dir];
+
+  double t0 = hostTimer();
+
+  //- 1. Post the halo messages
+  if(partitioned) halo.start(src, dir, dispSign);
+  double t1 = hostTimer();
+  if(!overlapComms) halo.wait();
+  double t2 = hostTimer();
+
+  //- 2. Interior sites, their neighbours are all local
+#pragma omp parallel for
+  for(int idx=0;idx<geom.volume;idx++){
+    const int pty  = idx / geom.volumeCB;
+    const int x_cb = idx - pty*geom.volumeCB;
+    int x[N_DIM_];
+    geom.getCoords(x, x_cb, pty);
+    if(geom.isBoundary(x, dir, dispSign)) continue;
+    covariantDisplaceSite<Float>(dst, src, gauge, x, idx, dir, dispSign);
+  }
+  double t3 = hostTimer();
+
+  //- 3. Wait for the halos
+  halo.wait();
+  double t4 = hostTimer();
+
+  //- 4. Boundary sites, one face of the local lattice
+  if(partitioned){
+    const int fVol = geom.faceVolume[dir];
+#pragma omp parallel for
+    for(int f=0;f<fVol;f++){
+      int x[N_DIM_];
+      geom.faceCoords(x, f, dir);
+      x[dir] = (dispSign == DispSignPlus) ? geom.lL[dir] - 1 : 0;
+      covariantDisplaceSite<Float>(dst, src, gauge, x, geom.siteIndex(x), dir, dispSign);
+    }
+  }
+  double t5 = hostTimer();
+
+  if(profile){
+    profile->pack     += t1 - t0;
+    profile->wait     += (t2 - t1) + (t4 - t3);
+    profile->interior += t3 - t2;
+    profile->boundary += t5 - t4;
+    profile->total    += t5 - t0;
+    profile->nCall++;
+  }
+}
+//---------------------------------------------------------------------------
+
+
+HostNbrTable::HostNbrTable(const HostGeom &geom_) :
+  geom(geom_)
+{
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    const int dir = f / 2;
+    const DisplaceSign dispSign = (f % 2 == 0) ? DispSignPlus : DispSignMinus;
+
+    nbr[f].resize(geom.volume);
+    for(int idx=0;idx<geom.volume;idx++){
+      const int pty  = idx / geom.volumeCB;
+      int x[N_DIM_];
+      geom.getCoords(x, idx - pty*geom.volumeCB, pty);
+      if(geom.isBoundary(x, dir, dispSign)){
+	nbr[f][idx] = -(geom.faceIndex(x, dir) + 1);
+	continue;
+      }
+      //- Local neighbour, with periodic wrap-around in the dimensions that are not partitioned
+      x[dir] = (x[dir] + (dispSign == DispSignPlus ? 1 : -1) + geom.lL[dir]) % geom.lL[dir];
+      nbr[f][idx] = geom.siteIndex(x);
+      interior[f].push_back(idx);
+    }
+
+    if(geom.commDim[dir]){
+      const int fVol = geom.faceVolume[dir];
+      boundary[f].resize(fVol);
+      for(int fIdx=0;fIdx<fVol;fIdx++){
+	int x[N_DIM_];
+	geom.faceCoords(x, fIdx, dir);
+	x[dir] = (dispSign == DispSignPlus) ? geom.lL[dir] - 1 : 0;
+	boundary[f][fIdx] = geom.siteIndex(x);
+      }
+    }
+  }
+
+  for(int dir=0;dir<N_DIM_;dir++)
+    for(int idx=0;idx<geom.volume;idx++){
+      if(nbr[2*dir][idx] >= 0 && nbr[2*dir+1][idx] >= 0) interiorSym[dir].push_back(idx);
+      else boundarySym[dir].push_back(idx);
+    }
+
+  for(int idx=0;idx<geom.volume;idx++){
+    bool local = true;
+    for(int f=0;f<N_DISPLACE_FLAGS;f++) local = local && (nbr[f][idx] >= 0);
+    if(local) interiorAll.push_back(idx);
+    else boundaryAll.push_back(idx);
+  }
+}
+
+
+template <typename Float>
+void performCovariantDisplacementVectorHost(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile, MuGiqBool overlapComms){
+
+  if(src.Nspin() != N_SPIN_ || src.Ncolor() != N_COLOR_ || dst.Nspin() != N_SPIN_ || dst.Ncolor() != N_COLOR_)
+    errorQuda("%s: Displacements are supported only for Nspin = %d, Ncolor = %d fields\n", __func__, N_SPIN_, N_COLOR_);
+  if(&dst == &src) errorQuda("%s: Displacement cannot be performed in place\n", __func__);
+
+  const int dir = static_cast<int>(dispDir);
+  const int f = HostNbrTable::flagIndex(dispDir, dispSign);
+  const bool partitioned = table.geom.commDim[dir];
+  const bool dagger = (dispSign == DispSignMinus);
+  const int *nbr = table.nbr[f].data();
+
+  double t0 = hostTimer();
+
+  //- 1. Post the halo messages
+  if(partitioned) halo.start(src, dir, dispSign);
+  double t1 = hostTimer();
+  if(!overlapComms) halo.wait();
+  double t2 = hostTimer();
+
+  //- 2. Interior sites: U_d(x) * src(x+d), or U_d^\dag(x-d) * src(x-d) with the link stored on the neighbour
+  const int *intSite = table.interior[f].data();
+  const int nInt = static_cast<int>(table.interior[f].size());
+#pragma omp parallel for
+  for(int i=0;i<nInt;i++){
+    const int idx = intSite[i];
+    const int nIdx = nbr[idx];
+    std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+    linkTimesSpinor<Float>(dst.Site(idx), gauge.Link(dir, dagger ? nIdx : idx, ubuf), src.Site(nIdx), dagger);
+  }
+  double t3 = hostTimer();
+
+  //- 3. Wait for the halos
+  halo.wait();
+  double t4 = hostTimer();
+
+  //- 4. Boundary sites, the neighbour (and for dispSign = - the link) comes from the ghost zone
+  if(partitioned){
+    const int bnd = dagger ? static_cast<int>(MUGIQ_BOUNDARY_BACKWARD) : static_cast<int>(MUGIQ_BOUNDARY_FORWARD);
+    const int *bndSite = table.boundary[f].data();
+    const int nBnd = static_cast<int>(table.boundary[f].size());
+#pragma omp parallel for
+    for(int fIdx=0;fIdx<nBnd;fIdx++){
+      const int idx = bndSite[fIdx];
+      std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+      const std::complex<Float> *link = dagger ? gauge.GhostLink(dir, fIdx, ubuf) : gauge.Link(dir, idx, ubuf);
+      linkTimesSpinor<Float>(dst.Site(idx), link, src.GhostSite(dir, bnd, fIdx), dagger);
+    }
+  }
+  double t5 = hostTimer();
+
+  if(profile){
+    profile->pack     += t1 - t0;
+    profile->wait     += (t2 - t1) + (t4 - t3);
+    profile->interior += t3 - t2;
+    profile->boundary += t5 - t4;
+    profile->total    += t5 - t0;
+    profile->nCall++;
+  }
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+void performCovariantDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &dst,
+					    std::vector<HostColorSpinorField<Float>*> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSign dispSign,
+					    DisplaceProfile *profile, MuGiqBool overlapComms){
+
+  const int nVec = static_cast<int>(src.size());
+  if(static_cast<int>(dst.size()) != nVec) errorQuda("%s: Got %d source and %zu destination vectors\n", __func__, nVec, dst.size());
+  if(nVec == 0) return;
+  for(int iv=0;iv<nVec;iv++){
+    if(src[iv]->Nspin() != N_SPIN_ || src[iv]->Ncolor() != N_COLOR_ || dst[iv]->Nspin() != N_SPIN_ || dst[iv]->Ncolor() != N_COLOR_)
+      errorQuda("%s: Displacements are supported only for Nspin = %d, Ncolor = %d fields\n", __func__, N_SPIN_, N_COLOR_);
+    if(dst[iv] == src[iv]) errorQuda("%s: Displacement cannot be performed in place\n", __func__);
+  }
+
+  const int dir = static_cast<int>(dispDir);
+  const int f = HostNbrTable::flagIndex(dispDir, dispSign);
+  const bool partitioned = table.geom.commDim[dir];
+  const bool dagger = (dispSign == DispSignMinus);
+  const int *nbr = table.nbr[f].data();
+
+  double t0 = hostTimer();
+
+  //- 1. Post a single halo message for the whole batch
+  if(partitioned) halo.start(src, dir, dispSign);
+  double t1 = hostTimer();
+  if(!overlapComms) halo.wait();
+  double t2 = hostTimer();
+
+  //- 2. Interior sites, each link is loaded once and applied to all the vectors of the batch
+  const int *intSite = table.interior[f].data();
+  const int nInt = static_cast<int>(table.interior[f].size());
+#pragma omp parallel for
+  for(int i=0;i<nInt;i++){
+    const int idx = intSite[i];
+    const int nIdx = nbr[idx];
+    Float ur[N_COLOR_][N_COLOR_], ui[N_COLOR_][N_COLOR_];
+    std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+    loadLink<Float>(ur, ui, gauge.Link(dir, dagger ? nIdx : idx, ubuf), dagger);
+    for(int iv=0;iv<nVec;iv++) applyLink<Float>(dst[iv]->Site(idx), ur, ui, src[iv]->Site(nIdx));
+  }
+  double t3 = hostTimer();
+
+  //- 3. Wait for the halos
+  halo.wait();
+  double t4 = hostTimer();
+
+  //- 4. Boundary sites
+  if(partitioned){
+    const int bnd = dagger ? static_cast<int>(MUGIQ_BOUNDARY_BACKWARD) : static_cast<int>(MUGIQ_BOUNDARY_FORWARD);
+    const int *bndSite = table.boundary[f].data();
+    const int nBnd = static_cast<int>(table.boundary[f].size());
+#pragma omp parallel for
+    for(int fIdx=0;fIdx<nBnd;fIdx++){
+      const int idx = bndSite[fIdx];
+      Float ur[N_COLOR_][N_COLOR_], ui[N_COLOR_][N_COLOR_];
+      std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+      loadLink<Float>(ur, ui, dagger ? gauge.GhostLink(dir, fIdx, ubuf) : gauge.Link(dir, idx, ubuf), dagger);
+      for(int iv=0;iv<nVec;iv++) applyLink<Float>(dst[iv]->Site(idx), ur, ui, src[iv]->GhostSite(dir, bnd, fIdx));
+    }
+  }
+  double t5 = hostTimer();
+
+  if(profile){
+    profile->pack     += t1 - t0;
+    profile->wait     += (t2 - t1) + (t4 - t3);
+    profile->interior += t3 - t2;
+    profile->boundary += t5 - t4;
+    profile->total    += t5 - t0;
+    profile->nCall    += nVec;
+  }
+}
+//---------------------------------------------------------------------------
+
+
+//- Displace the vectors at site idx by +d and -d, a neighbour in the ghost zone is encoded as -(faceIndex+1)
+template <typename Float>
+inline static void symmetricDisplaceSite(std::vector<HostColorSpinorField<Float>*> &dstPlus,
+					 std::vector<HostColorSpinorField<Float>*> &dstMinus,
+					 std::vector<HostColorSpinorField<Float>*> &src,
+					 const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					 int dir, int idx, DisplaceSymType symType){
+  const int nP = table.nbr[2*dir][idx];
+  const int nM = table.nbr[2*dir+1][idx];
+  const int bndP = static_cast<int>(MUGIQ_BOUNDARY_FORWARD);
+  const int bndM = static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+
+  Float upr[N_COLOR_][N_COLOR_], upi[N_COLOR_][N_COLOR_];
+  Float umr[N_COLOR_][N_COLOR_], umi[N_COLOR_][N_COLOR_];
+  std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+  loadLink<Float>(upr, upi, gauge.Link(dir, idx, ubuf), false);
+  loadLink<Float>(umr, umi, (nM >= 0) ? gauge.Link(dir, nM, ubuf) : gauge.GhostLink(dir, -(nM+1), ubuf), true);
+
+  for(size_t iv=0;iv<src.size();iv++){
+    const std::complex<Float> *vP = (nP >= 0) ? src[iv]->Site(nP) : src[iv]->GhostSite(dir, bndP, -(nP+1));
+    const std::complex<Float> *vM = (nM >= 0) ? src[iv]->Site(nM) : src[iv]->GhostSite(dir, bndM, -(nM+1));
+    if(symType == DISPLACE_SYM_PAIR){
+      applyLink<Float>(dstPlus[iv]->Site(idx), upr, upi, vP);
+      applyLink<Float>(dstMinus[iv]->Site(idx), umr, umi, vM);
+    }
+    else{
+      std::complex<Float> wP[SPINOR_SITE_LEN_], wM[SPINOR_SITE_LEN_];
+      applyLink<Float>(wP, upr, upi, vP);
+      applyLink<Float>(wM, umr, umi, vM);
+      std::complex<Float> *d = dstPlus[iv]->Site(idx);
+      for(int i=0;i<SPINOR_SITE_LEN_;i++) d[i] = (wP[i] - wM[i]) * static_cast<Float>(0.5);
+    }
+  }
+}
+
+
+template <typename Float>
+void performSymmetricDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &dstPlus,
+					    std::vector<HostColorSpinorField<Float>*> &dstMinus,
+					    std::vector<HostColorSpinorField<Float>*> &src,
+					    const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+					    HostHaloExchange<Float> &halo,
+					    DisplaceDir dispDir, DisplaceSymType symType,
+					    DisplaceProfile *profile, MuGiqBool overlapComms){
+
+  if(symType != DISPLACE_SYM_PAIR && symType != DISPLACE_SYM_DERIV)
+    errorQuda("%s: Unsupported symmetric displacement type %d\n", __func__, static_cast<int>(symType));
+  const bool pair = (symType == DISPLACE_SYM_PAIR);
+  const int nVec = static_cast<int>(src.size());
+  if(static_cast<int>(dstPlus.size()) != nVec || (pair && static_cast<int>(dstMinus.size()) != nVec))
+    errorQuda("%s: Got %d source and %zu,%zu destination vectors\n", __func__, nVec, dstPlus.size(), dstMinus.size());
+  if(nVec == 0) return;
+  for(int iv=0;iv<nVec;iv++){
+    if(src[iv]->Nspin() != N_SPIN_ || src[iv]->Ncolor() != N_COLOR_ || dstPlus[iv]->Nspin() != N_SPIN_ || dstPlus[iv]->Ncolor() != N_COLOR_ ||
+       (pair && (dstMinus[iv]->Nspin() != N_SPIN_ || dstMinus[iv]->Ncolor() != N_COLOR_)))
+      errorQuda("%s: Displacements are supported only for Nspin = %d, Ncolor = %d fields\n", __func__, N_SPIN_, N_COLOR_);
+    if(dstPlus[iv] == src[iv] || (pair && (dstMinus[iv] == src[iv] || dstMinus[iv] == dstPlus[iv])))
+      errorQuda("%s: Displacement cannot be performed in place\n", __func__);
+  }
+
+  const int dir = static_cast<int>(dispDir);
+  const bool partitioned = table.geom.commDim[dir];
+
+  double t0 = hostTimer();
+
+  //- 1. Post the halo messages of both directions for the whole batch
+  if(partitioned){
+    halo.start(src, dir, DispSignPlus);
+    halo.start(src, dir, DispSignMinus);
+  }
+  double t1 = hostTimer();
+  if(!overlapComms) halo.wait();
+  double t2 = hostTimer();
+
+  //- 2. Interior sites, both neighbours are local
+  const int *intSite = table.interiorSym[dir].data();
+  const int nInt = static_cast<int>(table.interiorSym[dir].size());
+#pragma omp parallel for
+  for(int i=0;i<nInt;i++) symmetricDisplaceSite<Float>(dstPlus, dstMinus, src, gauge, table, dir, intSite[i], symType);
+  double t3 = hostTimer();
+
+  //- 3. Wait for the halos of both directions
+  halo.wait();
+  double t4 = hostTimer();
+
+  //- 4. Boundary sites, at least one neighbour (and for -d possibly the link) comes from the ghost zone
+  const int *bndSite = table.boundarySym[dir].data();
+  const int nBnd = static_cast<int>(table.boundarySym[dir].size());
+#pragma omp parallel for
+  for(int i=0;i<nBnd;i++) symmetricDisplaceSite<Float>(dstPlus, dstMinus, src, gauge, table, dir, bndSite[i], symType);
+  double t5 = hostTimer();
+
+  if(profile){
+    profile->pack     += t1 - t0;
+    profile->wait     += (t2 - t1) + (t4 - t3);
+    profile->interior += t3 - t2;
+    profile->boundary += t5 - t4;
+    profile->total    += t5 - t0;
+    profile->nCall    += 2*nVec;
+  }
+}
+//---------------------------------------------------------------------------
+
+
+//- Gather the transported neighbours of site idx along all the flags into w, see HostStarSink
+template <typename Float>
+inline static void starDisplaceSite(std::complex<Float> *w, std::vector<HostColorSpinorField<Float>*> &src,
+				    const std::vector<DisplaceFlag> &flags, const HostGaugeField<Float> &gauge,
+				    const HostNbrTable &table, int idx){
+  const int nVec = static_cast<int>(src.size());
+  for(size_t i=0;i<flags.size();i++){
+    const int f = static_cast<int>(flags[i]);
+    const int dir = f / 2;
+    const bool dagger = (f % 2 == 1);
+    const int bnd = dagger ? static_cast<int>(MUGIQ_BOUNDARY_BACKWARD) : static_cast<int>(MUGIQ_BOUNDARY_FORWARD);
+    const int nIdx = table.nbr[f][idx];
+
+    Float ur[N_COLOR_][N_COLOR_], ui[N_COLOR_][N_COLOR_];
+    std::complex<Float> ubuf[GAUGE_SITE_LEN_];
+    const std::complex<Float> *link = nullptr;
+    if(!dagger) link = gauge.Link(dir, idx, ubuf);
+    else link = (nIdx >= 0) ? gauge.Link(dir, nIdx, ubuf) : gauge.GhostLink(dir, -(nIdx+1), ubuf);
+    loadLink<Float>(ur, ui, link, dagger);
+
+    for(int iv=0;iv<nVec;iv++){
+      const std::complex<Float> *vec = (nIdx >= 0) ? src[iv]->Site(nIdx) : src[iv]->GhostSite(dir, bnd, -(nIdx+1));
+      applyLink<Float>(w + (i*nVec + iv)*SPINOR_SITE_LEN_, ur, ui, vec);
+    }
+  }
+}
+
+
+template <typename Float>
+void performStarDisplacementVectorHost(std::vector<HostColorSpinorField<Float>*> &src, const std::vector<DisplaceFlag> &flags,
+				       HostStarSink<Float> &sink,
+				       const HostGaugeField<Float> &gauge, const HostNbrTable &table,
+				       HostHaloExchange<Float> &halo,
+				       DisplaceProfile *profile, MuGiqBool overlapComms){
+
+  const int nVec = static_cast<int>(src.size());
+  const int nFlag = static_cast<int>(flags.size());
+  if(nVec == 0 || nFlag == 0) return;
+  for(int iv=0;iv<nVec;iv++)
+    if(src[iv]->Nspin() != N_SPIN_ || src[iv]->Ncolor() != N_COLOR_)
+      errorQuda("%s: Displacements are supported only for Nspin = %d, Ncolor = %d fields\n", __func__, N_SPIN_, N_COLOR_);
+  for(int i=0;i<nFlag;i++){
+    const int f = static_cast<int>(flags[i]);
+    if(f < 0 || f >= N_DISPLACE_FLAGS) errorQuda("%s: Invalid displacement flag %d\n", __func__, f);
+    for(int j=0;j<i;j++) if(flags[j] == flags[i]) errorQuda("%s: Displacement flag %d is given twice\n", __func__, f);
+  }
+
+  double t0 = hostTimer();
+
+  //- 1. Post the halo messages of all the flags for the whole batch
+  for(auto flag: flags){
+    const int dir = static_cast<int>(flag) / 2;
+    if(table.geom.commDim[dir]) halo.start(src, dir, (static_cast<int>(flag) % 2 == 0) ? DispSignPlus : DispSignMinus);
+  }
+  double t1 = hostTimer();
+  if(!overlapComms) halo.wait();
+  double t2 = hostTimer();
+
+  const size_t wLen = static_cast<size_t>(nFlag) * nVec * SPINOR_SITE_LEN_;
+
+  //- 2. Interior sites, all neighbours are local
+  const int *intSite = table.interiorAll.data();
+  const int nInt = static_cast<int>(table.interiorAll.size());
+#pragma omp parallel
+  {
+    std::vector<std::complex<Float>> w(wLen);
+#pragma omp for
+    for(int i=0;i<nInt;i++){
+      starDisplaceSite<Float>(w.data(), src, flags, gauge, table, intSite[i]);
+      sink.site(intSite[i], w.data());
+    }
+  }
+  double t3 = hostTimer();
+
+  //- 3. Wait for the halos of all the flags
+  halo.wait();
+  double t4 = hostTimer();
+
+  //- 4. Sites with a neighbour in the ghost zone
+  const int *bndSite = table.boundaryAll.data();
+  const int nBnd = static_cast<int>(table.boundaryAll.size());
+#pragma omp parallel
+  {
+    std::vector<std::complex<Float>> w(wLen);
+#pragma omp for
+    for(int i=0;i<nBnd;i++){
+      starDisplaceSite<Float>(w.data(), src, flags, gauge, table, bndSite[i]);
+      sink.site(bndSite[i], w.data());
+    }
+  }
+  double t5 = hostTimer();
+
+  if(profile){
+    profile->pack     += t1 - t0;
+    profile->wait     += (t2 - t1) + (t4 - t3);
+    profile->interior += t3 - t2;
+    profile->boundary += t5 - t4;
+    profile->total    += t5 - t0;
+    profile->nCall    += nFlag*nVec;
+  }
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+DisplaceHost<Float>::DisplaceHost(const HostGeom &geom_, void *gaugePtr[], QudaPrecision cpuPrec, MuGiqBool overlapComms_,
+				  QudaReconstructType recon) :
+  geom(geom_),
+  gauge(nullptr),
+  nbrTable(geom_),
+  overlapComms(overlapComms_),
+  useNbrTable(MUGIQ_BOOL_TRUE),
+  batchSize(DISPLACE_BATCH_HOST_)
+{
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+  gauge = new HostGaugeField<Float>(geom, gaugePtr, cpuPrec, recon);
+  printfQuda("%s: Host gauge field for displacements created (%d reals per link, %.1f MB), halo exchange will%s overlap with the interior stencil\n",
+	     __func__, 2*gauge->LinkLength(), gauge->Bytes() / (1024.0*1024.0), overlapComms ? "" : " NOT");
+}
+
+
+template <typename Float>
+DisplaceHost<Float>::~DisplaceHost(){
+  if(gauge) delete gauge;
+  gauge = nullptr;
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::loadGauge(void *gaugePtr[], QudaPrecision cpuPrec){
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+  gauge->loadGauge(gaugePtr, cpuPrec);
+  if(!wLine.empty()) computeWilsonLines();
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doVectorDisplacement(HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+					       DisplaceDir dispDir, DisplaceSign dispSign){
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+  if(useNbrTable)
+    performCovariantDisplacementVectorHost<Float>(dst, src, *gauge, nbrTable, halo, dispDir, dispSign, &profile, overlapComms);
+  else
+    performCovariantDisplacementVectorHost<Float>(dst, src, *gauge, halo, dispDir, dispSign, &profile, overlapComms);
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doVectorDisplacement(std::vector<HostColorSpinorField<Float>*> &dst,
+					       std::vector<HostColorSpinorField<Float>*> &src,
+					       DisplaceDir dispDir, DisplaceSign dispSign){
+  if(dst.size() != src.size()) errorQuda("%s: Got %zu source and %zu destination vectors\n", __func__, src.size(), dst.size());
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+  for(size_t i0=0;i0<src.size();i0+=batchSize){
+    const size_t i1 = std::min(src.size(), i0 + batchSize);
+    std::vector<HostColorSpinorField<Float>*> dstB(dst.begin()+i0, dst.begin()+i1);
+    std::vector<HostColorSpinorField<Float>*> srcB(src.begin()+i0, src.begin()+i1);
+    performCovariantDisplacementVectorHost<Float>(dstB, srcB, *gauge, nbrTable, halo, dispDir, dispSign, &profile, overlapComms);
+  }
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doVectorHop(std::vector<HostColorSpinorField<Float>*> &vec,
+				      std::vector<HostColorSpinorField<Float>*> &spare,
+				      DisplaceDir dispDir, DisplaceSign dispSign){
+  if(spare.size() != vec.size()) errorQuda("%s: Got %zu vectors and %zu spare buffers\n", __func__, vec.size(), spare.size());
+  doVectorDisplacement(spare, vec, dispDir, dispSign);
+  vec.swap(spare);
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doSymmetricDisplacement(std::vector<HostColorSpinorField<Float>*> &dstPlus,
+						  std::vector<HostColorSpinorField<Float>*> &dstMinus,
+						  std::vector<HostColorSpinorField<Float>*> &src,
+						  DisplaceDir dispDir, DisplaceSymType symType){
+  const bool pair = (symType == DISPLACE_SYM_PAIR);
+  if(dstPlus.size() != src.size() || (pair && dstMinus.size() != src.size()))
+    errorQuda("%s: Got %zu source and %zu,%zu destination vectors\n", __func__, src.size(), dstPlus.size(), dstMinus.size());
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+  for(size_t i0=0;i0<src.size();i0+=batchSize){
+    const size_t i1 = std::min(src.size(), i0 + batchSize);
+    std::vector<HostColorSpinorField<Float>*> dstPB(dstPlus.begin()+i0, dstPlus.begin()+i1);
+    std::vector<HostColorSpinorField<Float>*> dstMB;
+    if(pair) dstMB.assign(dstMinus.begin()+i0, dstMinus.begin()+i1);
+    std::vector<HostColorSpinorField<Float>*> srcB(src.begin()+i0, src.begin()+i1);
+    performSymmetricDisplacementVectorHost<Float>(dstPB, dstMB, srcB, *gauge, nbrTable, halo, dispDir, symType, &profile, overlapComms);
+  }
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doStarDisplacement(std::vector<HostColorSpinorField<Float>*> &src, const std::vector<DisplaceFlag> &flags,
+					     HostStarSink<Float> &sink){
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+  performStarDisplacementVectorHost<Float>(src, flags, sink, *gauge, nbrTable, halo, &profile, overlapComms);
+}
+
+
+template <typename Float>
+int DisplaceHost<Float>::findWilsonLine(DisplaceFlag flag, int length) const {
+  for(size_t i=0;i<wLine.size();i++)
+    if(wLine[i].flag == flag && wLine[i].length == length) return static_cast<int>(i);
+  return -1;
+}
+
+
+template <typename Float>
+bool DisplaceHost<Float>::addWilsonLine(DisplaceFlag flag, int length){
+  if(static_cast<int>(flag) < 0 || static_cast<int>(flag) >= N_DISPLACE_FLAGS || length < 1)
+    errorQuda("%s: Invalid Wilson line, flag %d and length %d\n", __func__, static_cast<int>(flag), length);
+  const int dir = static_cast<int>(flag) / 2;
+  if(geom.commDim[dir] && length > geom.lL[dir]) return false;
+  if(findWilsonLine(flag, length) < 0) wLine.push_back({flag, length, std::vector<std::complex<Float>>()});
+  return true;
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::computeWilsonLines(){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+
+  //- The columns of the Wilson line are displaced as the first three spins of a color-spinor field:
+  //- starting from the unit matrix, each hop gives W_l(x) = U_d(x) W_{l-1}(x+d)
+  HostColorSpinorField<Float> wA(geom);
+  HostColorSpinorField<Float> wB(geom);
+
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    int maxLen = 0;
+    for(const auto &wl: wLine) if(static_cast<int>(wl.flag) == f) maxLen = std::max(maxLen, wl.length);
+    if(maxLen == 0) continue;
+
+    const DisplaceDir  dispDir  = static_cast<DisplaceDir>(f / 2);
+    const DisplaceSign dispSign = (f % 2 == 0) ? DispSignPlus : DispSignMinus;
+
+    HostColorSpinorField<Float> *w = &wA;
+    HostColorSpinorField<Float> *wTmp = &wB;
+    w->zero();
+#pragma omp parallel for
+    for(int idx=0;idx<geom.volume;idx++)
+      for(int c=0;c<N_COLOR_;c++) w->Site(idx)[SPINOR_SITE_IDX(c,c)] = 1.0;
+
+    for(int l=1;l<=maxLen;l++){
+      doVectorDisplacement(*wTmp, *w, dispDir, dispSign);
+      std::swap(w, wTmp);
+
+      const int iw = findWilsonLine(static_cast<DisplaceFlag>(f), l);
+      if(iw < 0) continue;
+      std::vector<std::complex<Float>> &W = wLine[iw].W;
+      W.resize(static_cast<size_t>(geom.volume) * GAUGE_SITE_LEN_);
+#pragma omp parallel for
+      for(int idx=0;idx<geom.volume;idx++)
+	for(int c1=0;c1<N_COLOR_;c1++)
+	  for(int c2=0;c2<N_COLOR_;c2++)
+	    W[static_cast<size_t>(idx)*GAUGE_SITE_LEN_ + GAUGE_SITE_IDX(c1,c2)] = w->Site(idx)[SPINOR_SITE_IDX(c2,c1)];
+    }
+  }
+
+  printfQuda("%s: %zu Wilson lines computed, %.1f MB\n", __func__, wLine.size(), WilsonLineBytes() / (1024.0*1024.0));
+}
+
+
+template <typename Float>
+void DisplaceHost<Float>::doWilsonLineDisplacement(std::vector<HostColorSpinorField<Float>*> &dst,
+						   std::vector<HostColorSpinorField<Float>*> &src,
+						   DisplaceFlag flag, int length, MuGiqBool exchange){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_DISPLACE_HALO);
+
+  const int iw = findWilsonLine(flag, length);
+  if(iw < 0 || wLine[iw].W.empty())
+    errorQuda("%s: Wilson line %s of length %d has not been computed\n", __func__, displaceFlagString(flag).c_str(), length);
+  const int nVec = static_cast<int>(src.size());
+  if(static_cast<int>(dst.size()) != nVec) errorQuda("%s: Got %d source and %zu destination vectors\n", __func__, nVec, dst.size());
+  if(nVec == 0) return;
+
+  const int dir = static_cast<int>(flag) / 2;
+  const bool plus = (static_cast<int>(flag) % 2 == 0);
+  const int bnd = plus ? static_cast<int>(MUGIQ_BOUNDARY_FORWARD) : static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+  const bool partitioned = geom.commDim[dir];
+  const std::complex<Float> *W = wLine[iw].W.data();
+
+  double t0 = hostTimer();
+
+  //- A single halo exchange of depth length for the whole block
+  if(partitioned){
+    if(exchange){
+      halo.start(src, dir, plus ? DispSignPlus : DispSignMinus, length);
+      halo.wait();
+    }
+    else
+      for(auto v: src)
+	if(v->GhostDepth(dir, bnd) < length)
+	  errorQuda("%s: Ghost depth %d is smaller than the length %d\n", __func__, v->GhostDepth(dir, bnd), length);
+  }
+  double t1 = hostTimer();
+
+  //- dst(x) = W(x) src(x + length*d), the source site may lie in the ghost zone, layer = distance from the boundary minus one
+#pragma omp parallel for
+  for(int idx=0;idx<geom.volume;idx++){
+    const int pty = idx / geom.volumeCB;
+    int x[N_DIM_];
+    geom.getCoords(x, idx - pty*geom.volumeCB, pty);
+    const int fIdx = geom.faceIndex(x, dir);
+    int y = x[dir] + (plus ? length : -length);
+
+    int gIdx = -1;
+    if(y < 0 || y >= geom.lL[dir]){
+      if(partitioned) gIdx = fIdx + geom.faceVolume[dir] * (plus ? y - geom.lL[dir] : -1 - y);
+      else y = ((y % geom.lL[dir]) + geom.lL[dir]) % geom.lL[dir];
+    }
+    x[dir] = y;
+    const int nIdx = (gIdx < 0) ? geom.siteIndex(x) : -1;
+
+    Float ur[N_COLOR_][N_COLOR_], ui[N_COLOR_][N_COLOR_];
+    loadLink<Float>(ur, ui, W + static_cast<size_t>(idx)*GAUGE_SITE_LEN_, false);
+    for(int iv=0;iv<nVec;iv++){
+      const std::complex<Float> *vec = (gIdx < 0) ? src[iv]->Site(nIdx) : src[iv]->GhostSite(dir, bnd, gIdx);
+      applyLink<Float>(dst[iv]->Site(idx), ur, ui, vec);
+    }
+  }
+  double t2 = hostTimer();
+
+  profile.wait     += t1 - t0;
+  profile.interior += t2 - t1;
+  profile.total    += t2 - t0;
+  profile.nCall    += nVec;
+}
+
+
+template void performCovariantDisplacementVectorHost<float>(HostColorSpinorField<float> &dst, HostColorSpinorField<float> &src,
+							    const HostGaugeField<float> &gauge, HostHaloExchange<float> &halo,
+							    DisplaceDir dispDir, DisplaceSign dispSign,
+							    DisplaceProfile *profile, MuGiqBool overlapComms);
+template void performCovariantDisplacementVectorHost<double>(HostColorSpinorField<double> &dst, HostColorSpinorField<double> &src,
+							     const HostGaugeField<double> &gauge, HostHaloExchange<double> &halo,
+							     DisplaceDir dispDir, DisplaceSign dispSign,
+							     DisplaceProfile *profile, MuGiqBool overlapComms);
+
+template void performCovariantDisplacementVectorHost<float>(HostColorSpinorField<float> &dst, HostColorSpinorField<float> &src,
+							    const HostGaugeField<float> &gauge, const HostNbrTable &table,
+							    HostHaloExchange<float> &halo,
+							    DisplaceDir dispDir, DisplaceSign dispSign,
+							    DisplaceProfile *profile, MuGiqBool overlapComms);
+template void performCovariantDisplacementVectorHost<double>(HostColorSpinorField<double> &dst, HostColorSpinorField<double> &src,
+							     const HostGaugeField<double> &gauge, const HostNbrTable &table,
+							     HostHaloExchange<double> &halo,
+							     DisplaceDir dispDir, DisplaceSign dispSign,
+							     DisplaceProfile *profile, MuGiqBool overlapComms);
+
+template void performCovariantDisplacementVectorHost<float>(std::vector<HostColorSpinorField<float>*> &dst,
+							    std::vector<HostColorSpinorField<float>*> &src,
+							    const HostGaugeField<float> &gauge, const HostNbrTable &table,
+							    HostHaloExchange<float> &halo,
+							    DisplaceDir dispDir, DisplaceSign dispSign,
+							    DisplaceProfile *profile, MuGiqBool overlapComms);
+template void performCovariantDisplacementVectorHost<double>(std::vector<HostColorSpinorField<double>*> &dst,
+							     std::vector<HostColorSpinorField<double>*> &src,
+							     const HostGaugeField<double> &gauge, const HostNbrTable &table,
+							     HostHaloExchange<double> &halo,
+							     DisplaceDir dispDir, DisplaceSign dispSign,
+							     DisplaceProfile *profile, MuGiqBool overlapComms);
+
+template void performSymmetricDisplacementVectorHost<float>(std::vector<HostColorSpinorField<float>*> &dstPlus,
+							    std::vector<HostColorSpinorField<float>*> &dstMinus,
+							    std::vector<HostColorSpinorField<float>*> &src,
+							    const HostGaugeField<float> &gauge, const HostNbrTable &table,
+							    HostHaloExchange<float> &halo,
+							    DisplaceDir dispDir, DisplaceSymType symType,
+							    DisplaceProfile *profile, MuGiqBool overlapComms);
+template void performSymmetricDisplacementVectorHost<double>(std::vector<HostColorSpinorField<double>*> &dstPlus,
+							     std::vector<HostColorSpinorField<double>*> &dstMinus,
+							     std::vector<HostColorSpinorField<double>*> &src,
+							     const HostGaugeField<double> &gauge, const HostNbrTable &table,
+							     HostHaloExchange<double> &halo,
+							     DisplaceDir dispDir, DisplaceSymType symType,
+							     DisplaceProfile *profile, MuGiqBool overlapComms);
+
+template void performStarDisplacementVectorHost<float>(std::vector<HostColorSpinorField<float>*> &src,
+						       const std::vector<DisplaceFlag> &flags, HostStarSink<float> &sink,
+						       const HostGaugeField<float> &gauge, const HostNbrTable &table,
+						       HostHaloExchange<float> &halo,
+						       DisplaceProfile *profile, MuGiqBool overlapComms);
+template void performStarDisplacementVectorHost<double>(std::vector<HostColorSpinorField<double>*> &src,
+							const std::vector<DisplaceFlag> &flags, HostStarSink<double> &sink,
+							const HostGaugeField<double> &gauge, const HostNbrTable &table,
+							HostHaloExchange<double> &halo,
+							DisplaceProfile *profile, MuGiqBool overlapComms);
+
+template class DisplaceHost<float>;
+template class DisplaceHost<double>;
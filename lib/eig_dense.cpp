@@ -0,0 +1,220 @@
+#include <eig_dense.h>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+#ifdef MUGIQ_LAPACK
+extern "C" void zheevr_(const char *jobz, const char *range, const char *uplo, const int *n, std::complex<double> *a,
+			const int *lda, const double *vl, const double *vu, const int *il, const int *iu, const double *abstol,
+			int *m, double *w, std::complex<double> *z, const int *ldz, int *isuppz, std::complex<double> *work,
+			const int *lwork, double *rwork, const int *lrwork, int *iwork, const int *liwork, int *info);
+#endif
+
+
+#ifdef MUGIQ_LAPACK
+
+//- Eigenpairs il..iu (1-based, ascending), or all of them if il == 0, with LAPACK's MRRR solver
+static void eigHermitianLapack(int n, std::vector<std::complex<double>> &A, int il, int iu,
+			       std::vector<double> &w, std::vector<std::complex<double>> &Z){
+
+  const char jobz = 'V', range = (il > 0) ? 'I' : 'A', uplo = 'L';
+  const double vl = 0.0, vu = 0.0, abstol = std::numeric_limits<double>::min();
+  int m = 0, info = 0;
+  w.resize(n);
+  Z.resize(static_cast<size_t>(n) * (il > 0 ? iu - il + 1 : n));
+  std::vector<int> isuppz(2*n);
+
+  //- Workspace query
+  int lwork = -1, lrwork = -1, liwork = -1;
+  std::complex<double> workQ;
+  double rworkQ;
+  int iworkQ;
+  zheevr_(&jobz, &range, &uplo, &n, A.data(), &n, &vl, &vu, &il, &iu, &abstol, &m, w.data(), Z.data(), &n, isuppz.data(),
+	  &workQ, &lwork, &rworkQ, &lrwork, &iworkQ, &liwork, &info);
+  lwork = static_cast<int>(workQ.real());
+  lrwork = static_cast<int>(rworkQ);
+  liwork = iworkQ;
+  std::vector<std::complex<double>> work(lwork);
+  std::vector<double> rwork(lrwork);
+  std::vector<int> iwork(liwork);
+
+  zheevr_(&jobz, &range, &uplo, &n, A.data(), &n, &vl, &vu, &il, &iu, &abstol, &m, w.data(), Z.data(), &n, isuppz.data(),
+	  work.data(), &lwork, rwork.data(), &lrwork, iwork.data(), &liwork, &info);
+  if(info != 0) errorQuda("%s: zheevr failed with info = %d\n", __func__, info);
+  w.resize(m);
+}
+
+#else
+
+//- All the eigenpairs, in ascending order, with the cyclic Jacobi method: every rotation zeroes an off-diagonal element
+//- after the phase of the element has been rotated away
+static void eigHermitianJacobi(int n, std::vector<std::complex<double>> &A,
+			       std::vector<double> &w, std::vector<std::complex<double>> &Z){
+
+  auto a = [&](int r, int c) -> std::complex<double>& { return A[static_cast<size_t>(c)*n + r]; };
+  std::vector<std::complex<double>> V(static_cast<size_t>(n) * n, 0.0);
+  for(int i=0;i<n;i++) V[static_cast<size_t>(i)*n + i] = 1.0;
+
+  const double eps = std::numeric_limits<double>::epsilon();
+  double norm = 0.0;
+  for(const auto &x: A) norm += std::norm(x);
+  const double tolOff = static_cast<double>(n) * n * eps * eps * norm;
+  const int maxSweep = 60;
+
+  int sweep = 0;
+  for(;sweep<maxSweep;sweep++){
+    double off = 0.0;
+    for(int q=1;q<n;q++)
+      for(int p=0;p<q;p++) off += std::norm(a(p,q));
+    if(off <= tolOff) break;
+
+    for(int p=0;p<n-1;p++)
+      for(int q=p+1;q<n;q++){
+	const double mag = std::abs(a(p,q));
+	const double app = a(p,p).real(), aqq = a(q,q).real();
+	if(mag <= eps * std::sqrt(std::abs(app*aqq)) || mag == 0.0){
+	  a(p,q) = a(q,p) = 0.0;
+	  continue;
+	}
+	const std::complex<double> ec = std::conj(a(p,q) / mag);
+	const double theta = (aqq - app) / (2.0*mag);
+	const double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta*theta + 1.0));
+	const double c = 1.0 / std::sqrt(t*t + 1.0), s = t*c;
+
+	//- A = J^dag A J and V = V J, with J = diag(1, conj(e)) times the real rotation of the (p,q) plane
+	for(int k=0;k<n;k++){
+	  const std::complex<double> akp = a(k,p), akq = a(k,q);
+	  a(k,p) = c*akp - s*ec*akq;
+	  a(k,q) = s*akp + c*ec*akq;
+	}
+	for(int k=0;k<n;k++){
+	  const std::complex<double> apk = a(p,k), aqk = a(q,k);
+	  a(p,k) = c*apk - s*std::conj(ec)*aqk;
+	  a(q,k) = s*apk + c*std::conj(ec)*aqk;
+	}
+	std::complex<double> *vp = &V[static_cast<size_t>(p)*n], *vq = &V[static_cast<size_t>(q)*n];
+	for(int k=0;k<n;k++){
+	  const std::complex<double> vkp = vp[k], vkq = vq[k];
+	  vp[k] = c*vkp - s*ec*vkq;
+	  vq[k] = s*vkp + c*ec*vkq;
+	}
+	a(p,q) = a(q,p) = 0.0;
+	a(p,p) = a(p,p).real();
+	a(q,q) = a(q,q).real();
+      }
+  }
+  if(sweep == maxSweep) warningQuda("%s: The Jacobi sweeps did not converge in %d sweeps\n", __func__, maxSweep);
+
+  std::vector<int> idx(n);
+  std::iota(idx.begin(), idx.end(), 0);
+  std::sort(idx.begin(), idx.end(), [&](int i, int j){ return a(i,i).real() < a(j,j).real(); });
+  w.resize(n);
+  Z.resize(static_cast<size_t>(n) * n);
+  for(int k=0;k<n;k++){
+    w[k] = a(idx[k],idx[k]).real();
+    std::copy(V.begin() + static_cast<size_t>(idx[k])*n, V.begin() + static_cast<size_t>(idx[k]+1)*n,
+	      Z.begin() + static_cast<size_t>(k)*n);
+  }
+}
+
+#endif
+
+
+void denseEigHermitian(int n, std::vector<std::complex<double>> &A, MuGiqEigSpectrum spec, int nEv,
+		       std::vector<double> &w, std::vector<std::complex<double>> &Z){
+
+  if(static_cast<long long>(A.size()) != static_cast<long long>(n) * n)
+    errorQuda("%s: Got %zu matrix elements for dimension %d\n", __func__, A.size(), n);
+  if(nEv < 1 || nEv > n) errorQuda("%s: Cannot compute %d eigenpairs of a matrix of dimension %d\n", __func__, nEv, n);
+
+  //- Hermiticity of the assembled operator, the solvers read only one triangle
+  double maxA = 0.0, dev = 0.0;
+  for(int c=0;c<n;c++)
+    for(int r=0;r<=c;r++){
+      maxA = std::max(maxA, std::abs(A[static_cast<size_t>(c)*n + r]));
+      dev = std::max(dev, std::abs(A[static_cast<size_t>(c)*n + r] - std::conj(A[static_cast<size_t>(r)*n + c])));
+    }
+  if(dev > 1e-5 * maxA) warningQuda("%s: The matrix is not Hermitian, max |A - A^dag| = %e of max |A| = %e\n", __func__, dev, maxA);
+
+  //- Eigenpairs in ascending order: the ends of the spectrum only for SR and LR, all of them for SM and LM
+  std::vector<double> wAll;
+  std::vector<std::complex<double>> ZAll;
+#ifdef MUGIQ_LAPACK
+  int il = 0, iu = 0;
+  if(spec == MUGIQ_SPECTRUM_SR){ il = 1; iu = nEv; }
+  else if(spec == MUGIQ_SPECTRUM_LR){ il = n - nEv + 1; iu = n; }
+  eigHermitianLapack(n, A, il, iu, wAll, ZAll);
+#else
+  eigHermitianJacobi(n, A, wAll, ZAll);
+#endif
+
+  const int m = static_cast<int>(wAll.size());
+  std::vector<int> idx(m);
+  std::iota(idx.begin(), idx.end(), 0);
+  switch(spec){
+  case MUGIQ_SPECTRUM_SR: break;
+  case MUGIQ_SPECTRUM_LR: std::reverse(idx.begin(), idx.end()); break;
+  case MUGIQ_SPECTRUM_SM: std::stable_sort(idx.begin(), idx.end(), [&](int i, int j){ return std::abs(wAll[i]) < std::abs(wAll[j]); }); break;
+  case MUGIQ_SPECTRUM_LM: std::stable_sort(idx.begin(), idx.end(), [&](int i, int j){ return std::abs(wAll[i]) > std::abs(wAll[j]); }); break;
+  default: errorQuda("%s: Unsupported part of the spectrum %d\n", __func__, static_cast<int>(spec));
+  }
+  if(m < nEv) errorQuda("%s: Got %d eigenpairs, %d requested\n", __func__, m, nEv);
+
+  w.resize(nEv);
+  Z.resize(static_cast<size_t>(n) * nEv);
+  for(int k=0;k<nEv;k++){
+    w[k] = wAll[idx[k]];
+    std::copy(ZAll.begin() + static_cast<size_t>(idx[k])*n, ZAll.begin() + static_cast<size_t>(idx[k]+1)*n,
+	      Z.begin() + static_cast<size_t>(k)*n);
+  }
+}
+
+
+void denseEigDistributed(int localLen, std::vector<std::complex<double>> &Aloc, MuGiqEigSpectrum spec, int nEv,
+			 std::vector<double> &w, std::vector<std::complex<double>> &Zloc, MPI_Comm comm){
+
+  int rank = 0, nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  int lenMin = localLen, lenMax = localLen;
+  MPI_Allreduce(MPI_IN_PLACE, &lenMin, 1, MPI_INT, MPI_MIN, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &lenMax, 1, MPI_INT, MPI_MAX, comm);
+  if(lenMin != lenMax) errorQuda("%s: The processes hold %d to %d rows, they must hold the same number\n", __func__, lenMin, lenMax);
+
+  const int n = localLen * nRanks;
+  if(static_cast<long long>(Aloc.size()) != static_cast<long long>(localLen) * n)
+    errorQuda("%s: Got %zu local matrix elements for %d rows of dimension %d\n", __func__, Aloc.size(), localLen, n);
+  if(nEv < 1 || nEv > n) errorQuda("%s: Cannot compute %d eigenpairs of a matrix of dimension %d\n", __func__, nEv, n);
+
+  //- The rows of each process are a strided block of the columns of the global matrix: localLen complex numbers
+  //- every n, and the block of process r starts at row r*localLen
+  const int root = 0;
+  auto rowBlockType = [&](int nCol){
+    MPI_Datatype vec, blk;
+    MPI_Type_vector(nCol, 2*localLen, 2*n, MPI_DOUBLE, &vec);
+    MPI_Type_create_resized(vec, 0, 2*localLen*sizeof(double), &blk);
+    MPI_Type_commit(&blk);
+    MPI_Type_free(&vec);
+    return blk;
+  };
+
+  std::vector<std::complex<double>> A, Z;
+  if(rank == root) A.resize(static_cast<size_t>(n) * n);
+  MPI_Datatype aRows = rowBlockType(n);
+  MPI_Gather(Aloc.data(), 2*localLen*n, MPI_DOUBLE, A.data(), 1, aRows, root, comm);
+  MPI_Type_free(&aRows);
+
+  w.resize(nEv);
+  if(rank == root){
+    denseEigHermitian(n, A, spec, nEv, w, Z);
+    std::vector<std::complex<double>>().swap(A);
+  }
+
+  Zloc.resize(static_cast<size_t>(localLen) * nEv);
+  MPI_Datatype zRows = rowBlockType(nEv);
+  MPI_Scatter(Z.data(), 1, zRows, Zloc.data(), 2*localLen*nEv, MPI_DOUBLE, root, comm);
+  MPI_Type_free(&zRows);
+  MPI_Bcast(w.data(), nEv, MPI_DOUBLE, root, comm);
+}
@@ -0,0 +1,322 @@
+#include <eig_host.h>
+#include <host_blas_mugiq.h>
+#include <algorithm>
+#include <cmath>
+
+
+template <typename Float>
+void computeEvalsHost(HostOperator<Float> &op, const std::vector<HostColorSpinorField<Float>*> &eVecs,
+		      std::vector<std::complex<double>> &lambda, std::vector<double> &res, int nBatch){
+
+  const HostGeom &geom = op.Geom();
+  const int nEv = static_cast<int>(eVecs.size());
+  if(nBatch < 1) errorQuda("%s: Invalid batch size %d\n", __func__, nBatch);
+  nBatch = std::min(nBatch, nEv);
+
+  lambda.resize(nEv);
+  res.resize(nEv);
+
+  std::vector<HostColorSpinorField<Float>*> w;
+  for(int k=0;k<nBatch;k++) w.push_back(new HostColorSpinorField<Float>(geom, op.Nspin(), op.Ncolor()));
+  const int siteLen = op.Nspin() * op.Ncolor();
+
+  //- Per-vector sums of a block: Re, Im of v^dag w and ||v||^2 in the first sweep, ||w - lambda v||^2 in the second.
+  //- Each sweep streams the vectors one after the other, as the per-vector reductions do, and the block shares a
+  //- single MPI reduction
+  std::vector<double> sum(3*nBatch), sumGlobal(3*nBatch);
+  std::vector<std::complex<Float>> lam(nBatch);
+
+  for(int n0=0;n0<nEv;n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    std::vector<HostColorSpinorField<Float>*> vB(eVecs.begin()+n0, eVecs.begin()+n0+kB);
+    std::vector<HostColorSpinorField<Float>*> wB(w.begin(), w.begin()+kB);
+
+    op.apply(wB, vB); //- w = A*v_i
+
+    std::fill(sum.begin(), sum.end(), 0.0);
+#pragma omp parallel
+    {
+      std::vector<double> sumT(3*kB, 0.0);
+      for(int k=0;k<kB;k++){
+#pragma omp for nowait
+	for(int i=0;i<geom.volume;i++){
+	  const std::complex<Float> *v = vB[k]->Site(i);
+	  const std::complex<Float> *ws = wB[k]->Site(i);
+	  for(int c=0;c<siteLen;c++){
+	    const std::complex<double> vc(v[c]), wc(ws[c]);
+	    const std::complex<double> p = std::conj(vc) * wc;
+	    sumT[3*k+0] += p.real();
+	    sumT[3*k+1] += p.imag();
+	    sumT[3*k+2] += std::norm(vc);
+	  }
+	}
+      }
+#pragma omp critical
+      for(int j=0;j<3*kB;j++) sum[j] += sumT[j];
+    }
+    MPI_Allreduce(sum.data(), sumGlobal.data(), 3*kB, MPI_DOUBLE, MPI_SUM, geom.comm);
+
+    for(int k=0;k<kB;k++){
+      lambda[n0+k] = std::complex<double>(sumGlobal[3*k+0], sumGlobal[3*k+1]) / std::sqrt(sumGlobal[3*k+2]); // lambda_i = (v_i^dag A v_i) / ||v_i||
+      lam[k] = std::complex<Float>(lambda[n0+k]);
+    }
+
+    //- w_i = A*v_i - lambda_i*v_i and its norm in the same sweep
+    std::fill(sum.begin(), sum.end(), 0.0);
+#pragma omp parallel
+    {
+      std::vector<double> sumT(kB, 0.0);
+      for(int k=0;k<kB;k++){
+#pragma omp for nowait
+	for(int i=0;i<geom.volume;i++){
+	  const std::complex<Float> *v = vB[k]->Site(i);
+	  std::complex<Float> *ws = wB[k]->Site(i);
+	  for(int c=0;c<siteLen;c++){
+	    ws[c] -= lam[k] * v[c];
+	    sumT[k] += std::norm(std::complex<double>(ws[c]));
+	  }
+	}
+      }
+#pragma omp critical
+      for(int k=0;k<kB;k++) sum[k] += sumT[k];
+    }
+    MPI_Allreduce(sum.data(), sumGlobal.data(), kB, MPI_DOUBLE, MPI_SUM, geom.comm);
+
+    for(int k=0;k<kB;k++) res[n0+k] = std::sqrt(sumGlobal[k]); // r = ||w||
+  }
+
+  for(auto f: w) delete f;
+}
+
+
+template <typename Float>
+void eigsolveDenseHost(HostOperator<Float> &op, std::vector<HostColorSpinorField<Float>*> &eVecs, std::vector<double> &evals,
+		       MuGiqEigSpectrum spec, int nBatch){
+
+  const HostGeom &geom = op.Geom();
+  const int nEv = static_cast<int>(eVecs.size());
+  if(nBatch < 1) errorQuda("%s: Invalid batch size %d\n", __func__, nBatch);
+
+  int rank = 0, nRanks = 1;
+  MPI_Comm_rank(geom.comm, &rank);
+  MPI_Comm_size(geom.comm, &nRanks);
+  const long long localLen = static_cast<long long>(geom.volume) * op.Nspin() * op.Ncolor();
+  const long long dim = localLen * nRanks;
+  if(dim > DENSE_EIG_MAX_DIM_) errorQuda("%s: Dimension %lld exceeds the dense limit %d\n", __func__, dim, DENSE_EIG_MAX_DIM_);
+  nBatch = std::min(static_cast<long long>(nBatch), dim);
+
+  std::vector<HostColorSpinorField<Float>*> in, out;
+  for(int k=0;k<nBatch;k++){
+    in.push_back(new HostColorSpinorField<Float>(geom, op.Nspin(), op.Ncolor()));
+    out.push_back(new HostColorSpinorField<Float>(geom, op.Nspin(), op.Ncolor()));
+    in[k]->zero();
+  }
+
+  //- Column j of the operator is its action on the unit vector j, which is non-zero on process j / localLen only
+  std::vector<std::complex<double>> Aloc(localLen * dim);
+  for(long long j0=0;j0<dim;j0+=nBatch){
+    const int kB = static_cast<int>(std::min(static_cast<long long>(nBatch), dim - j0));
+    std::vector<HostColorSpinorField<Float>*> inB(in.begin(), in.begin()+kB), outB(out.begin(), out.begin()+kB);
+    for(int k=0;k<kB;k++)
+      if((j0+k) / localLen == rank) inB[k]->V()[(j0+k) % localLen] = 1.0;
+
+    op.apply(outB, inB);
+
+    for(int k=0;k<kB;k++){
+      if((j0+k) / localLen == rank) inB[k]->V()[(j0+k) % localLen] = 0.0;
+      const std::complex<Float> *o = outB[k]->V();
+      std::complex<double> *a = Aloc.data() + (j0+k) * localLen;
+#pragma omp parallel for
+      for(long long i=0;i<localLen;i++) a[i] = std::complex<double>(o[i]);
+    }
+  }
+  for(auto f: in) delete f;
+  for(auto f: out) delete f;
+
+  std::vector<std::complex<double>> Zloc;
+  denseEigDistributed(static_cast<int>(localLen), Aloc, spec, nEv, evals, Zloc, geom.comm);
+
+  for(int k=0;k<nEv;k++){
+    if(&(eVecs[k]->Geom()) != &geom || eVecs[k]->Nspin() != op.Nspin() || eVecs[k]->Ncolor() != op.Ncolor())
+      errorQuda("%s: Eigenvector %d does not have the shape of the operator fields\n", __func__, k);
+    std::complex<Float> *v = eVecs[k]->V();
+    const std::complex<double> *z = Zloc.data() + k * localLen;
+#pragma omp parallel for
+    for(long long i=0;i<localLen;i++) v[i] = std::complex<Float>(z[i]);
+  }
+}
+
+
+template <typename Float>
+HostProjector<Float>::HostProjector(HostOperator<Float> &op_, HostProlongator<Float> *P_,
+				    const std::vector<HostColorSpinorField<Float>*> &eVecs_,
+				    const std::vector<std::complex<double>> &evals_) :
+  op(op_),
+  P(P_),
+  eVecs(&eVecs_),
+  eVecsC(nullptr),
+  evals(evals_),
+  nLevel(P_ ? P_->NLevel() : 0),
+  nEv(static_cast<int>(eVecs_.size())),
+  gEv(nullptr),
+  siteLen(0)
+{
+  checkEvecs();
+  if(nEv > 0){
+    gEv = &((*eVecs)[0]->Geom());
+    siteLen = (*eVecs)[0]->SiteLength();
+  }
+}
+
+
+template <typename Float>
+HostProjector<Float>::HostProjector(HostOperator<Float> &op_, HostProlongator<Float> *P_,
+				    const std::vector<HostCompressedField<Float>*> &eVecs_,
+				    const std::vector<std::complex<double>> &evals_) :
+  op(op_),
+  P(P_),
+  eVecs(nullptr),
+  eVecsC(&eVecs_),
+  evals(evals_),
+  nLevel(P_ ? P_->NLevel() : 0),
+  nEv(static_cast<int>(eVecs_.size())),
+  gEv(nullptr),
+  siteLen(0)
+{
+  checkEvecs();
+  if(nEv > 0){
+    gEv = &((*eVecsC)[0]->Geom());
+    siteLen = (*eVecsC)[0]->SiteLength();
+  }
+}
+
+
+template <typename Float>
+void HostProjector<Float>::checkEvecs(){
+  if(nEv == 0 || static_cast<int>(evals.size()) != nEv)
+    errorQuda("%s: Got %d eigenvectors and %zu eigenvalues\n", __func__, nEv, evals.size());
+  if(P && &(P->Geom(0)) != &(op.Geom())) errorQuda("%s: The prolongator is not on the lattice of the operator\n", __func__);
+
+  const HostGeom &g = P ? P->Geom(nLevel) : op.Geom();
+  for(int i=0;i<nEv;i++){
+    const HostGeom &gi = eVecs ? (*eVecs)[i]->Geom() : (*eVecsC)[i]->Geom();
+    if(&gi != &g) errorQuda("%s: Eigenvector %d is not on the coarsest lattice\n", __func__, i);
+  }
+}
+
+
+template <typename Float>
+HostProjector<Float>::~HostProjector(){
+  for(auto &lev: tmp)
+    for(auto v: lev) delete v;
+}
+
+
+template <typename Float>
+void HostProjector<Float>::createTmp(int nVec){
+  if(!tmp.empty() && static_cast<int>(tmp[0].size()) >= nVec) return;
+  tmp.resize(nLevel + 1);
+  for(int lev=0;lev<=nLevel;lev++)
+    while(static_cast<int>(tmp[lev].size()) < nVec){
+      if(lev == 0) tmp[lev].push_back(new HostColorSpinorField<Float>(op.Geom(), op.Nspin(), op.Ncolor()));
+      else tmp[lev].push_back(new HostColorSpinorField<Float>(P->Geom(lev), P->Nspin(lev), P->Ncolor(lev)));
+    }
+}
+
+
+template <typename Float>
+void HostProjector<Float>::projectVectors(std::vector<HostColorSpinorField<Float>*> &out,
+					  const std::vector<HostColorSpinorField<Float>*> &in){
+
+  const int nSrc = static_cast<int>(in.size());
+  if(static_cast<int>(out.size()) != nSrc) errorQuda("%s: Got %zu output and %d input vectors\n", __func__, out.size(), nSrc);
+  const int nBatch = std::min(PROJECT_BATCH_HOST_, nSrc);
+
+  createTmp(nBatch);
+  s.resize(static_cast<size_t>(nEv) * nBatch);
+
+  for(int j0=0;j0<nSrc;j0+=nBatch){
+    const int kB = std::min(nBatch, nSrc - j0);
+
+    //- Min_j = gamma_5 * M * in_j, restricted to the lattice of the eigenvectors
+    std::vector<HostColorSpinorField<Float>*> inB(in.begin()+j0, in.begin()+j0+kB);
+    std::vector<HostColorSpinorField<Float>*> Mc(tmp[0].begin(), tmp[0].begin()+kB);
+    op.apply(Mc, inB);
+    for(int lev=0;lev<nLevel;lev++){
+      std::vector<HostColorSpinorField<Float>*> dst(tmp[lev+1].begin(), tmp[lev+1].begin()+kB);
+      P->restrictVectors(dst, Mc, lev);
+      Mc = dst;
+    }
+
+    //- s[i][j] = dot(eVecs[i], Min_j) as s = E^dag Min, with the eigenvectors and the sources the columns of E and Min:
+    //- one GEMM per tile of sites, on the tile of each eigenvector loaded (and decoded) once for all the sources. The
+    //- tiles are summed in double precision
+    const int volume = gEv->volume;
+    const int tileSites = gemmTileSites<Float>(nEv + kB, siteLen, volume);
+    const int nTile = (volume + tileSites - 1) / tileSites;
+    std::fill(s.begin(), s.end(), std::complex<double>(0.0));
+#pragma omp parallel
+    {
+      std::vector<std::complex<double>> sT(static_cast<size_t>(nEv) * kB, 0.0);
+      std::vector<std::complex<Float>> E(static_cast<size_t>(tileSites) * siteLen * nEv);
+      std::vector<std::complex<Float>> M(static_cast<size_t>(tileSites) * siteLen * kB);
+      std::vector<std::complex<Float>> sTile(static_cast<size_t>(nEv) * kB);
+#pragma omp for
+      for(int t=0;t<nTile;t++){
+	const int x0 = t * tileSites;
+	const int rows = std::min(tileSites, volume - x0) * siteLen;
+	loadEvecTile(E.data(), x0, rows);
+	for(int j=0;j<kB;j++) std::copy(Mc[j]->Site(x0), Mc[j]->Site(x0) + rows, M.begin() + static_cast<size_t>(j)*rows);
+	gemmHost<Float>('C', nEv, kB, rows, 1.0, E.data(), rows, M.data(), rows, 0.0, sTile.data(), nEv);
+	for(int i=0;i<nEv;i++)
+	  for(int j=0;j<kB;j++) sT[i*kB + j] += std::complex<double>(sTile[i + j*nEv]);
+      }
+#pragma omp critical
+      for(size_t n=0;n<sT.size();n++) s[n] += sT[n];
+    }
+    MPI_Allreduce(MPI_IN_PLACE, s.data(), 2*nEv*kB, MPI_DOUBLE, MPI_SUM, gEv->comm);
+
+    //- Mout_j = Sum_i s[i][j] / evals[i] * eVecs[i], i.e. Mout = E a per tile, on the scratch fields of the coarsest
+    //- lattice or straight to out
+    std::vector<std::complex<Float>> a(static_cast<size_t>(nEv) * kB);
+    for(int i=0;i<nEv;i++)
+      for(int j=0;j<kB;j++) a[i + j*nEv] = std::complex<Float>(s[i*kB + j] / evals[i]);
+    std::vector<HostColorSpinorField<Float>*> Mout(kB);
+    for(int j=0;j<kB;j++) Mout[j] = nLevel > 0 ? Mc[j] : out[j0+j];
+#pragma omp parallel
+    {
+      std::vector<std::complex<Float>> E(static_cast<size_t>(tileSites) * siteLen * nEv);
+      std::vector<std::complex<Float>> M(static_cast<size_t>(tileSites) * siteLen * kB);
+#pragma omp for
+      for(int t=0;t<nTile;t++){
+	const int x0 = t * tileSites;
+	const int rows = std::min(tileSites, volume - x0) * siteLen;
+	loadEvecTile(E.data(), x0, rows);
+	gemmHost<Float>('N', rows, kB, nEv, 1.0, E.data(), rows, a.data(), nEv, 0.0, M.data(), rows);
+	for(int j=0;j<kB;j++)
+	  std::copy(M.begin() + static_cast<size_t>(j)*rows, M.begin() + static_cast<size_t>(j+1)*rows, Mout[j]->Site(x0));
+      }
+    }
+
+    //- Back to the fine lattice
+    if(nLevel > 0){
+      std::vector<HostColorSpinorField<Float>*> outB(out.begin()+j0, out.begin()+j0+kB);
+      P->prolongate(outB, Mout);
+    }
+  }
+}
+
+
+template class HostProjector<float>;
+template class HostProjector<double>;
+
+
+template void eigsolveDenseHost<float>(HostOperator<float> &op, std::vector<HostColorSpinorField<float>*> &eVecs,
+				       std::vector<double> &evals, MuGiqEigSpectrum spec, int nBatch);
+template void eigsolveDenseHost<double>(HostOperator<double> &op, std::vector<HostColorSpinorField<double>*> &eVecs,
+					std::vector<double> &evals, MuGiqEigSpectrum spec, int nBatch);
+
+template void computeEvalsHost<float>(HostOperator<float> &op, const std::vector<HostColorSpinorField<float>*> &eVecs,
+				      std::vector<std::complex<double>> &lambda, std::vector<double> &res, int nBatch);
+template void computeEvalsHost<double>(HostOperator<double> &op, const std::vector<HostColorSpinorField<double>*> &eVecs,
+				       std::vector<std::complex<double>> &lambda, std::vector<double> &res, int nBatch);
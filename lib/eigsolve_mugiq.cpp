@@ -1,6 +1,10 @@
 #include <eigsolve_mugiq.h>
 #include <util_quda.h>
 #include <eigensolve_quda.h>
+#include <farm_mugiq.h>
+#include <lanczos_host.h>
+#include <eig_host.h>
+#include <dirac_host.h>
 
 Eigsolve_Mugiq::Eigsolve_Mugiq(MugiqEigParam *eigParams_,
 			       MG_Mugiq *mg_env_,
@@ -16,11 +20,13 @@ Eigsolve_Mugiq::Eigsolve_Mugiq(MugiqEigParam *eigParams_,
   dirac(nullptr),
   mat(nullptr),
   matFine(nullptr),
+  matDirect(nullptr),
   diracCreated(MUGIQ_BOOL_FALSE),
   eVals_quda(nullptr),
   eVals(nullptr),
   eVals_sigma(nullptr),
   evals_res(nullptr),
+  hostBackend(nullptr),
   computeCoarse(computeCoarse_)
 {
   if(!mg_env->mgInit) errorQuda("%s: Multigrid environment must be initialized before Eigensolver.\n", __func__);
@@ -49,6 +55,7 @@ Eigsolve_Mugiq::Eigsolve_Mugiq(MugiqEigParam *eigParams_,
   allocateEvals();
   
   makeChecks();  
+  createHostBackend();
   eigInit = MUGIQ_BOOL_TRUE;
 }
 
@@ -65,11 +72,13 @@ Eigsolve_Mugiq::Eigsolve_Mugiq(MugiqEigParam *eigParams_,
   dirac(nullptr),
   mat(nullptr),
   matFine(nullptr),
+  matDirect(nullptr),
   diracCreated(MUGIQ_BOOL_FALSE),
   eVals_quda(nullptr),
   eVals(nullptr),
   eVals_sigma(nullptr),
   evals_res(nullptr),
+  hostBackend(nullptr),
   computeCoarse(MUGIQ_BOOL_FALSE)
 {  
   allocateFineEvecs();
@@ -83,6 +92,7 @@ Eigsolve_Mugiq::Eigsolve_Mugiq(MugiqEigParam *eigParams_,
   allocateEvals();
 
   makeChecks();
+  createHostBackend();
   eigInit = MUGIQ_BOOL_TRUE;
 }
 
@@ -95,9 +105,10 @@ Eigsolve_Mugiq::~Eigsolve_Mugiq(){
   if(eigParams->diracType == MUGIQ_EIG_OPERATOR_MdagM || eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag)
     delete eVals_sigma;
 
-  if(mat) delete mat;
-  if(matFine) delete mat;
-  mat = nullptr;
+  freeOperator();
+  freeProjectTmp();
+  if(hostBackend) delete hostBackend;
+  hostBackend = nullptr;
   
   if(useMGenv){
     //- (dirac deletion is taken care by mg_solver destructor in this case)
@@ -208,7 +219,46 @@ void Eigsolve_Mugiq::createNewDiracMatrix(){
   else if (eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag)  mat = new DiracMMdag(*dirac);
   else errorQuda("%s: Unsupported Dirac operator type\n", __func__);
 
-  matFine = new DiracM(*mg_env->mg_solver->d);
+  //- The operator itself, for the eigenvalues and residuals
+  matDirect = new DiracM(*dirac);
+
+  //- The fine operator of the projection, that of the MG hierarchy or the operator itself without MG
+  matFine = new DiracM(useMGenv ? *mg_env->mg_solver->d : *dirac);
+}
+
+
+void Eigsolve_Mugiq::freeOperator(){
+  if(mat) delete mat;
+  mat = nullptr;
+  if(matFine) delete matFine;
+  matFine = nullptr;
+  if(matDirect) delete matDirect;
+  matDirect = nullptr;
+}
+
+
+void Eigsolve_Mugiq::loadGauge(void *hostGauge[], void *hostClover){
+
+  if(!eigInit) errorQuda("%s: Eigsolve_Mugiq must be initialized first.\n", __func__);
+
+  //- The Dirac operator of the gauge field now loaded in QUDA, with MG the (updated) one of the hierarchy
+  freeOperator();
+  if(useMGenv) dirac = computeCoarse ? mg_env->diracCoarse : mg_env->mg_solver->d;
+  else{
+    if(dirac && diracCreated) delete dirac;
+    dirac = nullptr;
+    createDiracOperator();
+  }
+  createNewDiracMatrix();
+
+  //- The host operator keeps its geometry and eigenvectors, only its links and clover term change
+  for(int d=0;d<N_DIM_;d++) eigParams->hostGauge[d] = hostGauge[d];
+  eigParams->hostClover = hostClover;
+  if(!hostBackend) return;
+  hostBackend->op.loadGauge(eigParams->hostGauge, eigParams->hostPrec);
+  if(eigParams->hostClover) hostBackend->op.loadClover(eigParams->hostClover, eigParams->hostPrec);
+  hostBackend->resetProjector();
+  checkHostBackend();
 }
 
 
@@ -264,7 +314,11 @@ void Eigsolve_Mugiq::printInfo(){
   printfQuda("Will %suse the Multigrid environment\n", useMGenv ? "" : "NOT ");
   if(useMGenv) printfQuda("Will %suse the Coarse Dirac operator\n", computeCoarse ? "" : "NOT ");
   printfQuda("Will compute the eigenpairs of the %s Dirac operator\n", optrStr);
-  printfQuda("Will employ the %s algorithm for computation\n", eig_algo);
+  MuGiqEigSpectrum spec;
+  if(useDenseEigsolve(spec)) printfQuda("Will employ the dense solver, nEv exceeds %g of the operator dimension\n", eigParams->denseRatio);
+  else if(useHostEigsolve(spec)) printfQuda("Will employ the host %s algorithm for computation\n", eig_algo);
+  else printfQuda("Will employ the %s algorithm for computation\n", eig_algo);
+  if(hostBackend) printfQuda("Will use the host Wilson-clover operator for the eigenvalues and the projection\n");
   printfQuda("Part of spectrum requested: %s\n", spectrum);
   printfQuda("Number of eigenvalues requested: %d\n", eigParams->nEv);
   printfQuda("Size of Krylov space: %d\n", eigParams->nKr);
@@ -284,9 +338,23 @@ void Eigsolve_Mugiq::computeEvecs(){
 
   if(!eigInit) errorQuda("%s: Eigsolve_Mugiq must be initialized first.\n", __func__);
 
-  //- Perform eigensolve
-  EigenSolver *eigSolve = EigenSolver::create(eigParams->QudaEigParams, *mat, *eigProfile);
-  (*eigSolve)(eVecs, *eVals_quda);
+  //- Perform eigensolve, small operators of which a large fraction of the spectrum is requested are diagonalized as dense matrices
+  MuGiqEigSpectrum spec = MUGIQ_SPECTRUM_INVALID;
+  const MuGiqBool dense = useDenseEigsolve(spec);
+  if(dense && hostBackend){
+    computeEvecsHost(spec, MUGIQ_BOOL_TRUE);
+    return;
+  }
+  else if(dense) computeEvecsDense(spec);
+  else if(useHostEigsolve(spec)){
+    computeEvecsHost(spec, MUGIQ_BOOL_FALSE);
+    return;
+  }
+  else{
+    EigenSolver *eigSolve = EigenSolver::create(eigParams->QudaEigParams, *mat, *eigProfile);
+    (*eigSolve)(eVecs, *eVals_quda);
+    delete eigSolve;
+  }
 
   // Get the right singular vectors if the solver returns the left singular vectors
   if(eigParams->diracType == MUGIQ_EIG_OPERATOR_Mdag || eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag){
@@ -295,38 +363,375 @@ void Eigsolve_Mugiq::computeEvecs(){
     }
   }
 
-  delete eigSolve;
+  //- The host eigenvalues and projection need the host copies of the eigenvectors
+  if(hostBackend){
+    for(int i=0; i<eigParams->nEv; i++) hostBackend->toHost(*hostBackend->eVecs[i], *eVecs[i]);
+    hostBackend->resetProjector();
+  }
+}
+
+
+MuGiqBool Eigsolve_Mugiq::useDenseEigsolve(MuGiqEigSpectrum &spec){
+
+  switch(eigParams->QudaEigParams->spectrum){
+  case QUDA_SPECTRUM_SR_EIG: spec = MUGIQ_SPECTRUM_SR; break;
+  case QUDA_SPECTRUM_LR_EIG: spec = MUGIQ_SPECTRUM_LR; break;
+  case QUDA_SPECTRUM_SM_EIG: spec = MUGIQ_SPECTRUM_SM; break;
+  case QUDA_SPECTRUM_LM_EIG: spec = MUGIQ_SPECTRUM_LM; break;
+  default: return MUGIQ_BOOL_FALSE; //- The dense eigenvalues are real
+  }
+
+  //- The dense solver needs a Hermitian operator
+  if(eigParams->diracType != MUGIQ_EIG_OPERATOR_MdagM && eigParams->diracType != MUGIQ_EIG_OPERATOR_MMdag) return MUGIQ_BOOL_FALSE;
+
+  int nRanks = 1;
+  MPI_Comm_size(getCommMugiq(), &nRanks);
+  const double dim = static_cast<double>(eVecs[0]->Volume()) * eVecs[0]->Nspin() * eVecs[0]->Ncolor() * nRanks;
+  return denseEigSelected(eigParams->nEv, dim, eigParams->denseRatio) ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE;
+}
+
+
+void Eigsolve_Mugiq::computeEvecsDense(MuGiqEigSpectrum spec){
+
+  MPI_Comm comm = getCommMugiq();
+  int rank = 0, nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+  const int localLen = eVecs[0]->Volume() * eVecs[0]->Nspin() * eVecs[0]->Ncolor();
+  const long long dim = static_cast<long long>(localLen) * nRanks;
+  printfQuda("%s: Computing %d eigenpairs of the operator of dimension %lld with the dense solver\n", __func__, eigParams->nEv, dim);
+
+  //- Unit vectors and operator columns go through double-precision host fields in space-spin-color order,
+  //- the global index of a local element is rank*localLen + its offset in the host field
+  ColorSpinorParam hParam(*eVecs[0]);
+  hParam.location = QUDA_CPU_FIELD_LOCATION;
+  hParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+  hParam.create = QUDA_ZERO_FIELD_CREATE;
+  hParam.setPrecision(QUDA_DOUBLE_PRECISION);
+  ColorSpinorField *hIn = ColorSpinorField::Create(hParam);
+  ColorSpinorField *hOut = ColorSpinorField::Create(hParam);
+
+  ColorSpinorParam dParam(*eVecs[0]);
+  dParam.create = QUDA_ZERO_FIELD_CREATE;
+  ColorSpinorField *dIn = ColorSpinorField::Create(dParam);
+  ColorSpinorField *dOut = ColorSpinorField::Create(dParam);
+
+  std::complex<double> *hv = static_cast<std::complex<double>*>(hIn->V());
+  std::vector<std::complex<double>> Aloc(static_cast<size_t>(localLen) * dim);
+  for(long long j=0;j<dim;j++){
+    const bool owner = (j / localLen == rank);
+    if(owner) hv[j % localLen] = 1.0;
+    *dIn = *hIn;
+    (*mat)(*dOut, *dIn);
+    *hOut = *dOut;
+    if(owner) hv[j % localLen] = 0.0;
+    memcpy(Aloc.data() + j*localLen, hOut->V(), localLen * sizeof(std::complex<double>));
+  }
+
+  std::vector<double> w;
+  std::vector<std::complex<double>> Zloc;
+  denseEigDistributed(localLen, Aloc, spec, eigParams->nEv, w, Zloc, comm);
+
+  for(int k=0;k<eigParams->nEv;k++){
+    memcpy(hv, Zloc.data() + static_cast<size_t>(k)*localLen, localLen * sizeof(std::complex<double>));
+    *eVecs[k] = *hIn;
+    (*eVals_quda)[k] = Complex(w[k], 0.0);
+  }
+
+  delete hIn;
+  delete hOut;
+  delete dIn;
+  delete dOut;
+}
+
+//- Host backend of the eigensolve: the fine Wilson-clover operator on host fields, the host copies of the eigenvectors,
+//- and the double-precision DeGrand-Rossi host field through which vectors go to and from the device fields
+class HostEigBackend {
+
+public:
+
+  HostGeom geom;
+  HostWilsonCloverOperator<double> op;
+  std::vector<HostColorSpinorField<double>*> eVecs;
+  HostProjector<double> *proj;  // Projector on the current eigenpairs, created on first use
+  std::vector<HostColorSpinorField<double>*> projIn, projOut;
+
+  ColorSpinorField *hField;
+
+  HostEigBackend(const int lL[], MugiqEigParam *eigParams, double kappa, const ColorSpinorField &f) :
+    geom(lL),
+    op(geom, eigParams->hostGauge, eigParams->hostPrec, kappa, eigParams->hostClover),
+    proj(nullptr)
+  {
+    for(int i=0;i<eigParams->nEv;i++) eVecs.push_back(new HostColorSpinorField<double>(geom));
+
+    ColorSpinorParam hParam(f);
+    hParam.location = QUDA_CPU_FIELD_LOCATION;
+    hParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+    hParam.gammaBasis = QUDA_DEGRAND_ROSSI_GAMMA_BASIS;
+    hParam.create = QUDA_ZERO_FIELD_CREATE;
+    hParam.setPrecision(QUDA_DOUBLE_PRECISION);
+    hField = ColorSpinorField::Create(hParam);
+  }
+
+  ~HostEigBackend(){
+    resetProjector();
+    for(auto v: projIn) delete v;
+    for(auto v: projOut) delete v;
+    for(auto v: eVecs) delete v;
+    delete hField;
+  }
+
+  HostEigBackend(const HostEigBackend &) = delete;
+  HostEigBackend& operator=(const HostEigBackend &) = delete;
+
+  void toHost(HostColorSpinorField<double> &dst, const ColorSpinorField &src){
+    *hField = src;
+    memcpy(dst.V(), hField->V(), dst.Bytes());
+  }
+
+  void toDevice(ColorSpinorField &dst, const HostColorSpinorField<double> &src){
+    memcpy(hField->V(), src.V(), src.Bytes());
+    dst = *hField;
+  }
+
+  //- The projector holds a copy of the eigenvalues, it is re-created when they change
+  void resetProjector(){
+    if(proj) delete proj;
+    proj = nullptr;
+  }
+
+  //- out_j = sum_i evecs_i * dot(evecs_i, gamma_5 M in_j) / eval_i, the sources go to the host in batches of PROJECT_BATCH_HOST_
+  void projectVectors(std::vector<ColorSpinorField *> &out, std::vector<ColorSpinorField *> &in, const std::vector<Complex> &evals){
+    op.setOperator(MUGIQ_EIG_OPERATOR_M, MUGIQ_BOOL_TRUE);
+    if(!proj) proj = new HostProjector<double>(op, nullptr, eVecs, evals);
+
+    const int nSrc = static_cast<int>(in.size());
+    const int nBatch = std::min(PROJECT_BATCH_HOST_, nSrc);
+    while(static_cast<int>(projIn.size()) < nBatch){
+      projIn.push_back(new HostColorSpinorField<double>(geom));
+      projOut.push_back(new HostColorSpinorField<double>(geom));
+    }
+    for(int j0=0; j0<nSrc; j0+=nBatch){
+      const int kB = std::min(nBatch, nSrc - j0);
+      std::vector<HostColorSpinorField<double>*> hIn(projIn.begin(), projIn.begin()+kB), hOut(projOut.begin(), projOut.begin()+kB);
+      for(int j=0; j<kB; j++) toHost(*hIn[j], *in[j0+j]);
+      proj->projectVectors(hOut, hIn);
+      for(int j=0; j<kB; j++) toDevice(*out[j0+j], *hOut[j]);
+    }
+  }
+};
+
+
+void Eigsolve_Mugiq::createHostBackend(){
+
+  if(!eigParams->useHostEigsolver) return;
+
+  bool links = true;
+  for(int d=0;d<N_DIM_;d++) links = links && eigParams->hostGauge[d];
+
+  const char *why = nullptr;
+  if(!links) why = "the host links are not given";
+  else if(useMGenv && computeCoarse) why = "the operator is the coarse one";
+  else if(invParams->dslash_type != QUDA_WILSON_DSLASH && invParams->dslash_type != QUDA_CLOVER_WILSON_DSLASH) why = "the operator is not Wilson(-clover)";
+  else if(invParams->dslash_type == QUDA_CLOVER_WILSON_DSLASH && !eigParams->hostClover) why = "the host clover term is not given";
+  else if(invParams->mass_normalization != QUDA_KAPPA_NORMALIZATION) why = "the host operator needs the kappa normalization";
+  else if(eVecs[0]->SiteSubset() != QUDA_FULL_SITE_SUBSET || eVecs[0]->Nspin() != N_SPIN_ || eVecs[0]->Ncolor() != N_COLOR_)
+    why = "the host operator needs full-parity Wilson fields";
+  if(why){
+    warningQuda("%s: The host operator is not used, %s\n", __func__, why);
+    return;
+  }
+
+  int lL[N_DIM_];
+  for(int d=0;d<N_DIM_;d++) lL[d] = eVecs[0]->X(d);
+  hostBackend = new HostEigBackend(lL, eigParams, invParams->kappa, *eVecs[0]);
+  checkHostBackend();
+}
+
+
+void Eigsolve_Mugiq::checkHostBackend(){
+
+  //- The host operator must agree with the device one, i.e. the links and the clover term must be those of the device
+  //- operator in QUDA's host orders, and the boundary conditions the same. Otherwise the device operator is used
+  HostEigBackend &hb = *hostBackend;
+  HostColorSpinorField<double> x(hb.geom), y(hb.geom), z(hb.geom);
+  for(long long e=0;e<x.Length();e++) x.V()[e] = std::complex<double>(rand() / (double)RAND_MAX - 0.5, rand() / (double)RAND_MAX - 0.5);
+  ColorSpinorParam dParam(*eVecs[0]);
+  dParam.create = QUDA_ZERO_FIELD_CREATE;
+  ColorSpinorField *dIn = ColorSpinorField::Create(dParam);
+  ColorSpinorField *dOut = ColorSpinorField::Create(dParam);
+  hb.toDevice(*dIn, x);
+  (*matDirect)(*dOut, *dIn);
+  hb.toHost(z, *dOut);
+  delete dIn;
+  delete dOut;
+
+  std::vector<HostColorSpinorField<double>*> yv(1, &y);
+  const std::vector<HostColorSpinorField<double>*> xv(1, &x);
+  hb.op.setOperator(MUGIQ_EIG_OPERATOR_M);
+  hb.op.apply(yv, xv);
+
+  double dev[2] = {0.0, 0.0};
+  for(long long e=0;e<y.Length();e++){
+    dev[0] = std::max(dev[0], std::abs(y.V()[e] - z.V()[e]));
+    dev[1] = std::max(dev[1], std::abs(z.V()[e]));
+  }
+  MPI_Allreduce(MPI_IN_PLACE, dev, 2, MPI_DOUBLE, MPI_MAX, getCommMugiq());
+  const double relDev = dev[1] > 0 ? dev[0] / dev[1] : dev[0];
+
+  const QudaPrecision prec = std::min(eVecs[0]->Precision(), eigParams->hostPrec);
+  const double tol = (prec == QUDA_DOUBLE_PRECISION) ? 1e-10 : (prec == QUDA_SINGLE_PRECISION) ? 1e-5 : 1e-2;
+  printfQuda("%s: Relative deviation of the host Wilson-clover operator from the device one: %e\n", __func__, relDev);
+  if(relDev > tol){
+    warningQuda("%s: The host operator deviates from the device one (tolerance = %e), it is not used\n", __func__, tol);
+    delete hostBackend;
+    hostBackend = nullptr;
+  }
+}
+
+
+MuGiqBool Eigsolve_Mugiq::useHostEigsolve(MuGiqEigSpectrum &spec){
+
+  if(!eigParams->useHostEigsolver) return MUGIQ_BOOL_FALSE;
+
+  if(!hostBackend){
+    warningQuda("%s: The host eigensolver needs the host Wilson-clover operator, falling back to QUDA\n", __func__);
+    return MUGIQ_BOOL_FALSE;
+  }
+
+  if(eigParams->QudaEigParams->eig_type != QUDA_EIG_TR_LANCZOS){
+    warningQuda("%s: The host eigensolver is a thick-restart Lanczos, falling back to QUDA for this eig_type\n", __func__);
+    return MUGIQ_BOOL_FALSE;
+  }
+  if(eigParams->diracType != MUGIQ_EIG_OPERATOR_MdagM && eigParams->diracType != MUGIQ_EIG_OPERATOR_MMdag){
+    warningQuda("%s: The host Lanczos needs a Hermitian operator, MdagM or MMdag, falling back to QUDA\n", __func__);
+    return MUGIQ_BOOL_FALSE;
+  }
+  switch(eigParams->QudaEigParams->spectrum){
+  case QUDA_SPECTRUM_SR_EIG: spec = MUGIQ_SPECTRUM_SR; break;
+  case QUDA_SPECTRUM_LR_EIG: spec = MUGIQ_SPECTRUM_LR; break;
+  default:
+    warningQuda("%s: The host Lanczos computes the SR or LR part of the spectrum, falling back to QUDA\n", __func__);
+    return MUGIQ_BOOL_FALSE;
+  }
+  return MUGIQ_BOOL_TRUE;
+}
+
+
+void Eigsolve_Mugiq::computeEvecsHost(MuGiqEigSpectrum spec, MuGiqBool dense){
+
+  HostWilsonCloverOperator<double> &op = hostBackend->op;
+  std::vector<HostColorSpinorField<double>*> &hVecs = hostBackend->eVecs;
+  op.setOperator(eigParams->diracType);
+  hostBackend->resetProjector();
+
+  std::vector<double> evals;
+  if(dense){
+    printfQuda("%s: Computing %d eigenpairs with the dense solver on the host operator\n", __func__, eigParams->nEv);
+    eigsolveDenseHost(op, hVecs, evals, spec);
+  }
+  else{
+    HostLanczosParam param;
+    param.nEv = eigParams->nEv;
+    param.nKr = eigParams->nKr;
+    param.tol = eigParams->tol;
+    param.maxRestarts = eigParams->QudaEigParams->max_restarts;
+    param.spectrum = spec;
+    param.use_poly_acc = eigParams->use_poly_acc;
+    param.poly_acc_deg = eigParams->poly_acc_deg;
+    param.a_min = eigParams->a_min;
+    param.a_max = eigParams->a_max;
+
+    std::vector<double> res;
+    HostLanczos<double> lanczos(op, param);
+    lanczos.solve(hVecs, evals, res);
+  }
+
+  //- Right singular vectors from the left ones, then the device copies for the rest of the computation
+  for(int k=0;k<eigParams->nEv;k++){
+    if(eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag) applyGamma5Host(*hVecs[k]);
+    hostBackend->toDevice(*eVecs[k], *hVecs[k]);
+    (*eVals_quda)[k] = Complex(evals[k], 0.0);
+  }
 }
 
+
 void Eigsolve_Mugiq::computeEvals(){
 
+  const int nEv = eigParams->nEv;
+
+  if(hostBackend){
+    //- lambda_i = v_i^dag \gamma_5 M v_i / ||v_i|| and r_i = ||\gamma_5 M v_i - lambda_i v_i||, on the host eigenvectors
+    HostWilsonCloverOperator<double> &op = hostBackend->op;
+    op.setOperator(MUGIQ_EIG_OPERATOR_M, MUGIQ_BOOL_TRUE);
+    std::vector<std::complex<double>> lambdaH;
+    std::vector<double> resH;
+    computeEvalsHost(op, hostBackend->eVecs, lambdaH, resH);
+    for(int i=0; i<nEv; i++){
+      (*eVals)[i] = lambdaH[i];
+      (*evals_res)[i] = resH[i];
+    }
+    hostBackend->resetProjector();
+  }
+  else computeEvalsDevice();
+
+  if(eigParams->diracType == MUGIQ_EIG_OPERATOR_MdagM || eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag){
+    std::vector<double> &sigma = *eVals_sigma;    
+    for(int i=0; i<nEv; i++) sigma[i] = sqrt((*eVals)[i].real());
+  }
+}
+
+
+void Eigsolve_Mugiq::computeEvalsDevice(){
+
+  const int nEv = eigParams->nEv;
+  const int nBatch = std::min(EVALS_BATCH_DEVICE_, nEv);
+
   ColorSpinorParam csParam(*eVecs[0]);
-  ColorSpinorField *w;
-  w = ColorSpinorField::Create(csParam);
+  std::vector<ColorSpinorField*> w;
+  for(int k=0;k<nBatch;k++) w.push_back(ColorSpinorField::Create(csParam));
 
   std::vector<Complex> &lambda = *eVals;
   std::vector<double> &r = *evals_res;
 
   double kappa = invParams->kappa;
-  DiracMatrix *mat_direct = new DiracM(*dirac);	  
-  
-  for(int i=0; i<eigParams->nEv; i++){
-    (*mat_direct)(*w,*eVecs[i]); //- w = M*v_i
-    if(invParams->mass_normalization == QUDA_MASS_NORMALIZATION) blas::ax(0.25/(kappa*kappa), *w);
-    gamma5(*w, *w);
-    lambda[i] = blas::cDotProduct(*eVecs[i], *w) / sqrt(blas::norm2(*eVecs[i])); // lambda_i = (v_i^dag M v_i) / ||v_i||
-    Complex Cm1(-1.0, 0.0);
-    blas::caxpby(lambda[i], *eVecs[i], Cm1, *w); // w = lambda_i*v_i - \gamma_5*A*v_i
-    r[i] = sqrt(blas::norm2(*w)); // r = ||w||
-  }
 
-  if(eigParams->diracType == MUGIQ_EIG_OPERATOR_MdagM || eigParams->diracType == MUGIQ_EIG_OPERATOR_MMdag){
-    std::vector<double> &sigma = *eVals_sigma;    
-    for(int i=0; i<eigParams->nEv; i++) sigma[i] = sqrt(lambda[i].real());
+  //- The eigenvectors are taken in batches: after the operator is applied vector by vector, the quotients and norms of
+  //- the whole batch come from one block inner product of v against [w, v], and the residual norms from one block
+  //- inner product of the updated w with itself. Only the diagonals of the blocks are read, but each block is a single
+  //- multi-vector reduction instead of one reduction per eigenvector
+  std::vector<Complex> dots(2*nBatch*nBatch);
+  std::vector<Complex> a(nBatch*nBatch);
+  std::vector<Complex> rr(nBatch*nBatch);
+  for(int n0=0; n0<nEv; n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    std::vector<ColorSpinorField*> vB(eVecs.begin()+n0, eVecs.begin()+n0+kB);
+    std::vector<ColorSpinorField*> wB(w.begin(), w.begin()+kB);
+
+    for(int k=0; k<kB; k++){
+      (*matDirect)(*wB[k],*vB[k]); //- w = M*v_i
+      if(invParams->mass_normalization == QUDA_MASS_NORMALIZATION) blas::ax(0.25/(kappa*kappa), *wB[k]);
+      gamma5(*wB[k], *wB[k]);
+    }
+
+    //- dots[i][j] = dot(v_i, [w, v]_j), the diagonals of the two halves are v_i^dag \gamma_5 M v_i and ||v_i||^2
+    std::vector<ColorSpinorField*> wv(wB);
+    wv.insert(wv.end(), vB.begin(), vB.end());
+    blas::cDotProduct(dots.data(), vB, wv);
+
+    std::fill(a.begin(), a.end(), Complex(0.0, 0.0));
+    for(int k=0; k<kB; k++){
+      lambda[n0+k] = dots[k*2*kB + k] / sqrt(dots[k*2*kB + kB + k].real()); // lambda_i = (v_i^dag M v_i) / ||v_i||
+      a[k*kB + k] = -lambda[n0+k];
+    }
+
+    blas::caxpy(a.data(), vB, wB); // w_i = \gamma_5*A*v_i - lambda_i*v_i
+    blas::cDotProduct(rr.data(), wB, wB);
+    for(int k=0; k<kB; k++) r[n0+k] = sqrt(rr[k*kB + k].real()); // r = ||w||
   }
-  
-  delete mat_direct;
-  delete w;
+
+  for(auto f: w) delete f;
 }
 
 void Eigsolve_Mugiq::printEvals(){
@@ -349,54 +754,202 @@ void Eigsolve_Mugiq::printEvals(){
   
 }
 
+//- Copy between a field and a mapped cache file, with the field on the device or on the host
+static void copyCacheVector(void *dst, const void *src, size_t bytes, QudaFieldLocation fieldLocation, cudaMemcpyKind kind){
+  if(fieldLocation != QUDA_CUDA_FIELD_LOCATION){
+    memcpy(dst, src, bytes);
+    return;
+  }
+  cudaError_t err = cudaMemcpy(dst, src, bytes, kind);
+  if(err != cudaSuccess) errorQuda("Eigenvector cache copy failed: %s\n", cudaGetErrorString(err));
+}
+
+
+EvecCacheHeader Eigsolve_Mugiq::evecCacheHeader(uint64_t gaugeChecksum){
+
+  const ColorSpinorField &v = *eVecs[0];
+  if(v.Precision() < QUDA_SINGLE_PRECISION)
+    errorQuda("%s: The eigenvector cache does not support precision %d\n", __func__, static_cast<int>(v.Precision()));
+  if(v.SiteSubset() != QUDA_FULL_SITE_SUBSET) errorQuda("%s: The eigenvector cache requires full-parity eigenvectors\n", __func__);
+
+  int lL[N_DIM_], totalL[N_DIM_], coord[N_DIM_];
+  for(int d=0;d<N_DIM_;d++){
+    lL[d] = v.X(d);
+    totalL[d] = lL[d] * comm_dim(d);
+    coord[d] = comm_coord(d);
+  }
+  const int level = (useMGenv && computeCoarse) ? mgParams->n_level-1 : 0;
+
+  return EvecCacheHeader(lL, totalL, coord, level, static_cast<int>(v.Precision()), static_cast<int>(v.FieldOrder()),
+			 eigParams->nEv, static_cast<long long>(v.Bytes()), gaugeChecksum);
+}
+
+
+void Eigsolve_Mugiq::saveEvecs(const std::string &base, uint64_t gaugeChecksum){
+
+  const EvecCacheHeader header = evecCacheHeader(gaugeChecksum);
+  const std::string fname = evecCacheFileName(base, comm_rank());
+  {
+    EvecCacheFile cache(fname, header);
+
+    //- The vectors are copied straight into the mapped file
+    for(int i=0;i<eigParams->nEv;i++)
+      copyCacheVector(cache.Vector(i), eVecs[i]->V(), header.vecBytes, eVecs[i]->Location(), cudaMemcpyDeviceToHost);
+
+    EvecCacheEvals ev;
+    ev.evalsQuda.assign(eVals_quda->begin(), eVals_quda->end());
+    ev.evals.assign(eVals->begin(), eVals->end());
+    ev.res.assign(evals_res->begin(), evals_res->end());
+    if(eVals_sigma) ev.sigma.assign(eVals_sigma->begin(), eVals_sigma->end());
+    else ev.sigma.assign(eigParams->nEv, 0.0);
+    cache.setEvals(ev);
+  }
+
+  printfQuda("%s: %d eigenpairs saved to the cache %s, %.1f MB per rank\n", __func__, eigParams->nEv,
+	     evecCacheFileName(base, 0).c_str(), (header.dataOffset + eigParams->nEv*header.vecBytes) / (1024.0*1024.0));
+}
+
+
+MuGiqBool Eigsolve_Mugiq::loadEvecs(const std::string &base, uint64_t gaugeChecksum){
+
+  const EvecCacheHeader expect = evecCacheHeader(gaugeChecksum);
+  const std::string fname = evecCacheFileName(base, comm_rank());
+  EvecCacheFile cache(fname);
+
+  std::string why = "the file is absent or incomplete";
+  const bool ok = cache.Valid() && cache.Header().matches(expect, why);
+  if(!ok && cache.Valid()) warningQuda("%s: Cannot use the cache %s: %s\n", __func__, fname.c_str(), why.c_str());
+  if(!evecCacheAllRanks(ok, getCommMugiq())){
+    printfQuda("%s: No usable eigenvector cache %s on all ranks, the eigenpairs will be computed\n", __func__, fname.c_str());
+    return MUGIQ_BOOL_FALSE;
+  }
+
+  //- The vectors are streamed from the mapped file straight into the field storage
+  for(int i=0;i<eigParams->nEv;i++)
+    copyCacheVector(eVecs[i]->V(), cache.Vector(i), expect.vecBytes, eVecs[i]->Location(), cudaMemcpyHostToDevice);
+
+  EvecCacheEvals ev;
+  cache.getEvals(ev);
+  for(int i=0;i<eigParams->nEv;i++){
+    (*eVals_quda)[i] = ev.evalsQuda[i];
+    (*eVals)[i] = ev.evals[i];
+    (*evals_res)[i] = ev.res[i];
+    if(eVals_sigma) (*eVals_sigma)[i] = ev.sigma[i];
+  }
+  if(hostBackend){
+    for(int i=0;i<eigParams->nEv;i++) hostBackend->toHost(*hostBackend->eVecs[i], *eVecs[i]);
+    hostBackend->resetProjector();
+  }
+
+  printfQuda("%s: %d eigenpairs loaded from the cache %s\n", __func__, eigParams->nEv, fname.c_str());
+  return MUGIQ_BOOL_TRUE;
+}
+
+
+void Eigsolve_Mugiq::createProjectTmp(int nVec){
+
+  if(!projTmp.empty() && static_cast<int>(projTmp[0].size()) >= nVec) return;
+  freeProjectTmp();
+
+  //- Fine fields, and with coarse eigenvectors one set per coarse level, all in the precision of the eigenvectors
+  const bool coarse = computeCoarse && mg_env && mg_env->nCoarseLevels > 0;
+  ColorSpinorParam csParam(coarse ? *(mg_env->mg_solver->B[0]) : *eVecs[0]);
+  csParam.location = QUDA_CUDA_FIELD_LOCATION;
+  csParam.create = QUDA_ZERO_FIELD_CREATE;
+  csParam.setPrecision(eVecs[0]->Precision());
+
+  const int nLevel = coarse ? mg_env->nCoarseLevels : 0;
+  projTmp.resize(nLevel + 1);
+  for(int j=0;j<nVec;j++){
+    projTmp[0].push_back(ColorSpinorField::Create(csParam));
+    for(int lev=0;lev<nLevel;lev++)
+      projTmp[lev+1].push_back(projTmp[lev][j]->CreateCoarse(mgParams->geo_block_size[lev],
+							     mgParams->spin_block_size[lev],
+							     mgParams->n_vec[lev],
+							     eVecs[0]->Precision(),
+							     mgParams->setup_location[lev+1]));
+  }
+}
+
+
+void Eigsolve_Mugiq::freeProjectTmp(){
+  for(auto &lev: projTmp)
+    for(auto v: lev) delete v;
+  projTmp.clear();
+}
+
+
 /**
  * Perform the projection: out = \sum_i evecs_i * dot(evecs_i*,\gamma_5 * fine_op * in) / eval_i
  */
 void Eigsolve_Mugiq::projectVector(ColorSpinorField &out, ColorSpinorField &in){
-  // Min = gamma_5 * matFine * in
-  ColorSpinorParam csParam(*tmpCSF[0]);
-  ColorSpinorField *Min = ColorSpinorField::Create(csParam);
-  (*matFine)(*Min,in);
-  gamma5(*Min, *Min);
-
-  // Transfer Min to the coarsest level  
-  ColorSpinorField *Min_coarse = nullptr, *Mout_coarse = nullptr;
-  if (computeCoarse && mg_env->nCoarseLevels > 0) {
-    blas::zero(*tmpCSF[1]);
-    mg_env->transfer[0]->R(*tmpCSF[1], *Min);
-    for(int lev=1; lev<mg_env->nCoarseLevels; lev++){
-      blas::zero(*tmpCSF[lev+1]);
+  std::vector<ColorSpinorField *> out_(1, &out), in_(1, &in);
+  projectVectors(out_, in_);
+}
+
+
+/**
+ * Perform the projection for a block of sources: out_j = \sum_i evecs_i * dot(evecs_i*,\gamma_5 * fine_op * in_j) / eval_i
+ */
+void Eigsolve_Mugiq::projectVectors(std::vector<ColorSpinorField *> &out, std::vector<ColorSpinorField *> &in){
+
+  const int nSrc = static_cast<int>(in.size());
+  if(static_cast<int>(out.size()) != nSrc) errorQuda("%s: Got %zu output and %d input vectors\n", __func__, out.size(), nSrc);
+
+  //- The host backend only exists for fine eigenvectors, the projection is then done on the host operator
+  if(hostBackend){
+    hostBackend->projectVectors(out, in, *eVals);
+    return;
+  }
+
+  const int nEv = eigParams->nEv;
+  const int nBatch = std::min(PROJECT_BATCH_DEVICE_, nSrc);
+  const bool coarse = computeCoarse && mg_env && mg_env->nCoarseLevels > 0;
+  const int nLevel = coarse ? mg_env->nCoarseLevels : 0;
+
+  //- The scratch fields are kept for later calls
+  createProjectTmp(nBatch);
+
+  std::vector<Complex> s(nEv*nBatch);
+  for(int j0=0; j0<nSrc; j0+=nBatch){
+    const int kB = std::min(nBatch, nSrc - j0);
+
+    // Min_j = gamma_5 * matFine * in_j
+    for(int j=0; j<kB; j++){
+      (*matFine)(*projTmp[0][j], *in[j0+j]);
+      gamma5(*projTmp[0][j], *projTmp[0][j]);
+    }
+
+    // Transfer Min to the coarsest level
+    for(int lev=0; lev<nLevel; lev++){
       if(!mg_env->transfer[lev]) errorQuda("%s: Transfer operator for level %d does not exist!\n", __func__, lev);
-      mg_env->transfer[lev]->R(*tmpCSF[lev+1], *tmpCSF[lev]);
+      for(int j=0; j<kB; j++){
+	blas::zero(*projTmp[lev+1][j]);
+	mg_env->transfer[lev]->R(*projTmp[lev+1][j], *projTmp[lev][j]);
+      }
     }
-    Mout_coarse = Min_coarse = tmpCSF[mg_env->nCoarseLevels];
-  } else {
-    Min_coarse = Min;
-    Mout_coarse = &out;
-  }
-
-  // s[i] = dot(eVecs[i], Min_coarse)
-  std::vector<Complex> s(eigParams->nEv);
-  std::vector<ColorSpinorField *> Minc_(1, Min_coarse);
-  blas::cDotProduct(s.data(), eVecs, Minc_);
-
-  // Mout_coarse = Sum_i s[i] / evals[i] * eVecs[i]
-  blas::zero(*Mout_coarse);
-  for (int i = 0; i < eigParams->nEv; i++) {
-    s[i] /= (*eVals)[i];
-  }
-  std::vector<ColorSpinorField *> Moutc_(1, Mout_coarse);
-  blas::caxpy(s.data(), eVecs, Moutc_);
-
-  // Transfer Mout_coarse to the fine level  
-  if (computeCoarse && mg_env->nCoarseLevels > 0) {
-    for(int lev=mg_env->nCoarseLevels; lev>1; lev--){
-      blas::zero(*tmpCSF[lev-1]);
-      mg_env->transfer[lev-1]->P(*tmpCSF[lev-1], *tmpCSF[lev]);
+    std::vector<ColorSpinorField *> Mc(projTmp[nLevel].begin(), projTmp[nLevel].begin()+kB);
+
+    // s[i][j] = dot(eVecs[i], Min_coarse_j), all the eigenvectors against all the sources in one block reduction
+    blas::cDotProduct(s.data(), eVecs, Mc);
+
+    // Mout_coarse_j = Sum_i s[i][j] / evals[i] * eVecs[i]
+    for(int i=0; i<nEv; i++)
+      for(int j=0; j<kB; j++) s[i*kB + j] /= (*eVals)[i];
+    std::vector<ColorSpinorField *> Mout(kB);
+    for(int j=0; j<kB; j++){
+      Mout[j] = coarse ? Mc[j] : out[j0+j];
+      blas::zero(*Mout[j]);
+    }
+    blas::caxpy(s.data(), eVecs, Mout);
+
+    // Transfer Mout_coarse to the fine level
+    for(int lev=nLevel; lev>0; lev--){
+      for(int j=0; j<kB; j++){
+	ColorSpinorField *dst = (lev == 1) ? out[j0+j] : projTmp[lev-1][j];
+	blas::zero(*dst);
+	mg_env->transfer[lev-1]->P(*dst, *projTmp[lev][j]);
+      }
     }
-    blas::zero(out);
-    mg_env->transfer[0]->P(out, *tmpCSF[1]);
   }
-
-  delete Min;
 }
@@ -0,0 +1,244 @@
+#include <evec_cache_mugiq.h>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+EvecCacheHeader::EvecCacheHeader(){
+  memset(this, 0, sizeof(EvecCacheHeader));
+}
+
+
+EvecCacheHeader::EvecCacheHeader(const int lL_[], const int totalL_[], const int commCoord_[], int level_, int precision_,
+				 int fieldOrder_, int nEv_, long long vecBytes_, uint64_t gaugeChecksum_){
+  memset(this, 0, sizeof(EvecCacheHeader));
+  memcpy(magic, EVEC_CACHE_MAGIC_, sizeof(magic));
+  version = EVEC_CACHE_VERSION_;
+  for(int d=0;d<N_DIM_;d++){
+    lL[d] = lL_[d];
+    totalL[d] = totalL_[d];
+    commCoord[d] = commCoord_[d];
+  }
+  level = level_;
+  precision = precision_;
+  fieldOrder = fieldOrder_;
+  nEv = nEv_;
+  vecBytes = vecBytes_;
+  gaugeChecksum = gaugeChecksum_;
+  dataOffset = EvecCacheFile::DataOffset(nEv_);
+}
+
+
+bool EvecCacheHeader::matches(const EvecCacheHeader &expect, std::string &why) const {
+  char buf[256];
+  auto fail = [&](const char *what, long long got, long long want){
+    snprintf(buf, sizeof(buf), "%s is %lld, expected %lld", what, got, want);
+    why = buf;
+    return false;
+  };
+
+  if(memcmp(magic, EVEC_CACHE_MAGIC_, sizeof(magic)) != 0){ why = "not an eigenvector cache file"; return false; }
+  if(version != EVEC_CACHE_VERSION_) return fail("format version", version, EVEC_CACHE_VERSION_);
+  for(int d=0;d<N_DIM_;d++){
+    if(lL[d] != expect.lL[d]) return fail("local lattice extent", lL[d], expect.lL[d]);
+    if(totalL[d] != expect.totalL[d]) return fail("global lattice extent", totalL[d], expect.totalL[d]);
+    if(commCoord[d] != expect.commCoord[d]) return fail("process-grid coordinate", commCoord[d], expect.commCoord[d]);
+  }
+  if(level != expect.level) return fail("MG level", level, expect.level);
+  if(precision != expect.precision) return fail("precision", precision, expect.precision);
+  if(fieldOrder != expect.fieldOrder) return fail("field order", fieldOrder, expect.fieldOrder);
+  if(vecBytes != expect.vecBytes) return fail("vector length (bytes)", vecBytes, expect.vecBytes);
+  //- More eigenpairs than needed are fine, the first ones are used
+  if(nEv < expect.nEv) return fail("number of eigenpairs", nEv, expect.nEv);
+  if(gaugeChecksum != expect.gaugeChecksum){ why = "the gauge checksum differs, the cache belongs to another configuration"; return false; }
+
+  why.clear();
+  return true;
+}
+//---------------------------------------------------------------------------
+
+
+//- The eigenvalues follow the header, at an offset aligned for doubles
+static const int64_t evalOffset = ((sizeof(EvecCacheHeader) + 15) / 16) * 16;
+
+
+int64_t EvecCacheFile::DataOffset(int nEv){
+  const int64_t evalBytes = static_cast<int64_t>(nEv) * (2*sizeof(std::complex<double>) + 2*sizeof(double));
+  return ((evalOffset + evalBytes + EVEC_CACHE_ALIGN_ - 1) / EVEC_CACHE_ALIGN_) * EVEC_CACHE_ALIGN_;
+}
+
+
+EvecCacheFile::EvecCacheFile(const std::string &fname_, const EvecCacheHeader &header) :
+  fname(fname_), fd(-1), map(nullptr), mapBytes(0), writeMode(true)
+{
+  if(header.nEv < 1 || header.vecBytes < 1) errorQuda("%s: Invalid cache header, nEv = %d, vecBytes = %lld\n", __func__,
+						      header.nEv, static_cast<long long>(header.vecBytes));
+  mapBytes = header.dataOffset + header.nEv * header.vecBytes;
+
+  //- The file gets its name only when it is complete, so an interrupted save never leaves a loadable cache behind
+  const std::string tmpName = fname + ".tmp";
+  fd = open(tmpName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0) errorQuda("%s: Cannot create eigenvector cache file %s\n", __func__, tmpName.c_str());
+  if(ftruncate(fd, mapBytes) != 0) errorQuda("%s: Cannot allocate %zu bytes for %s\n", __func__, mapBytes, tmpName.c_str());
+
+  void *m = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(m == MAP_FAILED) errorQuda("%s: Cannot map eigenvector cache file %s\n", __func__, tmpName.c_str());
+  map = static_cast<char*>(m);
+  memcpy(map, &header, sizeof(EvecCacheHeader));
+}
+
+
+EvecCacheFile::EvecCacheFile(const std::string &fname_) :
+  fname(fname_), fd(-1), map(nullptr), mapBytes(0), writeMode(false)
+{
+  fd = open(fname.c_str(), O_RDONLY);
+  if(fd < 0) return;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(EvecCacheHeader))){
+    unmap();
+    return;
+  }
+  mapBytes = st.st_size;
+
+  //- Private mapping, the pages are read in as the vectors are streamed
+  void *m = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(m == MAP_FAILED){
+    unmap();
+    return;
+  }
+  map = static_cast<char*>(m);
+  posix_madvise(map, mapBytes, POSIX_MADV_SEQUENTIAL);
+
+  const EvecCacheHeader &h = Header();
+  if(memcmp(h.magic, EVEC_CACHE_MAGIC_, sizeof(h.magic)) != 0 || h.nEv < 1 || h.dataOffset != DataOffset(h.nEv) ||
+     static_cast<int64_t>(mapBytes) != h.dataOffset + h.nEv * h.vecBytes){
+    warningQuda("%s: %s is not a complete eigenvector cache file\n", __func__, fname.c_str());
+    unmap();
+  }
+}
+
+
+void EvecCacheFile::unmap(){
+  if(map) munmap(map, mapBytes);
+  if(fd >= 0) close(fd);
+  map = nullptr;
+  fd = -1;
+}
+
+
+void EvecCacheFile::sync(){
+  if(writeMode && map) msync(map, mapBytes, MS_SYNC);
+}
+
+
+EvecCacheFile::~EvecCacheFile(){
+  const bool complete = writeMode && map;
+  sync();
+  unmap();
+  if(complete){
+    const std::string tmpName = fname + ".tmp";
+    if(rename(tmpName.c_str(), fname.c_str()) != 0)
+      warningQuda("%s: Cannot rename %s to %s, the eigenvectors are not cached\n", __func__, tmpName.c_str(), fname.c_str());
+  }
+}
+
+
+void* EvecCacheFile::Vector(int n){
+  if(!map || n < 0 || n >= Header().nEv) errorQuda("%s: Vector %d is not in the cache %s\n", __func__, n, fname.c_str());
+  return map + Header().dataOffset + n * Header().vecBytes;
+}
+
+
+const void* EvecCacheFile::Vector(int n) const {
+  if(!map || n < 0 || n >= Header().nEv) errorQuda("%s: Vector %d is not in the cache %s\n", __func__, n, fname.c_str());
+  return map + Header().dataOffset + n * Header().vecBytes;
+}
+
+
+void EvecCacheFile::setEvals(const EvecCacheEvals &ev){
+  if(!writeMode) errorQuda("%s: The cache %s is read-only\n", __func__, fname.c_str());
+  const size_t nEv = Header().nEv;
+  if(ev.evalsQuda.size() < nEv || ev.evals.size() < nEv || ev.res.size() < nEv || ev.sigma.size() < nEv)
+    errorQuda("%s: Got fewer than %zu eigenvalues\n", __func__, nEv);
+
+  char *p = map + evalOffset;
+  memcpy(p, ev.evalsQuda.data(), nEv*sizeof(std::complex<double>)); p += nEv*sizeof(std::complex<double>);
+  memcpy(p, ev.evals.data(),     nEv*sizeof(std::complex<double>)); p += nEv*sizeof(std::complex<double>);
+  memcpy(p, ev.res.data(),       nEv*sizeof(double));               p += nEv*sizeof(double);
+  memcpy(p, ev.sigma.data(),     nEv*sizeof(double));
+}
+
+
+void EvecCacheFile::getEvals(EvecCacheEvals &ev) const {
+  const size_t nEv = Header().nEv;
+  ev.evalsQuda.resize(nEv);
+  ev.evals.resize(nEv);
+  ev.res.resize(nEv);
+  ev.sigma.resize(nEv);
+
+  const char *p = map + evalOffset;
+  memcpy(ev.evalsQuda.data(), p, nEv*sizeof(std::complex<double>)); p += nEv*sizeof(std::complex<double>);
+  memcpy(ev.evals.data(),     p, nEv*sizeof(std::complex<double>)); p += nEv*sizeof(std::complex<double>);
+  memcpy(ev.res.data(),       p, nEv*sizeof(double));               p += nEv*sizeof(double);
+  memcpy(ev.sigma.data(),     p, nEv*sizeof(double));
+}
+//---------------------------------------------------------------------------
+
+
+std::string evecCacheFileName(const std::string &base, int rank){
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "_rank%05d.evc", rank);
+  return base + suffix;
+}
+
+
+//- splitmix64 finalizer, mixes a 64-bit word
+static inline uint64_t mixWord(uint64_t z){
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+
+template <typename T>
+static uint64_t localChecksum(void *gauge[], long long volume, int rank){
+  uint64_t sum = 0;
+  const long long len = volume * 2 * GAUGE_SITE_LEN_;
+  for(int d=0;d<N_DIM_;d++){
+    const T *g = static_cast<const T*>(gauge[d]);
+#pragma omp parallel for reduction(+:sum)
+    for(long long i=0;i<len;i++){
+      uint64_t w = 0;
+      memcpy(&w, &g[i], sizeof(T));
+      sum += mixWord(w ^ mixWord((static_cast<uint64_t>(rank) << 40) + (static_cast<uint64_t>(d) << 36) + i));
+    }
+  }
+  return sum;
+}
+
+
+uint64_t gaugeChecksumMugiq(void *gauge[], QudaPrecision prec, long long volume, MPI_Comm comm){
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  uint64_t sum = 0;
+  if(prec == QUDA_DOUBLE_PRECISION) sum = localChecksum<double>(gauge, volume, rank);
+  else if(prec == QUDA_SINGLE_PRECISION) sum = localChecksum<float>(gauge, volume, rank);
+  else errorQuda("%s: Unsupported gauge precision %d\n", __func__, static_cast<int>(prec));
+
+  //- Sums modulo 2^64 are exact, so the result does not depend on the reduction order
+  uint64_t sumGlobal = 0;
+  MPI_Allreduce(&sum, &sumGlobal, 1, MPI_UINT64_T, MPI_SUM, comm);
+  return sumGlobal;
+}
+
+
+bool evecCacheAllRanks(bool ok, MPI_Comm comm){
+  int okLocal = ok ? 1 : 0, okGlobal = 0;
+  MPI_Allreduce(&okLocal, &okGlobal, 1, MPI_INT, MPI_MIN, comm);
+  return okGlobal == 1;
+}
@@ -0,0 +1,129 @@
+#include <evec_compress_mugiq.h>
+#include <algorithm>
+
+
+template <typename Float>
+constexpr float HostCompressedField<Float>::maxHalf;
+
+template <typename Float>
+constexpr float HostCompressedField<Float>::maxQuarter;
+
+
+template <typename Float>
+HostCompressedField<Float>::HostCompressedField(const HostGeom &geom_, MuGiqEvecCompression comp_, int nSpin_, int nColor_) :
+  geom(geom_),
+  nSpin(nSpin_),
+  nColor(nColor_),
+  siteLen(nSpin_*nColor_),
+  comp(comp_)
+{
+  data.resize(static_cast<size_t>(geom.volume) * 2 * siteLen * evecCompressBytes(comp));
+  if(comp != MUGIQ_EVEC_COMPRESS_BF16) scale.resize(geom.volume);
+}
+
+
+//- Complex numbers of a site decoded at a time by the site-wise kernels
+static const int decodeChunk = 32;
+
+
+//- Round a float to bfloat16, to nearest even
+static inline uint16_t floatToBF16(float f){
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  if((u & 0x7fffffffu) > 0x7f800000u) return static_cast<uint16_t>((u >> 16) | 0x40u); //- quiet NaN
+  u += 0x7fffu + ((u >> 16) & 1u);
+  return static_cast<uint16_t>(u >> 16);
+}
+
+
+template <typename Float>
+void HostCompressedField<Float>::encode(const HostColorSpinorField<Float> &in){
+
+  if(in.Nspin() != nSpin || in.Ncolor() != nColor || &(in.Geom()) != &geom)
+    errorQuda("%s: The field does not have the shape of the compressed field\n", __func__);
+
+  const int nReal = 2*siteLen;
+#pragma omp parallel for
+  for(int i=0;i<geom.volume;i++){
+    const Float *x = reinterpret_cast<const Float*>(in.Site(i));
+    const long long r0 = static_cast<long long>(i) * nReal;
+
+    if(comp == MUGIQ_EVEC_COMPRESS_BF16){
+      uint16_t *q = reinterpret_cast<uint16_t*>(data.data()) + r0;
+      for(int r=0;r<nReal;r++) q[r] = floatToBF16(static_cast<float>(x[r]));
+      continue;
+    }
+
+    Float xMax = 0.0;
+    for(int r=0;r<nReal;r++) xMax = std::max(xMax, std::abs(x[r]));
+    scale[i] = static_cast<float>(xMax);
+
+    //- Quantize with the scale as stored, so that decoding the largest element gives back xMax up to its rounding to float
+    const float qMax = (comp == MUGIQ_EVEC_COMPRESS_HALF) ? maxHalf : maxQuarter;
+    const Float inv = scale[i] > 0.0f ? static_cast<Float>(qMax) / static_cast<Float>(scale[i]) : 0.0;
+    for(int r=0;r<nReal;r++){
+      const Float v = std::min(std::max(std::round(x[r] * inv), -static_cast<Float>(qMax)), static_cast<Float>(qMax));
+      if(comp == MUGIQ_EVEC_COMPRESS_HALF) reinterpret_cast<int16_t*>(data.data())[r0 + r] = static_cast<int16_t>(v);
+      else reinterpret_cast<int8_t*>(data.data())[r0 + r] = static_cast<int8_t>(v);
+    }
+  }
+}
+
+
+template <typename Float>
+void HostCompressedField<Float>::decode(HostColorSpinorField<Float> &out) const {
+
+  if(out.Nspin() != nSpin || out.Ncolor() != nColor || &(out.Geom()) != &geom)
+    errorQuda("%s: The field does not have the shape of the compressed field\n", __func__);
+
+#pragma omp parallel for
+  for(int i=0;i<geom.volume;i++) decodeSite(out.Site(i), i, 0, siteLen);
+}
+
+
+template <typename Float>
+std::complex<double> HostCompressedField<Float>::cDotLocal(const HostColorSpinorField<Float> &x) const {
+
+  if(x.Nspin() != nSpin || x.Ncolor() != nColor || &(x.Geom()) != &geom)
+    errorQuda("%s: The field does not have the shape of the compressed field\n", __func__);
+
+  double re = 0.0, im = 0.0;
+#pragma omp parallel for reduction(+:re,im)
+  for(int i=0;i<geom.volume;i++){
+    std::complex<Float> v[decodeChunk];
+    const std::complex<Float> *xs = x.Site(i);
+    for(int c0=0;c0<siteLen;c0+=decodeChunk){
+      const int len = std::min(decodeChunk, siteLen - c0);
+      decodeSite(v, i, c0, len);
+      for(int c=0;c<len;c++){
+	const std::complex<double> p = std::conj(std::complex<double>(v[c])) * std::complex<double>(xs[c0+c]);
+	re += p.real();
+	im += p.imag();
+      }
+    }
+  }
+  return std::complex<double>(re, im);
+}
+
+
+template <typename Float>
+void HostCompressedField<Float>::caxpy(std::complex<Float> a, HostColorSpinorField<Float> &y) const {
+
+  if(y.Nspin() != nSpin || y.Ncolor() != nColor || &(y.Geom()) != &geom)
+    errorQuda("%s: The field does not have the shape of the compressed field\n", __func__);
+
+#pragma omp parallel for
+  for(int i=0;i<geom.volume;i++){
+    std::complex<Float> v[decodeChunk];
+    std::complex<Float> *ys = y.Site(i);
+    for(int c0=0;c0<siteLen;c0+=decodeChunk){
+      const int len = std::min(decodeChunk, siteLen - c0);
+      decodeSite(v, i, c0, len);
+      for(int c=0;c<len;c++) ys[c0+c] += a * v[c];
+    }
+  }
+}
+
+
+template class HostCompressedField<float>;
+template class HostCompressedField<double>;
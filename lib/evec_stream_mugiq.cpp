@@ -0,0 +1,143 @@
+#include <evec_stream_mugiq.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+template <typename Float>
+HostEvecStream<Float>::HostEvecStream(const HostGeom &geom_, const std::string &fname_, const EvecCacheHeader &expect,
+				      int ringSize_) :
+  geom(geom_),
+  fname(fname_),
+  fd(-1),
+  ringSize(ringSize_),
+  first(0), end(0), loaded(0), released(0),
+  stopFlag(false),
+  tStart(0.0)
+{
+  if(ringSize < 1) errorQuda("%s: The ring needs at least one vector, got %d\n", __func__, ringSize);
+  if(expect.vecBytes != static_cast<int64_t>(geom.volume) * SPINOR_SITE_LEN_ * static_cast<int64_t>(sizeof(std::complex<Float>)))
+    errorQuda("%s: The expected vectors are not host color-spinor fields of this geometry\n", __func__);
+
+  //- The header and the eigenvalues are taken from the mapping, which touches only their pages
+  {
+    EvecCacheFile cache(fname);
+    std::string why = "the file is absent or incomplete";
+    if(!cache.Valid() || !cache.Header().matches(expect, why))
+      errorQuda("%s: Cannot stream the eigenvectors of %s: %s\n", __func__, fname.c_str(), why.c_str());
+    header = cache.Header();
+    cache.getEvals(evals);
+  }
+
+  fd = open(fname.c_str(), O_RDONLY);
+  if(fd < 0) errorQuda("%s: Cannot open %s\n", __func__, fname.c_str());
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  for(int i=0;i<ringSize;i++) ring.push_back(new HostColorSpinorField<Float>(geom));
+}
+
+
+template <typename Float>
+HostEvecStream<Float>::~HostEvecStream(){
+  {
+    std::lock_guard<std::mutex> lk(mtx);
+    stopFlag = true;
+  }
+  cv.notify_all();
+  if(prefetch.joinable()) prefetch.join();
+
+  for(auto v: ring) delete v;
+  ring.clear();
+  if(fd >= 0) close(fd);
+}
+
+
+template <typename Float>
+void HostEvecStream<Float>::readVector(int n, HostColorSpinorField<Float> &v){
+  char *dst = reinterpret_cast<char*>(v.V());
+  const size_t bytes = header.vecBytes;
+  const off_t offset = header.dataOffset + static_cast<off_t>(n) * header.vecBytes;
+  size_t done = 0;
+  while(done < bytes){
+    const ssize_t r = pread(fd, dst + done, bytes - done, offset + done);
+    if(r <= 0) errorQuda("%s: Reading vector %d of %s failed\n", __func__, n, fname.c_str());
+    done += r;
+  }
+}
+
+
+template <typename Float>
+void HostEvecStream<Float>::prefetchLoop(){
+  for(;;){
+    int n;
+    {
+      //- A slot is free when the vector that held it, ringSize vectors earlier, has been released
+      std::unique_lock<std::mutex> lk(mtx);
+      cv.wait(lk, [&]{ return stopFlag || loaded >= end || loaded - released < ringSize; });
+      if(stopFlag || loaded >= end) return;
+      n = loaded;
+    }
+
+    const double t0 = hostTimer();
+    readVector(n, *ring[(n - first) % ringSize]);
+    const double t1 = hostTimer();
+
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      profile.read += t1 - t0;
+      profile.bytes += header.vecBytes;
+      loaded++;
+    }
+    cv.notify_all();
+  }
+}
+
+
+template <typename Float>
+void HostEvecStream<Float>::start(int first_, int count){
+  if(prefetch.joinable()) errorQuda("%s: The previous pass has not finished\n", __func__);
+  if(first_ < 0 || count < 0 || first_ + count > header.nEv)
+    errorQuda("%s: Cannot stream vectors [%d,%d) of %d\n", __func__, first_, first_ + count, header.nEv);
+
+  first = first_;
+  end = first_ + count;
+  loaded = released = first_;
+  stopFlag = false;
+  tStart = hostTimer();
+  prefetch = std::thread(&HostEvecStream<Float>::prefetchLoop, this);
+}
+
+
+template <typename Float>
+void HostEvecStream<Float>::finish(){
+  if(released != end) errorQuda("%s: %d vectors of the pass have not been released\n", __func__, end - released);
+  if(prefetch.joinable()) prefetch.join();
+  profile.total += hostTimer() - tStart;
+}
+
+
+template <typename Float>
+HostColorSpinorField<Float>* HostEvecStream<Float>::acquire(int n){
+  if(n < released || n >= end || n >= released + ringSize)
+    errorQuda("%s: Vector %d cannot be resident, the pass is at [%d,%d) with %d slots\n", __func__, n, released, end, ringSize);
+
+  const double t0 = hostTimer();
+  std::unique_lock<std::mutex> lk(mtx);
+  cv.wait(lk, [&]{ return loaded > n; });
+  profile.wait += hostTimer() - t0;
+  return ring[(n - first) % ringSize];
+}
+
+
+template <typename Float>
+void HostEvecStream<Float>::release(int n){
+  {
+    std::lock_guard<std::mutex> lk(mtx);
+    if(n != released) errorQuda("%s: Vectors must be released in order, expected %d, got %d\n", __func__, released, n);
+    released++;
+  }
+  cv.notify_all();
+}
+
+
+template class HostEvecStream<float>;
+template class HostEvecStream<double>;
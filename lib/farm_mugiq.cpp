@@ -0,0 +1,190 @@
+#include <farm_mugiq.h>
+#include <quda.h>
+#include <util_quda.h>
+#include <comm_quda.h>
+#include <mpi_comm_handle.h>
+#include <fstream>
+#include <sstream>
+
+
+MPI_Comm getCommMugiq(){
+  return MPI_COMM_HANDLE;
+}
+
+
+FarmComm::FarmComm(int nGroups_) :
+  nGroups(nGroups_)
+{
+  MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+
+  if(nGroups < 1 || worldSize % nGroups != 0)
+    errorQuda("%s: Number of groups %d must divide the number of processes %d\n", __func__, nGroups, worldSize);
+
+  //- Consecutive world ranks form a group, they are most likely on the same or on neighbouring nodes
+  groupSize = worldSize / nGroups;
+  groupId = worldRank / groupSize;
+  MPI_Comm_split(MPI_COMM_WORLD, groupId, worldRank, &group);
+  MPI_Comm_rank(group, &groupRank);
+}
+
+
+FarmComm::~FarmComm(){
+  if(group != MPI_COMM_NULL) MPI_Comm_free(&group);
+}
+//---------------------------------------------------------------------------
+
+
+FarmQueue::FarmQueue(const FarmComm &farm_, long long nTask_) :
+  farm(farm_),
+  nTask(nTask_),
+  counter(nullptr),
+  win(MPI_WIN_NULL)
+{
+  MPI_Aint winSize = (farm.worldRank == 0) ? sizeof(long long) : 0;
+  MPI_Win_allocate(winSize, sizeof(long long), MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &win);
+
+  if(farm.worldRank == 0){
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+    *counter = 0;
+    MPI_Win_unlock(0, win);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+
+FarmQueue::~FarmQueue(){
+  if(win != MPI_WIN_NULL) MPI_Win_free(&win);
+}
+
+
+long long FarmQueue::next(){
+
+  long long task = -1;
+
+  //- Only the leader of the group touches the counter, the rest of the group gets the task from it
+  if(farm.groupRank == 0){
+    const long long one = 1;
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, win);
+    MPI_Fetch_and_op(&one, &task, MPI_LONG_LONG, 0, 0, MPI_SUM, win);
+    MPI_Win_unlock(0, win);
+    if(task >= nTask) task = -1;
+  }
+  MPI_Bcast(&task, 1, MPI_LONG_LONG, 0, farm.group);
+
+  if(task >= 0) done.push_back(task);
+
+  return task;
+}
+
+
+void FarmQueue::report() const {
+
+  //- Number of tasks of each group leader, the rest of the processes contribute zero
+  int nDone = (farm.groupRank == 0) ? static_cast<int>(done.size()) : 0;
+  std::vector<int> nDoneAll(farm.worldSize);
+  MPI_Gather(&nDone, 1, MPI_INT, nDoneAll.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> displs(farm.worldSize, 0);
+  int nTot = 0;
+  for(int r=0;r<farm.worldSize;r++){
+    displs[r] = nTot;
+    nTot += nDoneAll[r];
+  }
+  std::vector<long long> tasksAll(nTot > 0 ? nTot : 1);
+  MPI_Gatherv(done.data(), nDone, MPI_LONG_LONG, tasksAll.data(), nDoneAll.data(), displs.data(), MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+  if(farm.worldRank != 0) return;
+
+  printf("Farm: %lld tasks on %d groups of %d processes\n", nTask, farm.nGroups, farm.groupSize);
+  for(int g=0;g<farm.nGroups;g++){
+    const int r = g * farm.groupSize;
+    printf("Farm: Group %3d processed %3d tasks:", g, nDoneAll[r]);
+    for(int i=0;i<nDoneAll[r];i++) printf(" %lld", tasksAll[displs[r]+i]);
+    printf("\n");
+  }
+}
+//---------------------------------------------------------------------------
+
+
+std::vector<std::string> readFarmTaskList(const std::string &fname){
+
+  std::ifstream in(fname);
+  if(!in.good()) errorQuda("%s: Cannot open task list %s\n", __func__, fname.c_str());
+
+  std::vector<std::string> tasks;
+  std::string line;
+  while(std::getline(in, line)){
+    const size_t b = line.find_first_not_of(" \t\r");
+    if(b == std::string::npos || line[b] == '#') continue;
+    const size_t e = line.find_last_not_of(" \t\r");
+    tasks.push_back(line.substr(b, e-b+1));
+  }
+
+  return tasks;
+}
+//---------------------------------------------------------------------------
+
+
+std::string farmFileName(const std::string &fname, const std::string &tag){
+  if(fname.empty()) return fname;
+  size_t dot = fname.find_last_of('.');
+  size_t slash = fname.find_last_of('/');
+  if(dot == std::string::npos || (slash != std::string::npos && dot < slash)) return fname + "_" + tag;
+  return fname.substr(0, dot) + "_" + tag + fname.substr(dot);
+}
+
+
+std::string farmTaskTag(const std::string &gaugeFile){
+  size_t slash = gaugeFile.find_last_of('/');
+  std::string tag = (slash == std::string::npos) ? gaugeFile : gaugeFile.substr(slash+1);
+  size_t dot = tag.find_last_of('.');
+  return (dot == std::string::npos || dot == 0) ? tag : tag.substr(0, dot);
+}
+//---------------------------------------------------------------------------
+
+
+FarmComm* initFarmCommsMuGiq(int nGroups, int *argc, char ***argv, const int gridSize[]){
+
+  MPI_Init(argc, argv);
+  FarmComm *farm = new FarmComm(nGroups);
+
+  //- QUDA keeps a pointer to the handle, it must stay valid until finalizeFarmCommsMuGiq
+  qudaSetCommHandle(static_cast<void*>(&farm->group));
+  int grid[4] = {gridSize[0], gridSize[1], gridSize[2], gridSize[3]};
+  initCommsGridQuda(4, grid, nullptr, nullptr);
+
+  char prefix[64];
+  snprintf(prefix, sizeof(prefix), "Group %d: ", farm->groupId);
+  setOutputPrefix(prefix);
+
+  return farm;
+}
+
+
+void finalizeFarmCommsMuGiq(FarmComm *farm){
+  comm_finalize(); //- Synchronizes over the group communicator, it must still be alive
+  delete farm;
+  MPI_Finalize();
+}
+
+
+void runFarmMuGiq(const FarmComm &farm, const std::string &taskList, const std::function<void(const FarmTask&)> &run){
+
+  std::vector<std::string> tasks = readFarmTaskList(taskList);
+
+  FarmQueue queue(farm, static_cast<long long>(tasks.size()));
+  for(long long t = queue.next(); t >= 0; t = queue.next()){
+    FarmTask task;
+    task.index = t;
+    std::istringstream iss(tasks[t]);
+    iss >> task.gaugeFile >> task.loopGaugeFile;
+    if(task.loopGaugeFile.empty()) task.loopGaugeFile = task.gaugeFile;
+    task.tag = farmTaskTag(task.gaugeFile);
+
+    printfQuda("Farm: Task %lld, gauge configuration %s, loop gauge configuration %s\n",
+	       t, task.gaugeFile.c_str(), task.loopGaugeFile.c_str());
+    run(task);
+  }
+  queue.report();
+}
@@ -0,0 +1,265 @@
+#include <grid_planner_mugiq.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+//- Number of steps of a binomial-tree collective over n processes
+inline static int treeSteps(int n){
+  int steps = 0;
+  for(int p=1;p<n;p*=2) steps++;
+  return steps;
+}
+
+
+GridPlanWorkload::GridPlanWorkload() :
+  L{0,0,0,0}, nProcs(1), nEv(1), Nmom(1), nLoop(1),
+  nHops{0,0,0,0},
+  siteBytes(0), cplxBytes(0),
+  haloAllDims(MUGIQ_BOOL_TRUE),
+  alpha(2.0e-6), beta(1.0e-10)
+{
+  setPrecision(sizeof(double));
+}
+
+
+void GridPlanWorkload::setPrecision(int realBytes){
+  cplxBytes = 2*realBytes;
+  siteBytes = 4*3*cplxBytes; //- Nspin x Ncolor complex numbers
+}
+
+
+bool GridPlanWorkload::addDisplaceEntries(const std::string &entries){
+
+  const std::string dirChar = "xyzt";
+
+  std::stringstream ss(entries);
+  std::string entry;
+  while(std::getline(ss, entry, ';')){
+    if(entry.empty()) continue;
+
+    //- Entries are of the form +z:1,8 or +z:3
+    size_t colon = entry.find(':');
+    if(colon == std::string::npos || colon != 2) return false;
+    if(entry[0] != '+' && entry[0] != '-') return false;
+    size_t dir = dirChar.find(entry[1]);
+    if(dir == std::string::npos) return false;
+
+    std::string lim = entry.substr(colon+1);
+    int start = 0, stop = 0;
+    size_t comma = lim.find(',');
+    start = atoi(lim.substr(0, comma).c_str());
+    stop  = (comma == std::string::npos) ? start : atoi(lim.substr(comma+1).c_str());
+    if(start > stop) std::swap(start, stop);
+    if(start < 1) return false;
+
+    //- Each eigenvector is displaced stop times, a trace is taken for each length in [start,stop]
+    nHops[dir] += stop;
+    nLoop += stop - start + 1;
+  }
+
+  return true;
+}
+
+
+bool GridPlanWorkload::addDisplacePaths(const std::string &paths){
+
+  const std::string dirChar = "xyzt";
+
+  std::stringstream ss(paths);
+  std::string path;
+  while(std::getline(ss, path, ';')){
+    if(path.empty()) continue;
+
+    //- Paths are sequences of hops, e.g. +z+z+x-z, one trace is taken at the end of the path
+    if(path.size() % 2 != 0) return false;
+    for(size_t i=0;i<path.size();i+=2){
+      if(path[i] != '+' && path[i] != '-') return false;
+      size_t dir = dirChar.find(path[i+1]);
+      if(dir == std::string::npos) return false;
+      nHops[dir]++;
+    }
+    nLoop++;
+  }
+
+  return true;
+}
+
+
+bool GridPlanWorkload::addDisplaceDerivatives(const std::string &derivs){
+
+  const std::string dirChar = "xyzt";
+
+  std::stringstream ss(derivs);
+  std::string deriv;
+  while(std::getline(ss, deriv, ';')){
+    if(deriv.empty()) continue;
+    if(deriv.size() != 1) return false;
+    size_t dir = dirChar.find(deriv[0]);
+    if(dir == std::string::npos) return false;
+    nHops[dir] += 2;
+    nLoop++;
+  }
+
+  return true;
+}
+//---------------------------------------------------------------------------
+
+
+bool gridPlanValid(const GridPlanWorkload &w, const int grid[]){
+  int nProcs = 1;
+  for(int d=0;d<GRID_PLAN_NDIM;d++){
+    if(grid[d] < 1 || w.L[d] % grid[d] != 0) return false;
+    if((w.L[d] / grid[d]) % 2 != 0) return false;
+    nProcs *= grid[d];
+  }
+  return nProcs == w.nProcs;
+}
+
+
+GridPlanCost gridPlanCost(const GridPlanWorkload &w, const int grid[]){
+
+  GridPlanCost c;
+
+  double locV = 1.0;
+  for(int d=0;d<GRID_PLAN_NDIM;d++){
+    c.grid[d] = grid[d];
+    c.lL[d] = w.L[d] / grid[d];
+    locV *= c.lL[d];
+  }
+
+  //- Displacement halos: a hop along an unpartitioned direction needs no ghosts and exchanges nothing,
+  //- otherwise each rank sends one face per partitioned dimension and direction it exchanges
+  c.haloBytes = 0.0;
+  c.haloMsgs = 0;
+  for(int d=0;d<GRID_PLAN_NDIM;d++){
+    if(w.nHops[d] == 0 || grid[d] == 1) continue;
+    const double hops = static_cast<double>(w.nHops[d]) * w.nEv;
+
+    double bytesPerHop = 0.0;
+    long long msgsPerHop = 0;
+    if(w.haloAllDims){
+      for(int d2=0;d2<GRID_PLAN_NDIM;d2++){
+	if(grid[d2] == 1) continue;
+	bytesPerHop += 2.0 * (locV / c.lL[d2]) * w.siteBytes;
+	msgsPerHop  += 2;
+      }
+    }
+    else{
+      bytesPerHop = (locV / c.lL[d]) * w.siteBytes;
+      msgsPerHop  = 1;
+    }
+    c.haloBytes += hops * bytesPerHop;
+    c.haloMsgs  += static_cast<long long>(hops) * msgsPerHop;
+  }
+  c.haloTime = c.haloMsgs * w.alpha + c.haloBytes * w.beta;
+
+  //- Momentum projection: reduce over the ranks with the same time coordinate, gather over time, broadcast to all
+  const int nSpace = w.nProcs / grid[GRID_PLAN_NDIM-1];
+  const int nTime  = grid[GRID_PLAN_NDIM-1];
+  const double msgLoc = 16.0 * w.Nmom * w.nLoop * c.lL[GRID_PLAN_NDIM-1] * w.cplxBytes; //- N_GAMMA x Nmom x nLoop x locT
+  const double msgTot = msgLoc * nTime;
+
+  c.reduceBytes = treeSteps(nSpace) * msgLoc;
+  c.gatherBytes = (nTime - 1) * msgLoc;
+  c.bcastBytes  = treeSteps(w.nProcs) * msgTot;
+  c.momTime = (treeSteps(nSpace) + treeSteps(nTime) + treeSteps(w.nProcs)) * w.alpha +
+    (c.reduceBytes + c.gatherBytes + c.bcastBytes) * w.beta;
+
+  c.total = c.haloTime + c.momTime;
+
+  return c;
+}
+
+
+std::vector<GridPlanCost> planProcessGrid(const GridPlanWorkload &w){
+
+  std::vector<GridPlanCost> plans;
+
+  //- Enumerate all factorizations of nProcs into four dimensions
+  int grid[GRID_PLAN_NDIM];
+  for(grid[0]=1;grid[0]<=w.nProcs;grid[0]++){
+    if(w.nProcs % grid[0] != 0) continue;
+    for(grid[1]=1;grid[1]<=w.nProcs/grid[0];grid[1]++){
+      if((w.nProcs/grid[0]) % grid[1] != 0) continue;
+      for(grid[2]=1;grid[2]<=w.nProcs/(grid[0]*grid[1]);grid[2]++){
+	if((w.nProcs/(grid[0]*grid[1])) % grid[2] != 0) continue;
+	grid[3] = w.nProcs / (grid[0]*grid[1]*grid[2]);
+	if(gridPlanValid(w, grid)) plans.push_back(gridPlanCost(w, grid));
+      }
+    }
+  }
+
+  //- Cheapest first, ties broken towards fewer hops along partitioned directions, i.e. away from partitioning the
+  //- most displaced directions, then towards fewer partitioned dimensions and then towards partitioning time
+  auto partHops = [&](const GridPlanCost &c){
+    long long n = 0;
+    for(int d=0;d<GRID_PLAN_NDIM;d++) if(c.grid[d] > 1) n += w.nHops[d];
+    return n;
+  };
+  auto nPart = [](const GridPlanCost &c){
+    int n = 0;
+    for(int d=0;d<GRID_PLAN_NDIM;d++) n += (c.grid[d] > 1);
+    return n;
+  };
+  std::stable_sort(plans.begin(), plans.end(), [&](const GridPlanCost &a, const GridPlanCost &b){
+      if(a.total != b.total) return a.total < b.total;
+      if(partHops(a) != partHops(b)) return partHops(a) < partHops(b);
+      if(nPart(a) != nPart(b)) return nPart(a) < nPart(b);
+      return a.grid[GRID_PLAN_NDIM-1] > b.grid[GRID_PLAN_NDIM-1];
+    });
+
+  return plans;
+}
+
+
+std::string gridPlanReport(const GridPlanWorkload &w, const std::vector<GridPlanCost> &plans,
+			   const int userGrid[], int nShow){
+
+  std::ostringstream out;
+  char line[512];
+
+  snprintf(line, sizeof(line), "Grid planner: lattice %dx%dx%dx%d on %d processes, nEv = %d, Nmom = %d, nLoop = %d\n",
+	   w.L[0], w.L[1], w.L[2], w.L[3], w.nProcs, w.nEv, w.Nmom, w.nLoop);
+  out << line;
+  snprintf(line, sizeof(line), "Grid planner: hops/eigenvector (x,y,z,t) = %lld %lld %lld %lld, halo of %s, alpha = %.2e s, beta = %.2e s/byte\n",
+	   w.nHops[0], w.nHops[1], w.nHops[2], w.nHops[3],
+	   w.haloAllDims ? "all partitioned dimensions" : "the displacement direction", w.alpha, w.beta);
+  out << line;
+
+  if(plans.empty()){
+    out << "Grid planner: No process grid divides the lattice into even local dimensions\n";
+    return out.str();
+  }
+
+  snprintf(line, sizeof(line), "  %-12s %-14s %12s %12s %12s %12s %12s %12s\n",
+	   "grid", "local", "halo(MB)", "halo msgs", "mom(MB)", "halo(s)", "mom(s)", "total(s)");
+  out << line;
+
+  auto printPlan = [&](const GridPlanCost &c, const char *tag){
+    char g[32], l[32];
+    snprintf(g, sizeof(g), "%dx%dx%dx%d", c.grid[0], c.grid[1], c.grid[2], c.grid[3]);
+    snprintf(l, sizeof(l), "%dx%dx%dx%d", c.lL[0], c.lL[1], c.lL[2], c.lL[3]);
+    snprintf(line, sizeof(line), "  %-12s %-14s %12.3f %12lld %12.3f %12.4e %12.4e %12.4e %s\n",
+	     g, l, c.haloBytes/1.0e6, c.haloMsgs, (c.reduceBytes + c.gatherBytes + c.bcastBytes)/1.0e6,
+	     c.haloTime, c.momTime, c.total, tag);
+    out << line;
+  };
+
+  const int n = std::min(nShow, static_cast<int>(plans.size()));
+  for(int i=0;i<n;i++) printPlan(plans[i], i == 0 ? "<- recommended" : "");
+
+  if(userGrid){
+    if(gridPlanValid(w, userGrid)){
+      GridPlanCost u = gridPlanCost(w, userGrid);
+      printPlan(u, "<- user grid");
+      snprintf(line, sizeof(line), "Grid planner: Estimated speedup of the communication over the user grid: %.2f\n",
+	       plans[0].total > 0 ? u.total / plans[0].total : 1.0);
+      out << line;
+    }
+    else out << "Grid planner: The user grid is not compatible with the lattice\n";
+  }
+
+  return out.str();
+}
@@ -0,0 +1,81 @@
+#include <host_blas_mugiq.h>
+
+#ifdef MUGIQ_LAPACK
+extern "C" void cgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k,
+		       const std::complex<float> *alpha, const std::complex<float> *a, const int *lda,
+		       const std::complex<float> *b, const int *ldb, const std::complex<float> *beta,
+		       std::complex<float> *c, const int *ldc);
+extern "C" void zgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k,
+		       const std::complex<double> *alpha, const std::complex<double> *a, const int *lda,
+		       const std::complex<double> *b, const int *ldb, const std::complex<double> *beta,
+		       std::complex<double> *c, const int *ldc);
+
+
+static void gemmBlas(const char *transA, const int *m, const int *n, const int *k, const std::complex<float> *alpha,
+		     const std::complex<float> *A, const int *lda, const std::complex<float> *B, const int *ldb,
+		     const std::complex<float> *beta, std::complex<float> *C, const int *ldc){
+  const char transB = 'N';
+  cgemm_(transA, &transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+static void gemmBlas(const char *transA, const int *m, const int *n, const int *k, const std::complex<double> *alpha,
+		     const std::complex<double> *A, const int *lda, const std::complex<double> *B, const int *ldb,
+		     const std::complex<double> *beta, std::complex<double> *C, const int *ldc){
+  const char transB = 'N';
+  zgemm_(transA, &transB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+#endif
+
+
+template <typename Float>
+void gemmHost(char transA, int m, int n, int k, std::complex<Float> alpha, const std::complex<Float> *A, int lda,
+	      const std::complex<Float> *B, int ldb, std::complex<Float> beta, std::complex<Float> *C, int ldc){
+
+  if(transA != 'N' && transA != 'C') errorQuda("%s: Unsupported transA = %c\n", __func__, transA);
+  if(m <= 0 || n <= 0) return;
+
+#ifdef MUGIQ_LAPACK
+  gemmBlas(&transA, &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc);
+#else
+  for(int j=0;j<n;j++){
+    const Float *b = reinterpret_cast<const Float*>(B + static_cast<size_t>(j)*ldb);
+    std::complex<Float> *c = C + static_cast<size_t>(j)*ldc;
+
+    if(transA == 'C'){
+      //- c_i = alpha a_i^dag b + beta c_i, a_i the columns of A: one contiguous dot product per element
+      for(int i=0;i<m;i++){
+	const Float *a = reinterpret_cast<const Float*>(A + static_cast<size_t>(i)*lda);
+	Float re = 0.0, im = 0.0;
+	for(int l=0;l<k;l++){
+	  re += a[2*l] * b[2*l] + a[2*l+1] * b[2*l+1];
+	  im += a[2*l] * b[2*l+1] - a[2*l+1] * b[2*l];
+	}
+	c[i] = alpha * std::complex<Float>(re, im) + (beta == Float(0.0) ? std::complex<Float>(0.0) : beta * c[i]);
+      }
+    }
+    else{
+      //- c = alpha Sum_l b_l a_l + beta c, a_l the columns of A: one contiguous axpy per element of b
+      Float *cf = reinterpret_cast<Float*>(c);
+      if(beta == Float(0.0)) std::fill(c, c + m, std::complex<Float>(0.0));
+      else if(beta != Float(1.0)) for(int i=0;i<m;i++) c[i] *= beta;
+      for(int l=0;l<k;l++){
+	const std::complex<Float> s = alpha * std::complex<Float>(b[2*l], b[2*l+1]);
+	const Float sr = s.real(), si = s.imag();
+	const Float *a = reinterpret_cast<const Float*>(A + static_cast<size_t>(l)*lda);
+	for(int i=0;i<m;i++){
+	  cf[2*i]   += sr * a[2*i] - si * a[2*i+1];
+	  cf[2*i+1] += sr * a[2*i+1] + si * a[2*i];
+	}
+      }
+    }
+  }
+#endif
+}
+
+
+template void gemmHost<float>(char transA, int m, int n, int k, std::complex<float> alpha, const std::complex<float> *A,
+			      int lda, const std::complex<float> *B, int ldb, std::complex<float> beta,
+			      std::complex<float> *C, int ldc);
+template void gemmHost<double>(char transA, int m, int n, int k, std::complex<double> alpha, const std::complex<double> *A,
+			       int lda, const std::complex<double> *B, int ldb, std::complex<double> beta,
+			       std::complex<double> *C, int ldc);
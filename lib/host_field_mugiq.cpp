@@ -0,0 +1,422 @@
+#include <host_field_mugiq.h>
+#include <farm_mugiq.h>
+#include <cstring>
+#include <climits>
+
+HostGeom::HostGeom(const int lL_[], const int commDim_[], const int commCoord_[], const int nbrRank_[][2], MPI_Comm comm_) :
+  lL{lL_[0], lL_[1], lL_[2], lL_[3]},
+  commDim{commDim_[0], commDim_[1], commDim_[2], commDim_[3]},
+  commCoord{commCoord_[0], commCoord_[1], commCoord_[2], commCoord_[3]},
+  comm(comm_),
+  volume(1), volumeCB(0)
+{
+  for(int d=0;d<N_DIM_;d++){
+    nbrRank[d][0] = nbrRank_[d][0];
+    nbrRank[d][1] = nbrRank_[d][1];
+    volume *= lL[d];
+    if(lL[d] % 2 != 0) errorQuda("%s: Local lattice dimensions must be even, got L[%d] = %d\n", __func__, d, lL[d]);
+  }
+  volumeCB = volume/2;
+  for(int d=0;d<N_DIM_;d++) faceVolume[d] = volume/lL[d];
+}
+
+
+HostGeom::HostGeom(const int lL_[]) :
+  lL{lL_[0], lL_[1], lL_[2], lL_[3]},
+  comm(getCommMugiq()),
+  volume(1), volumeCB(0)
+{
+  for(int d=0;d<N_DIM_;d++){
+    commDim[d]   = comm_dim_partitioned(d);
+    commCoord[d] = comm_coord(d);
+    nbrRank[d][static_cast<int>(MUGIQ_BOUNDARY_BACKWARD)] = comm_neighbor_rank(0, d);
+    nbrRank[d][static_cast<int>(MUGIQ_BOUNDARY_FORWARD)]  = comm_neighbor_rank(1, d);
+    volume *= lL[d];
+    if(lL[d] % 2 != 0) errorQuda("%s: Local lattice dimensions must be even, got L[%d] = %d\n", __func__, d, lL[d]);
+  }
+  volumeCB = volume/2;
+  for(int d=0;d<N_DIM_;d++) faceVolume[d] = volume/lL[d];
+}
+
+
+void HostGeom::print() const {
+  printfQuda("HostGeom: Local lattice size (x,y,z,t): %d %d %d %d\n", lL[0], lL[1], lL[2], lL[3]);
+  printfQuda("HostGeom: Partitioned dimensions (x,y,z,t): %d %d %d %d\n", commDim[0], commDim[1], commDim[2], commDim[3]);
+  printfQuda("HostGeom: Local volume: %d, checkerboard volume: %d\n", volume, volumeCB);
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+HostColorSpinorField<Float>::HostColorSpinorField(const HostGeom &geom_, int nSpin_, int nColor_) :
+  geom(geom_),
+  nSpin(nSpin_), nColor(nColor_), siteLen(nSpin_*nColor_),
+  v(nullptr), ownData(MUGIQ_BOOL_TRUE),
+  ghostDepth{{0,0},{0,0},{0,0},{0,0}}
+{
+  v = static_cast<std::complex<Float>*>(calloc(Length(), sizeof(std::complex<Float>)));
+  if(v == NULL) errorQuda("%s: Could not allocate host color-spinor field\n", __func__);
+}
+
+
+template <typename Float>
+HostColorSpinorField<Float>::HostColorSpinorField(const HostGeom &geom_, int nSpin_, int nColor_, std::complex<Float> *v_) :
+  geom(geom_),
+  nSpin(nSpin_), nColor(nColor_), siteLen(nSpin_*nColor_),
+  v(v_), ownData(MUGIQ_BOOL_FALSE),
+  ghostDepth{{0,0},{0,0},{0,0},{0,0}}
+{
+  if(v == nullptr) errorQuda("%s: Got NULL storage\n", __func__);
+}
+
+
+template <typename Float>
+HostColorSpinorField<Float>::~HostColorSpinorField(){
+  if(ownData && v) free(v);
+  v = nullptr;
+}
+
+
+template <typename Float>
+void HostColorSpinorField<Float>::allocateGhost(int dim, int bnd, int depth){
+  if(depth > geom.lL[dim])
+    errorQuda("%s: Ghost depth %d exceeds the local extent %d of dimension %d\n", __func__, depth, geom.lL[dim], dim);
+  if(depth <= ghostDepth[dim][bnd]) return;
+  ghost[dim][bnd].resize(static_cast<size_t>(depth) * geom.faceVolume[dim] * siteLen);
+  ghostDepth[dim][bnd] = depth;
+}
+
+
+template <typename Float>
+void HostColorSpinorField<Float>::zero(){
+  const long long len = Length();
+#pragma omp parallel for
+  for(long long i=0;i<len;i++) v[i] = 0.0;
+}
+
+
+template <typename Float>
+void HostColorSpinorField<Float>::copy(const HostColorSpinorField<Float> &src){
+  if(src.Length() != Length()) errorQuda("%s: Fields have different lengths\n", __func__);
+  const long long len = Length();
+  const std::complex<Float> *s = src.V();
+#pragma omp parallel for
+  for(long long i=0;i<len;i++) v[i] = s[i];
+}
+
+
+template <typename Float>
+double HostColorSpinorField<Float>::norm2Local() const {
+  const long long len = Length();
+  double nrm = 0.0;
+#pragma omp parallel for reduction(+:nrm)
+  for(long long i=0;i<len;i++) nrm += std::norm(v[i]);
+  return nrm;
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+HostGaugeField<Float>::HostGaugeField(const HostGeom &geom_, void *gauge[], QudaPrecision cpuPrec,
+				      QudaReconstructType recon_) :
+  geom(geom_),
+  recon(recon_),
+  linkLen(GAUGE_SITE_LEN_)
+{
+  switch(recon){
+  case QUDA_RECONSTRUCT_NO: linkLen = GAUGE_SITE_LEN_; break;
+  case QUDA_RECONSTRUCT_12: linkLen = 2*N_COLOR_; break;
+  case QUDA_RECONSTRUCT_8:  linkLen = 4; break;
+  default: errorQuda("%s: Unsupported link reconstruction %d\n", __func__, static_cast<int>(recon));
+  }
+
+  for(int dir=0;dir<N_DIM_;dir++){
+    links[dir].resize(static_cast<size_t>(geom.volume) * linkLen);
+    if(geom.commDim[dir]) ghostLinks[dir].resize(static_cast<size_t>(geom.faceVolume[dir]) * linkLen);
+    lastSliceSign[dir] = ghostSign[dir] = 1.0;
+  }
+  if(gauge) loadGauge(gauge, cpuPrec);
+}
+
+
+template <typename Float>
+size_t HostGaugeField<Float>::Bytes() const {
+  size_t bytes = 0;
+  for(int dir=0;dir<N_DIM_;dir++) bytes += (links[dir].size() + ghostLinks[dir].size()) * sizeof(std::complex<Float>);
+  return bytes;
+}
+
+
+template <typename Float>
+void HostGaugeField<Float>::packLink(std::complex<Float> *out, const std::complex<Float> U[]) const {
+  if(recon == QUDA_RECONSTRUCT_12){
+    for(int i=0;i<2*N_COLOR_;i++) out[i] = U[i];
+  }
+  else{
+    out[0] = std::complex<Float>(std::arg(U[GAUGE_SITE_IDX(0,0)]), std::arg(U[GAUGE_SITE_IDX(2,0)]));
+    out[1] = U[GAUGE_SITE_IDX(0,1)];
+    out[2] = U[GAUGE_SITE_IDX(0,2)];
+    out[3] = U[GAUGE_SITE_IDX(1,0)];
+  }
+}
+
+
+template <typename Float>
+void HostGaugeField<Float>::loadGauge(void *gauge[], QudaPrecision cpuPrec){
+
+  if(cpuPrec != QUDA_DOUBLE_PRECISION && cpuPrec != QUDA_SINGLE_PRECISION)
+    errorQuda("%s: Unsupported gauge field precision %d\n", __func__, static_cast<int>(cpuPrec));
+
+  //- QDP order: one array per direction, sites in even/odd order, 18 reals per link
+  auto qdpLink = [&](int dir, long long i) -> std::complex<Float> {
+    if(cpuPrec == QUDA_DOUBLE_PRECISION){
+      const double *g = static_cast<const double*>(gauge[dir]);
+      return std::complex<Float>(g[2*i], g[2*i+1]);
+    }
+    const float *g = static_cast<const float*>(gauge[dir]);
+    return std::complex<Float>(g[2*i], g[2*i+1]);
+  };
+
+  const long long len = static_cast<long long>(geom.volume) * GAUGE_SITE_LEN_;
+  for(int dir=0;dir<N_DIM_;dir++){
+    if(gauge[dir] == nullptr) errorQuda("%s: Gauge field pointer for direction %d is NULL\n", __func__, dir);
+    std::complex<Float> *U = links[dir].data();
+    if(recon == QUDA_RECONSTRUCT_NO){
+#pragma omp parallel for
+      for(long long i=0;i<len;i++) U[i] = qdpLink(dir, i);
+      continue;
+    }
+
+    //- Compressed links: check that each link is unitary with determinant +1, or -1 on the whole last slice,
+    //- and store the SU(3) matrix sign*U
+    const double tol = (cpuPrec == QUDA_DOUBLE_PRECISION && sizeof(Float) == sizeof(double)) ? 1e-10 : 1e-5;
+    int nBad = 0, nPlusLast = 0, nMinusLast = 0;
+#pragma omp parallel for reduction(+:nBad,nPlusLast,nMinusLast)
+    for(int idx=0;idx<geom.volume;idx++){
+      std::complex<Float> W[GAUGE_SITE_LEN_];
+      for(int i=0;i<GAUGE_SITE_LEN_;i++) W[i] = qdpLink(dir, static_cast<long long>(idx)*GAUGE_SITE_LEN_ + i);
+
+      double dev = 0.0;
+      for(int i=0;i<N_COLOR_;i++)
+	for(int j=0;j<N_COLOR_;j++){
+	  std::complex<double> s = 0.0;
+	  for(int k=0;k<N_COLOR_;k++) s += std::complex<double>(W[GAUGE_SITE_IDX(i,k)] * std::conj(W[GAUGE_SITE_IDX(j,k)]));
+	  dev = std::max(dev, std::abs(s - (i == j ? 1.0 : 0.0)));
+	}
+      const std::complex<Float> *a = W, *b = W + N_COLOR_, *c = W + 2*N_COLOR_;
+      const std::complex<double> det = c[0]*(a[1]*b[2] - a[2]*b[1]) + c[1]*(a[2]*b[0] - a[0]*b[2]) + c[2]*(a[0]*b[1] - a[1]*b[0]);
+      const Float sign = (det.real() < 0) ? -1.0 : 1.0;
+      dev = std::max(dev, std::abs(det - static_cast<double>(sign)));
+      if(dev > tol) nBad++;
+
+      int x[N_DIM_];
+      const int pty = idx / geom.volumeCB;
+      geom.getCoords(x, idx - pty*geom.volumeCB, pty);
+      if(x[dir] == geom.lL[dir]-1){
+	if(sign > 0) nPlusLast++;
+	else nMinusLast++;
+      }
+      else if(sign < 0) nBad++;
+
+      for(int i=0;i<GAUGE_SITE_LEN_;i++) W[i] *= sign;
+      packLink(U + static_cast<size_t>(idx)*linkLen, W);
+    }
+    if(nBad > 0 || (nPlusLast > 0 && nMinusLast > 0))
+      errorQuda("%s: Links of direction %d are not SU(3) (up to a sign on the last slice), they cannot be compressed with reconstruction %d\n",
+		__func__, dir, static_cast<int>(recon));
+    lastSliceSign[dir] = (nMinusLast > 0) ? -1.0 : 1.0;
+  }
+
+  exchangeGhost();
+}
+
+
+template <typename Float>
+void HostGaugeField<Float>::exchangeGhost(){
+
+  MPI_Datatype dataTypeMPI = (sizeof(Float) == sizeof(double)) ? MPI_DOUBLE_COMPLEX : MPI_COMPLEX;
+  MPI_Datatype signTypeMPI = (sizeof(Float) == sizeof(double)) ? MPI_DOUBLE : MPI_FLOAT;
+  const int bwd = static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+  const int fwd = static_cast<int>(MUGIQ_BOUNDARY_FORWARD);
+
+  for(int dir=0;dir<N_DIM_;dir++){
+    if(!geom.commDim[dir]) continue;
+
+    //- Send the links on the last slice forward, they are U_dir(x-dir) for the forward neighbour's first slice
+    const int fVol = geom.faceVolume[dir];
+    std::vector<std::complex<Float>> sendBuf(static_cast<size_t>(fVol) * linkLen);
+#pragma omp parallel for
+    for(int f=0;f<fVol;f++){
+      int x[N_DIM_];
+      geom.faceCoords(x, f, dir);
+      x[dir] = geom.lL[dir] - 1;
+      const std::complex<Float> *U = LinkData(dir, geom.siteIndex(x));
+      for(int i=0;i<linkLen;i++) sendBuf[static_cast<size_t>(f)*linkLen + i] = U[i];
+    }
+
+    MPI_Sendrecv(sendBuf.data(), fVol*linkLen, dataTypeMPI, geom.nbrRank[dir][fwd], 200+dir,
+		 ghostLinks[dir].data(), fVol*linkLen, dataTypeMPI, geom.nbrRank[dir][bwd], 200+dir,
+		 geom.comm, MPI_STATUS_IGNORE);
+    if(recon != QUDA_RECONSTRUCT_NO)
+      MPI_Sendrecv(&lastSliceSign[dir], 1, signTypeMPI, geom.nbrRank[dir][fwd], 210+dir,
+		   &ghostSign[dir], 1, signTypeMPI, geom.nbrRank[dir][bwd], 210+dir,
+		   geom.comm, MPI_STATUS_IGNORE);
+  }
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+HostHaloExchange<Float>::HostHaloExchange() :
+  unpackDepth{{0,0},{0,0},{0,0},{0,0}},
+  dataTypeMPI((sizeof(Float) == sizeof(double)) ? MPI_DOUBLE_COMPLEX : MPI_COMPLEX),
+  maxMsgLen(INT_MAX),
+  nMsg(0), nBytes(0)
+{ }
+
+
+template <typename Float>
+HostHaloExchange<Float>::~HostHaloExchange(){
+  if(inFlight()) wait();
+}
+
+
+template <typename Float>
+void HostHaloExchange<Float>::setMaxMessageLength(long long n){
+  if(n < 1 || n > INT_MAX) errorQuda("%s: Invalid maximum message length %lld\n", __func__, n);
+  if(inFlight()) errorQuda("%s: Cannot change the maximum message length with messages in flight\n", __func__);
+  maxMsgLen = n;
+}
+
+
+template <typename Float>
+void HostHaloExchange<Float>::post(std::complex<Float> *recv, std::complex<Float> *send, long long msgLen,
+				   int src, int dest, int tag, MPI_Comm comm){
+  //- The MPI count is an int, longer messages go out in chunks of at most maxMsgLen elements. Messages between the same
+  //- pair of ranks with the same tag are matched in the order they are posted, so the chunks land in place
+  for(long long off=0;off<msgLen;off+=maxMsgLen){
+    const int n = static_cast<int>(std::min(maxMsgLen, msgLen - off));
+    MPI_Request r[2];
+    MPI_Irecv(recv + off, n, dataTypeMPI, src, tag, comm, &r[0]);
+    MPI_Isend(send + off, n, dataTypeMPI, dest, tag, comm, &r[1]);
+    req.push_back(r[0]);
+    req.push_back(r[1]);
+    nMsg++;
+    nBytes += static_cast<long long>(n) * sizeof(std::complex<Float>);
+  }
+}
+
+
+template <typename Float>
+void HostHaloExchange<Float>::start(HostColorSpinorField<Float> &x, int dim, DisplaceSign dispSign, int depth){
+
+  const HostGeom &geom = x.Geom();
+  if(!geom.commDim[dim]) return;
+
+  //- dispSign = +: receive the forward neighbour's first slices, send our first slices backwards
+  //- dispSign = -: receive the backward neighbour's last slices, send our last slices forward
+  const int bnd  = (dispSign == DispSignPlus) ? static_cast<int>(MUGIQ_BOUNDARY_FORWARD) : static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+  const int dest = geom.nbrRank[dim][1-bnd];
+  const int src  = geom.nbrRank[dim][bnd];
+  const int tag  = 100 + 2*dim + bnd;
+
+  x.allocateGhost(dim, bnd, depth);
+
+  const int siteLen = x.SiteLength();
+  const int fVol = geom.faceVolume[dim];
+  const long long msgLen = static_cast<long long>(depth) * fVol * siteLen;
+  std::vector<std::complex<Float>> &buf = sendBuf[dim][bnd];
+  if(static_cast<long long>(buf.size()) < msgLen) buf.resize(msgLen);
+
+#pragma omp parallel for collapse(2)
+  for(int layer=0;layer<depth;layer++){
+    for(int f=0;f<fVol;f++){
+      int c[N_DIM_];
+      geom.faceCoords(c, f, dim);
+      c[dim] = (dispSign == DispSignPlus) ? layer : geom.lL[dim] - 1 - layer;
+      const std::complex<Float> *s = x.Site(geom.siteIndex(c));
+      std::complex<Float> *b = &(buf[(static_cast<long long>(layer)*fVol + f) * siteLen]);
+      for(int i=0;i<siteLen;i++) b[i] = s[i];
+    }
+  }
+
+  post(x.Ghost(dim, bnd), buf.data(), msgLen, src, dest, tag, geom.comm);
+}
+
+
+template <typename Float>
+void HostHaloExchange<Float>::start(std::vector<HostColorSpinorField<Float>*> &x, int dim, DisplaceSign dispSign, int depth){
+
+  if(x.empty()) return;
+  const HostGeom &geom = x[0]->Geom();
+  if(!geom.commDim[dim]) return;
+
+  const int bnd  = (dispSign == DispSignPlus) ? static_cast<int>(MUGIQ_BOUNDARY_FORWARD) : static_cast<int>(MUGIQ_BOUNDARY_BACKWARD);
+  const int dest = geom.nbrRank[dim][1-bnd];
+  const int src  = geom.nbrRank[dim][bnd];
+  const int tag  = 100 + 2*dim + bnd;
+
+  if(!unpackVec[dim][bnd].empty()) errorQuda("%s: A batched exchange in (%d,%d) is already in flight\n", __func__, dim, bnd);
+
+  const int nVec = static_cast<int>(x.size());
+  const int siteLen = x[0]->SiteLength();
+  const int fVol = geom.faceVolume[dim];
+  const long long vecLen = static_cast<long long>(depth) * fVol * siteLen;
+  const long long msgLen = vecLen * nVec;
+  std::vector<std::complex<Float>> &buf = sendBuf[dim][bnd];
+  if(static_cast<long long>(buf.size()) < msgLen) buf.resize(msgLen);
+  if(static_cast<long long>(recvBuf[dim][bnd].size()) < msgLen) recvBuf[dim][bnd].resize(msgLen);
+
+  //- Message layout: face-inside-layer-inside-vector
+#pragma omp parallel for collapse(2)
+  for(int layer=0;layer<depth;layer++){
+    for(int f=0;f<fVol;f++){
+      int c[N_DIM_];
+      geom.faceCoords(c, f, dim);
+      c[dim] = (dispSign == DispSignPlus) ? layer : geom.lL[dim] - 1 - layer;
+      const int idx = geom.siteIndex(c);
+      for(int iv=0;iv<nVec;iv++){
+	const std::complex<Float> *s = x[iv]->Site(idx);
+	std::complex<Float> *b = &(buf[iv*vecLen + (static_cast<long long>(layer)*fVol + f) * siteLen]);
+	for(int i=0;i<siteLen;i++) b[i] = s[i];
+      }
+    }
+  }
+
+  for(auto v: x) v->allocateGhost(dim, bnd, depth);
+  unpackVec[dim][bnd] = x;
+  unpackDepth[dim][bnd] = depth;
+
+  post(recvBuf[dim][bnd].data(), buf.data(), msgLen, src, dest, tag, geom.comm);
+}
+
+
+template <typename Float>
+void HostHaloExchange<Float>::wait(){
+  if(req.empty()) return;
+  MPI_Waitall(static_cast<int>(req.size()), req.data(), MPI_STATUSES_IGNORE);
+  req.clear();
+
+  for(int dim=0;dim<N_DIM_;dim++){
+    for(int bnd=0;bnd<2;bnd++){
+      std::vector<HostColorSpinorField<Float>*> &x = unpackVec[dim][bnd];
+      if(x.empty()) continue;
+      const long long vecLen = static_cast<long long>(unpackDepth[dim][bnd]) * x[0]->Geom().faceVolume[dim] * x[0]->SiteLength();
+      const std::complex<Float> *b = recvBuf[dim][bnd].data();
+      for(size_t iv=0;iv<x.size();iv++){
+	std::complex<Float> *g = x[iv]->Ghost(dim, bnd);
+#pragma omp parallel for
+	for(long long i=0;i<vecLen;i++) g[i] = b[iv*vecLen + i];
+      }
+      x.clear();
+    }
+  }
+}
+
+
+template class HostColorSpinorField<float>;
+template class HostColorSpinorField<double>;
+template class HostGaugeField<float>;
+template class HostGaugeField<double>;
+template class HostHaloExchange<float>;
+template class HostHaloExchange<double>;
@@ -29,6 +29,8 @@
 #include <mg_mugiq.h>
 #include <util_mugiq.h>
 #include <interface_mugiq.h>
+#include <loop_session.h>
+#include <farm_mugiq.h>
 
 #include <type_traits>
 
@@ -76,7 +78,7 @@ MG_Mugiq* newMG_Mugiq(QudaMultigridParam *mgParams, QudaEigParam *QudaEigParams)
 
 
 //- Compute the eigenvalues and eigenvectors of the coarse Dirac operator using MG
-void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam QudaEigParams){
+void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam QudaEigParams, MugiqEigOptions eigOptions){
 
   printfQuda("\n%s: Using MuGiq interface to compute eigenvectors of coarse Operator using MG!\n", __func__);
 
@@ -91,7 +93,7 @@ void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam QudaEigParam
 
   
   //- Create the eigensolver environment
-  MugiqEigParam *eigParams = new MugiqEigParam(&QudaEigParams);
+  MugiqEigParam *eigParams = new MugiqEigParam(&QudaEigParams, eigOptions);
   profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_TOTAL);
   profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_INIT);  
   Eigsolve_Mugiq *eigsolve = new Eigsolve_Mugiq(eigParams, mg_env, &profileEigensolveMuGiq);
@@ -119,7 +121,7 @@ void computeEvecsMuGiq_MG(QudaMultigridParam mgParams, QudaEigParam QudaEigParam
 
 
 //- Compute the eigenvalues and eigenvectors of the Dirac operator
-void computeEvecsMuGiq(QudaEigParam QudaEigParams){
+void computeEvecsMuGiq(QudaEigParam QudaEigParams, MugiqEigOptions eigOptions){
 
   printfQuda("\n%s: Using MuGiq interface to compute eigenvectors of Dirac operator!\n", __func__);
 
@@ -130,7 +132,7 @@ void computeEvecsMuGiq(QudaEigParam QudaEigParams){
   }  
   
   //- Create the eigensolver environment
-  MugiqEigParam *eigParams = new MugiqEigParam(&QudaEigParams);
+  MugiqEigParam *eigParams = new MugiqEigParam(&QudaEigParams, eigOptions);
   profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_TOTAL);
   profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_INIT);  
   Eigsolve_Mugiq *eigsolve = new Eigsolve_Mugiq(eigParams, &profileEigensolveMuGiq);
@@ -155,23 +157,172 @@ void computeEvecsMuGiq(QudaEigParam QudaEigParams){
   saveTuneCache();
 }
 
+//- GPU backend of the loop session
+//- The MG environment and the Loop_Mugiq environment (buffers, communicators, phase matrix, extended gauge field)
+//- are created with the first configuration and kept. So is the eigensolver with its eigenvector storage, only its
+//- operators are rebuilt for each configuration
 template <typename Float, QudaFieldOrder fieldOrder>
-void computeLoop(MugiqLoopParam loopParams, Eigsolve_Mugiq *eigsolve){
+class LoopSessionQuda : public LoopSessionBackend {
+
+private:
+
+  QudaMultigridParam mgParams;
+  QudaEigParam QudaEigParams;
+  MugiqLoopParam loopParams;
+
+  MuGiqBool computeCoarse;
+  MuGiqBool useMG;
+
+  MugiqEigParam *eigParams;
+  MG_Mugiq *mg_env;
+  Eigsolve_Mugiq *eigsolve;
+  Loop_Mugiq<Float,fieldOrder> *loop;
+
+public:
+
+  LoopSessionQuda(QudaMultigridParam *mgParams_, QudaEigParam *QudaEigParams_, MugiqLoopParam *loopParams_,
+		  MuGiqBool computeCoarse_, MuGiqBool useMG_) :
+    QudaEigParams(*QudaEigParams_),
+    loopParams(*loopParams_),
+    computeCoarse(computeCoarse_),
+    useMG(useMG_),
+    eigParams(nullptr),
+    mg_env(nullptr),
+    eigsolve(nullptr),
+    loop(nullptr)
+  {
+    if(useMG) mgParams = *mgParams_;
+  }
 
-  Loop_Mugiq<Float,fieldOrder> *loop = new Loop_Mugiq<Float,fieldOrder>(&loopParams, eigsolve);
-  
-  loop->computeCoarseLoop();
-  
-  if(loopParams.writeMomSpaceHDF5 != MUGIQ_BOOL_FALSE ||
-     loopParams.writePosSpaceHDF5 != MUGIQ_BOOL_FALSE)
+  const char* name() const { return "QUDA"; }
+
+  void setup(){
+    eigParams = new MugiqEigParam(&QudaEigParams, loopParams.eigOptions);
+    if(useMG) printfQuda("\n%s: Will compute disconnected loops using Multi-grid deflation!\n", __func__);
+    else printfQuda("\n%s: Will NOT use Multi-grid deflation to compute disconnected loops!\n", __func__);
+  }
+
+  void loadGauge(void *gauge[]){
+    for(int d=0;d<N_DIM_;d++) loopParams.gauge[d] = gauge[d];
+
+    //- The eigensolver is created with the first configuration. Later ones only rebuild its operators, the Dirac
+    //- matrices refer to the operators of the MG hierarchy so they are freed before the hierarchy is updated
+    profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_INIT);
+    if(eigsolve){
+      eigsolve->freeOperator();
+      if(useMG) mg_env->update();
+      //- loopParams.gauge are the links of the displacements, the host operator takes those of the fermion operator
+      eigsolve->loadGauge(eigParams->hostGauge, eigParams->hostClover);
+    }
+    else if(useMG){
+      mg_env = newMG_Mugiq(&mgParams, &QudaEigParams);
+      eigsolve = new Eigsolve_Mugiq(eigParams, mg_env, &profileEigensolveMuGiq, computeCoarse);
+    }
+    else eigsolve = new Eigsolve_Mugiq(eigParams, &profileEigensolveMuGiq);
+    profileEigensolveMuGiq.TPSTOP(QUDA_PROFILE_INIT);
+
+    eigsolve->printInfo();
+  }
+
+  void computeLoop(){
+    //- Load the eigenpairs from the cache when possible, otherwise compute eigenvectors and (local) eigenvalues
+    const MuGiqEvecCacheMode cacheMode = loopParams.evecCacheMode;
+    uint64_t gaugeChecksum = 0;
+    if(cacheMode != MUGIQ_EVEC_CACHE_NONE){
+      if(loopParams.evecCacheFile.empty()) errorQuda("%s: The eigenvector cache needs a file name\n", __func__);
+      const QudaGaugeParam &gParam = *(loopParams.gauge_param);
+      long long volume = 1;
+      for(int d=0;d<N_DIM_;d++) volume *= gParam.X[d];
+      gaugeChecksum = gaugeChecksumMugiq(loopParams.gauge, gParam.cpu_prec, volume, getCommMugiq());
+    }
+
+    MuGiqBool loaded = MUGIQ_BOOL_FALSE;
+    if(cacheMode == MUGIQ_EVEC_CACHE_LOAD) loaded = eigsolve->loadEvecs(loopParams.evecCacheFile, gaugeChecksum);
+    if(!loaded){
+      eigsolve->computeEvecs();
+      eigsolve->computeEvals();
+      if(cacheMode != MUGIQ_EVEC_CACHE_NONE) eigsolve->saveEvecs(loopParams.evecCacheFile, gaugeChecksum);
+    }
+    eigsolve->printEvals();
+
+    const QudaPrecision ePrec = eigsolve->getEvecs()[0]->Precision();
+    const int ePrecInt = static_cast<int>(ePrec);
+    if(ePrec == QUDA_SINGLE_PRECISION && typeid(Float) == typeid(float))
+      printfQuda("\n%s: Running in single precision!\n", __func__);
+    else if(ePrec == QUDA_DOUBLE_PRECISION && typeid(Float) == typeid(double))
+      printfQuda("\n%s: Running in double precision!\n", __func__);
+    else errorQuda("Missmatch between eigenvector precision %d and templated precision %zu\n", ePrecInt, sizeof(Float));
+
+    if(eigsolve->getEvecs()[0]->FieldOrder() != fieldOrder)
+      errorQuda("%s: Got FieldOrder = %d, expected %d from useMGenv and computeCoarse\n", __func__,
+		static_cast<int>(eigsolve->getEvecs()[0]->FieldOrder()), static_cast<int>(fieldOrder));
+
+    if(!loop) loop = new Loop_Mugiq<Float,fieldOrder>(&loopParams, eigsolve);
+    else loop->resetConfig(&loopParams, eigsolve);
+
+    loop->computeCoarseLoop();
+  }
+
+  void writeLoop(const std::string &fnameMom, const std::string &fnamePos){
+    if(loopParams.writeMomSpaceHDF5 == MUGIQ_BOOL_FALSE && loopParams.writePosSpaceHDF5 == MUGIQ_BOOL_FALSE){
+      warningQuda("%s: Will NOT write output data!\n", __func__);
+      return;
+    }
+    loopParams.fname_mom_h5 = fnameMom;
+    loopParams.fname_pos_h5 = fnamePos;
+    loop->resetOutput(&loopParams);
     loop->writeLoopsHDF5();
-  else warningQuda("%s: Will NOT write output data!\n", __func__);
+  }
 
-  //- Clean-up
-  delete loop;
+  void teardown(){
+    if(loop) delete loop;
+    loop = nullptr;
+
+    profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_FREE);
+    if(eigsolve) delete eigsolve;
+    eigsolve = nullptr;
+    profileEigensolveMuGiq.TPSTOP(QUDA_PROFILE_FREE);
+
+    if(mg_env) delete mg_env;
+    mg_env = nullptr;
+    if(eigParams) delete eigParams;
+    eigParams = nullptr;
+
+    saveTuneCache();
+  }
+};
+
+
+template <typename Float>
+LoopSession* newLoopSessionMuGiq(QudaMultigridParam *mgParams, QudaEigParam *QudaEigParams, MugiqLoopParam *loopParams,
+				 MuGiqBool computeCoarse, MuGiqBool useMG){
+
+  /** Loop_Mugiq is templated on the Field Order of the eigenvectors
+   *  QUDA_FLOAT2_FIELD_ORDER: This is set when running with MG AND using the coarse operator/eigenvectors
+   *  QUDA_FLOAT4_FIELD_ORDER: This is set when running with no MG, or with MG and the FINE operator/eigenvectors
+   */
+  LoopSessionBackend *backend = nullptr;
+  if(useMG && computeCoarse)
+    backend = new LoopSessionQuda<Float, QUDA_FLOAT2_FIELD_ORDER>(mgParams, QudaEigParams, loopParams, computeCoarse, useMG);
+  else
+    backend = new LoopSessionQuda<Float, QUDA_FLOAT4_FIELD_ORDER>(mgParams, QudaEigParams, loopParams, computeCoarse, useMG);
+
+  return new LoopSession(backend);
 }
 
+
+void computeLoopSessionMuGiq(LoopSession *session, MugiqLoopParam *loopParams){
+  session->processConfig(loopParams->gauge, loopParams->fname_mom_h5, loopParams->fname_pos_h5);
+}
+
+
+void destroyLoopSessionMuGiq(LoopSession *session){
+  delete session;
+}
+
+
 //- Compute disconnected loops, top level function
+//- This is a session that processes a single configuration
 template <typename Float>
 void computeLoop(QudaMultigridParam mgParams, QudaEigParam QudaEigParams, MugiqLoopParam loopParams,
 		 MuGiqBool computeCoarse, MuGiqBool useMG){
@@ -184,69 +335,23 @@ void computeLoop(QudaMultigridParam mgParams, QudaEigParam QudaEigParams, MugiqL
     printQudaEigParam(&QudaEigParams);
   }
 
-  //- Create the Multigrid environment
-  MG_Mugiq *mg_env = nullptr;  
-  Eigsolve_Mugiq *eigsolve = nullptr;
-  
-  //- Create the eigensolver environment
-  MugiqEigParam *eigParams = new MugiqEigParam(&QudaEigParams);
   profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_TOTAL);
-  profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_INIT);
-  if(useMG){
-    printfQuda("\n%s: Will compute disconnected loops using Multi-grid deflation!\n", __func__);  
-    mg_env = newMG_Mugiq(&mgParams, &QudaEigParams);
-    eigsolve = new Eigsolve_Mugiq(eigParams, mg_env, &profileEigensolveMuGiq, computeCoarse);
-  }
-  else{
-    printfQuda("\n%s: Will NOT use Multi-grid deflation to compute disconnected loops!\n", __func__);  
-    eigsolve = new Eigsolve_Mugiq(eigParams, &profileEigensolveMuGiq);
-  }
-  profileEigensolveMuGiq.TPSTOP(QUDA_PROFILE_INIT);
-
-  eigsolve->printInfo();
-  
-  //- Compute eigenvectors and (local) eigenvalues
-  eigsolve->computeEvecs();
-  eigsolve->computeEvals();
-  eigsolve->printEvals();
-  
-  const QudaPrecision ePrec = eigsolve->getEvecs()[0]->Precision();
-  const int ePrecInt = static_cast<int>(ePrec);
-  if(ePrec == QUDA_SINGLE_PRECISION && typeid(Float) == typeid(float))
-    printfQuda("\n%s: Running in single precision!\n", __func__);
-  else if(ePrec == QUDA_DOUBLE_PRECISION && typeid(Float) == typeid(double))
-    printfQuda("\n%s: Running in double precision!\n", __func__);
-  else errorQuda("Missmatch between eigenvector precision %d and templated precision %zu\n", ePrecInt, sizeof(Float));
-  
-  /** Compute loop, template on Field Order
-   *  Currently supported field orders are:
-   *  QUDA_FLOAT2_FIELD_ORDER: This is set when running with MG AND using the coarse operator/eigenvectors
-   *  QUDA_FLOAT4_FIELD_ORDER: This is set when running with no MG, or with MG and the FINE operator/eigenvectors
-   */
-  if(eigsolve->getEvecs()[0]->FieldOrder() == QUDA_FLOAT2_FIELD_ORDER){
-    if(!(useMG && computeCoarse))
-      errorQuda("%s: Got FieldOrder = FLOAT2, but useMGenv = FALSE and computeCoarse = FALSE\n", __func__);
-    computeLoop<Float, QUDA_FLOAT2_FIELD_ORDER>(loopParams, eigsolve);
-  }
-  else if(eigsolve->getEvecs()[0]->FieldOrder() == QUDA_FLOAT4_FIELD_ORDER){
-    if(useMG && computeCoarse)
-      errorQuda("%s: Got FieldOrder = FLOAT4, but useMGenv = TRUE and computeCoarse = TRUE\n", __func__);
-    computeLoop<Float, QUDA_FLOAT4_FIELD_ORDER>(loopParams, eigsolve);
-  }
 
-  //- Clean-up
-  profileEigensolveMuGiq.TPSTART(QUDA_PROFILE_FREE);
-  delete eigsolve;
-  profileEigensolveMuGiq.TPSTOP(QUDA_PROFILE_FREE);
-  if(useMG) delete mg_env;
+  LoopSession *session = newLoopSessionMuGiq<Float>(&mgParams, &QudaEigParams, &loopParams, computeCoarse, useMG);
+  computeLoopSessionMuGiq(session, &loopParams);
+  destroyLoopSessionMuGiq(session);
   
   profileEigensolveMuGiq.TPSTOP(QUDA_PROFILE_TOTAL);
   printProfileInfo(profileEigensolveMuGiq);
 
   popVerbosity();
-  saveTuneCache();
 }
 
+template LoopSession* newLoopSessionMuGiq<double>(QudaMultigridParam *mgParams, QudaEigParam *QudaEigParams, MugiqLoopParam *loopParams,
+						  MuGiqBool computeCoarse, MuGiqBool useMG);
+template LoopSession* newLoopSessionMuGiq<float>(QudaMultigridParam *mgParams, QudaEigParam *QudaEigParams, MugiqLoopParam *loopParams,
+						 MuGiqBool computeCoarse, MuGiqBool useMG);
+
 template void computeLoop<double>(QudaMultigridParam mgParams, QudaEigParam QudaEigParams, MugiqLoopParam loopParams,
 				  MuGiqBool computeCoarse, MuGiqBool useMG);
 template void computeLoop<float>(QudaMultigridParam mgParams, QudaEigParam QudaEigParams, MugiqLoopParam loopParams,
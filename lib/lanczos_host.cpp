@@ -0,0 +1,275 @@
+#include <lanczos_host.h>
+#include <eig_host.h>
+#include <host_blas_mugiq.h>
+#include <random>
+#include <climits>
+#include <numeric>
+
+
+template <typename Float>
+HostLanczos<Float>::HostLanczos(HostOperator<Float> &op_, const HostLanczosParam &param_) :
+  op(op_),
+  param(param_),
+  nRestart(0),
+  nConv(0),
+  nOp(0)
+{
+  if(param.nEv < 1 || param.nKr < param.nEv + 2)
+    errorQuda("%s: The Krylov space of %d vectors must exceed the %d eigenpairs by at least 2\n", __func__, param.nKr, param.nEv);
+  if(param.spectrum != MUGIQ_SPECTRUM_SR && param.spectrum != MUGIQ_SPECTRUM_LR)
+    errorQuda("%s: The thick-restart Lanczos computes the ends of the spectrum, SR or LR\n", __func__);
+  if(param.use_poly_acc && (param.poly_acc_deg < 1 || param.a_max <= param.a_min))
+    errorQuda("%s: Invalid Chebyshev polynomial, degree %d on [%e, %e]\n", __func__, param.poly_acc_deg, param.a_min, param.a_max);
+
+  //- The basis vectors are the columns of one matrix, so that the products with the whole basis are single GEMMs
+  len = static_cast<long long>(op.Geom().volume) * op.Nspin() * op.Ncolor();
+  if(len > INT_MAX) errorQuda("%s: The local length %lld of the Krylov vectors exceeds INT_MAX\n", __func__, len);
+  basis.resize(static_cast<size_t>(param.nKr + 1) * len);
+  for(int i=0;i<=param.nKr;i++)
+    kSpace.push_back(new HostColorSpinorField<Float>(op.Geom(), op.Nspin(), op.Ncolor(), basis.data() + i*len));
+  if(param.use_poly_acc)
+    for(int i=0;i<3;i++) cheb.push_back(new HostColorSpinorField<Float>(op.Geom(), op.Nspin(), op.Ncolor()));
+}
+
+
+template <typename Float>
+HostLanczos<Float>::~HostLanczos(){
+  for(auto v: kSpace) delete v;
+  for(auto v: cheb) delete v;
+}
+
+
+template <typename Float>
+void HostLanczos<Float>::applyPoly(HostColorSpinorField<Float> &out, HostColorSpinorField<Float> &in){
+
+  auto applyOp = [&](HostColorSpinorField<Float> &y, HostColorSpinorField<Float> &x){
+    std::vector<HostColorSpinorField<Float>*> yv(1, &y), xv(1, &x);
+    op.apply(yv, xv);
+    nOp++;
+  };
+
+  if(!param.use_poly_acc){
+    applyOp(out, in);
+    return;
+  }
+
+  //- T_k(s(A)) in with s(A) mapping [a_min, a_max] to [-1, 1], T_{k+1} = 2 s(A) T_k - T_{k-1}. As in QUDA,
+  //- s(A) = (c - A)/d for SR and (A - c)/d for LR, so that the wanted eigenvalues are mapped above 1, where T_k is
+  //- largest for any degree. With (A - c)/d for SR they would be mapped below -1, where T_k has the sign of (-1)^k
+  const Float d = (param.spectrum == MUGIQ_SPECTRUM_SR ? -1 : 1) * (param.a_max - param.a_min) / 2;
+  const Float c = (param.a_max + param.a_min) / 2;
+  const long long len = in.Length();
+  HostColorSpinorField<Float> *t0 = &in, *t1 = cheb[0], *t2 = cheb[1];
+
+  applyOp(*t1, in);
+#pragma omp parallel for
+  for(long long i=0;i<len;i++) t1->V()[i] = (t1->V()[i] - c * in.V()[i]) / d;
+
+  for(int k=2;k<=param.poly_acc_deg;k++){
+    applyOp(*t2, *t1);
+#pragma omp parallel for
+    for(long long i=0;i<len;i++) t2->V()[i] = static_cast<Float>(2) * (t2->V()[i] - c * t1->V()[i]) / d - t0->V()[i];
+    HostColorSpinorField<Float> *free = (t0 == &in) ? cheb[2] : t0;
+    t0 = t1;
+    t1 = t2;
+    t2 = free;
+  }
+
+  std::copy(t1->V(), t1->V() + len, out.V());
+}
+
+
+template <typename Float>
+void HostLanczos<Float>::orthogonalize(HostColorSpinorField<Float> &w, int n, std::vector<std::complex<double>> &h){
+
+  const HostGeom &geom = op.Geom();
+  const int siteLen = w.SiteLength();
+  const int tileSites = gemmTileSites<Float>(n + 1, siteLen, geom.volume);
+  const int nTile = (geom.volume + tileSites - 1) / tileSites;
+  std::vector<std::complex<double>> d(n, 0.0);
+
+  //- d = K^dag w, K the first n basis vectors as columns, one GEMM per tile of sites summed in double precision
+#pragma omp parallel
+  {
+    std::vector<std::complex<double>> dT(n, 0.0);
+    std::vector<std::complex<Float>> dTile(n);
+#pragma omp for
+    for(int t=0;t<nTile;t++){
+      const long long r0 = static_cast<long long>(t) * tileSites * siteLen;
+      const int rows = std::min(tileSites, geom.volume - t*tileSites) * siteLen;
+      gemmHost<Float>('C', n, 1, rows, 1.0, basis.data() + r0, len, w.V() + r0, rows, 0.0, dTile.data(), n);
+      for(int i=0;i<n;i++) dT[i] += std::complex<double>(dTile[i]);
+    }
+#pragma omp critical
+    for(int i=0;i<n;i++) d[i] += dT[i];
+  }
+  MPI_Allreduce(MPI_IN_PLACE, d.data(), 2*n, MPI_DOUBLE, MPI_SUM, geom.comm);
+
+  //- w -= K d
+  std::vector<std::complex<Float>> dF(n);
+  for(int i=0;i<n;i++){
+    dF[i] = std::complex<Float>(d[i]);
+    h[i] += d[i];
+  }
+#pragma omp parallel for
+  for(int t=0;t<nTile;t++){
+    const long long r0 = static_cast<long long>(t) * tileSites * siteLen;
+    const int rows = std::min(tileSites, geom.volume - t*tileSites) * siteLen;
+    gemmHost<Float>('N', rows, 1, n, -1.0, basis.data() + r0, len, dF.data(), n, 1.0, w.V() + r0, rows);
+  }
+}
+
+
+template <typename Float>
+void HostLanczos<Float>::rotateBasis(const std::vector<std::complex<double>> &Q, int m, int nOut,
+				     std::vector<HostColorSpinorField<Float>*> &out){
+
+  const HostGeom &geom = op.Geom();
+  const int siteLen = kSpace[0]->SiteLength();
+  const int tileSites = gemmTileSites<Float>(m + nOut, siteLen, geom.volume);
+  const int nTile = (geom.volume + tileSites - 1) / tileSites;
+  std::vector<std::complex<Float>> QF(Q.begin(), Q.end());
+
+  //- out = K Q per tile of sites, formed in a buffer from the m basis vectors of the tile, so out may be the basis itself
+#pragma omp parallel
+  {
+    std::vector<std::complex<Float>> buf(static_cast<size_t>(nOut) * tileSites * siteLen);
+#pragma omp for
+    for(int t=0;t<nTile;t++){
+      const int x0 = t * tileSites;
+      const long long r0 = static_cast<long long>(x0) * siteLen;
+      const int rows = std::min(tileSites, geom.volume - x0) * siteLen;
+      gemmHost<Float>('N', rows, nOut, m, 1.0, basis.data() + r0, len, QF.data(), m, 0.0, buf.data(), rows);
+      for(int k=0;k<nOut;k++)
+	std::copy(buf.begin() + static_cast<size_t>(k)*rows, buf.begin() + static_cast<size_t>(k+1)*rows, out[k]->Site(x0));
+    }
+  }
+}
+
+
+template <typename Float>
+void HostLanczos<Float>::solve(std::vector<HostColorSpinorField<Float>*> &eVecs, std::vector<double> &evals, std::vector<double> &res){
+
+  const HostGeom &geom = op.Geom();
+  const int nEv = param.nEv, nKr = param.nKr;
+  if(static_cast<int>(eVecs.size()) != nEv) errorQuda("%s: Got %zu vectors for %d eigenpairs\n", __func__, eVecs.size(), nEv);
+
+  //- The wanted eigenvalues of the polynomial are its largest ones, above T_k(1) = 1, see applyPoly
+  const bool largest = param.use_poly_acc || param.spectrum == MUGIQ_SPECTRUM_LR;
+  const int nKeep = std::min(nKr - 1, nEv + (nKr - nEv) / 2);
+
+  auto norm = [&](HostColorSpinorField<Float> &x){
+    double n2 = x.norm2Local();
+    MPI_Allreduce(MPI_IN_PLACE, &n2, 1, MPI_DOUBLE, MPI_SUM, geom.comm);
+    return std::sqrt(n2);
+  };
+  auto scale = [&](HostColorSpinorField<Float> &x, double a){
+    const Float aF = static_cast<Float>(a);
+#pragma omp parallel for
+    for(long long i=0;i<x.Length();i++) x.V()[i] *= aF;
+  };
+
+  //- Random starting vector, different on each process
+  int rank = 0;
+  MPI_Comm_rank(geom.comm, &rank);
+  std::mt19937 gen(1234 + rank);
+  std::uniform_real_distribution<double> dist(-0.5, 0.5);
+  for(long long i=0;i<kSpace[0]->Length();i++) kSpace[0]->V()[i] = std::complex<Float>(dist(gen), dist(gen));
+  scale(*kSpace[0], 1.0 / norm(*kSpace[0]));
+
+  nRestart = 0;
+  nOp = 0;
+  nConv = 0;
+  int k = 0;
+  double betaLast = 0.0;
+  std::vector<std::complex<double>> T(static_cast<size_t>(nKr) * nKr, 0.0), Tc, Y, Q;
+  std::vector<double> theta;
+  std::vector<int> sel(nKr);
+
+  for(;;){
+    //- Extend the basis from k to nKr vectors, T is the projection of the operator on the basis
+    for(int j=k;j<nKr;j++){
+      HostColorSpinorField<Float> &w = *kSpace[j+1];
+      applyPoly(w, *kSpace[j]);
+      std::vector<std::complex<double>> h(j+1, 0.0);
+      orthogonalize(w, j+1, h);
+      orthogonalize(w, j+1, h);
+      for(int i=0;i<j;i++){
+	T[static_cast<size_t>(j)*nKr + i] = h[i];
+	T[static_cast<size_t>(i)*nKr + j] = std::conj(h[i]);
+      }
+      T[static_cast<size_t>(j)*nKr + j] = h[j].real();
+
+      const double beta = norm(w);
+      if(beta == 0.0) errorQuda("%s: The Krylov space became invariant at %d vectors\n", __func__, j+1);
+      if(j < nKr-1) scale(w, 1.0 / beta);
+      else betaLast = beta;
+    }
+
+    //- Ritz pairs, wanted ones first, the residual of Ritz pair i is beta * |last component of its Ritz vector|
+    Tc = T;
+    denseEigHermitian(nKr, Tc, MUGIQ_SPECTRUM_SR, nKr, theta, Y);
+    for(int i=0;i<nKr;i++) sel[i] = largest ? nKr-1-i : i;
+    double thetaMax = 0.0;
+    for(auto t: theta) thetaMax = std::max(thetaMax, std::abs(t));
+    nConv = 0;
+    while(nConv < nEv && betaLast * std::abs(Y[static_cast<size_t>(sel[nConv])*nKr + nKr-1]) < param.tol * thetaMax) nConv++;
+    if(nConv == nEv || nRestart == param.maxRestarts) break;
+
+    //- Thick restart: keep the nKeep wanted Ritz vectors and continue from the residual vector
+    Q.assign(static_cast<size_t>(nKr) * nKeep, 0.0);
+    for(int i=0;i<nKeep;i++) std::copy(Y.begin() + static_cast<size_t>(sel[i])*nKr, Y.begin() + static_cast<size_t>(sel[i]+1)*nKr,
+				       Q.begin() + static_cast<size_t>(i)*nKr);
+    rotateBasis(Q, nKr, nKeep, kSpace);
+    scale(*kSpace[nKr], 1.0 / betaLast);
+    std::copy(kSpace[nKr]->V(), kSpace[nKr]->V() + len, kSpace[nKeep]->V());
+
+    std::fill(T.begin(), T.end(), std::complex<double>(0.0));
+    for(int i=0;i<nKeep;i++) T[static_cast<size_t>(i)*nKr + i] = theta[sel[i]];
+    k = nKeep;
+    nRestart++;
+  }
+
+  Q.assign(static_cast<size_t>(nKr) * nEv, 0.0);
+  for(int i=0;i<nEv;i++) std::copy(Y.begin() + static_cast<size_t>(sel[i])*nKr, Y.begin() + static_cast<size_t>(sel[i]+1)*nKr,
+				   Q.begin() + static_cast<size_t>(i)*nKr);
+  rotateBasis(Q, nKr, nEv, eVecs);
+
+  //- Eigenvalues of the operator itself, and the eigenpairs in the order of the spectrum
+  std::vector<std::complex<double>> lambda;
+  std::vector<double> r;
+  computeEvalsHost(op, eVecs, lambda, r);
+  nOp += nEv;
+
+  std::vector<int> idx(nEv);
+  std::iota(idx.begin(), idx.end(), 0);
+  std::stable_sort(idx.begin(), idx.end(), [&](int a, int b){
+      return param.spectrum == MUGIQ_SPECTRUM_LR ? lambda[a].real() > lambda[b].real() : lambda[a].real() < lambda[b].real(); });
+  std::vector<HostColorSpinorField<Float>*> sorted(nEv);
+  evals.resize(nEv);
+  res.resize(nEv);
+  for(int i=0;i<nEv;i++){
+    sorted[i] = eVecs[idx[i]];
+    evals[i] = lambda[idx[i]].real();
+    res[i] = r[idx[i]];
+  }
+  eVecs = sorted;
+
+  //- With the polynomial the residuals above are those of its eigenpairs, the wanted eigenpairs are only counted as
+  //- converged if those of the operator are, relative to its norm: a_max bounds the spectrum for SR, and the largest
+  //- eigenvalue is wanted for LR
+  if(param.use_poly_acc){
+    double opNorm = (param.spectrum == MUGIQ_SPECTRUM_SR) ? std::abs(param.a_max) : 0.0;
+    for(auto l: evals) opNorm = std::max(opNorm, std::abs(l));
+    nConv = 0;
+    while(nConv < nEv && res[nConv] < param.tol * opNorm) nConv++;
+  }
+  if(nConv < nEv) warningQuda("%s: Only %d of %d eigenpairs converged in %d restarts\n", __func__, nConv, nEv, nRestart);
+
+  printfQuda("%s: %d of %d eigenpairs converged in %d restarts and %lld operator applications\n", __func__, nConv, nEv,
+	     nRestart, nOp);
+}
+
+
+template class HostLanczos<float>;
+template class HostLanczos<double>;
@@ -0,0 +1,783 @@
+#include <loop_host.h>
+#include <loop_io_mugiq.h>
+#include <gamma.h>
+#include <mpi_profile_mugiq.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+LoopHostParam::LoopHostParam(const MugiqLoopParam *loopParams, const HostGeom &geom) :
+  Nmom(loopParams->Nmom),
+  FTSign(loopParams->FTSign),
+  doMomProj(loopParams->doMomProj),
+  doNonLocal(loopParams->doNonLocal),
+  localL{0,0,0,0},
+  totalL{0,0,0,0},
+  locT(0), totT(0),
+  locV4(1), locV3(1),
+  nDispEntries(0),
+  nDispPaths(0),
+  dispPathOffset(0),
+  nDispDerivs(0),
+  dispDerivOffset(0),
+  wilsonLineBudget(loopParams->wilsonLineBudget),
+  nLoop(0), nData(0)
+{
+  int commDimSize[N_DIM_];
+  for(int i=0;i<N_DIM_;i++) commDimSize[i] = 1;
+  MPI_Allreduce(geom.commCoord, commDimSize, N_DIM_, MPI_INT, MPI_MAX, geom.comm);
+
+  for(int i=0;i<N_DIM_;i++){
+    localL[i] = geom.lL[i];
+    totalL[i] = localL[i] * (commDimSize[i] + 1);
+    locV4 *= localL[i];
+    if(i<N_DIM_-1) locV3 *= localL[i];
+  }
+  locT = localL[N_DIM_-1];
+  totT = totalL[N_DIM_-1];
+
+  if(doMomProj){
+    momMatrix.resize(Nmom*MOM_DIM_);
+    for(int im=0;im<Nmom;im++)
+      for(int id=0;id<MOM_DIM_;id++)
+	momMatrix[MOM_MATRIX_IDX(id,im)] = loopParams->momMatrix[im][id];
+  }
+
+  if(doNonLocal){
+    nDispEntries = loopParams->disp_str.size();
+    if(nDispEntries != static_cast<int>(loopParams->disp_start.size()) ||
+       nDispEntries != static_cast<int>(loopParams->disp_stop.size()))
+      errorQuda("Displacement string length not compatible with displacement limits length\n");
+
+    int osum = 1; //-start with ultra-local
+    for(int id=0;id<nDispEntries;id++){
+      dispEntry.push_back(loopParams->disp_entry.at(id));
+      dispString.push_back(loopParams->disp_str.at(id));
+      dispStart.push_back(std::min(loopParams->disp_start.at(id), loopParams->disp_stop.at(id)));
+      dispStop.push_back(std::max(loopParams->disp_start.at(id), loopParams->disp_stop.at(id)));
+
+      DisplaceFlag flag = parseDisplaceFlag(dispString.at(id));
+      if(flag == DispFlagNone) errorQuda("%s: Cannot parse given displacement string = %s.\n", __func__, dispString.at(id).c_str());
+      dispDir.push_back(displaceFlagDir(flag));
+      dispSign.push_back(displaceFlagSign(flag));
+
+      useWilsonLine.push_back(MUGIQ_BOOL_FALSE);
+      nLoopPerEntry.push_back(dispStop.at(id) - dispStart.at(id) + 1);
+      nLoopOffset.push_back(osum);
+      osum += nLoopPerEntry.at(id);
+    }
+
+    nDispPaths = loopParams->disp_path.size();
+    dispPathOffset = osum;
+    for(int ip=0;ip<nDispPaths;ip++){
+      std::vector<DisplaceFlag> hops;
+      if(!parseDispPath(loopParams->disp_path.at(ip), hops))
+	errorQuda("%s: Cannot parse given displacement path = %s.\n", __func__, loopParams->disp_path.at(ip).c_str());
+      dispPath.push_back(loopParams->disp_path.at(ip));
+    }
+
+    nDispDerivs = loopParams->disp_deriv.size();
+    dispDerivOffset = osum + nDispPaths;
+    for(int id=0;id<nDispDerivs;id++){
+      if(parseDisplaceDir(loopParams->disp_deriv.at(id)) == DispDirNone)
+	errorQuda("%s: Cannot parse given derivative direction = %s.\n", __func__, loopParams->disp_deriv.at(id).c_str());
+      dispDeriv.push_back(loopParams->disp_deriv.at(id));
+    }
+    nLoop = osum + nDispPaths + nDispDerivs;
+  }
+  else nLoop = 1;
+
+  nData = nLoop*N_GAMMA_;
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+LoopHost<Float>::LoopHost(const MugiqLoopParam *loopParams, const HostGeom &geom_) :
+  geom(geom_),
+  cPrm(nullptr),
+  displace(nullptr),
+  COMM_SPACE(MPI_COMM_NULL),
+  COMM_TIME(MPI_COMM_NULL),
+  IamTimeProcess(MUGIQ_BOOL_FALSE),
+  dataTypeMPI(typeid(Float) == typeid(double) ? MPI_DOUBLE_COMPLEX : MPI_COMPLEX)
+{
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+
+  cPrm = new LoopHostParam(loopParams, geom);
+
+  dataPos.assign(cPrm->locV4 * cPrm->nData, 0.0);
+  if(cPrm->doMomProj){
+    const long long nElemMomLoc = static_cast<long long>(cPrm->nData) * cPrm->Nmom * cPrm->locT;
+    dataPosMP.assign(cPrm->locV4 * cPrm->nData, 0.0);
+    dataMom_h.assign(nElemMomLoc, 0.0);
+    dataMom.assign(nElemMomLoc, 0.0);
+    dataMom_bcast.assign(nElemMomLoc * (cPrm->totT / cPrm->locT), 0.0);
+    createPhaseMatrix();
+    setupComms();
+  }
+  createGammaCoeff();
+
+  if(cPrm->doNonLocal){
+    displace = new DisplaceHost<Float>(geom, nullptr, QUDA_INVALID_PRECISION);
+    if(cPrm->wilsonLineBudget > 0) setupWilsonLines();
+  }
+
+  //- The entries served by the Wilson-line tables are left out of the trie walk
+  std::vector<std::string> tString;
+  std::vector<int> tStart, tStop, tOffset;
+  for(int id=0;id<cPrm->nDispEntries;id++){
+    if(cPrm->useWilsonLine.at(id)) continue;
+    tString.push_back(cPrm->dispString.at(id));
+    tStart.push_back(cPrm->dispStart.at(id));
+    tStop.push_back(cPrm->dispStop.at(id));
+    tOffset.push_back(cPrm->nLoopOffset.at(id));
+  }
+  pathTrie = DispPathTrie::fromEntries(tString, tStart, tStop, tOffset, cPrm->dispPath, cPrm->dispPathOffset,
+				       cPrm->dispDeriv, cPrm->dispDerivOffset);
+
+  if(cPrm->doNonLocal){
+    vSlot.resize(pathTrie.NSlot() - 1);
+    for(auto &slot: vSlot)
+      for(int k=0;k<displace->BatchSize();k++) slot.push_back(new HostColorSpinorField<Float>(geom));
+    pathTrie.printReport(__func__);
+  }
+
+  printfQuda("%s: Host loop computation environment created, %d loop traces\n", __func__, cPrm->nLoop);
+}
+
+
+template <typename Float>
+void LoopHost<Float>::setStarStencil(MuGiqBool star){
+  pathTrie.setStar(star == MUGIQ_BOOL_TRUE);
+  if(!cPrm->doNonLocal) return;
+  while(static_cast<int>(vSlot.size()) < pathTrie.NSlot() - 1){
+    vSlot.push_back(std::vector<HostColorSpinorField<Float>*>());
+    for(int k=0;k<displace->BatchSize();k++) vSlot.back().push_back(new HostColorSpinorField<Float>(geom));
+  }
+}
+
+
+template <typename Float>
+LoopHost<Float>::~LoopHost(){
+  if(COMM_SPACE != MPI_COMM_NULL) MPI_Comm_free(&COMM_SPACE);
+  if(COMM_TIME  != MPI_COMM_NULL) MPI_Comm_free(&COMM_TIME);
+  if(displace) delete displace;
+  for(auto &slot: vSlot)
+    for(auto v: slot) delete v;
+  for(auto v: vLine) delete v;
+  for(auto v: vDecode) delete v;
+  delete cPrm;
+}
+
+
+template <typename Float>
+void LoopHost<Float>::setupWilsonLines(){
+
+  //- An entry +d:start,stop needs the lines of lengths start,...,stop; an entry whose source sites would lie beyond
+  //- the ghost zone (stop larger than the local extent of a partitioned dimension) is displaced hop by hop
+  std::vector<int> eligible;
+  long long nLine = 0;
+  for(int id=0;id<cPrm->nDispEntries;id++){
+    const int dir = static_cast<int>(cPrm->dispDir.at(id));
+    if(geom.commDim[dir] && cPrm->dispStop.at(id) > geom.lL[dir]){
+      warningQuda("%s: Displacement entry %s is longer than the local extent %d, it will be displaced hop by hop\n",
+		  __func__, cPrm->dispEntry.at(id).c_str(), geom.lL[dir]);
+      continue;
+    }
+    eligible.push_back(id);
+    nLine += cPrm->nLoopPerEntry.at(id);
+  }
+  if(eligible.empty()) return;
+
+  const double lineMB = DisplaceHost<Float>::wilsonLineBytes(geom, nLine) / (1024.0*1024.0);
+  if(lineMB > cPrm->wilsonLineBudget){
+    warningQuda("%s: Wilson-line tables need %.1f MB, more than the budget of %.1f MB. Displacing hop by hop\n",
+		__func__, lineMB, cPrm->wilsonLineBudget);
+    return;
+  }
+
+  for(auto id: eligible){
+    const DisplaceFlag flag = parseDisplaceFlag(cPrm->dispString.at(id));
+    for(int l=cPrm->dispStart.at(id);l<=cPrm->dispStop.at(id);l++) displace->addWilsonLine(flag, l);
+    cPrm->useWilsonLine.at(id) = MUGIQ_BOOL_TRUE;
+  }
+  for(int k=0;k<displace->BatchSize();k++) vLine.push_back(new HostColorSpinorField<Float>(geom));
+
+  printfQuda("%s: %zu displacement entries use Wilson-line tables, %.1f MB\n", __func__, eligible.size(), lineMB);
+}
+
+
+template <typename Float>
+void LoopHost<Float>::setupComms(){
+
+  //-- Processes with the same time coordinate
+  const int tCoord = geom.commCoord[N_DIM_-1];
+  int cRank;
+  MPI_Comm_rank(geom.comm, &cRank);
+  MPI_Comm_split(geom.comm, tCoord, cRank, &COMM_SPACE);
+
+  //-- Processes with all but the time coordinate equal to 0
+  IamTimeProcess = (geom.commCoord[0] == 0 && geom.commCoord[1] == 0 && geom.commCoord[2] == 0) ?
+    MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE;
+  MPI_Comm_split(geom.comm, IamTimeProcess ? 0 : MPI_UNDEFINED, tCoord, &COMM_TIME);
+}
+
+
+template <typename Float>
+void LoopHost<Float>::createGammaCoeff(){
+
+  std::vector<int> minusG = minusGamma();
+  std::vector<int> idxG   = indexMapGamma();
+
+  for(int m=0;m<N_GAMMA_;m++){
+    for(int n=0;n<N_SPIN_;n++){
+      gColumnIndex[m][n] = GammaColumnIndex(m,n);
+      gRowValue[m][n] = std::complex<Float>(GammaRowValue(m,n,0), GammaRowValue(m,n,1));
+    }
+    gMapIndex[m] = idxG.at(m);
+    gMapSign[m] = static_cast<Float>(1.0);
+  }
+  for(auto g: minusG) gMapSign[g] = static_cast<Float>(-1.0);
+}
+
+
+template <typename Float>
+void LoopHost<Float>::createPhaseMatrix(){
+
+  const long long locV3 = cPrm->locV3;
+  phaseMatrix.resize(locV3 * cPrm->Nmom);
+
+  const Float sgn = static_cast<Float>(cPrm->FTSign);
+#pragma omp parallel for
+  for(long long v=0;v<locV3;v++){
+    int gcoord[MOM_DIM_];
+    long long r = v;
+    for(int d=0;d<MOM_DIM_;d++){
+      gcoord[d] = static_cast<int>(r % cPrm->localL[d]) + geom.commCoord[d] * cPrm->localL[d];
+      r /= cPrm->localL[d];
+    }
+    for(int im=0;im<cPrm->Nmom;im++){
+      Float phase = 0.0;
+      for(int id=0;id<MOM_DIM_;id++)
+	phase += cPrm->momMatrix[MOM_MATRIX_IDX(id,im)]*gcoord[id] / static_cast<Float>(cPrm->totalL[id]);
+      phaseMatrix[v + locV3*im] = std::complex<Float>(cos(2.0*PI*phase), sgn*sin(2.0*PI*phase));
+    }
+  }
+}
+
+
+template <typename Float>
+void LoopHost<Float>::loadGauge(void *gauge[], QudaPrecision cpuPrec){
+  if(displace) displace->loadGauge(gauge, cpuPrec);
+}
+
+
+template <typename Float>
+inline void LoopHost<Float>::contractSite(std::complex<Float> *loopData, int x, const std::complex<Float> *l,
+					  const std::complex<Float> *r, Float inv_sigma) const {
+
+  //- resG(be,al) = vL^\dag(be) * vR(al), traced over color
+  std::complex<Float> resG[N_SPIN_*N_SPIN_];
+  for(int be=0;be<N_SPIN_;be++)
+    for(int al=0;al<N_SPIN_;al++){
+      std::complex<Float> s = 0;
+      for(int kc=0;kc<N_COLOR_;kc++) s += std::conj(l[SPINOR_SITE_IDX(be,kc)]) * r[SPINOR_SITE_IDX(al,kc)];
+      resG[GAMMA_MAT_IDX(be,al)] = s;
+    }
+
+  //- project/trace on Gamma(iG), trace = resG(be,al) * Gamma(be,al)
+  const long long lV = geom.volume;
+  for(int iG=0;iG<N_GAMMA_;iG++){
+    std::complex<Float> trace = 0;
+    for(int s2=0;s2<N_SPIN_;s2++){
+      int s1 = gColumnIndex[iG][s2];
+      trace += gRowValue[iG][s2] * resG[GAMMA_MAT_IDX(s2, s1)];
+    }
+    loopData[x + lV*iG] += inv_sigma * trace;
+  }
+}
+
+
+template <typename Float>
+void LoopHost<Float>::performLoopContraction(std::complex<Float> *loopData, const HostColorSpinorField<Float> &vL,
+					     const HostColorSpinorField<Float> &vR_, Float sigma){
+
+  const int lV = geom.volume;
+  const Float inv_sigma = static_cast<Float>(1.0) / sigma;
+
+#pragma omp parallel for
+  for(int x=0;x<lV;x++) contractSite(loopData, x, vL.Site(x), vR_.Site(x), inv_sigma);
+}
+
+
+//- The transported neighbours of each site are contracted as soon as they are computed, into the trace of their leaf
+template <typename Float>
+struct LoopHost<Float>::StarContraction : public HostStarSink<Float> {
+
+  const LoopHost<Float> &loop;
+  const std::vector<HostColorSpinorField<Float>*> &vL;  // the eigenvectors of the batch
+  std::vector<Float> inv_sigma;
+  std::vector<std::complex<Float>*> loopData;           // trace of each flag
+
+  StarContraction(const LoopHost<Float> &loop_, const std::vector<HostColorSpinorField<Float>*> &vL_,
+		  const std::vector<double> &sigma, std::vector<std::complex<Float>*> loopData_) :
+    loop(loop_), vL(vL_), loopData(loopData_)
+  {
+    for(auto s: sigma) inv_sigma.push_back(static_cast<Float>(1.0) / static_cast<Float>(s));
+  }
+
+  void site(int idx, const std::complex<Float> *w){
+    const int nVec = static_cast<int>(vL.size());
+    for(size_t i=0;i<loopData.size();i++)
+      for(int iv=0;iv<nVec;iv++)
+	loop.contractSite(loopData[i], idx, vL[iv]->Site(idx), w + (i*nVec + iv)*SPINOR_SITE_LEN_, inv_sigma[iv]);
+  }
+};
+
+
+template <typename Float>
+void LoopHost<Float>::performMomentumProjection(){
+
+  const long long locV3 = cPrm->locV3;
+  const int locT  = cPrm->locT;
+  const int Nmom  = cPrm->Nmom;
+  const int nData = cPrm->nData;
+  const int lV = geom.volume;
+
+  //- Convert indices from even/odd volume-inside-gamma-inside-nLoop to time-inside-nData-inside-volume3d,
+  //- mapping G -> g5*G, as in convertIdxOrder_mapGamma
+#pragma omp parallel for
+  for(int tid=0;tid<lV;tid++){
+    int x[N_DIM_];
+    const int pty = tid / geom.volumeCB;
+    geom.getCoords(x, tid - pty*geom.volumeCB, pty);
+    const long long v3 = x[0] + cPrm->localL[0]*(x[1] + cPrm->localL[1]*static_cast<long long>(x[2]));
+    for(int iL=0;iL<cPrm->nLoop;iL++)
+      for(int ig=0;ig<N_GAMMA_;ig++){
+	const long long idxFrom = tid + static_cast<long long>(lV)*(ig + N_GAMMA_*iL);
+	const int idataTo = gMapIndex[ig] + N_GAMMA_*iL;
+	dataPosMP[x[3] + locT*idataTo + locT*nData*v3] = gMapSign[ig] * dataPos[idxFrom];
+      }
+  }
+
+  //- dataMom(locT*nData, Nmom) = dataPosMP(locT*nData, locV3) * phaseMatrix(locV3, Nmom), column-major
+  const long long nRow = static_cast<long long>(locT) * nData;
+#pragma omp parallel for
+  for(long long i=0;i<nRow;i++){
+    for(int im=0;im<Nmom;im++){
+      std::complex<Float> s = 0;
+      for(long long v=0;v<locV3;v++) s += dataPosMP[i + nRow*v] * phaseMatrix[v + locV3*im];
+      dataMom_h[i + nRow*im] = s;
+    }
+  }
+
+  //- Sum over the space processes, gather over the time processes, broadcast to all
+  const int nElemMomLoc = static_cast<int>(dataMom_h.size());
+
+  mpiProfilePushStage(MUGIQ_STAGE_MOM_REDUCE);
+  MPI_Reduce(dataMom_h.data(), dataMom.data(), nElemMomLoc, dataTypeMPI, MPI_SUM, 0, COMM_SPACE);
+  mpiProfilePopStage();
+
+  mpiProfilePushStage(MUGIQ_STAGE_GATHER);
+  if(IamTimeProcess)
+    MPI_Gather(dataMom.data(), nElemMomLoc, dataTypeMPI, dataMom_bcast.data(), nElemMomLoc, dataTypeMPI, 0, COMM_TIME);
+  MPI_Bcast(dataMom_bcast.data(), static_cast<int>(dataMom_bcast.size()), dataTypeMPI, 0, geom.comm);
+  mpiProfilePopStage();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::contractBatch(const std::vector<HostColorSpinorField<Float>*> &evB, const std::vector<double> &sigB){
+
+  const int kB = static_cast<int>(evB.size());
+  const long long nElemPosLocPerLoop = cPrm->locV4 * N_GAMMA_;
+
+  //- The eigenvectors walk the displacement-path trie in batches: every hop is performed once for all the
+  //- traces sharing it, and applies the links to the whole batch. The +d/-d hop pairs and the derivatives
+  //- use the fused stencil, with one sweep and one two-way halo exchange, and the one-hop leaves optionally the
+  //- star stencil, which contracts the neighbours of each site as soon as they are transported
+  const std::vector<DispPathOp> &sched = pathTrie.Schedule();
+  const std::vector<DispPathNode> &node = pathTrie.Nodes();
+  std::vector<std::vector<HostColorSpinorField<Float>*>> slot(vSlot.size() + 1);
+  std::vector<HostColorSpinorField<Float>*> line;
+  std::vector<HostColorSpinorField<Float>*> none;
+
+  slot[0] = evB; //- slot 0 holds the original, un-displaced eigenvectors
+  for(size_t s=1;s<slot.size();s++) slot[s].assign(vSlot[s-1].begin(), vSlot[s-1].begin()+kB);
+
+  for(const auto &op: sched){
+    if(op.type == DISP_PATH_OP_HOP)
+      displace->doVectorDisplacement(slot[op.dst], slot[op.src], displaceFlagDir(op.hop), displaceFlagSign(op.hop));
+    else if(op.type == DISP_PATH_OP_HOP_PAIR)
+      displace->doSymmetricDisplacement(slot[op.dst], slot[op.dst2], slot[op.src], displaceFlagDir(op.hop), DISPLACE_SYM_PAIR);
+    else if(op.type == DISP_PATH_OP_DERIV)
+      displace->doSymmetricDisplacement(slot[op.dst], none, slot[op.src], displaceFlagDir(op.hop), DISPLACE_SYM_DERIV);
+    else if(op.type == DISP_PATH_OP_STAR){
+      std::vector<DisplaceFlag> flags;
+      std::vector<std::complex<Float>*> loopData;
+      for(auto c: pathTrie.StarLeaves(op.node)){
+	flags.push_back(node[c].hop);
+	loopData.push_back(&(dataPos[nElemPosLocPerLoop * node[c].loopIdx.at(0)]));
+      }
+      StarContraction sink(*this, evB, sigB, loopData);
+      displace->doStarDisplacement(slot[op.src], flags, sink);
+    }
+    else{
+      const long long bufOffset = nElemPosLocPerLoop * node[op.node].loopIdx.at(0);
+      for(int k=0;k<kB;k++)
+	performLoopContraction(&(dataPos[bufOffset]), *evB[k], *slot[op.src][k], static_cast<Float>(sigB[k]));
+    }
+  }
+
+  //- Entries with Wilson-line tables: one halo exchange of depth stop, then one step per length, longest first
+  for(int id=0;id<cPrm->nDispEntries;id++){
+    if(!cPrm->useWilsonLine.at(id)) continue;
+    const DisplaceFlag flag = parseDisplaceFlag(cPrm->dispString.at(id));
+    line.assign(vLine.begin(), vLine.begin()+kB);
+    for(int l=cPrm->dispStop.at(id);l>=cPrm->dispStart.at(id);l--){
+      displace->doWilsonLineDisplacement(line, slot[0], flag, l, (l == cPrm->dispStop.at(id)) ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE);
+      const long long bufOffset = nElemPosLocPerLoop * (cPrm->nLoopOffset.at(id) + l - cPrm->dispStart.at(id));
+      for(int k=0;k<kB;k++)
+	performLoopContraction(&(dataPos[bufOffset]), *evB[k], *line[k], static_cast<Float>(sigB[k]));
+    }
+  }
+}
+
+
+template <typename Float>
+void LoopHost<Float>::finishLoop(){
+
+  const long long nElemPosLocPerLoop = cPrm->locV4 * N_GAMMA_;
+
+  //- Traces requested more than once with the same path are copies of the first one
+  for(const auto &nd: pathTrie.Nodes())
+    for(size_t i=1;i<nd.loopIdx.size();i++)
+      std::copy(dataPos.begin() + nElemPosLocPerLoop*nd.loopIdx[0], dataPos.begin() + nElemPosLocPerLoop*(nd.loopIdx[0]+1),
+		dataPos.begin() + nElemPosLocPerLoop*nd.loopIdx[i]);
+
+  if(cPrm->doMomProj) performMomentumProjection();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::computeLoop(const std::vector<HostColorSpinorField<Float>*> &eVecs, const std::vector<double> &sigma){
+
+  const int nEv = static_cast<int>(eVecs.size());
+  if(static_cast<int>(sigma.size()) != nEv) errorQuda("%s: Got %d eigenvectors but %zu singular values\n", __func__, nEv, sigma.size());
+
+  std::fill(dataPos.begin(), dataPos.end(), std::complex<Float>(0.0));
+
+  const int nBatch = displace ? displace->BatchSize() : std::max(nEv, 1);
+  for(int n0=0;n0<nEv;n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    contractBatch(std::vector<HostColorSpinorField<Float>*>(eVecs.begin()+n0, eVecs.begin()+n0+kB),
+		  std::vector<double>(sigma.begin()+n0, sigma.begin()+n0+kB));
+  }
+
+  finishLoop();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::computeLoopStream(HostEvecStream<Float> &stream, const std::vector<double> &sigma){
+
+  const int nEv = static_cast<int>(sigma.size());
+  if(nEv > stream.NEv()) errorQuda("%s: Got %d singular values but the stream holds %d eigenvectors\n", __func__, nEv, stream.NEv());
+
+  std::fill(dataPos.begin(), dataPos.end(), std::complex<Float>(0.0));
+
+  //- A batch occupies at most half of the ring, so the next batch is read while this one is contracted. The traces
+  //- are summed over the eigenvectors in the same order as in computeLoop, whatever the batch size
+  const int nBatch = std::max(1, std::min(displace ? displace->BatchSize() : nEv, stream.RingSize() / 2));
+  std::vector<HostColorSpinorField<Float>*> evB;
+
+  stream.start(0, nEv);
+  for(int n0=0;n0<nEv;n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    evB.clear();
+    for(int k=0;k<kB;k++) evB.push_back(stream.acquire(n0+k));
+    contractBatch(evB, std::vector<double>(sigma.begin()+n0, sigma.begin()+n0+kB));
+    for(int k=0;k<kB;k++) stream.release(n0+k);
+  }
+  stream.finish();
+
+  finishLoop();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::computeLoopCompressed(const std::vector<HostCompressedField<Float>*> &eVecs, const std::vector<double> &sigma){
+
+  const int nEv = static_cast<int>(eVecs.size());
+  if(static_cast<int>(sigma.size()) != nEv) errorQuda("%s: Got %d eigenvectors but %zu singular values\n", __func__, nEv, sigma.size());
+
+  std::fill(dataPos.begin(), dataPos.end(), std::complex<Float>(0.0));
+
+  //- Only the batch being contracted is decoded
+  const int nBatch = displace ? displace->BatchSize() : std::max(nEv, 1);
+  while(static_cast<int>(vDecode.size()) < std::min(nBatch, nEv)) vDecode.push_back(new HostColorSpinorField<Float>(geom));
+
+  for(int n0=0;n0<nEv;n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    for(int k=0;k<kB;k++) eVecs[n0+k]->decode(*vDecode[k]);
+    contractBatch(std::vector<HostColorSpinorField<Float>*>(vDecode.begin(), vDecode.begin()+kB),
+		  std::vector<double>(sigma.begin()+n0, sigma.begin()+n0+kB));
+  }
+
+  finishLoop();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::computeLoopReference(const std::vector<HostColorSpinorField<Float>*> &eVecs, const std::vector<double> &sigma){
+
+  const int nEv = static_cast<int>(eVecs.size());
+  if(static_cast<int>(sigma.size()) != nEv) errorQuda("%s: Got %d eigenvectors but %zu singular values\n", __func__, nEv, sigma.size());
+
+  const long long nElemPosLocPerLoop = cPrm->locV4 * N_GAMMA_;
+  std::fill(dataPos.begin(), dataPos.end(), std::complex<Float>(0.0));
+
+  //- The hops of every loop trace: the ultra-local one, the lengths of each entry, the paths, and the derivatives
+  //- (marked by an empty path with the derivative direction in derivDir)
+  std::vector<std::vector<DisplaceFlag>> hops(1);
+  std::vector<int> loopIdx(1, 0);
+  std::vector<int> derivDir(1, -1);
+  if(cPrm->doNonLocal){
+    for(int id=0;id<cPrm->nDispEntries;id++)
+      for(int l=cPrm->dispStart.at(id);l<=cPrm->dispStop.at(id);l++){
+	hops.push_back(std::vector<DisplaceFlag>(l, parseDisplaceFlag(cPrm->dispString.at(id))));
+	loopIdx.push_back(cPrm->nLoopOffset.at(id) + l - cPrm->dispStart.at(id));
+	derivDir.push_back(-1);
+      }
+    for(int ip=0;ip<cPrm->nDispPaths;ip++){
+      hops.push_back(std::vector<DisplaceFlag>());
+      parseDispPath(cPrm->dispPath.at(ip), hops.back());
+      loopIdx.push_back(cPrm->dispPathOffset + ip);
+      derivDir.push_back(-1);
+    }
+    for(int id=0;id<cPrm->nDispDerivs;id++){
+      hops.push_back(std::vector<DisplaceFlag>());
+      loopIdx.push_back(cPrm->dispDerivOffset + id);
+      derivDir.push_back(static_cast<int>(parseDisplaceDir(cPrm->dispDeriv.at(id))));
+    }
+  }
+
+  HostColorSpinorField<Float> v(geom);
+  HostColorSpinorField<Float> w(geom);
+  for(size_t it=0;it<hops.size();it++){
+    std::complex<Float> *loopData = &(dataPos[nElemPosLocPerLoop * loopIdx[it]]);
+    for(int n=0;n<nEv;n++){
+      v.copy(*eVecs[n]);
+      if(derivDir[it] >= 0){
+	const DisplaceDir dir = static_cast<DisplaceDir>(derivDir[it]);
+	displace->doVectorDisplacement(w, *eVecs[n], dir, DispSignPlus);
+	displace->doVectorDisplacement(v, *eVecs[n], dir, DispSignMinus);
+	for(long long i=0;i<v.Length();i++) v.V()[i] = (w.V()[i] - v.V()[i]) * static_cast<Float>(0.5);
+      }
+      for(auto hop: hops[it]){
+	displace->doVectorDisplacement(w, v, displaceFlagDir(hop), displaceFlagSign(hop));
+	v.copy(w);
+      }
+      performLoopContraction(loopData, *eVecs[n], v, static_cast<Float>(sigma[n]));
+    }
+  }
+
+  if(cPrm->doMomProj) performMomentumProjection();
+}
+
+
+template <typename Float>
+void LoopHost<Float>::writeLoopsHDF5(const std::string &fnameMom){
+
+  MPIProfileStage profStage(MUGIQ_STAGE_HDF5_IO);
+
+  if(!cPrm->doMomProj) errorQuda("%s: Writing the position-space loop data is not supported yet!\n", __func__);
+
+  if(IamTimeProcess){
+    LoopMomLayout lay;
+    lay.Nmom = cPrm->Nmom;
+    lay.momMatrix = cPrm->momMatrix;
+    lay.nDispEntries = cPrm->nDispEntries;
+    lay.dispString = cPrm->dispString;
+    lay.dispStart = cPrm->dispStart;
+    lay.dispStop = cPrm->dispStop;
+    lay.dispPath = cPrm->dispPath;
+    lay.dispDeriv = cPrm->dispDeriv;
+    lay.nLoop = cPrm->nLoop;
+    lay.locT = cPrm->locT;
+    lay.totT = cPrm->totT;
+    lay.tCoord = geom.commCoord[N_DIM_-1];
+    writeLoopMomHDF5<Float>(fnameMom, lay, reinterpret_cast<const Float*>(dataMom.data()), COMM_TIME);
+  }
+}
+//---------------------------------------------------------------------------
+
+
+template <typename Float>
+LoopSessionHost<Float>::LoopSessionHost(const MugiqLoopParam *loopParams_, const HostGeom &geom_, QudaPrecision cpuPrec_,
+					int nEv_, HostEigenSource<Float> eigenSource_) :
+  loopParams(*loopParams_),
+  geom(geom_),
+  cpuPrec(cpuPrec_),
+  nEv(nEv_),
+  eigenSource(eigenSource_),
+  loop(nullptr),
+  gauge{nullptr,nullptr,nullptr,nullptr}
+{
+  if(!eigenSource) errorQuda("%s: The host backend needs a source of eigenpairs\n", __func__);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::setup(){
+  loop = new LoopHost<Float>(&loopParams, geom);
+  sigma.assign(nEv, 1.0);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::createEvecs(){
+  while(static_cast<int>(eVecs.size()) < nEv) eVecs.push_back(new HostColorSpinorField<Float>(geom));
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::loadGauge(void *gaugePtr[]){
+  for(int d=0;d<N_DIM_;d++) gauge[d] = gaugePtr[d];
+  loop->loadGauge(gauge, cpuPrec);
+}
+
+
+template <typename Float>
+EvecCacheHeader LoopSessionHost<Float>::evecCacheHeader(uint64_t gaugeChecksum) const {
+  int totalL[N_DIM_];
+  for(int d=0;d<N_DIM_;d++) totalL[d] = geom.lL[d] * comm_dim(d);
+  return EvecCacheHeader(geom.lL, totalL, geom.commCoord, 0, static_cast<int>(sizeof(Float)),
+			 static_cast<int>(QUDA_SPACE_SPIN_COLOR_FIELD_ORDER), nEv,
+			 static_cast<long long>(geom.volume) * SPINOR_SITE_LEN_ * sizeof(std::complex<Float>), gaugeChecksum);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::runLoop(const std::vector<HostColorSpinorField<Float>*> &ev, const std::vector<double> &sg){
+
+  const MuGiqEvecCompression comp = loopParams.evecCompression;
+  if(comp == MUGIQ_EVEC_COMPRESS_NONE){
+    loop->computeLoop(ev, sg);
+    return;
+  }
+
+  if(eVecsCompressed.empty()){
+    for(int n=0;n<nEv;n++) eVecsCompressed.push_back(new HostCompressedField<Float>(geom, comp));
+    printfQuda("%s: Eigenvectors stored in %s compression, %.1f MB instead of %.1f MB per rank\n", __func__,
+	       evecCompressName(comp), nEv * eVecsCompressed[0]->Bytes() / (1024.0*1024.0),
+	       nEv * ev[0]->Bytes() / (1024.0*1024.0));
+  }
+  for(int n=0;n<nEv;n++) eVecsCompressed[n]->encode(*ev[n]);
+
+  //- The uncompressed eigenvectors are only needed until they are encoded
+  for(auto v: eVecs) delete v;
+  eVecs.clear();
+
+  loop->computeLoopCompressed(eVecsCompressed, sg);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::computeLoop(){
+
+  const MuGiqEvecCacheMode cacheMode = loopParams.evecCacheMode;
+  if(cacheMode == MUGIQ_EVEC_CACHE_NONE){
+    createEvecs();
+    eigenSource(gauge, eVecs, sigma);
+    runLoop(eVecs, sigma);
+    return;
+  }
+
+  if(loopParams.evecCacheFile.empty()) errorQuda("%s: The eigenvector cache needs a file name\n", __func__);
+  const EvecCacheHeader expect = evecCacheHeader(gaugeChecksumMugiq(gauge, cpuPrec, geom.volume, geom.comm));
+  const std::string fname = evecCacheFileName(loopParams.evecCacheFile, comm_rank());
+
+  if(cacheMode == MUGIQ_EVEC_CACHE_LOAD){
+    EvecCacheFile cache(fname);
+    std::string why = "the file is absent or incomplete";
+    const bool ok = cache.Valid() && cache.Header().matches(expect, why);
+    if(!ok && cache.Valid()) warningQuda("%s: Cannot use the cache %s: %s\n", __func__, fname.c_str(), why.c_str());
+    const bool okAll = evecCacheAllRanks(ok, geom.comm);
+    if(okAll && loopParams.evecStreamRing > 0){
+      HostEvecStream<Float> stream(geom, fname, expect, loopParams.evecStreamRing);
+      const std::vector<double> sigmaCached(stream.Evals().sigma.begin(), stream.Evals().sigma.begin() + nEv);
+      printfQuda("%s: %d eigenpairs streamed from the cache %s through %d resident vectors\n", __func__,
+		 nEv, fname.c_str(), stream.RingSize());
+
+      if(loopParams.evecCompression != MUGIQ_EVEC_COMPRESS_NONE)
+	warningQuda("%s: The streamed eigenvectors are used as stored, without compression\n", __func__);
+      loop->computeLoopStream(stream, sigmaCached);
+      stream.Profile().print(__func__);
+      return;
+    }
+    else if(okAll){
+      std::vector<HostColorSpinorField<Float>*> cached;
+      for(int n=0;n<nEv;n++)
+	cached.push_back(new HostColorSpinorField<Float>(geom, N_SPIN_, N_COLOR_, static_cast<std::complex<Float>*>(cache.Vector(n))));
+      EvecCacheEvals ev;
+      cache.getEvals(ev);
+      const std::vector<double> sigmaCached(ev.sigma.begin(), ev.sigma.begin() + nEv);
+      printfQuda("%s: %d eigenpairs loaded from the cache %s\n", __func__, nEv, fname.c_str());
+
+      runLoop(cached, sigmaCached);
+      for(auto v: cached) delete v;
+      return;
+    }
+    printfQuda("%s: No usable eigenvector cache %s on all ranks, the eigenpairs will be computed\n", __func__, fname.c_str());
+  }
+
+  createEvecs();
+  eigenSource(gauge, eVecs, sigma);
+  {
+    EvecCacheFile cache(fname, expect);
+    for(int n=0;n<nEv;n++) memcpy(cache.Vector(n), eVecs[n]->V(), expect.vecBytes);
+
+    //- The host eigenpairs come with the singular values only, the eigenvalues of the Hermitian operator are their squares
+    EvecCacheEvals ev;
+    for(int n=0;n<nEv;n++){
+      ev.evalsQuda.push_back(std::complex<double>(sigma[n]*sigma[n], 0.0));
+      ev.evals.push_back(std::complex<double>(sigma[n]*sigma[n], 0.0));
+      ev.res.push_back(0.0);
+      ev.sigma.push_back(sigma[n]);
+    }
+    cache.setEvals(ev);
+  }
+  printfQuda("%s: %d eigenpairs saved to the cache %s\n", __func__, nEv, fname.c_str());
+
+  runLoop(eVecs, sigma);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::writeLoop(const std::string &fnameMom, const std::string &){
+  if(loopParams.writeMomSpaceHDF5 == MUGIQ_BOOL_FALSE){
+    warningQuda("%s: Will NOT write output data!\n", __func__);
+    return;
+  }
+  loop->writeLoopsHDF5(fnameMom);
+}
+
+
+template <typename Float>
+void LoopSessionHost<Float>::teardown(){
+  for(auto v: eVecs) delete v;
+  eVecs.clear();
+  for(auto v: eVecsCompressed) delete v;
+  eVecsCompressed.clear();
+  if(loop) delete loop;
+  loop = nullptr;
+}
+
+
+template class LoopHost<float>;
+template class LoopHost<double>;
+template class LoopSessionHost<float>;
+template class LoopSessionHost<double>;
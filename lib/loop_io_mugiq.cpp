@@ -0,0 +1,118 @@
+#include <loop_io_mugiq.h>
+#include <util_mugiq.h>
+#include <gamma.h>
+#include <typeinfo>
+#include <cstring>
+
+#ifdef HDF5_LIB
+#include <hdf5.h>
+#endif
+
+
+template <typename Float>
+void writeLoopMomHDF5(const std::string &fname, const LoopMomLayout &lay, const Float *dataMom, MPI_Comm comm){
+#ifdef HDF5_LIB
+  const int locT   = lay.locT;
+  const int nGamma = N_GAMMA_;
+  const int nLoop  = lay.nLoop;
+
+  //- Determine the data type for writing
+  hid_t H5_dataType;
+  if( typeid(Float) == typeid(float) ){
+    H5_dataType = H5T_NATIVE_FLOAT;
+    printfQuda("%s: Will write loop data in single precision\n", __func__);
+  }
+  else if( typeid(Float) == typeid(double)){
+    H5_dataType = H5T_NATIVE_DOUBLE;
+    printfQuda("%s: Will write loop data in double precision\n", __func__);
+  }
+  else errorQuda("%s: Precision not supported!\n", __func__);
+
+  char filename_c[fname.size()+1];
+  strcpy(filename_c, fname.c_str());
+  printfQuda("%s: Momentum-space loop data HDF5 filename: %s\n", __func__, filename_c);
+
+  const int dSetDim = 2; //- Size of each dataset (Time, real-imag)
+
+  //- Start point (offset) for each process, in each dimension
+  hsize_t start[dSetDim] = {static_cast<hsize_t>(lay.tCoord*locT), 0};
+
+  // Dimensions of the dataspace
+  hsize_t tdims[dSetDim] = {static_cast<hsize_t>(lay.totT), 2}; // Global
+  hsize_t ldims[dSetDim] = {static_cast<hsize_t>(locT), 2};     // Local
+
+  //- Open the file
+  hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_fapl_mpio(fapl_id, comm, MPI_INFO_NULL);
+  hid_t file_id = H5Fcreate(filename_c, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
+  if(file_id<0) errorQuda("%s: Cannot open filename %s. Check that directory exists!\n", __func__, filename_c);
+  H5Pclose(fapl_id);
+
+  //- Begin creating the groups
+  for(int im=0;im<lay.Nmom;im++){
+    //-Momenta group
+    char group1_tag[16];
+    snprintf(group1_tag, sizeof(group1_tag), "mom_%+d_%+d_%+d",
+	     lay.momMatrix[MOM_MATRIX_IDX(0,im)],
+	     lay.momMatrix[MOM_MATRIX_IDX(1,im)],
+	     lay.momMatrix[MOM_MATRIX_IDX(2,im)]);
+    hid_t group1_id = H5Gcreate(file_id, group1_tag, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+    //- Displacement group tags, in the order of the loop traces: ultra-local, entries, paths, derivatives
+    std::vector<std::string> group2_tag;
+    group2_tag.push_back("disp_0");
+    for(int iDE=0;iDE<lay.nDispEntries;iDE++)
+      for(int idisp=lay.dispStart.at(iDE);idisp<=lay.dispStop.at(iDE);idisp++)
+	group2_tag.push_back("disp_" + lay.dispString.at(iDE) + "_" + std::to_string(idisp));
+    for(const auto &path: lay.dispPath) group2_tag.push_back("path_" + path);
+    for(const auto &deriv: lay.dispDeriv) group2_tag.push_back("deriv_" + deriv);
+    if(static_cast<int>(group2_tag.size()) != nLoop)
+      errorQuda("%s: Got %d loop traces but %zu displacements\n", __func__, nLoop, group2_tag.size());
+
+    for(int iL=0;iL<nLoop;iL++){
+      //- Displacement group
+      hid_t group2_id = H5Gcreate(group1_id, group2_tag.at(iL).c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+      for(int ig=0;ig<N_GAMMA_;ig++){
+	//- Gamma matrix group
+	std::string gStr = GammaName(ig);
+	char group3_tag[gStr.size()+1];
+	strcpy(group3_tag, gStr.c_str());
+	hid_t group3_id = H5Gcreate(group2_id, group3_tag, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	//- Create filespaces and hyperslab
+	hid_t h5_filespace = H5Screate_simple(dSetDim, tdims, NULL);
+	hid_t dataset_id   = H5Dcreate(group3_id, "loop", H5_dataType, h5_filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	hid_t h5_subspace  = H5Screate_simple(dSetDim, ldims, NULL);
+	h5_filespace = H5Dget_space(dataset_id);
+	H5Sselect_hyperslab(h5_filespace, H5S_SELECT_SET, start, NULL, ldims, NULL);
+	hid_t plist_id = H5Pcreate(H5P_DATASET_XFER);
+	H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
+
+	const long long loopIdx = locT*ig + locT*nGamma*iL + locT*nGamma*nLoop*im;
+
+	herr_t status = H5Dwrite(dataset_id, H5_dataType, h5_subspace, h5_filespace, plist_id, &(dataMom[2*loopIdx]));
+	if(status<0) errorQuda("%s: Could not write data for (mom,disp,gamma) = (%d,%d,%d)\n", __func__,im,iL,ig);
+
+	H5Sclose(h5_subspace);
+	H5Dclose(dataset_id);
+	H5Sclose(h5_filespace);
+	H5Pclose(plist_id);
+
+	H5Gclose(group3_id);
+      }//- for gamma
+
+      H5Gclose(group2_id);
+    }//- for loop traces
+
+    H5Gclose(group1_id);
+  }//- for momenta
+
+  H5Fclose(file_id);
+#else // HDF5_LIB
+  errorQuda("Function not available: compile with HDF5");
+#endif
+}
+
+template void writeLoopMomHDF5<float> (const std::string &fname, const LoopMomLayout &lay, const float  *dataMom, MPI_Comm comm);
+template void writeLoopMomHDF5<double>(const std::string &fname, const LoopMomLayout &lay, const double *dataMom, MPI_Comm comm);
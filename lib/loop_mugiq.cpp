@@ -1,10 +1,10 @@
 #include <loop_mugiq.h>
 #include <gamma.h>
+#include <mpi_profile_mugiq.h>
+#include <farm_mugiq.h>
+#include <loop_io_mugiq.h>
 #include <cublas_v2.h>
-
-#ifdef HDF5_LIB
-#include <hdf5.h>
-#endif
+#include <algorithm>
 
 template <typename Float, QudaFieldOrder fieldOrder>
 Loop_Mugiq<Float, fieldOrder>::Loop_Mugiq(MugiqLoopParam *loopParams_,
@@ -58,16 +58,26 @@ Loop_Mugiq<Float, fieldOrder>::Loop_Mugiq(MugiqLoopParam *loopParams_,
 								 refVec,
 								 eigsolve->eVecs[0]->Precision());
 
+  pathTrie = DispPathTrie::fromEntries(cPrm->dispString, cPrm->dispStart, cPrm->dispStop, cPrm->nLoopOffset,
+				       cPrm->dispPath, cPrm->dispPathOffset, cPrm->dispDeriv, cPrm->dispDerivOffset);
+  //- The fused +d/-d stencil and the star stencil exist on the host only, the device walks the trie hop by hop
+  pathTrie.setFusePairs(false);
+  if(cPrm->doNonLocal) pathTrie.printReport(__func__);
+  if(cPrm->doNonLocal && loopParams_->wilsonLineBudget > 0)
+    warningQuda("%s: Wilson-line tables are available in the host loop only, the displacements are performed hop by hop\n", __func__);
+
   printfQuda("*************************************************\n\n");
 }
 
 template <typename Float, QudaFieldOrder fieldOrder>
 void Loop_Mugiq<Float, fieldOrder>::setupComms(){
 
+  MPIProfileStage profStage(MUGIQ_STAGE_SETUP);
+
   //-- Create space-communicator
   tCoord = comm_coord(3);
   cRank = comm_rank();
-  MPI_Comm_split(MPI_COMM_WORLD, tCoord, cRank, &COMM_SPACE);
+  MPI_Comm_split(getCommMugiq(), tCoord, cRank, &COMM_SPACE);
   MPI_Comm_rank(COMM_SPACE,&space_rank);
   MPI_Comm_size(COMM_SPACE,&space_size);
   
@@ -81,7 +91,7 @@ void Loop_Mugiq<Float, fieldOrder>::setupComms(){
     IamTimeProcess = MUGIQ_BOOL_TRUE;
   }
     
-  MPI_Comm_split(MPI_COMM_WORLD, time_color, tCoord, &COMM_TIME);
+  MPI_Comm_split(getCommMugiq(), time_color, tCoord, &COMM_TIME);
   MPI_Comm_rank(COMM_TIME,&time_rank);
   MPI_Comm_size(COMM_TIME,&time_size);
 
@@ -96,11 +106,48 @@ Loop_Mugiq<Float, fieldOrder>::~Loop_Mugiq(){
 
   freeDataMemory();
 
+  if(commsAreSet){
+    MPI_Comm_free(&COMM_SPACE);
+    MPI_Comm_free(&COMM_TIME);
+    commsAreSet = MUGIQ_BOOL_FALSE;
+  }
+
+  freeProlongTmp();
+  freeHostProlongator();
   if(cPrm->doNonLocal) delete displace;
   delete cPrm;
 }
 
 
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::resetConfig(MugiqLoopParam *loopParams_, Eigsolve_Mugiq *eigsolve_){
+
+  eigsolve = eigsolve_;
+  if(eigsolve->useMGenv && eigsolve->computeCoarse) refVec = eigsolve->tmpCSF[0];
+  else refVec = eigsolve->eVecs[0];
+
+  if(refVec->VolumeCB() != cPrm->volumeCB || refVec->SiteSubset() != cPrm->nParity)
+    errorQuda("%s: The geometry of the eigenvectors changed within the session\n", __func__);
+
+  MomProjDone = MUGIQ_BOOL_FALSE;
+  resetOutput(loopParams_);
+
+  //- Only the links change, the extended gauge field and the communicators are kept
+  if(cPrm->doNonLocal) displace->loadGauge(loopParams_->gauge);
+
+  printfQuda("%s: Loop computation environment reset for a new configuration\n", __func__);
+}
+
+
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::resetOutput(MugiqLoopParam *loopParams_){
+  writeDataPos = loopParams_->writePosSpaceHDF5;
+  writeDataMom = loopParams_->writeMomSpaceHDF5;
+  momSpaceFilename = loopParams_->fname_mom_h5;
+  posSpaceFilename = loopParams_->fname_pos_h5;
+}
+
+
 template <typename Float, QudaFieldOrder fieldOrder>
 void Loop_Mugiq<Float, fieldOrder>::allocateDataMemory(){
 
@@ -240,6 +287,8 @@ void Loop_Mugiq<Float, fieldOrder>::printLoopComputeParams(){
   printfQuda("    Parameters of the Loop Computation\n");
   printfQuda("Precision is %s\n", typeid(Float) == typeid(float) ? "single" : "double");
   printfQuda("Will%s use Multigrid\n", eigsolve->useMGenv ? "" : " NOT");
+  if(eigsolve->useMGenv && eigsolve->computeCoarse)
+    printfQuda("Will prolongate the coarse eigenvectors %s\n", cPrm->hostProlong ? "in batches on the host" : "one by one on the device");
   printfQuda("Working with %s operators/fields\n", eigsolve->computeCoarse ? "coarse" : "fine");  
   printfQuda("Will%s perform Momentum Projection (Fourier Transform)\n", cPrm->doMomProj ? "" : " NOT");
   if(cPrm->doMomProj){
@@ -260,7 +309,13 @@ void Loop_Mugiq<Float, fieldOrder>::printLoopComputeParams(){
       else
 	printfQuda("  %d: %s with lengths from %d to %d, #loops = %d, loop-offset = %d\n", id,
 		   dispStr_c, cPrm->dispStart.at(id),cPrm->dispStop.at(id), cPrm->nLoopPerEntry.at(id), cPrm->nLoopOffset.at(id));
-    }   
+    }
+    if(cPrm->nDispPaths > 0) printfQuda("and the following %d displacement paths:\n", cPrm->nDispPaths);
+    for(int ip=0;ip<cPrm->nDispPaths;ip++)
+      printfQuda("  %d: %s, loop-offset = %d\n", ip, cPrm->dispPath.at(ip).c_str(), cPrm->dispPathOffset + ip);
+    if(cPrm->nDispDerivs > 0) printfQuda("and the following %d symmetric covariant derivatives:\n", cPrm->nDispDerivs);
+    for(int id=0;id<cPrm->nDispDerivs;id++)
+      printfQuda("  %d: %s, loop-offset = %d\n", id, cPrm->dispDeriv.at(id).c_str(), cPrm->dispDerivOffset + id);
   }
   printfQuda("Total number of Loop Traces to perform: %d\n", cPrm->nLoop);
   printfQuda("Local  lattice size (x,y,z,t): %d %d %d %d \n", cPrm->localL[0], cPrm->localL[1], cPrm->localL[2], cPrm->localL[3]);
@@ -270,7 +325,7 @@ void Loop_Mugiq<Float, fieldOrder>::printLoopComputeParams(){
   printfQuda("Local  volume: %lld\n", cPrm->locV4);
   printfQuda("Local  3d volume: %lld\n", cPrm->locV3);
   printfQuda("Global 3d volume: %lld\n", cPrm->totV3);
-  printfQuda("Transverse shift max. depth (not applicable now): %d\n", cPrm->max_depth);
+  printfQuda("Maximum number of hops of the displaced vectors: %d\n", cPrm->max_depth);
   printfQuda("******************************************\n");
   
 }
@@ -285,25 +340,10 @@ void Loop_Mugiq<Float, fieldOrder>::prolongateEvec(ColorSpinorField *fineEvec, C
   if(fieldOrder != QUDA_FLOAT2_FIELD_ORDER) errorQuda("%s: Vector prolongation requires fieldOrder = FLOAT2\n", __func__);
   
   MG_Mugiq &mg_env = *(eigsolve->getMGEnv());
-  
-  //- Create one fine and N_coarse temporary coarse fields
-  //- Will be used for prolongating the coarse eigenvectors back to the fine lattice  
-  std::vector<ColorSpinorField *> tmpCSF;
-  ColorSpinorParam csParam(*refVec);
-  QudaPrecision coarsePrec = coarseEvec->Precision();
-  csParam.location = QUDA_CUDA_FIELD_LOCATION;
-  csParam.create = QUDA_ZERO_FIELD_CREATE;
-  csParam.setPrecision(coarsePrec);
 
-  tmpCSF.push_back(ColorSpinorField::Create(csParam)); //- tmpCSF[0] is a fine field
-  for(int lev=0;lev<mg_env.nCoarseLevels;lev++){
-    tmpCSF.push_back(tmpCSF[lev]->CreateCoarse(mg_env.mgParams->geo_block_size[lev],
-                                               mg_env.mgParams->spin_block_size[lev],
-                                               mg_env.mgParams->n_vec[lev],
-                                               coarsePrec,
-                                               mg_env.mgParams->setup_location[lev+1]));
-  }//-lev
-    
+  createProlongTmp(coarseEvec->Precision());
+  std::vector<ColorSpinorField *> &tmpCSF = prolongTmp;
+
   //- Prolongate the coarse eigenvectors recursively
   //- to get to the finest level
   *(tmpCSF[mg_env.nCoarseLevels]) = *coarseEvec;
@@ -316,9 +356,154 @@ void Loop_Mugiq<Float, fieldOrder>::prolongateEvec(ColorSpinorField *fineEvec, C
   if(!mg_env.transfer[0]) errorQuda("%s: Transfer operator for finest level does not exist!\n", __func__);
   mg_env.transfer[0]->P(*fineEvec, *(tmpCSF[1]));
 
-  for(int i=0;i<static_cast<int>(tmpCSF.size());i++) delete tmpCSF[i];
+  if(getVerbosity() >= QUDA_VERBOSE) printfQuda("%s: Vector prolongated\n", __func__);
+}
+
 
-  printfQuda("%s: Vector prolongated\n", __func__);
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::createProlongTmp(QudaPrecision coarsePrec){
+
+  if(!prolongTmp.empty() && prolongTmp[0]->Precision() == coarsePrec) return;
+  freeProlongTmp();
+
+  MG_Mugiq &mg_env = *(eigsolve->getMGEnv());
+
+  //- Create one fine and N_coarse temporary coarse fields
+  //- Will be used for prolongating the coarse eigenvectors back to the fine lattice
+  ColorSpinorParam csParam(*refVec);
+  csParam.location = QUDA_CUDA_FIELD_LOCATION;
+  csParam.create = QUDA_ZERO_FIELD_CREATE;
+  csParam.setPrecision(coarsePrec);
+
+  prolongTmp.push_back(ColorSpinorField::Create(csParam)); //- prolongTmp[0] is a fine field
+  for(int lev=0;lev<mg_env.nCoarseLevels;lev++){
+    prolongTmp.push_back(prolongTmp[lev]->CreateCoarse(mg_env.mgParams->geo_block_size[lev],
+						       mg_env.mgParams->spin_block_size[lev],
+						       mg_env.mgParams->n_vec[lev],
+						       coarsePrec,
+						       mg_env.mgParams->setup_location[lev+1]));
+  }//-lev
+
+  printfQuda("%s: Scratch fields of the prolongation created for %d coarse levels\n", __func__, mg_env.nCoarseLevels);
+}
+
+
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::freeProlongTmp(){
+  for(auto v: prolongTmp) delete v;
+  prolongTmp.clear();
+}
+
+
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::loadHostProlongator(){
+
+  MG_Mugiq &mg_env = *(eigsolve->getMGEnv());
+  const int nLevel = mg_env.nCoarseLevels;
+  const QudaPrecision hostPrec = (sizeof(Float) == sizeof(double)) ? QUDA_DOUBLE_PRECISION : QUDA_SINGLE_PRECISION;
+
+  if(!hostProlong){
+    if(cPrm->nParity != 2) errorQuda("%s: The host prolongation requires full-parity eigenvectors\n", __func__);
+    hostGeom = new HostGeom(cPrm->localL);
+    int geoBlock[QUDA_MAX_MG_LEVEL][N_DIM_];
+    int spinBlock[QUDA_MAX_MG_LEVEL];
+    int nVec[QUDA_MAX_MG_LEVEL];
+    for(int lev=0;lev<nLevel;lev++){
+      for(int d=0;d<N_DIM_;d++) geoBlock[lev][d] = mg_env.mgParams->geo_block_size[lev][d];
+      spinBlock[lev] = mg_env.mgParams->spin_block_size[lev];
+      nVec[lev] = mg_env.mgParams->n_vec[lev];
+    }
+    hostProlong = new HostProlongator<Float>(*hostGeom, nLevel, geoBlock, spinBlock, nVec);
+  }
+
+  //- The null vectors change with the MG hierarchy, so they are copied for every configuration
+  for(int lev=0;lev<nLevel;lev++){
+    if(!mg_env.transfer[lev]) errorQuda("%s: Transfer operator for level %d does not exist!\n", __func__, lev);
+    const ColorSpinorField &V = mg_env.transfer[lev]->Vectors();
+    ColorSpinorParam vParam(V);
+    vParam.location = QUDA_CPU_FIELD_LOCATION;
+    vParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+    vParam.create = QUDA_NULL_FIELD_CREATE;
+    vParam.setPrecision(hostPrec);
+    ColorSpinorField *hostV = ColorSpinorField::Create(vParam);
+    *hostV = V;
+    hostProlong->setNullVectors(lev, hostV->V(), hostPrec);
+    delete hostV;
+  }
+
+  printfQuda("%s: Null vectors of %d levels copied to the host prolongator, %.1f MB\n", __func__, nLevel,
+	     hostProlong->Bytes() / (1024.0*1024.0));
+}
+
+
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::freeHostProlongator(){
+  for(auto v: hostProlongCoarse) delete v;
+  for(auto v: hostProlongFine) delete v;
+  hostProlongCoarse.clear();
+  hostProlongFine.clear();
+  delete hostProlong;
+  delete hostGeom;
+  hostProlong = nullptr;
+  hostGeom = nullptr;
+}
+
+
+template <typename Float, QudaFieldOrder fieldOrder>
+void Loop_Mugiq<Float, fieldOrder>::prolongateEvec(std::vector<ColorSpinorField*> &fineEvec,
+						   const std::vector<ColorSpinorField*> &coarseEvec){
+
+  if(!cPrm->hostProlong){
+    for(size_t k=0;k<coarseEvec.size();k++) prolongateEvec(fineEvec[k], coarseEvec[k]);
+    return;
+  }
+
+  if(!eigsolve->useMGenv) errorQuda("%s: This function is applicable only when using MG environment\n", __func__);
+  if(!eigsolve->computeCoarse) errorQuda("%s: Not supposed to be called when computeCoarse is False\n", __func__);
+  if(!hostProlong) errorQuda("%s: The host prolongator has not been loaded\n", __func__);
+
+  MG_Mugiq &mg_env = *(eigsolve->getMGEnv());
+  const int nLevel = hostProlong->NLevel();
+  const QudaPrecision hostPrec = (sizeof(Float) == sizeof(double)) ? QUDA_DOUBLE_PRECISION : QUDA_SINGLE_PRECISION;
+  const size_t kB = coarseEvec.size();
+
+  //- The host fields are in the spin basis of the null vectors, the copies to and from them change the basis
+  while(hostProlongCoarse.size() < kB){
+    ColorSpinorParam cParam(*coarseEvec[0]);
+    cParam.location = QUDA_CPU_FIELD_LOCATION;
+    cParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+    cParam.create = QUDA_NULL_FIELD_CREATE;
+    cParam.setPrecision(hostPrec);
+    hostProlongCoarse.push_back(ColorSpinorField::Create(cParam));
+
+    ColorSpinorParam fParam(*fineEvec[0]);
+    fParam.location = QUDA_CPU_FIELD_LOCATION;
+    fParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+    fParam.gammaBasis = mg_env.transfer[0]->Vectors().GammaBasis();
+    fParam.create = QUDA_NULL_FIELD_CREATE;
+    fParam.setPrecision(hostPrec);
+    hostProlongFine.push_back(ColorSpinorField::Create(fParam));
+  }
+
+  //- The host fields wrap the storage of the QUDA host fields
+  std::vector<HostColorSpinorField<Float>*> hCoarse, hFine;
+  for(size_t k=0;k<kB;k++){
+    *hostProlongCoarse[k] = *coarseEvec[k];
+    hCoarse.push_back(new HostColorSpinorField<Float>(hostProlong->Geom(nLevel), hostProlong->Nspin(nLevel), hostProlong->Ncolor(nLevel),
+						      static_cast<std::complex<Float>*>(hostProlongCoarse[k]->V())));
+    hFine.push_back(new HostColorSpinorField<Float>(*hostGeom, N_SPIN_, N_COLOR_,
+						    static_cast<std::complex<Float>*>(hostProlongFine[k]->V())));
+  }
+
+  hostProlong->prolongate(hFine, hCoarse);
+
+  for(size_t k=0;k<kB;k++){
+    *fineEvec[k] = *hostProlongFine[k];
+    delete hCoarse[k];
+    delete hFine[k];
+  }
+
+  if(getVerbosity() >= QUDA_VERBOSE) printfQuda("%s: %zu vectors prolongated on the host\n", __func__, kB);
 }
 
 
@@ -406,7 +591,9 @@ void Loop_Mugiq<Float, fieldOrder>::performMomentumProjection(){
   if     ( typeid(Float) == typeid(float) ) dataTypeMPI = MPI_COMPLEX;
   else if( typeid(Float) == typeid(double)) dataTypeMPI = MPI_DOUBLE_COMPLEX;
   
+  mpiProfilePushStage(MUGIQ_STAGE_MOM_REDUCE);
   MPI_Reduce(dataMom_h, dataMom, nElemMomLoc, dataTypeMPI, MPI_SUM, 0, COMM_SPACE);
+  mpiProfilePopStage();
   
   
   /**
@@ -420,17 +607,17 @@ void Loop_Mugiq<Float, fieldOrder>::performMomentumProjection(){
    *    id = ig + nGamma*iL
    *    nData = nGamma*nLoops
    */
+  mpiProfilePushStage(MUGIQ_STAGE_GATHER);
   MPI_Gather(dataMom      , nElemMomLoc, dataTypeMPI,
              dataMom_bcast, nElemMomLoc, dataTypeMPI,
              0, COMM_TIME);
   
-  MPI_Bcast(dataMom_bcast, nElemMomTot, dataTypeMPI, 0, MPI_COMM_WORLD);
+  MPI_Bcast(dataMom_bcast, nElemMomTot, dataTypeMPI, 0, getCommMugiq());
+  mpiProfilePopStage();
 
   
   //-- cleanup & return
-  MPI_Comm_free(&COMM_SPACE);
-  MPI_Comm_free(&COMM_TIME);
-
+  //-- (the communicators are kept for the following configurations, they are freed with the object)
   cublasDestroy(handle);
 
   MomProjDone = MUGIQ_BOOL_TRUE;
@@ -452,64 +639,61 @@ void Loop_Mugiq<Float, fieldOrder>::computeCoarseLoop(){
   QudaPrecision evecPrec = eigsolve->eVecs[0]->Precision();
   csParam.create = QUDA_ZERO_FIELD_CREATE;
   csParam.setPrecision(evecPrec);
-  ColorSpinorField *fineEvecL = ColorSpinorField::Create(csParam);
-  ColorSpinorField *fineEvecR = ColorSpinorField::Create(csParam);
-  
-  for(int id=-1;id<cPrm->nDispEntries;id++){
-    char *dispEntry_c = nullptr;
-    if( cPrm->doNonLocal && (id != -1) ){
-      dispEntry_c = (char*)malloc(sizeof(char)*(cPrm->dispEntry.at(id).size()+1));
-      strcpy(dispEntry_c, cPrm->dispEntry.at(id).c_str());
-      printfQuda("\n\n%s: Will perform loop for displacement entry %s\n", __func__, dispEntry_c);
-      displace->setupDisplacement(cPrm->dispString.at(id));
-    }
-    else printfQuda("\n\n%s: Will Run for ultra-local currents (displacement = 0)\n", __func__);    
 
-    long long bufOffset;
-    size_t bufByteSize;
-    if( cPrm->doNonLocal && (id != -1) ){
-      bufOffset = nElemPosLocPerLoop*cPrm->nLoopOffset.at(id); //- Jump the ultra-local plus loops of previous entry
-      bufByteSize = SizeCplxFloat*nElemPosLocPerLoop*cPrm->nLoopPerEntry.at(id); //- #elem/entry 
+  //- The fine eigenvectors walk the displacement-path trie in batches: every hop is performed once for all the
+  //- traces sharing it, and loads the links once for the whole batch. Slot 0 holds the un-displaced eigenvectors,
+  //- i.e. each coarse eigenvector is prolongated once for the ultra-local trace and all the displacements
+  const std::vector<DispPathOp> &sched = pathTrie.Schedule();
+  const std::vector<DispPathNode> &node = pathTrie.Nodes();
+  const int nBatch = cPrm->doNonLocal ? displace->BatchSize() : (cPrm->hostProlong ? DISPLACE_BATCH_DEVICE_ : 1);
+  std::vector<std::vector<ColorSpinorField*>> fineEvec(pathTrie.NSlot());
+  for(auto &slot: fineEvec)
+    for(int k=0;k<nBatch;k++) slot.push_back(ColorSpinorField::Create(csParam));
+
+  cudaMemset(dataPos_d, 0, SizeCplxFloat*nElemPosLoc);
+
+  if(eigsolve->computeCoarse && cPrm->hostProlong) loadHostProlongator();
+
+  for(int n0=0;n0<nEv;n0+=nBatch){
+    const int kB = std::min(nBatch, nEv - n0);
+    std::vector<Float> sigma(kB);
+    for(int k=0;k<kB;k++){
+      sigma[k] = (Float)(*(eigsolve->eVals_sigma))[n0+k];
+      printfQuda("%s: Performing Loop trace for EV[%04d] = %+.16e\n", __func__, n0+k, sigma[k]);
+      if(!eigsolve->computeCoarse) *fineEvec[0][k] = *(eigsolve->eVecs[n0+k]);
     }
-    else{
-      bufOffset = 0;
-      bufByteSize = SizeCplxFloat*nElemPosLocPerLoop;
+    if(eigsolve->computeCoarse){
+      //- The whole batch goes through the transfer chain at once
+      std::vector<ColorSpinorField*> fineBatch(fineEvec[0].begin(), fineEvec[0].begin()+kB);
+      std::vector<ColorSpinorField*> coarseBatch(eigsolve->eVecs.begin()+n0, eigsolve->eVecs.begin()+n0+kB);
+      prolongateEvec(fineBatch, coarseBatch);
     }
-
-    cudaMemset(&(dataPos_d[bufOffset]), 0, bufByteSize);
-    
-    for(int n=0;n<nEv;n++){
-      Float sigma = (Float)(*(eigsolve->eVals_sigma))[n];
-      printfQuda("%s: Performing Loop trace for EV[%04d] = %+.16e\n", __func__, n, sigma);
-      
-      if(eigsolve->computeCoarse) prolongateEvec(fineEvecL, eigsolve->eVecs[n]);
-      else *fineEvecL = *(eigsolve->eVecs[n]);
-
-      if( cPrm->doNonLocal && (id != -1) ){
-	//- Perform Displacements
-	*fineEvecR = *fineEvecL; //- reset right vector to the original, un-displaced eigenvector
-	int dispCount = 0;
-	for(int idisp=1;idisp<=cPrm->dispStop.at(id);idisp++){
-	  displace->doVectorDisplacement(DISPLACE_TYPE_COVARIANT, fineEvecR, idisp);
-	  if(idisp >= cPrm->dispStart.at(id) && idisp <= cPrm->dispStop.at(id)){
-	    long long dispOffset = nElemPosLocPerLoop*dispCount;
-	    performLoopContraction<Float, fieldOrder>(&(dataPos_d[bufOffset+dispOffset]), fineEvecL, fineEvecR, sigma);
-	    printfQuda("%s: EV[%04d] Loop trace for displacement = %02d completed\n", __func__, n, idisp);
-	    dispCount++;
-	  }
-	}//-for displacement
-      }
+    if(n0 == 0 && cPrm->doNonLocal) displace->checkLinkReconstruction(fineEvec[0][0]);
+
+    std::vector<std::vector<ColorSpinorField*>> slot(fineEvec.size());
+    for(size_t s=0;s<slot.size();s++) slot[s].assign(fineEvec[s].begin(), fineEvec[s].begin()+kB);
+
+    for(const auto &op: sched){
+      if(op.type == DISP_PATH_OP_HOP)
+	displace->doVectorDisplacement(DISPLACE_TYPE_COVARIANT, slot[op.dst], slot[op.src], op.hop);
+      else if(op.type == DISP_PATH_OP_DERIV)
+	displace->doVectorDerivative(DISPLACE_TYPE_COVARIANT, slot[op.dst], slot[op.src], displaceFlagDir(op.hop));
+      else if(op.type == DISP_PATH_OP_HOP_PAIR || op.type == DISP_PATH_OP_STAR)
+	errorQuda("%s: Operation %d of the displacement schedule is host-only\n", __func__, static_cast<int>(op.type));
       else{
-	//- Ultra-local
-	*fineEvecR = *fineEvecL;
-	performLoopContraction<Float, fieldOrder>(dataPos_d, fineEvecL, fineEvecR, sigma);
-	printfQuda("%s: EV[%04d] - Loop trace for Ultra-local completed\n", __func__, n);
+	const long long bufOffset = nElemPosLocPerLoop*node[op.node].loopIdx.at(0);
+	for(int k=0;k<kB;k++)
+	  performLoopContraction<Float, fieldOrder>(&(dataPos_d[bufOffset]), slot[0][k], slot[op.src][k], sigma[k]);
+	printfQuda("%s: EV[%04d-%04d] Loop trace for displacement = %02d completed\n", __func__, n0, n0+kB-1, node[op.node].depth);
       }
+    }
+  } //- Eigenvector batches
 
-    } //- Eigenvectors
-
-    if(dispEntry_c) free(dispEntry_c);
-  }//- Loop over displace entries
+  //- Traces requested more than once with the same path are copies of the first one
+  for(const auto &nd: node)
+    for(size_t i=1;i<nd.loopIdx.size();i++)
+      cudaMemcpy(&(dataPos_d[nElemPosLocPerLoop*nd.loopIdx[i]]), &(dataPos_d[nElemPosLocPerLoop*nd.loopIdx[0]]),
+		 SizeCplxFloat*nElemPosLocPerLoop, cudaMemcpyDeviceToDevice);
 
   //-Always copy the device position-space buffer to the host
   cudaMemcpy(dataPos, dataPos_d, SizeCplxFloat*nElemPosLoc, cudaMemcpyDeviceToHost);
@@ -522,8 +706,8 @@ void Loop_Mugiq<Float, fieldOrder>::computeCoarseLoop(){
     printfQuda("\n%s: Momentum projection for all loops completed\n\n", __func__);
   }
   
-  delete fineEvecL;
-  delete fineEvecR;
+  for(auto &slot: fineEvec)
+    for(auto v: slot) delete v;
   
 }
 
@@ -536,124 +720,22 @@ void Loop_Mugiq<Float, fieldOrder>::writeLoopsHDF5_Mom(){
   
   //- Only the "time" processes will write, they are the ones that have the globally reduced data buffer!
   if(IamTimeProcess){
-
-    const int locT   = cPrm->locT;
-    const int nGamma = cPrm->nG;
-    const int nLoop  = cPrm->nLoop;
-    
-    //- Determine the data type for writing
-    hid_t H5_dataType;
-    if( typeid(Float) == typeid(float) ){
-      H5_dataType = H5T_NATIVE_FLOAT;
-      printfQuda("%s: Will write loop data in single precision\n", __func__);
-    }
-    else if( typeid(Float) == typeid(double)){
-      H5_dataType = H5T_NATIVE_DOUBLE;
-      printfQuda("%s: Will write loop data in double precision\n", __func__);
-    }
-    else errorQuda("%s: Precision not supported!\n", __func__);
-
-    
-    char filename_c[momSpaceFilename.size()+1];
-    strcpy(filename_c, momSpaceFilename.c_str());
-    printfQuda("%s: Momentum-space loop data HDF5 filename: %s\n", __func__, filename_c);
-    
-    const int dSetDim = 2; //- Size of each dataset (Time, real-imag)
-
-    //- Start point (offset) for each process, in each dimension
-    hsize_t start[dSetDim] = {static_cast<hsize_t>(tCoord*cPrm->localL[3]), 0};
-
-    // Dimensions of the dataspace
-    hsize_t tdims[dSetDim] = {static_cast<hsize_t>(cPrm->totalL[3]), 2}; // Global
-    hsize_t ldims[dSetDim] = {static_cast<hsize_t>(cPrm->localL[3]), 2}; // Local
-
-    //- Open the file
-    hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
-
-    //H5Pset_fapl_mpio(fapl_id, COMM_TIME, MPI_INFO_NULL);
-    H5Pset_fapl_mpio(fapl_id, MPI_COMM_WORLD, MPI_INFO_NULL);
-    hid_t file_id = H5Fcreate(filename_c, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
-    if(file_id<0) errorQuda("%s: Cannot open filename %s. Check that directory exists!\n", __func__, filename_c);
-    H5Pclose(fapl_id);    
-
-    int dStart = 0, dStop = 0;
-
-    //- Begin creating the groups
-    for(int im=0;im<cPrm->Nmom;im++){
-      //-Momenta group
-      char group1_tag[16];
-      snprintf(group1_tag, sizeof(group1_tag), "mom_%+d_%+d_%+d",
-	       cPrm->momMatrix[MOM_MATRIX_IDX(0,im)],
-	       cPrm->momMatrix[MOM_MATRIX_IDX(1,im)],
-	       cPrm->momMatrix[MOM_MATRIX_IDX(2,im)]);
-      hid_t group1_id = H5Gcreate(file_id, group1_tag, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-
-      int iL = 0;
-      for(int iDE=-1;iDE<cPrm->nDispEntries;iDE++){
-	if(iDE == -1){
-	  dStart = 0;
-	  dStop  = 0;
-	}
-	else{
-	  dStart = cPrm->dispStart.at(iDE);
-	  dStop  = cPrm->dispStop.at(iDE);
-	}
-	for(int idisp=dStart;idisp<=dStop;idisp++){
-	  //- Displacement group
-	  char group2_tag[10];
-	  if(iDE==-1){
-	    snprintf(group2_tag,sizeof(group2_tag),"disp_0");
-	  }
-	  else{
-	    std::string dStr = cPrm->dispString.at(iDE);
-	    char disp_c[dStr.size()+1];
-	    strcpy(disp_c, dStr.c_str());
-	    snprintf(group2_tag,sizeof(group2_tag),"disp_%s_%d", disp_c, idisp);
-	  }  
-	  hid_t group2_id = H5Gcreate(group1_id, group2_tag, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	  
-	  for(int ig=0;ig<N_GAMMA_;ig++){
-	    //- Gamma matrix group
-	    std::string gStr = GammaName(ig);
-	    char group3_tag[gStr.size()+1];
-	    strcpy(group3_tag, gStr.c_str());
-	    hid_t group3_id = H5Gcreate(group2_id, group3_tag, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-
-	    //- Create filespaces and hyperslab
-            hid_t h5_filespace = H5Screate_simple(dSetDim, tdims, NULL);
-            hid_t dataset_id   = H5Dcreate(group3_id, "loop", H5_dataType, h5_filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-            hid_t h5_subspace  = H5Screate_simple(dSetDim, ldims, NULL);
-            h5_filespace = H5Dget_space(dataset_id);
-            H5Sselect_hyperslab(h5_filespace, H5S_SELECT_SET, start, NULL, ldims, NULL);
-            hid_t plist_id = H5Pcreate(H5P_DATASET_XFER);
-            H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
-
-	    const long long loopIdx = locT*ig + locT*nGamma*iL + locT*nGamma*nLoop*im;
-
-	    //	    for(int t=0;t<locT;t++)
-	    //	      printfQuda("%+16.e %16.e\n", dataMom[t+loopIdx].real(), dataMom[t+loopIdx].imag());
-	    
-	    herr_t status = H5Dwrite(dataset_id, H5_dataType, h5_subspace, h5_filespace, plist_id, &(dataMom[loopIdx]));
-	    if(status<0) errorQuda("%s: Could not write data for (mom,disp,gamma) = (%d,%d,%d)\n", __func__,im,iL,ig);
-
-            H5Sclose(h5_subspace);
-            H5Dclose(dataset_id);
-            H5Sclose(h5_filespace);
-            H5Pclose(plist_id);
-
-	    H5Gclose(group3_id);
-	  }//- for gamma
-	  
-	  iL++;
-	  H5Gclose(group2_id);
-	} //- for dispStart-dispStop
-      }//- for displacement entries
-      
-      H5Gclose(group1_id);
-    }//- for momenta
-
-    H5Fclose(file_id);
-    
+    LoopMomLayout lay;
+    lay.Nmom = cPrm->Nmom;
+    lay.momMatrix.assign(cPrm->momMatrix, cPrm->momMatrix + cPrm->Nmom*cPrm->momDim);
+    lay.nDispEntries = cPrm->nDispEntries;
+    lay.dispString = cPrm->dispString;
+    lay.dispStart = cPrm->dispStart;
+    lay.dispStop = cPrm->dispStop;
+    lay.dispPath = cPrm->dispPath;
+    lay.dispDeriv = cPrm->dispDeriv;
+    lay.nLoop = cPrm->nLoop;
+    lay.locT = cPrm->localL[3];
+    lay.totT = cPrm->totalL[3];
+    lay.tCoord = tCoord;
+
+    //- The file is opened collectively by the time processes only, i.e. on COMM_TIME
+    writeLoopMomHDF5<Float>(momSpaceFilename, lay, reinterpret_cast<Float*>(dataMom), COMM_TIME);
   }//- If time process
 #else // HDF5_LIB
   errorQuda("Function not available: compile with HDF5");
@@ -674,6 +756,8 @@ template <typename Float, QudaFieldOrder fieldOrder>
 void Loop_Mugiq<Float, fieldOrder>::writeLoopsHDF5(){
 
 #ifdef HDF5_LIB
+  MPIProfileStage profStage(MUGIQ_STAGE_HDF5_IO);
+
   if(cPrm->doMomProj){
     if(writeDataMom) printfQuda("%s: Will write the momentum-space loop data in HDF5 format\n", __func__);
     else{
@@ -0,0 +1,57 @@
+#include <loop_session.h>
+#include <host_field_mugiq.h>
+
+
+void LoopSessionStats::print(const char *label) const {
+  printfQuda("%s: Session statistics over %d configurations (sec):\n", label, nConfig);
+  printfQuda("  setup = %e , load gauge = %e , compute = %e , write = %e , teardown = %e\n",
+	     setup, loadGauge, compute, write, teardown);
+  if(nConfig > 0)
+    printfQuda("  per configuration: load gauge = %e , compute = %e , write = %e\n",
+	       loadGauge/nConfig, compute/nConfig, write/nConfig);
+}
+
+
+LoopSession::LoopSession(LoopSessionBackend *backend_) :
+  backend(backend_)
+{
+  if(!backend) errorQuda("%s: Got a null backend\n", __func__);
+
+  double t0 = hostTimer();
+  backend->setup();
+  stats.setup = hostTimer() - t0;
+
+  printfQuda("%s: Loop session with the %s backend created\n", __func__, backend->name());
+}
+
+
+LoopSession::~LoopSession(){
+
+  double t0 = hostTimer();
+  backend->teardown();
+  stats.teardown = hostTimer() - t0;
+
+  stats.print(backend->name());
+
+  delete backend;
+  backend = nullptr;
+}
+
+
+void LoopSession::processConfig(void *gauge[], const std::string &fnameMom, const std::string &fnamePos){
+
+  printfQuda("\n%s: Processing configuration %d\n", __func__, stats.nConfig);
+
+  double t0 = hostTimer();
+  backend->loadGauge(gauge);
+  double t1 = hostTimer();
+  backend->computeLoop();
+  double t2 = hostTimer();
+  backend->writeLoop(fnameMom, fnamePos);
+  double t3 = hostTimer();
+
+  stats.loadGauge += t1 - t0;
+  stats.compute   += t2 - t1;
+  stats.write     += t3 - t2;
+  stats.nConfig++;
+}
@@ -0,0 +1,480 @@
+/*
+ * PMPI interposition layer, see mpi_profile_mugiq.h
+ * The wrappers live in the same translation unit as the stage functions, so that linking against the static
+ * libmugiq pulls them in whenever the stages are used.
+ */
+
+#include <mpi_profile_mugiq.h>
+
+#ifdef MUGIQ_MPI_PROFILE
+
+#include <mpi.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if MPI_VERSION >= 3
+#define MUGIQ_MPI_CONST const
+#else
+#define MUGIQ_MPI_CONST
+#endif
+
+namespace {
+
+  enum MPIFunc {
+    F_SEND, F_RECV, F_ISEND, F_IRECV, F_SENDRECV, F_SEND_INIT, F_RECV_INIT, F_START, F_STARTALL,
+    F_WAIT, F_WAITALL, F_WAITANY, F_TEST, F_TESTALL,
+    F_BARRIER, F_BCAST, F_REDUCE, F_ALLREDUCE, F_GATHER, F_GATHERV, F_ALLGATHER, F_SCATTER, F_ALLTOALL,
+    F_COMM_SPLIT, F_COMM_DUP, F_COMM_FREE,
+    F_FILE_OPEN, F_FILE_CLOSE, F_FILE_SET_VIEW, F_FILE_WRITE_AT, F_FILE_WRITE_AT_ALL, F_FILE_WRITE_ALL,
+    F_FILE_READ_AT, F_FILE_READ_AT_ALL,
+    N_MPI_FUNC
+  };
+
+  const char *funcName[N_MPI_FUNC] = {
+    "MPI_Send", "MPI_Recv", "MPI_Isend", "MPI_Irecv", "MPI_Sendrecv", "MPI_Send_init", "MPI_Recv_init", "MPI_Start", "MPI_Startall",
+    "MPI_Wait", "MPI_Waitall", "MPI_Waitany", "MPI_Test", "MPI_Testall",
+    "MPI_Barrier", "MPI_Bcast", "MPI_Reduce", "MPI_Allreduce", "MPI_Gather", "MPI_Gatherv", "MPI_Allgather", "MPI_Scatter", "MPI_Alltoall",
+    "MPI_Comm_split", "MPI_Comm_dup", "MPI_Comm_free",
+    "MPI_File_open", "MPI_File_close", "MPI_File_set_view", "MPI_File_write_at", "MPI_File_write_at_all", "MPI_File_write_all",
+    "MPI_File_read_at", "MPI_File_read_at_all"
+  };
+
+  const char *stageName[] = {"other", "setup", "displace_halo", "mom_reduce", "gather", "hdf5_io"};
+  static_assert(sizeof(stageName)/sizeof(stageName[0]) == N_MUGIQ_STAGES_, "One name is needed for each MuGiqCommStage");
+
+  //- Counters of one rank, laid out contiguously so that they can be reduced in one go
+  struct Counters {
+    double time[N_MUGIQ_STAGES_][N_MPI_FUNC];
+    double calls[N_MUGIQ_STAGES_][N_MPI_FUNC];
+    double bytesSent[N_MUGIQ_STAGES_][N_MPI_FUNC];
+    double bytesRecv[N_MUGIQ_STAGES_][N_MPI_FUNC];
+    double wall[N_MUGIQ_STAGES_];   //- wall-clock time spent in each stage, exclusive of nested stages
+  };
+
+  Counters cnt = {};
+
+  //- Stack of active stages and the time the top one became active
+  std::vector<int> stageStack;
+  double stageStart = 0.0;
+
+  thread_local int depth = 0;  //- > 0 while inside a wrapper, nested MPI calls are not counted twice
+  bool reportDone = false;
+
+  //- Guards the counters, the stage stack and the persistent-request maps, which are shared by all the threads
+  std::mutex profMutex;
+
+  std::map<MPI_Request, long long> persistentSendBytes;
+  std::map<MPI_Request, long long> persistentRecvBytes;
+
+  inline double wallTime(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  //- The functions below expect profMutex to be held by the caller
+  inline int activeStage(){
+    return stageStack.empty() ? static_cast<int>(MUGIQ_STAGE_OTHER) : stageStack.back();
+  }
+
+  inline void chargeActiveStage(){
+    const double now = wallTime();
+    if(stageStart > 0.0) cnt.wall[activeStage()] += now - stageStart;
+    stageStart = now;
+  }
+
+  inline long long typeBytes(int count, MPI_Datatype dt){
+    int sz = 0;
+    PMPI_Type_size(dt, &sz);
+    return static_cast<long long>(count) * sz;
+  }
+
+  //- Times one MPI call and charges it to the active stage
+  class CallTimer {
+    const int func;
+    const long long sent;
+    const long long recv;
+    const bool outer;
+    const double t0;
+  public:
+    CallTimer(int func_, long long sent_=0, long long recv_=0) :
+      func(func_), sent(sent_), recv(recv_), outer(depth == 0), t0(wallTime()) { depth++; }
+    ~CallTimer(){
+      depth--;
+      if(!outer) return;
+      const double dt = wallTime() - t0;
+      std::lock_guard<std::mutex> lock(profMutex);
+      const int s = activeStage();
+      cnt.time[s][func] += dt;
+      cnt.calls[s][func] += 1;
+      cnt.bytesSent[s][func] += sent;
+      cnt.bytesRecv[s][func] += recv;
+    }
+  };
+
+  void writeStat(FILE *f, const char *name, double mn, double sum, double mx, int nRanks, bool last){
+    const double avg = sum / nRanks;
+    fprintf(f, "\"%s\": {\"min\": %.6e, \"avg\": %.6e, \"max\": %.6e, \"imbalance\": %.4f}%s",
+	    name, mn, avg, mx, avg > 0 ? mx/avg : 1.0, last ? "" : ", ");
+  }
+
+} // namespace
+
+
+void mpiProfilePushStage(MuGiqCommStage stage){
+  std::lock_guard<std::mutex> lock(profMutex);
+  chargeActiveStage();
+  stageStack.push_back(static_cast<int>(stage));
+}
+
+
+void mpiProfilePopStage(){
+  std::lock_guard<std::mutex> lock(profMutex);
+  chargeActiveStage();
+  if(!stageStack.empty()) stageStack.pop_back();
+}
+
+
+void mpiProfileReport(const char *fname){
+
+  int initialized = 0, finalized = 0;
+  PMPI_Initialized(&initialized);
+  PMPI_Finalized(&finalized);
+  if(!initialized || finalized) return;
+
+  //- Snapshot of the counters, the reductions below are not done under the lock
+  Counters loc;
+  {
+    std::lock_guard<std::mutex> lock(profMutex);
+    chargeActiveStage();
+    loc = cnt;
+  }
+
+  int rank = 0, nRanks = 1;
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  PMPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  const int len = sizeof(Counters) / sizeof(double);
+  Counters cMin, cMax, cSum;
+  depth++;
+  PMPI_Reduce(&loc, &cMin, len, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+  PMPI_Reduce(&loc, &cMax, len, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  PMPI_Reduce(&loc, &cSum, len, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  //- MPI time per stage and rank
+  double mpiLoc[N_MUGIQ_STAGES_], mpiMin[N_MUGIQ_STAGES_], mpiMax[N_MUGIQ_STAGES_], mpiSum[N_MUGIQ_STAGES_];
+  for(int s=0;s<N_MUGIQ_STAGES_;s++){
+    mpiLoc[s] = 0.0;
+    for(int fn=0;fn<N_MPI_FUNC;fn++) mpiLoc[s] += loc.time[s][fn];
+  }
+  PMPI_Reduce(mpiLoc, mpiMin, N_MUGIQ_STAGES_, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+  PMPI_Reduce(mpiLoc, mpiMax, N_MUGIQ_STAGES_, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  PMPI_Reduce(mpiLoc, mpiSum, N_MUGIQ_STAGES_, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  depth--;
+
+  reportDone = true;
+  if(rank != 0) return;
+
+  FILE *f = fopen(fname, "w");
+  if(f == NULL){
+    fprintf(stderr, "%s: Cannot open %s for writing the MPI profile\n", __func__, fname);
+    return;
+  }
+
+  fprintf(f, "{\n  \"nRanks\": %d,\n  \"stages\": [\n", nRanks);
+  for(int s=0;s<N_MUGIQ_STAGES_;s++){
+    fprintf(f, "    {\"stage\": \"%s\", ", stageName[s]);
+    writeStat(f, "wall", cMin.wall[s], cSum.wall[s], cMax.wall[s], nRanks, false);
+    writeStat(f, "mpi_time", mpiMin[s], mpiSum[s], mpiMax[s], nRanks, false);
+    fprintf(f, "\"mpi_fraction\": %.4f,\n     \"functions\": [", cSum.wall[s] > 0 ? mpiSum[s]/cSum.wall[s] : 0.0);
+    bool first = true;
+    for(int fn=0;fn<N_MPI_FUNC;fn++){
+      if(cMax.calls[s][fn] == 0) continue;
+      fprintf(f, "%s\n       {\"name\": \"%s\", ", first ? "" : ",", funcName[fn]);
+      writeStat(f, "time", cMin.time[s][fn], cSum.time[s][fn], cMax.time[s][fn], nRanks, false);
+      writeStat(f, "calls", cMin.calls[s][fn], cSum.calls[s][fn], cMax.calls[s][fn], nRanks, false);
+      writeStat(f, "bytes_sent", cMin.bytesSent[s][fn], cSum.bytesSent[s][fn], cMax.bytesSent[s][fn], nRanks, false);
+      writeStat(f, "bytes_recv", cMin.bytesRecv[s][fn], cSum.bytesRecv[s][fn], cMax.bytesRecv[s][fn], nRanks, true);
+      fprintf(f, "}");
+      first = false;
+    }
+    fprintf(f, "]}%s\n", s < N_MUGIQ_STAGES_-1 ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+
+  printf("%s: MPI profile written to %s\n", __func__, fname);
+}
+//---------------------------------------------------------------------------
+
+
+//- Initialization/Finalization
+
+int MPI_Init(int *argc, char ***argv){
+  stageStart = wallTime();
+  return PMPI_Init(argc, argv);
+}
+
+int MPI_Init_thread(int *argc, char ***argv, int required, int *provided){
+  stageStart = wallTime();
+  return PMPI_Init_thread(argc, argv, required, provided);
+}
+
+int MPI_Finalize(){
+  if(!reportDone){
+    const char *fname = getenv("MUGIQ_MPI_PROFILE_FILE");
+    mpiProfileReport(fname ? fname : "mugiq_mpi_profile.json");
+  }
+  return PMPI_Finalize();
+}
+
+
+//- Point-to-point
+
+int MPI_Send(MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, int dest, int tag, MPI_Comm comm){
+  CallTimer t(F_SEND, typeBytes(count, dt));
+  return PMPI_Send(buf, count, dt, dest, tag, comm);
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype dt, int src, int tag, MPI_Comm comm, MPI_Status *status){
+  CallTimer t(F_RECV, 0, typeBytes(count, dt));
+  return PMPI_Recv(buf, count, dt, src, tag, comm, status);
+}
+
+int MPI_Isend(MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, int dest, int tag, MPI_Comm comm, MPI_Request *req){
+  CallTimer t(F_ISEND, typeBytes(count, dt));
+  return PMPI_Isend(buf, count, dt, dest, tag, comm, req);
+}
+
+int MPI_Irecv(void *buf, int count, MPI_Datatype dt, int src, int tag, MPI_Comm comm, MPI_Request *req){
+  CallTimer t(F_IRECV, 0, typeBytes(count, dt));
+  return PMPI_Irecv(buf, count, dt, src, tag, comm, req);
+}
+
+int MPI_Sendrecv(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt, int dest, int stag,
+		 void *rbuf, int rcount, MPI_Datatype rdt, int src, int rtag, MPI_Comm comm, MPI_Status *status){
+  CallTimer t(F_SENDRECV, typeBytes(scount, sdt), typeBytes(rcount, rdt));
+  return PMPI_Sendrecv(sbuf, scount, sdt, dest, stag, rbuf, rcount, rdt, src, rtag, comm, status);
+}
+
+//- Persistent requests (used by QUDA), the bytes are charged when the request is started
+int MPI_Send_init(MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, int dest, int tag, MPI_Comm comm, MPI_Request *req){
+  CallTimer t(F_SEND_INIT);
+  int ret = PMPI_Send_init(buf, count, dt, dest, tag, comm, req);
+  const long long bytes = typeBytes(count, dt);
+  std::lock_guard<std::mutex> lock(profMutex);
+  persistentSendBytes[*req] = bytes;
+  return ret;
+}
+
+int MPI_Recv_init(void *buf, int count, MPI_Datatype dt, int src, int tag, MPI_Comm comm, MPI_Request *req){
+  CallTimer t(F_RECV_INIT);
+  int ret = PMPI_Recv_init(buf, count, dt, src, tag, comm, req);
+  const long long bytes = typeBytes(count, dt);
+  std::lock_guard<std::mutex> lock(profMutex);
+  persistentRecvBytes[*req] = bytes;
+  return ret;
+}
+
+int MPI_Start(MPI_Request *req){
+  long long sent = 0, recv = 0;
+  {
+    std::lock_guard<std::mutex> lock(profMutex);
+    auto s = persistentSendBytes.find(*req);
+    auto r = persistentRecvBytes.find(*req);
+    if(s != persistentSendBytes.end()) sent = s->second;
+    if(r != persistentRecvBytes.end()) recv = r->second;
+  }
+  CallTimer t(F_START, sent, recv);
+  return PMPI_Start(req);
+}
+
+int MPI_Startall(int n, MPI_Request req[]){
+  long long sent = 0, recv = 0;
+  {
+    std::lock_guard<std::mutex> lock(profMutex);
+    for(int i=0;i<n;i++){
+      auto s = persistentSendBytes.find(req[i]);
+      auto r = persistentRecvBytes.find(req[i]);
+      if(s != persistentSendBytes.end()) sent += s->second;
+      if(r != persistentRecvBytes.end()) recv += r->second;
+    }
+  }
+  CallTimer t(F_STARTALL, sent, recv);
+  return PMPI_Startall(n, req);
+}
+
+int MPI_Request_free(MPI_Request *req){
+  {
+    std::lock_guard<std::mutex> lock(profMutex);
+    persistentSendBytes.erase(*req);
+    persistentRecvBytes.erase(*req);
+  }
+  return PMPI_Request_free(req);
+}
+
+int MPI_Wait(MPI_Request *req, MPI_Status *status){
+  CallTimer t(F_WAIT);
+  return PMPI_Wait(req, status);
+}
+
+int MPI_Waitall(int n, MPI_Request req[], MPI_Status status[]){
+  CallTimer t(F_WAITALL);
+  return PMPI_Waitall(n, req, status);
+}
+
+int MPI_Waitany(int n, MPI_Request req[], int *idx, MPI_Status *status){
+  CallTimer t(F_WAITANY);
+  return PMPI_Waitany(n, req, idx, status);
+}
+
+int MPI_Test(MPI_Request *req, int *flag, MPI_Status *status){
+  CallTimer t(F_TEST);
+  return PMPI_Test(req, flag, status);
+}
+
+int MPI_Testall(int n, MPI_Request req[], int *flag, MPI_Status status[]){
+  CallTimer t(F_TESTALL);
+  return PMPI_Testall(n, req, flag, status);
+}
+
+
+//- Collectives, the bytes are those contributed (sent) and received by this rank
+
+int MPI_Barrier(MPI_Comm comm){
+  CallTimer t(F_BARRIER);
+  return PMPI_Barrier(comm);
+}
+
+int MPI_Bcast(void *buf, int count, MPI_Datatype dt, int root, MPI_Comm comm){
+  int rank;
+  PMPI_Comm_rank(comm, &rank);
+  const long long b = typeBytes(count, dt);
+  CallTimer t(F_BCAST, rank == root ? b : 0, rank == root ? 0 : b);
+  return PMPI_Bcast(buf, count, dt, root, comm);
+}
+
+int MPI_Reduce(MUGIQ_MPI_CONST void *sbuf, void *rbuf, int count, MPI_Datatype dt, MPI_Op op, int root, MPI_Comm comm){
+  int rank;
+  PMPI_Comm_rank(comm, &rank);
+  const long long b = typeBytes(count, dt);
+  CallTimer t(F_REDUCE, b, rank == root ? b : 0);
+  return PMPI_Reduce(sbuf, rbuf, count, dt, op, root, comm);
+}
+
+int MPI_Allreduce(MUGIQ_MPI_CONST void *sbuf, void *rbuf, int count, MPI_Datatype dt, MPI_Op op, MPI_Comm comm){
+  const long long b = typeBytes(count, dt);
+  CallTimer t(F_ALLREDUCE, b, b);
+  return PMPI_Allreduce(sbuf, rbuf, count, dt, op, comm);
+}
+
+int MPI_Gather(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt,
+	       void *rbuf, int rcount, MPI_Datatype rdt, int root, MPI_Comm comm){
+  int rank, size;
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &size);
+  CallTimer t(F_GATHER, typeBytes(scount, sdt), rank == root ? size * typeBytes(rcount, rdt) : 0);
+  return PMPI_Gather(sbuf, scount, sdt, rbuf, rcount, rdt, root, comm);
+}
+
+int MPI_Gatherv(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt,
+		void *rbuf, MUGIQ_MPI_CONST int rcounts[], MUGIQ_MPI_CONST int displs[], MPI_Datatype rdt, int root, MPI_Comm comm){
+  int rank, size;
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &size);
+  long long recv = 0;
+  if(rank == root) for(int i=0;i<size;i++) recv += typeBytes(rcounts[i], rdt);
+  CallTimer t(F_GATHERV, typeBytes(scount, sdt), recv);
+  return PMPI_Gatherv(sbuf, scount, sdt, rbuf, rcounts, displs, rdt, root, comm);
+}
+
+int MPI_Allgather(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt,
+		  void *rbuf, int rcount, MPI_Datatype rdt, MPI_Comm comm){
+  int size;
+  PMPI_Comm_size(comm, &size);
+  CallTimer t(F_ALLGATHER, typeBytes(scount, sdt), size * typeBytes(rcount, rdt));
+  return PMPI_Allgather(sbuf, scount, sdt, rbuf, rcount, rdt, comm);
+}
+
+int MPI_Scatter(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt,
+		void *rbuf, int rcount, MPI_Datatype rdt, int root, MPI_Comm comm){
+  int rank, size;
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &size);
+  CallTimer t(F_SCATTER, rank == root ? size * typeBytes(scount, sdt) : 0, typeBytes(rcount, rdt));
+  return PMPI_Scatter(sbuf, scount, sdt, rbuf, rcount, rdt, root, comm);
+}
+
+int MPI_Alltoall(MUGIQ_MPI_CONST void *sbuf, int scount, MPI_Datatype sdt,
+		 void *rbuf, int rcount, MPI_Datatype rdt, MPI_Comm comm){
+  int size;
+  PMPI_Comm_size(comm, &size);
+  CallTimer t(F_ALLTOALL, size * typeBytes(scount, sdt), size * typeBytes(rcount, rdt));
+  return PMPI_Alltoall(sbuf, scount, sdt, rbuf, rcount, rdt, comm);
+}
+
+
+//- Communicators
+
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm){
+  CallTimer t(F_COMM_SPLIT);
+  return PMPI_Comm_split(comm, color, key, newcomm);
+}
+
+int MPI_Comm_dup(MPI_Comm comm, MPI_Comm *newcomm){
+  CallTimer t(F_COMM_DUP);
+  return PMPI_Comm_dup(comm, newcomm);
+}
+
+int MPI_Comm_free(MPI_Comm *comm){
+  CallTimer t(F_COMM_FREE);
+  return PMPI_Comm_free(comm);
+}
+
+
+//- MPI-IO, used by the parallel HDF5 library
+
+int MPI_File_open(MPI_Comm comm, MUGIQ_MPI_CONST char *filename, int amode, MPI_Info info, MPI_File *fh){
+  CallTimer t(F_FILE_OPEN);
+  return PMPI_File_open(comm, filename, amode, info, fh);
+}
+
+int MPI_File_close(MPI_File *fh){
+  CallTimer t(F_FILE_CLOSE);
+  return PMPI_File_close(fh);
+}
+
+int MPI_File_set_view(MPI_File fh, MPI_Offset disp, MPI_Datatype etype, MPI_Datatype filetype,
+		      MUGIQ_MPI_CONST char *datarep, MPI_Info info){
+  CallTimer t(F_FILE_SET_VIEW);
+  return PMPI_File_set_view(fh, disp, etype, filetype, datarep, info);
+}
+
+int MPI_File_write_at(MPI_File fh, MPI_Offset offset, MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, MPI_Status *status){
+  CallTimer t(F_FILE_WRITE_AT, typeBytes(count, dt));
+  return PMPI_File_write_at(fh, offset, buf, count, dt, status);
+}
+
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, MPI_Status *status){
+  CallTimer t(F_FILE_WRITE_AT_ALL, typeBytes(count, dt));
+  return PMPI_File_write_at_all(fh, offset, buf, count, dt, status);
+}
+
+int MPI_File_write_all(MPI_File fh, MUGIQ_MPI_CONST void *buf, int count, MPI_Datatype dt, MPI_Status *status){
+  CallTimer t(F_FILE_WRITE_ALL, typeBytes(count, dt));
+  return PMPI_File_write_all(fh, buf, count, dt, status);
+}
+
+int MPI_File_read_at(MPI_File fh, MPI_Offset offset, void *buf, int count, MPI_Datatype dt, MPI_Status *status){
+  CallTimer t(F_FILE_READ_AT, 0, typeBytes(count, dt));
+  return PMPI_File_read_at(fh, offset, buf, count, dt, status);
+}
+
+int MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void *buf, int count, MPI_Datatype dt, MPI_Status *status){
+  CallTimer t(F_FILE_READ_AT_ALL, 0, typeBytes(count, dt));
+  return PMPI_File_read_at_all(fh, offset, buf, count, dt, status);
+}
+
+#endif // MUGIQ_MPI_PROFILE
@@ -5,8 +5,8 @@ inline static __device__ int evenORodd(const int x[]){
   return (x[0] + x[1] + x[2] + x[3]) % 2;
 }
 
-template <typename Float>
-inline static __device__ Link<Float> getNbrLink(Gauge<Float> &U, const int coord[], int pty,
+template <typename Float, typename G>
+inline static __device__ Link<Float> getNbrLink(G &U, const int coord[], int pty,
 						int dir, DisplaceSign dispSign,
 						const int dim[], const int commDim[], const int nFace){
 
@@ -36,8 +36,8 @@ inline static __device__ Link<Float> getNbrLink(Gauge<Float> &U, const int coord
 //-------------------------------------------------------------------
 
 
-template <typename Float>
-inline static __device__ Link<Float> getNbrLinkDispExtG(Gauge<Float> &U, const int coord[], int pty,
+template <typename Float, typename G>
+inline static __device__ Link<Float> getNbrLinkDispExtG(G &U, const int coord[], int pty,
 							const int dx[],
 							int dir, DisplaceSign dispSign,
 							const int dimEx[], const int brd[]){
@@ -65,8 +65,8 @@ inline static __device__ Link<Float> getNbrLinkDispExtG(Gauge<Float> &U, const i
   return dispU;
 }
 
-template <typename Float>
-inline static __device__ Link<Float> getNbrLinkExtG(Gauge<Float> &U, const int coord[], int pty,
+template <typename Float, typename G>
+inline static __device__ Link<Float> getNbrLinkExtG(G &U, const int coord[], int pty,
 						    int dir, DisplaceSign dispSign,
 						    const int dimEx[], const int brd[]){
   int dx[5] = {0,0,0,0,0};
@@ -153,9 +153,39 @@ inline static __device__ Vector<Float> getNbrSiteVec(Fermion<Float,order> &F, co
 //-------------------------------------------------------------------
 
 
+//- Whether the neighbour of site coord in the displacement direction lives in another process
+inline static __device__ bool isBoundarySite(const int coord[], const int dir, DisplaceSign dispSign,
+					     const int dim[], const int commDim[]){
+  if(!commDim[dir]) return false;
+  return (dispSign == DispSignPlus) ? (coord[dir] == dim[dir]-1) : (coord[dir] == 0);
+}
+//-------------------------------------------------------------------
+
+
 template <typename Float, typename Arg, QudaFieldOrder order>
-__global__ void covariantDisplacementVector_kernel(Arg *arg,
-						   DisplaceDir dispDir, DisplaceSign dispSign){
+inline static __device__ void covariantDisplaceSite(Arg *arg, const int coord[], const int x_cb, const int pty,
+						    const int dir, DisplaceSign dispSign){
+
+  //- The neighbouring vector of site x, V(x+d) or V(x-d)
+  Vector<Float> nbrV = getNbrSiteVec<Float,order>(arg->src, coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
+
+  Link<Float> nbrU; //- Neighbouring Link, U_d(x) or U_d^\dag(x-d)
+  if(arg->extendedGauge)
+    nbrU = getNbrLinkExtG<Float>(arg->U, coord, pty, dir, dispSign, arg->dimEx, arg->brd);
+  else
+    nbrU = getNbrLink<Float>(arg->U, coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
+
+  Vector<Float> R = nbrU * nbrV; // R(x) = U_d(x) * V(x+d) || U_d^\dag(x-d) * V(x-d)
+
+  FillFermionSite(arg->dst, R, x_cb, pty);
+}
+//-------------------------------------------------------------------
+
+
+//- Interior sites: all sites whose neighbour is local, does not read the ghosts of src
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorInterior_kernel(Arg *arg,
+							   DisplaceDir dispDir, DisplaceSign dispSign){
 
   int x_cb = blockIdx.x*blockDim.x + threadIdx.x;
   int pty  = blockIdx.y*blockDim.y + threadIdx.y;
@@ -170,8 +200,43 @@ __global__ void covariantDisplacementVector_kernel(Arg *arg,
 
   const int dir = (int)dispDir; //- Direction of the displacement (0:x, 1:y, 2:z, 3:t)
 
-  //- The neighbouring vector of site x, V(x+d) or V(x-d)
-  Vector<Float> nbrV = getNbrSiteVec<Float,order>(arg->src, coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
+  if(isBoundarySite(coord, dir, dispSign, arg->dim, arg->commDim)) return;
+
+  covariantDisplaceSite<Float,Arg,order>(arg, coord, x_cb, pty, dir, dispSign);
+}
+
+
+//- Boundary sites: the face perpendicular to the displacement direction, one thread per face site
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBoundary_kernel(Arg *arg,
+							   DisplaceDir dispDir, DisplaceSign dispSign){
+
+  const int dir = (int)dispDir; //- Direction of the displacement (0:x, 1:y, 2:z, 3:t)
+
+  int fIdx = blockIdx.x*blockDim.x + threadIdx.x;
+  if (fIdx >= arg->volume / arg->dim[dir]) return;
+
+  //- Lexicographic face index -> local coordinates
+  int coord[5];
+#pragma unroll
+  for(int d=0;d<N_DIM_;d++){
+    if(d == dir) continue;
+    coord[d] = fIdx % arg->dim[d];
+    fIdx /= arg->dim[d];
+  }
+  coord[dir] = (dispSign == DispSignPlus) ? arg->dim[dir]-1 : 0;
+  coord[4] = 0;
+
+  const int pty  = (coord[0] + coord[1] + coord[2] + coord[3]) & 1;
+  const int x_cb = linkIndex(coord, arg->dim);
+
+  covariantDisplaceSite<Float,Arg,order>(arg, coord, x_cb, pty, dir, dispSign);
+}
+
+//- Batched displacement of one site: the link is loaded once and applied to all the vectors of the batch
+template <typename Float, typename Arg, QudaFieldOrder order>
+inline static __device__ void covariantDisplaceSiteBatch(Arg *arg, const int coord[], const int x_cb, const int pty,
+							 const int dir, DisplaceSign dispSign){
 
   Link<Float> nbrU; //- Neighbouring Link, U_d(x) or U_d^\dag(x-d)
   if(arg->extendedGauge)
@@ -179,20 +244,290 @@ __global__ void covariantDisplacementVector_kernel(Arg *arg,
   else
     nbrU = getNbrLink<Float>(arg->U, coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
 
-  Vector<Float> R = nbrU * nbrV; // R(x) = U_d(x) * V(x+d) || U_d^\dag(x-d) * V(x-d)
+  for(int i=0;i<arg->nVec;i++){
+    Vector<Float> nbrV = getNbrSiteVec<Float,order>(arg->src(i), coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
+    Vector<Float> R = nbrU * nbrV;
+    FillFermionSite(arg->dst(i), R, x_cb, pty);
+  }
+}
+//-------------------------------------------------------------------
 
-  FillFermionSite(arg->dst, R, x_cb, pty);
+
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchInterior_kernel(Arg *arg,
+								DisplaceDir dispDir, DisplaceSign dispSign){
+
+  int x_cb = blockIdx.x*blockDim.x + threadIdx.x;
+  int pty  = blockIdx.y*blockDim.y + threadIdx.y;
+  pty = (arg->nParity == 2) ? pty : arg->parity;
+  if (x_cb >= arg->volumeCB) return;
+  if (pty >= arg->nParity) return;
+
+  int coord[5];
+  getCoords(coord, x_cb, arg->dim, pty);
+  coord[4] = 0;
+
+  const int dir = (int)dispDir;
+
+  if(isBoundarySite(coord, dir, dispSign, arg->dim, arg->commDim)) return;
+
+  covariantDisplaceSiteBatch<Float,Arg,order>(arg, coord, x_cb, pty, dir, dispSign);
+}
+
+
+//- Lexicographic index of a site on the face perpendicular to dir -> local coordinates, on slice coord[dir] = slice
+inline static __device__ void faceSiteCoords(int coord[], int fIdx, const int dir, const int slice, const int dim[]){
+#pragma unroll
+  for(int d=0;d<N_DIM_;d++){
+    if(d == dir) continue;
+    coord[d] = fIdx % dim[d];
+    fIdx /= dim[d];
+  }
+  coord[dir] = slice;
+  coord[4] = 0;
+}
+//-------------------------------------------------------------------
+
+
+//- Boundary sites of the batch: the neighbouring vectors come from the packed faces received in one message,
+//- at the same face index as the site, as the neighbour packed its face with faceSiteCoords as well
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchBoundary_kernel(Arg *arg,
+								DisplaceDir dispDir, DisplaceSign dispSign){
+
+  const int dir = (int)dispDir;
+
+  const int fIdx = blockIdx.x*blockDim.x + threadIdx.x;
+  if (fIdx >= arg->faceVolume) return;
+
+  int coord[5];
+  faceSiteCoords(coord, fIdx, dir, (dispSign == DispSignPlus) ? arg->dim[dir]-1 : 0, arg->dim);
+
+  const int pty  = (coord[0] + coord[1] + coord[2] + coord[3]) & 1;
+  const int x_cb = linkIndex(coord, arg->dim);
+
+  Link<Float> nbrU; //- Neighbouring Link, U_d(x) or U_d^\dag(x-d)
+  if(arg->extendedGauge)
+    nbrU = getNbrLinkExtG<Float>(arg->U, coord, pty, dir, dispSign, arg->dimEx, arg->brd);
+  else
+    nbrU = getNbrLink<Float>(arg->U, coord, pty, dir, dispSign, arg->dim, arg->commDim, arg->nFace);
+
+  for(int i=0;i<arg->nVec;i++){
+    const complex<Float> *g = arg->ghostRecv + (static_cast<long long>(i)*arg->faceVolume + fIdx) * N_SPIN_*N_COLOR_;
+    Vector<Float> nbrV;
+#pragma unroll
+    for(int j=0;j<N_SPIN_*N_COLOR_;j++) nbrV.data[j] = g[j];
+    Vector<Float> R = nbrU * nbrV;
+    FillFermionSite(arg->dst(i), R, x_cb, pty);
+  }
+}
+
+
+//- Pack the face of all the vectors of the batch that the neighbour needs: the first slice for positive displacements
+//- (it goes to the backward neighbour), the last slice for negative ones (it goes to the forward neighbour)
+template <typename Float, typename Arg, QudaFieldOrder order>
+__global__ void covariantDisplacementVectorBatchPack_kernel(Arg *arg,
+							    DisplaceDir dispDir, DisplaceSign dispSign){
+
+  const int dir = (int)dispDir;
+
+  const int fIdx = blockIdx.x*blockDim.x + threadIdx.x;
+  if (fIdx >= arg->faceVolume) return;
+
+  int coord[5];
+  faceSiteCoords(coord, fIdx, dir, (dispSign == DispSignPlus) ? 0 : arg->dim[dir]-1, arg->dim);
+
+  const int pty  = (coord[0] + coord[1] + coord[2] + coord[3]) & 1;
+  const int x_cb = linkIndex(coord, arg->dim);
+
+  for(int i=0;i<arg->nVec;i++){
+    const Vector<Float> v = getVectorSite<Float,order>(arg->src(i), x_cb, pty);
+    complex<Float> *g = arg->ghostSend + (static_cast<long long>(i)*arg->faceVolume + fIdx) * N_SPIN_*N_COLOR_;
+#pragma unroll
+    for(int j=0;j<N_SPIN_*N_COLOR_;j++) g[j] = v.data[j];
+  }
 }
 
-template __global__ void covariantDisplacementVector_kernel<float,CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER>,
-							    QUDA_FLOAT2_FIELD_ORDER>
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER>,
+								    QUDA_FLOAT2_FIELD_ORDER>
 (CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
-template __global__ void covariantDisplacementVector_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER>,
-							    QUDA_FLOAT4_FIELD_ORDER>
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER>,
+								    QUDA_FLOAT4_FIELD_ORDER>
 (CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
-template __global__ void covariantDisplacementVector_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER>,
-							    QUDA_FLOAT2_FIELD_ORDER>
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER>,
+								    QUDA_FLOAT2_FIELD_ORDER>
 (CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
-template __global__ void covariantDisplacementVector_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER>,
-							    QUDA_FLOAT4_FIELD_ORDER>
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER>,
+								    QUDA_FLOAT4_FIELD_ORDER>
 (CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+
+//- Compressed links, reconstruct-12 and reconstruct-8
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<float, CovDispVecArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorInterior_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBoundary_kernel<double, CovDispVecArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+								    QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_12>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_12> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<float, CovDispVecBatchArg<float,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<float, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT2_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT2_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT2_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchInterior_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchBoundary_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
+template __global__ void covariantDisplacementVectorBatchPack_kernel<double, CovDispVecBatchArg<double,QUDA_FLOAT4_FIELD_ORDER,QUDA_RECONSTRUCT_8>,
+									 QUDA_FLOAT4_FIELD_ORDER>
+(CovDispVecBatchArg<double, QUDA_FLOAT4_FIELD_ORDER, QUDA_RECONSTRUCT_8> *arg, DisplaceDir dispDir, DisplaceSign dispSign);
@@ -0,0 +1,286 @@
+#include <prolong_host.h>
+
+
+template <typename Float>
+HostProlongator<Float>::HostProlongator(const HostGeom &geom_, int nLevel_, const int geoBlock_[][N_DIM_],
+					const int spinBlock_[], const int nVec_[]) :
+  fineGeom(geom_),
+  nLevel(nLevel_)
+{
+  if(nLevel < 1) errorQuda("%s: At least one prolongation level is needed, got %d\n", __func__, nLevel);
+
+  nSpin.push_back(N_SPIN_);
+  nColor.push_back(N_COLOR_);
+  for(int lev=0;lev<nLevel;lev++){
+    const HostGeom &g = Geom(lev);
+    int lLc[N_DIM_];
+    for(int d=0;d<N_DIM_;d++){
+      geoBlock.push_back(geoBlock_[lev][d]);
+      if(geoBlock_[lev][d] < 1 || g.lL[d] % geoBlock_[lev][d] != 0)
+	errorQuda("%s: Geometric block %d of level %d does not divide the local lattice extent L[%d] = %d\n",
+		  __func__, geoBlock_[lev][d], lev, d, g.lL[d]);
+      lLc[d] = g.lL[d] / geoBlock_[lev][d];
+    }
+    if(spinBlock_[lev] < 1 || nSpin[lev] % spinBlock_[lev] != 0)
+      errorQuda("%s: Spin block %d of level %d does not divide %d spins\n", __func__, spinBlock_[lev], lev, nSpin[lev]);
+    spinBlock.push_back(spinBlock_[lev]);
+    nVec.push_back(nVec_[lev]);
+    nSpin.push_back(nSpin[lev] / spinBlock_[lev]);
+    nColor.push_back(nVec_[lev]);
+
+    coarseGeom.push_back(new HostGeom(lLc, g.commDim, g.commCoord, g.nbrRank, g.comm));
+    const HostGeom &gc = *coarseGeom.back();
+
+    //- The block of each fine site is fixed by the geometry, so the coarse index is tabulated once
+    coarseIdx.push_back(std::vector<int>(g.volume));
+    std::vector<int> &cIdx = coarseIdx.back();
+#pragma omp parallel for
+    for(int i=0;i<g.volume;i++){
+      int x[N_DIM_], xc[N_DIM_];
+      const int pty = i / g.volumeCB;
+      g.getCoords(x, i - pty*g.volumeCB, pty);
+      for(int d=0;d<N_DIM_;d++) xc[d] = x[d] / geoBlock_[lev][d];
+      cIdx[i] = gc.siteIndex(xc);
+    }
+
+    //- The inverse map, fine sites of each block in increasing order
+    blockOffset.push_back(std::vector<int>(gc.volume + 1, 0));
+    blockSites.push_back(std::vector<int>(g.volume));
+    std::vector<int> &bOff = blockOffset.back();
+    std::vector<int> &bSite = blockSites.back();
+    for(int i=0;i<g.volume;i++) bOff[cIdx[i]+1]++;
+    for(int ic=0;ic<gc.volume;ic++) bOff[ic+1] += bOff[ic];
+    std::vector<int> fill(bOff.begin(), bOff.end()-1);
+    for(int i=0;i<g.volume;i++) bSite[fill[cIdx[i]]++] = i;
+
+    V.push_back(std::vector<std::complex<Float>>(static_cast<size_t>(g.volume) * nSpin[lev] * nColor[lev] * nVec[lev]));
+  }
+
+  scratch.resize(nLevel);
+}
+
+
+template <typename Float>
+HostProlongator<Float>::~HostProlongator(){
+  freeScratch();
+  for(auto g: coarseGeom) delete g;
+  coarseGeom.clear();
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::freeScratch(){
+  for(auto &s: scratch){
+    for(auto v: s) delete v;
+    s.clear();
+  }
+}
+
+
+template <typename Float>
+size_t HostProlongator<Float>::Bytes() const {
+  size_t b = 0;
+  for(const auto &v: V) b += v.size() * sizeof(std::complex<Float>);
+  return b;
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::setNullVectors(int lev, const void *Vin, QudaPrecision prec){
+
+  checkLevel(lev, __func__);
+  if(Vin == nullptr) errorQuda("%s: Got NULL null vectors for level %d\n", __func__, lev);
+
+  std::vector<std::complex<Float>> &Vl = V[lev];
+  const long long len = static_cast<long long>(Vl.size());
+  if(prec == QUDA_DOUBLE_PRECISION){
+    const std::complex<double> *in = static_cast<const std::complex<double>*>(Vin);
+#pragma omp parallel for
+    for(long long i=0;i<len;i++) Vl[i] = std::complex<Float>(in[i].real(), in[i].imag());
+  }
+  else if(prec == QUDA_SINGLE_PRECISION){
+    const std::complex<float> *in = static_cast<const std::complex<float>*>(Vin);
+#pragma omp parallel for
+    for(long long i=0;i<len;i++) Vl[i] = std::complex<Float>(in[i].real(), in[i].imag());
+  }
+  else errorQuda("%s: Unsupported precision %d of the null vectors\n", __func__, static_cast<int>(prec));
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::checkFields(const std::vector<HostColorSpinorField<Float>*> &out, int lev, const char *func) const {
+  checkLevel(lev, func);
+  for(size_t j=0;j<out.size();j++)
+    if(out[j]->Nspin() != nSpin[lev] || out[j]->Ncolor() != nColor[lev] || &(out[j]->Geom()) != &Geom(lev))
+      errorQuda("%s: Output vector %zu is not a field of lattice %d\n", func, j, lev);
+}
+
+
+template <typename Float>
+template <typename CoarseSite>
+void HostProlongator<Float>::prolongateLevel(std::vector<HostColorSpinorField<Float>*> &out, int k, int lev, CoarseSite coarseSite){
+
+  const HostGeom &g = Geom(lev);
+  const int nS = nSpin[lev];
+  const int nC = nColor[lev];
+  const int nV = nVec[lev];
+  const int sB = spinBlock[lev];
+
+  const std::complex<Float> *Vl = V[lev].data();
+  const int *cIdx = coarseIdx[lev].data();
+  const long long vSiteLen = static_cast<long long>(nS) * nC * nV;
+
+#pragma omp parallel
+  {
+    std::vector<std::complex<Float>> buf(static_cast<size_t>(k) * nV);
+    std::vector<const std::complex<Float>*> cv(k);
+
+#pragma omp for
+    for(int i=0;i<g.volume;i++){
+      const std::complex<Float> *Vsite = Vl + i * vSiteLen;
+      const int ic = cIdx[i];
+      for(int s=0;s<nS;s++){
+	const int sc = s / sB;
+	for(int j=0;j<k;j++) cv[j] = coarseSite(j, ic, sc, &buf[static_cast<size_t>(j) * nV]);
+	for(int c=0;c<nC;c++){
+	  //- One row of the null vectors, applied to the whole block of vectors while it is in cache
+	  const std::complex<Float> *Vrow = Vsite + (s*nC + c)*nV;
+	  for(int j=0;j<k;j++){
+	    Float re = 0.0, im = 0.0;
+	    for(int v=0;v<nV;v++){
+	      re += Vrow[v].real() * cv[j][v].real() - Vrow[v].imag() * cv[j][v].imag();
+	      im += Vrow[v].real() * cv[j][v].imag() + Vrow[v].imag() * cv[j][v].real();
+	    }
+	    out[j]->Site(i)[s*nC + c] = std::complex<Float>(re, im);
+	  }
+	}
+      }
+    }
+  }
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::prolongate(std::vector<HostColorSpinorField<Float>*> &out,
+					const std::vector<HostColorSpinorField<Float>*> &in, int lev){
+
+  checkFields(out, lev, __func__);
+  if(out.size() != in.size()) errorQuda("%s: Got %zu output and %zu input vectors\n", __func__, out.size(), in.size());
+  for(size_t j=0;j<in.size();j++)
+    if(in[j]->Nspin() != nSpin[lev+1] || in[j]->Ncolor() != nColor[lev+1] || &(in[j]->Geom()) != &Geom(lev+1))
+      errorQuda("%s: Input vector %zu is not a field of lattice %d\n", __func__, j, lev+1);
+
+  const int nCoarseColor = nColor[lev+1];
+  prolongateLevel(out, static_cast<int>(in.size()), lev,
+		  [&](int j, int ic, int sc, std::complex<Float> *){ return in[j]->Site(ic) + sc*nCoarseColor; });
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::prolongate(std::vector<HostColorSpinorField<Float>*> &out,
+					const std::vector<HostCompressedField<Float>*> &in, int lev){
+
+  checkFields(out, lev, __func__);
+  if(out.size() != in.size()) errorQuda("%s: Got %zu output and %zu input vectors\n", __func__, out.size(), in.size());
+  for(size_t j=0;j<in.size();j++)
+    if(in[j]->Nspin() != nSpin[lev+1] || in[j]->Ncolor() != nColor[lev+1] || &(in[j]->Geom()) != &Geom(lev+1))
+      errorQuda("%s: Input vector %zu is not a field of lattice %d\n", __func__, j, lev+1);
+
+  const int nCoarseColor = nColor[lev+1];
+  prolongateLevel(out, static_cast<int>(in.size()), lev,
+		  [&](int j, int ic, int sc, std::complex<Float> *buf){
+		    in[j]->decodeSite(buf, ic, sc*nCoarseColor, nCoarseColor);
+		    return static_cast<const std::complex<Float>*>(buf);
+		  });
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::restrictVectors(std::vector<HostColorSpinorField<Float>*> &out,
+					     const std::vector<HostColorSpinorField<Float>*> &in, int lev){
+
+  checkLevel(lev, __func__);
+  if(out.size() != in.size()) errorQuda("%s: Got %zu output and %zu input vectors\n", __func__, out.size(), in.size());
+  const HostGeom &g = Geom(lev);
+  const HostGeom &gc = Geom(lev+1);
+  for(size_t j=0;j<in.size();j++){
+    if(in[j]->Nspin() != nSpin[lev] || in[j]->Ncolor() != nColor[lev] || &(in[j]->Geom()) != &g)
+      errorQuda("%s: Input vector %zu is not a field of lattice %d\n", __func__, j, lev);
+    if(out[j]->Nspin() != nSpin[lev+1] || out[j]->Ncolor() != nColor[lev+1] || &(out[j]->Geom()) != &gc)
+      errorQuda("%s: Output vector %zu is not a field of lattice %d\n", __func__, j, lev+1);
+  }
+
+  const int nS = nSpin[lev];
+  const int nC = nColor[lev];
+  const int nV = nVec[lev];
+  const int sB = spinBlock[lev];
+  const int k = static_cast<int>(in.size());
+  const std::complex<Float> *Vl = V[lev].data();
+  const int *bOff = blockOffset[lev].data();
+  const int *bSite = blockSites[lev].data();
+  const long long vSiteLen = static_cast<long long>(nS) * nC * nV;
+
+  //- Each coarse site gathers its block, so that no two threads write to the same site
+#pragma omp parallel for
+  for(int ic=0;ic<gc.volume;ic++){
+    for(int j=0;j<k;j++)
+      for(int e=0;e<out[j]->SiteLength();e++) out[j]->Site(ic)[e] = 0.0;
+
+    for(int b=bOff[ic];b<bOff[ic+1];b++){
+      const int i = bSite[b];
+      const std::complex<Float> *Vsite = Vl + i * vSiteLen;
+      for(int s=0;s<nS;s++){
+	const int sc = s / sB;
+	for(int c=0;c<nC;c++){
+	  const std::complex<Float> *Vrow = Vsite + (s*nC + c)*nV;
+	  for(int j=0;j<k;j++){
+	    const std::complex<Float> f = in[j]->Site(i)[s*nC + c];
+	    std::complex<Float> *cv = out[j]->Site(ic) + sc*nV;
+	    for(int v=0;v<nV;v++) cv[v] += std::conj(Vrow[v]) * f;
+	  }
+	}
+      }
+    }
+  }
+}
+
+
+template <typename Float>
+template <typename CoarseVec>
+void HostProlongator<Float>::prolongateChain(std::vector<HostColorSpinorField<Float>*> &fine, const std::vector<CoarseVec*> &coarse){
+
+  if(fine.size() != coarse.size()) errorQuda("%s: Got %zu fine and %zu coarse vectors\n", __func__, fine.size(), coarse.size());
+  const size_t k = coarse.size();
+
+  //- The coarsest level reads the input vectors, the others the scratch fields of the level below
+  std::vector<HostColorSpinorField<Float>*> src;
+  for(int lev=nLevel-1;lev>=0;lev--){
+    std::vector<HostColorSpinorField<Float>*> dst;
+    if(lev == 0) dst = fine;
+    else{
+      while(scratch[lev].size() < k) scratch[lev].push_back(new HostColorSpinorField<Float>(Geom(lev), nSpin[lev], nColor[lev]));
+      dst.assign(scratch[lev].begin(), scratch[lev].begin() + k);
+    }
+    if(lev == nLevel-1) prolongate(dst, coarse, lev);
+    else prolongate(dst, src, lev);
+    src = dst;
+  }
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::prolongate(std::vector<HostColorSpinorField<Float>*> &fine,
+					const std::vector<HostColorSpinorField<Float>*> &coarse){
+  prolongateChain(fine, coarse);
+}
+
+
+template <typename Float>
+void HostProlongator<Float>::prolongate(std::vector<HostColorSpinorField<Float>*> &fine,
+					const std::vector<HostCompressedField<Float>*> &coarse){
+  prolongateChain(fine, coarse);
+}
+
+
+template class HostProlongator<float>;
+template class HostProlongator<double>;
@@ -23,6 +23,7 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 #include <mugiq.h>
+#include <eigsolve_mugiq.h>
 
 double kappa5; // Derived, not given. Used in matVec checks.
 
@@ -650,6 +651,74 @@ void setLoopParam(MugiqLoopParam &loopParams){
 }
 
 
+//- The eigensolve with the host backend (host Lanczos, eigenvalues and projection on the host Wilson-clover operator)
+//- must agree with the one on the device: the eigenvalues within the tolerance, and the projection of a random source
+//- within the accuracy of the eigenvectors, which is the square root of that of the eigenvalues
+void checkHostEigsolve(QudaEigParam &eig_param, MugiqEigOptions eig_options){
+
+  TimeProfile profile("checkHostEigsolve");
+
+  MugiqEigOptions hostOptions = eig_options, devOptions = eig_options;
+  hostOptions.hostEigsolver = MUGIQ_BOOL_TRUE;
+  devOptions.hostEigsolver = MUGIQ_BOOL_FALSE;
+  MugiqEigParam paramHost(&eig_param, hostOptions);
+  MugiqEigParam paramDev(&eig_param, devOptions);
+
+  Eigsolve_Mugiq eigHost(&paramHost, &profile);
+  Eigsolve_Mugiq eigDev(&paramDev, &profile);
+  if(!eigHost.HostBackend()) errorQuda("%s: The host operator is not used for these parameters\n", __func__);
+
+  double t0 = MPI_Wtime();
+  eigHost.computeEvecs();
+  eigHost.computeEvals();
+  double t1 = MPI_Wtime();
+  eigDev.computeEvecs();
+  eigDev.computeEvals();
+  double t2 = MPI_Wtime();
+  printfQuda("%s: Eigensolve on the host in %.3f s, on the device in %.3f s\n", __func__, t1 - t0, t2 - t1);
+
+  const std::vector<Complex> &evH = *eigHost.getEvals();
+  const std::vector<Complex> &evD = *eigDev.getEvals();
+  double evMax = 0.0, devEvals = 0.0;
+  for(int i=0;i<eig_param.nEv;i++) evMax = std::max(evMax, std::abs(evD[i]));
+  for(int i=0;i<eig_param.nEv;i++) devEvals = std::max(devEvals, std::abs(evH[i] - evD[i]) / evMax);
+
+  //- Random source, through a host field
+  ColorSpinorField &v0 = *eigDev.getEvecs()[0];
+  ColorSpinorParam hParam(v0);
+  hParam.location = QUDA_CPU_FIELD_LOCATION;
+  hParam.fieldOrder = QUDA_SPACE_SPIN_COLOR_FIELD_ORDER;
+  hParam.create = QUDA_ZERO_FIELD_CREATE;
+  hParam.setPrecision(QUDA_DOUBLE_PRECISION);
+  ColorSpinorField *hSrc = ColorSpinorField::Create(hParam);
+  double *h = static_cast<double*>(hSrc->V());
+  for(size_t e=0;e<static_cast<size_t>(hSrc->Length());e++) h[e] = rand() / (double)RAND_MAX - 0.5;
+
+  ColorSpinorParam dParam(v0);
+  dParam.create = QUDA_ZERO_FIELD_CREATE;
+  ColorSpinorField *src = ColorSpinorField::Create(dParam);
+  ColorSpinorField *outH = ColorSpinorField::Create(dParam);
+  ColorSpinorField *outD = ColorSpinorField::Create(dParam);
+  *src = *hSrc;
+  eigHost.projectVector(*outH, *src);
+  eigDev.projectVector(*outD, *src);
+  const double normD = blas::norm2(*outD);
+  blas::axpy(-1.0, *outD, *outH);
+  const double devProj = sqrt(blas::norm2(*outH) / normD);
+
+  delete hSrc;
+  delete src;
+  delete outH;
+  delete outD;
+
+  printfQuda("%s: Max relative deviation of the host eigenvalues from the device ones: %e\n", __func__, devEvals);
+  printfQuda("%s: Relative deviation of the host projection from the device one: %e\n", __func__, devProj);
+  if(devEvals > 10*eig_param.tol) errorQuda("Host eigensolve check FAILED for the eigenvalues (tolerance = %e)\n", 10*eig_param.tol);
+  if(devProj > 10*sqrt(eig_param.tol)) errorQuda("Host eigensolve check FAILED for the projection (tolerance = %e)\n", 10*sqrt(eig_param.tol));
+  printfQuda("%s: Host eigensolve check PASSED\n", __func__);
+}
+
+
 int main(int argc, char **argv)
 {
   // Parse QUDA and MuGiq command line options
@@ -696,6 +765,10 @@ int main(int argc, char **argv)
   eig_param.invert_param = &eig_inv_param;
   setEigParam(eig_param);
 
+  MugiqEigOptions eig_options;
+  eig_options.denseRatio = mugiq_dense_ratio;
+  eig_options.hostEigsolver = mugiq_host_eigsolver;
+
   if (eig_param.arpack_check)
     errorQuda("MuGiq does not support ARPACK!\n");
 
@@ -777,6 +850,11 @@ int main(int argc, char **argv)
     eig_inv_param.return_clover_inverse = 1;
   }
 
+  //- Host links and clover term of the host eigensolver, the clover term is returned by QUDA when it is computed
+  for (int dir = 0; dir < 4; dir++) eig_options.hostGauge[dir] = gauge[dir];
+  eig_options.hostClover = clover;
+  eig_options.hostPrec = gauge_param.cpu_prec;
+
   // initialize the QUDA library
   initQuda(device);
 
@@ -815,18 +893,23 @@ int main(int argc, char **argv)
       free(host_evecs);
       free(host_evals);    
     }
-    else if(mugiq_task == MUGIQ_COMPUTE_EVECS_MUGIQ) computeEvecsMuGiq(eig_param);
+    else if(mugiq_task == MUGIQ_COMPUTE_EVECS_MUGIQ) computeEvecsMuGiq(eig_param, eig_options);
     else if(mugiq_task == MUGIQ_TASK_INVALID) errorQuda("Option --mugiq-task not set! (options are computeEvecsQuda, computeEvecsMuGiq)\n");
     else errorQuda("Unsupported option for --mugiq-task! (options are computeEvecsQuda, computeEvecsMuGiq when --mugiq-use-mg is set to no)\n");
   }
   else if(mugiq_use_mg == MUGIQ_BOOL_TRUE){
-    if(mugiq_task == MUGIQ_COMPUTE_EVECS_MUGIQ) computeEvecsMuGiq_MG(mg_param, eig_param); //- Compute Coarse MG operator eigenvalues
+    if(mugiq_task == MUGIQ_COMPUTE_EVECS_MUGIQ) computeEvecsMuGiq_MG(mg_param, eig_param, eig_options); //- Compute Coarse MG operator eigenvalues
     else if(mugiq_task == MUGIQ_COMPUTE_LOOP) errorQuda("Got option '--mugiq-task computeLoop'. For this option you need to run the test 'loop'.\n");
     else if(mugiq_task == MUGIQ_TASK_INVALID) errorQuda("Option --mugiq-task not set! (options are computeLoopULocal)\n");
     else errorQuda("Unsupported option for --mugiq-task! (options are computeEvecsMuGiq when --mugiq-use-mg is set to yes)\n");
   }
   else if(mugiq_use_mg == MUGIQ_BOOL_INVALID) errorQuda("Option --mugiq-use-mg not set! (options are yes/no)\n");
   else errorQuda("Unsupported option --mugiq-use-mg! (options are yes/no)\n");
+
+  if(mugiq_check_host == MUGIQ_BOOL_TRUE){
+    if(mugiq_use_mg == MUGIQ_BOOL_TRUE) errorQuda("The host eigensolve check needs --mugiq-use-mg no\n");
+    checkHostEigsolve(eig_param, eig_options);
+  }
     
   time += (double)clock();
   printfQuda("Time for solution = %f\n", time / CLOCKS_PER_SEC);
@@ -0,0 +1,149 @@
+/*
+ * Standalone process-grid planner, does not need QUDA, MPI or a GPU.
+ * It can be built without the rest of MuGiq, e.g.:
+ *   c++ -std=c++11 -I../include grid_planner.cpp ../lib/grid_planner_mugiq.cpp -o grid_planner
+ *
+ * Usage example:
+ *   ./grid_planner --lattice 32 32 32 64 --nprocs 16 --disp "+z:1,8;-z:1,8;+x:3" --nev 200 --nmom 33
+ *
+ * With --check the recommended grids of a few known workloads are checked instead
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include <grid_planner_mugiq.h>
+
+static void usage(const char *exe){
+  printf("Usage: %s --lattice X Y Z T --nprocs N [options]\n", exe);
+  printf("  --disp <entries>       Displacement entries, e.g. +z:1,8;-x:3 (default none)\n");
+  printf("  --nev <n>              Number of eigenvectors (default 1)\n");
+  printf("  --nmom <n>             Number of momenta (default 1)\n");
+  printf("  --prec <single|double> Precision of eigenvectors and loop data (default double)\n");
+  printf("  --halo <all|disp>      Ghosts of all partitioned dimensions per hop (GPU) or only the displaced one (host) (default all)\n");
+  printf("  --alpha <sec>          Latency per message (default 2e-6)\n");
+  printf("  --beta <sec/byte>      Inverse bandwidth (default 1e-10)\n");
+  printf("  --grid X Y Z T         Grid to compare against\n");
+  printf("  --show <n>             Number of grids to show (default 10)\n");
+  printf("  --check                Check the recommended grids of known workloads and exit\n");
+}
+
+
+//- Recommended grid of a workload, compared with the expected one
+static bool checkPlan(const char *label, int X, int Y, int Z, int T, int nProcs, const char *disp, int nEv, int Nmom,
+		      MuGiqBool haloAllDims, double alpha, double beta, const int expGrid[]){
+
+  GridPlanWorkload w;
+  w.L[0] = X; w.L[1] = Y; w.L[2] = Z; w.L[3] = T;
+  w.nProcs = nProcs;
+  w.nEv = nEv;
+  w.Nmom = Nmom;
+  w.haloAllDims = haloAllDims;
+  w.alpha = alpha;
+  w.beta = beta;
+  if(!w.addDisplaceEntries(disp)){
+    printf("%s: FAILED, cannot parse the displacement entries %s\n", label, disp);
+    return false;
+  }
+
+  std::vector<GridPlanCost> plans = planProcessGrid(w);
+  if(plans.empty()){
+    printf("%s: FAILED, no process grid found\n", label);
+    return false;
+  }
+
+  const int *g = plans[0].grid;
+  bool pass = true;
+  for(int d=0;d<GRID_PLAN_NDIM;d++) pass = pass && (g[d] == expGrid[d]);
+  printf("%s: recommended %dx%dx%dx%d, expected %dx%dx%dx%d -> %s\n", label, g[0], g[1], g[2], g[3],
+	 expGrid[0], expGrid[1], expGrid[2], expGrid[3], pass ? "PASSED" : "FAILED");
+  return pass;
+}
+
+
+static int runChecks(){
+
+  bool pass = true;
+
+  //- Hops along z and x only: neither is partitioned, time is preferred for the momentum reduction
+  const int g0[] = {1,1,1,16};
+  pass &= checkPlan("z/x hops, halo all", 32, 32, 32, 64, 16, "+z:1,8;-z:1,8;+x:3", 200, 33, MUGIQ_BOOL_TRUE, 2.0e-6, 1.0e-10, g0);
+  pass &= checkPlan("z/x hops, halo disp", 32, 32, 32, 64, 16, "+z:1,8;-z:1,8;+x:3", 200, 33, MUGIQ_BOOL_FALSE, 2.0e-6, 1.0e-10, g0);
+
+  //- Hops along all directions: the heavily displaced z and t stay local
+  const int g1[] = {4,4,1,1};
+  pass &= checkPlan("all hops, z/t heavy", 16, 16, 16, 16, 16, "+x:1;+y:1;+z:4;+t:4", 100, 1, MUGIQ_BOOL_TRUE, 2.0e-6, 1.0e-10, g1);
+  pass &= checkPlan("all hops, z/t heavy, halo disp", 16, 16, 16, 16, 16, "+x:1;+y:1;+z:4;+t:4", 100, 1, MUGIQ_BOOL_FALSE, 2.0e-6, 1.0e-10, g1);
+
+  //- Heavy z among light x, y, t hops: z is never partitioned
+  const int g2[] = {1,1,1,16};
+  pass &= checkPlan("z heavy, light x/y/t", 32, 32, 32, 64, 16, "+x:1,2;+y:1,2;+z:1,8;-z:1,8;+t:1,2", 200, 33, MUGIQ_BOOL_TRUE, 2.0e-6, 1.0e-10, g2);
+
+  //- Free communication: all grids tie and the tie-break keeps the displaced t and x local, even though
+  //- partitioning time would otherwise be preferred, and then partitions a single dimension
+  const int g3[] = {1,1,4,1};
+  pass &= checkPlan("tie-break", 16, 16, 16, 32, 4, "+t:1,8;+x:1", 100, 1, MUGIQ_BOOL_TRUE, 0.0, 0.0, g3);
+
+  printf("Grid planner checks %s\n", pass ? "PASSED" : "FAILED");
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+int main(int argc, char **argv)
+{
+  GridPlanWorkload w;
+  int userGrid[GRID_PLAN_NDIM] = {0,0,0,0};
+  bool haveUserGrid = false;
+  int nShow = 10;
+
+  for(int i=1;i<argc;i++){
+    std::string opt(argv[i]);
+    auto need = [&](int n){
+      if(i+n >= argc){
+	fprintf(stderr, "Option %s needs %d argument(s)\n", argv[i], n);
+	exit(EXIT_FAILURE);
+      }
+    };
+    if(opt == "--lattice"){ need(4); for(int d=0;d<GRID_PLAN_NDIM;d++) w.L[d] = atoi(argv[++i]); }
+    else if(opt == "--nprocs"){ need(1); w.nProcs = atoi(argv[++i]); }
+    else if(opt == "--disp"){
+      need(1);
+      if(!w.addDisplaceEntries(argv[++i])){
+	fprintf(stderr, "Wrong format of displacement entries %s. Example of good entries: +z:1,8;+x:3\n", argv[i]);
+	return EXIT_FAILURE;
+      }
+    }
+    else if(opt == "--nev"){ need(1); w.nEv = atoi(argv[++i]); }
+    else if(opt == "--nmom"){ need(1); w.Nmom = atoi(argv[++i]); }
+    else if(opt == "--prec"){ need(1); i++; w.setPrecision(strcmp(argv[i], "single") == 0 ? sizeof(float) : sizeof(double)); }
+    else if(opt == "--halo"){ need(1); i++; w.haloAllDims = (strcmp(argv[i], "disp") == 0) ? MUGIQ_BOOL_FALSE : MUGIQ_BOOL_TRUE; }
+    else if(opt == "--alpha"){ need(1); w.alpha = atof(argv[++i]); }
+    else if(opt == "--beta"){ need(1); w.beta = atof(argv[++i]); }
+    else if(opt == "--grid"){ need(4); for(int d=0;d<GRID_PLAN_NDIM;d++) userGrid[d] = atoi(argv[++i]); haveUserGrid = true; }
+    else if(opt == "--show"){ need(1); nShow = atoi(argv[++i]); }
+    else if(opt == "--check") return runChecks();
+    else{
+      usage(argv[0]);
+      return (opt == "--help" || opt == "-h") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  for(int d=0;d<GRID_PLAN_NDIM;d++){
+    if(w.L[d] < 2){
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if(haveUserGrid){
+    int n = 1;
+    for(int d=0;d<GRID_PLAN_NDIM;d++) n *= userGrid[d];
+    w.nProcs = n;
+  }
+
+  std::vector<GridPlanCost> plans = planProcessGrid(w);
+  printf("%s", gridPlanReport(w, plans, haveUserGrid ? userGrid : nullptr, nShow).c_str());
+
+  return plans.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
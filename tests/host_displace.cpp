@@ -0,0 +1,534 @@
+#include "host_test_mugiq.h"
+#include <disp_path_mugiq.h>
+
+/*
+ * Checks of the host (CPU) covariant displacements.
+ * Each displacement +d is followed by the displacement -d, which must give back the original vector, with and
+ * without overlapping the halo exchange with the interior stencil, whose profiles are printed.
+ */
+
+const char *dispFlagStr[2*N_DIM_] = {"+x","-x","+y","-y","+z","-z","+t","-t"};
+
+
+template <typename Float>
+static DisplaceProfile runDisplacements(DisplaceHost<Float> &disp, HostColorSpinorField<Float> &src,
+					HostColorSpinorField<Float> &tmp, HostColorSpinorField<Float> &dst,
+					MuGiqBool overlap, int niter, double &maxDev){
+
+  disp.setOverlapComms(overlap);
+  disp.getProfile().reset();
+  maxDev = 0.0;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  for(int it=0;it<niter;it++){
+    for(int f=0;f<2*N_DIM_;f++){
+      DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+      DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+      DisplaceSign back = (f%2 == 0) ? DispSignMinus : DispSignPlus;
+      disp.doVectorDisplacement(tmp, src, dir, sign);
+      disp.doVectorDisplacement(dst, tmp, dir, back);
+      if(it == 0){
+	double dev = maxDeviation(src, dst);
+	if(getVerbosity() >= QUDA_VERBOSE) printfQuda("  %s followed by its inverse: max deviation = %e\n", dispFlagStr[f], dev);
+	maxDev = std::max(maxDev, dev);
+      }
+    }
+  }
+
+  return disp.getProfile();
+}
+
+
+//- The neighbour-table engine must reproduce the coordinate-based one bit by bit, in all directions, on the periodic
+//- local lattice and with the boundary sites taken from the halo of the self-partitioned one
+template <typename Float>
+static bool checkNbrTable(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec){
+
+  int nMismatch = 0;
+  for(int part=0;part<2;part++){
+    const HostGeom geomS = selfGeom(geom, part);
+    DisplaceHost<Float> disp(geomS, gauge, cpuPrec);
+    std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomS, 1, true);
+    std::vector<HostColorSpinorField<Float>*> dstRef = newFields<Float>(geomS, 1), dst = newFields<Float>(geomS, 1);
+    for(int f=0;f<2*N_DIM_;f++){
+      DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+      DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+      disp.setUseNbrTable(MUGIQ_BOOL_FALSE);
+      disp.doVectorDisplacement(*dstRef[0], *src[0], dir, sign);
+      disp.setUseNbrTable(MUGIQ_BOOL_TRUE);
+      disp.doVectorDisplacement(*dst[0], *src[0], dir, sign);
+      nMismatch += countMismatch(dstRef, dst);
+    }
+    deleteFields(src);
+    deleteFields(dstRef);
+    deleteFields(dst);
+  }
+  return nMismatch == 0;
+}
+
+
+//- The batched displacements must reproduce the single-vector ones bit by bit, in all directions. On the
+//- self-partitioned lattice the faces of a batch travel together: nVec vectors take ceil(nVec/BatchSize()) messages
+//- per displacement instead of nVec
+template <typename Float>
+static bool checkBatch(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nVec, long long &nMsgSingle,
+		       long long &nMsgBatch){
+
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> disp(geomP, gauge, cpuPrec);
+  const int nBatch = (nVec + disp.BatchSize() - 1) / disp.BatchSize();
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomP, nVec, true);
+  std::vector<HostColorSpinorField<Float>*> dstRef = newFields<Float>(geomP, nVec), dst = newFields<Float>(geomP, nVec);
+
+  HostHaloExchange<Float> &halo = disp.getHalo();
+  int nMismatch = 0;
+  nMsgSingle = nMsgBatch = 0;
+  bool countOk = true;
+  for(int f=0;f<2*N_DIM_;f++){
+    DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+    DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+    halo.resetCounters();
+    for(int i=0;i<nVec;i++) disp.doVectorDisplacement(*dstRef[i], *src[i], dir, sign);
+    nMsgSingle += halo.Messages();
+    halo.resetCounters();
+    disp.doVectorDisplacement(dst, src, dir, sign);
+    nMsgBatch += halo.Messages();
+    countOk = countOk && halo.Messages() == nBatch;
+    nMismatch += countMismatch(dstRef, dst);
+  }
+
+  deleteFields(src);
+  deleteFields(dstRef);
+  deleteFields(dst);
+
+  return nMismatch == 0 && countOk;
+}
+
+
+//- Successive hops in place with rotated buffer handles must reproduce the former scheme, which zeroed the spare
+//- buffer, displaced into it and copied it back and forth, bit by bit, and every hop must only swap the handles of
+//- the vectors and their spare buffers. The memory traffic per hop and vector of both schemes follows from a model:
+//- the stencil reads the input and the links and writes the output, the zeroing writes one field and each of the
+//- two copies reads and writes one field
+template <typename Float>
+static bool checkPingPong(DisplaceHost<Float> &disp, const HostGeom &geom, int nVec, double &bytesCopy, double &bytesRotate){
+
+  std::vector<HostColorSpinorField<Float>*> vecRef = newFields<Float>(geom, nVec, true), spareRef = newFields<Float>(geom, nVec);
+  std::vector<HostColorSpinorField<Float>*> vec = newFields<Float>(geom, nVec), spare = newFields<Float>(geom, nVec);
+  for(int i=0;i<nVec;i++) vec[i]->copy(*vecRef[i]);
+
+  const double fieldBytes = static_cast<double>(vec[0]->Bytes());
+  const double linkBytes  = static_cast<double>(geom.volume) * disp.getGauge().LinkLength() * sizeof(std::complex<Float>);
+  bytesRotate = 2*fieldBytes + linkBytes / nVec;
+  bytesCopy   = bytesRotate + 5*fieldBytes;
+
+  bool swapped = true;
+  for(int f=0;f<2*N_DIM_;f++){
+    DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+    DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+    for(auto v: spareRef) v->zero();
+    disp.doVectorDisplacement(spareRef, vecRef, dir, sign);
+    for(int i=0;i<nVec;i++){
+      vecRef[i]->copy(*spareRef[i]);
+      spareRef[i]->copy(*vecRef[i]);
+    }
+    const std::vector<HostColorSpinorField<Float>*> vecIn = vec, spareIn = spare;
+    disp.doVectorHop(vec, spare, dir, sign);
+    swapped = swapped && vec == spareIn && spare == vecIn;
+  }
+
+  const int nMismatch = countMismatch(vecRef, vec);
+
+  deleteFields(vecRef);
+  deleteFields(spareRef);
+  deleteFields(vec);
+  deleteFields(spare);
+
+  return nMismatch == 0 && swapped;
+}
+
+
+//- (U_d(x)src(x+d) - U_d^\dag(x-d)src(x-d))/2 from two separate displacements
+template <typename Float>
+static void symmetricDerivativeRef(DisplaceHost<Float> &disp, HostColorSpinorField<Float> &dst, HostColorSpinorField<Float> &src,
+				   HostColorSpinorField<Float> &tmp, DisplaceDir dir){
+  disp.doVectorDisplacement(dst, src, dir, DispSignPlus);
+  disp.doVectorDisplacement(tmp, src, dir, DispSignMinus);
+  for(long long i=0;i<dst.Length();i++) dst.V()[i] = (dst.V()[i] - tmp.V()[i]) * static_cast<Float>(0.5);
+}
+
+
+//- The walk of the displacement-path trie must give the vectors of the straight displacements of each length bit by
+//- bit, with the overlapping entries sharing their hops: one hop per site of the longest path in each direction,
+//- instead of one per site of every entry. The +x/-x hops are fused into a pair, and the derivatives are leaves of
+//- the root
+template <typename Float>
+static bool checkPathTrie(DisplaceHost<Float> &disp, const HostGeom &geom, int &nHop, long long &nHopNaive){
+
+  const std::vector<std::string> dispString {"+x","+x","-t","+x","-x"};
+  const std::vector<int> dispStart {1,2,1,3,1};
+  const std::vector<int> dispStop  {2,4,2,3,2};
+  const std::vector<std::string> dispDeriv {"z","x"};
+  std::vector<int> nLoopOffset;
+  int osum = 1;
+  for(size_t id=0;id<dispString.size();id++){
+    nLoopOffset.push_back(osum);
+    osum += dispStop[id] - dispStart[id] + 1;
+  }
+
+  DispPathTrie trie = DispPathTrie::fromEntries(dispString, dispStart, dispStop, nLoopOffset,
+						std::vector<std::string>(), osum, dispDeriv, osum);
+  trie.printReport(__func__);
+  nHop = trie.NHop();
+  nHopNaive = trie.NHopNaive();
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geom, 1, true);
+  std::vector<std::vector<HostColorSpinorField<Float>*>> slot(trie.NSlot());
+  slot[0] = src;
+  for(int s=1;s<trie.NSlot();s++) slot[s] = newFields<Float>(geom, 1);
+  std::vector<HostColorSpinorField<Float>*> ref = newFields<Float>(geom, 1), tmp = newFields<Float>(geom, 1);
+  std::vector<HostColorSpinorField<Float>*> none;
+
+  int nMismatch = 0;
+  for(const auto &op: trie.Schedule()){
+    if(op.type == DISP_PATH_OP_HOP){
+      disp.doVectorDisplacement(slot[op.dst], slot[op.src], displaceFlagDir(op.hop), displaceFlagSign(op.hop));
+      continue;
+    }
+    if(op.type == DISP_PATH_OP_HOP_PAIR){
+      disp.doSymmetricDisplacement(slot[op.dst], slot[op.dst2], slot[op.src], displaceFlagDir(op.hop), DISPLACE_SYM_PAIR);
+      continue;
+    }
+    if(op.type == DISP_PATH_OP_DERIV){
+      disp.doSymmetricDisplacement(slot[op.dst], none, slot[op.src], displaceFlagDir(op.hop), DISPLACE_SYM_DERIV);
+      continue;
+    }
+    const DispPathNode &nd = trie.Nodes().at(op.node);
+    if(nd.depth == 0) continue;
+    if(nd.deriv) symmetricDerivativeRef<Float>(disp, *ref[0], *src[0], *tmp[0], displaceFlagDir(nd.hop));
+    else{
+      ref[0]->copy(*src[0]);
+      for(int d=0;d<nd.depth;d++){
+	disp.doVectorDisplacement(*tmp[0], *ref[0], displaceFlagDir(nd.hop), displaceFlagSign(nd.hop));
+	ref[0]->copy(*tmp[0]);
+      }
+    }
+    nMismatch += countMismatch(ref, slot[op.src]);
+  }
+
+  for(int s=1;s<trie.NSlot();s++) deleteFields(slot[s]);
+  deleteFields(src);
+  deleteFields(ref);
+  deleteFields(tmp);
+
+  return nMismatch == 0 && nHop == 12 && nHopNaive == 17 && trie.NPair() == 1;
+}
+
+
+//- The fused +d/-d displacements and derivatives must reproduce the separate displacements bit by bit, in all
+//- directions, on the self-partitioned lattice so that both halos are exchanged together
+template <typename Float>
+static bool checkSymmetric(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nVec){
+
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> disp(geomP, gauge, cpuPrec);
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomP, nVec, true);
+  std::vector<HostColorSpinorField<Float>*> refP = newFields<Float>(geomP, nVec), refM = newFields<Float>(geomP, nVec);
+  std::vector<HostColorSpinorField<Float>*> dstP = newFields<Float>(geomP, nVec), dstM = newFields<Float>(geomP, nVec);
+  std::vector<HostColorSpinorField<Float>*> none;
+
+  int nMismatch = 0;
+  for(int d=0;d<N_DIM_;d++){
+    DisplaceDir dir = static_cast<DisplaceDir>(d);
+    disp.doVectorDisplacement(refP, src, dir, DispSignPlus);
+    disp.doVectorDisplacement(refM, src, dir, DispSignMinus);
+    disp.doSymmetricDisplacement(dstP, dstM, src, dir, DISPLACE_SYM_PAIR);
+    nMismatch += countMismatch(refP, dstP) + countMismatch(refM, dstM);
+
+    disp.doSymmetricDisplacement(dstP, none, src, dir, DISPLACE_SYM_DERIV);
+    for(int i=0;i<nVec;i++) symmetricDerivativeRef<Float>(disp, *refP[i], *src[i], *refM[i], dir);
+    nMismatch += countMismatch(refP, dstP);
+  }
+
+  deleteFields(src);
+  deleteFields(refP);
+  deleteFields(refM);
+  deleteFields(dstP);
+  deleteFields(dstM);
+
+  return nMismatch == 0;
+}
+
+
+//- Star-stencil sink storing the transported neighbours
+template <typename Float>
+struct StoreStarSink : public HostStarSink<Float> {
+
+  std::vector<std::vector<HostColorSpinorField<Float>*>> &out;  // out[iFlag][iv]
+  int nVec;
+
+  StoreStarSink(std::vector<std::vector<HostColorSpinorField<Float>*>> &out_, int nVec_) : out(out_), nVec(nVec_) {}
+
+  void site(int idx, const std::complex<Float> *w){
+    for(size_t i=0;i<out.size();i++)
+      for(int iv=0;iv<nVec;iv++){
+	const std::complex<Float> *wi = w + (i*nVec + iv)*SPINOR_SITE_LEN_;
+	std::copy(wi, wi + SPINOR_SITE_LEN_, out[i][iv]->Site(idx));
+      }
+  }
+};
+
+
+//- The star stencil must reproduce the one-hop displacements in all eight directions bit by bit, on the
+//- self-partitioned lattice so that the neighbours of the boundary sites come from the halos
+template <typename Float>
+static bool checkStar(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nVec){
+
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> disp(geomP, gauge, cpuPrec);
+
+  std::vector<DisplaceFlag> flags;
+  for(int f=0;f<N_DISPLACE_FLAGS;f++) flags.push_back(static_cast<DisplaceFlag>(f));
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomP, nVec, true), dst = newFields<Float>(geomP, nVec);
+  std::vector<std::vector<HostColorSpinorField<Float>*>> star(N_DISPLACE_FLAGS);
+  for(auto &s: star) s = newFields<Float>(geomP, nVec);
+
+  StoreStarSink<Float> store(star, nVec);
+  disp.doStarDisplacement(src, flags, store);
+
+  int nMismatch = 0;
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    disp.doVectorDisplacement(dst, src, displaceFlagDir(flags[f]), displaceFlagSign(flags[f]));
+    nMismatch += countMismatch(star[f], dst);
+  }
+
+  deleteFields(src);
+  deleteFields(dst);
+  for(auto &s: star) deleteFields(s);
+
+  return nMismatch == 0;
+}
+
+
+//- A block of vectors displaced in one step with the straight Wilson lines of lengths 1,...,L must agree with the
+//- hop-by-hop displacements up to rounding, the lines being products of the same links. On the self-partitioned
+//- lattice all the lengths of an entry, longest first, take one halo exchange instead of one per hop
+template <typename Float>
+static double checkWilsonLines(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nVec, long long &nMsgHop,
+			       long long &nMsgLine, size_t &lineBytes){
+
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> disp(geomP, gauge, cpuPrec);
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomP, nVec, true);
+  std::vector<HostColorSpinorField<Float>*> ref = newFields<Float>(geomP, nVec), tmp = newFields<Float>(geomP, nVec);
+  std::vector<HostColorSpinorField<Float>*> dst = newFields<Float>(geomP, nVec);
+
+  int maxLen[N_DISPLACE_FLAGS];
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    maxLen[f] = std::min(4, geom.lL[f/2]);
+    for(int l=1;l<=maxLen[f];l++) disp.addWilsonLine(static_cast<DisplaceFlag>(f), l);
+  }
+  disp.computeWilsonLines();
+  lineBytes = disp.WilsonLineBytes();
+
+  HostHaloExchange<Float> &halo = disp.getHalo();
+  const long long nBatch = (nVec + disp.BatchSize() - 1) / disp.BatchSize();
+  double maxDev = 0.0;
+  nMsgHop = nMsgLine = 0;
+  for(int f=0;f<N_DISPLACE_FLAGS;f++){
+    const DisplaceFlag flag = static_cast<DisplaceFlag>(f);
+
+    //- Hop by hop, every length against its line
+    for(int i=0;i<nVec;i++) ref[i]->copy(*src[i]);
+    for(int l=1;l<=maxLen[f];l++){
+      halo.resetCounters();
+      disp.doVectorDisplacement(tmp, ref, displaceFlagDir(flag), displaceFlagSign(flag));
+      nMsgHop += halo.Messages();
+      std::swap(tmp, ref);
+      disp.doWilsonLineDisplacement(dst, src, flag, l);
+      for(int i=0;i<nVec;i++) maxDev = std::max(maxDev, maxDeviation(*ref[i], *dst[i]));
+    }
+
+    //- All the lengths of an entry with one exchange and one step per length
+    halo.resetCounters();
+    for(int l=maxLen[f];l>=1;l--)
+      disp.doWilsonLineDisplacement(dst, src, flag, l, (l == maxLen[f]) ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE);
+    nMsgLine += halo.Messages();
+    if(halo.Messages() != nBatch) maxDev = std::max(maxDev, 1.0);
+  }
+
+  deleteFields(src);
+  deleteFields(ref);
+  deleteFields(tmp);
+  deleteFields(dst);
+
+  return maxDev;
+}
+
+
+//- Displacements with compressed links (reconstruct-12/8) must agree with the uncompressed ones up to rounding, on
+//- the self-partitioned lattice so that the links of the ghost zone are reconstructed as well
+template <typename Float>
+static double checkRecon(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, QudaReconstructType recon,
+			 int &linkLen, int &linkLenRecon){
+
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> disp(geomP, gauge, cpuPrec);
+  DisplaceHost<Float> dispRecon(geomP, gauge, cpuPrec, MUGIQ_BOOL_TRUE, recon);
+  linkLen = disp.getGauge().LinkLength();
+  linkLenRecon = dispRecon.getGauge().LinkLength();
+
+  std::vector<HostColorSpinorField<Float>*> src = newFields<Float>(geomP, 1, true);
+  HostColorSpinorField<Float> dstRef(geomP);
+  HostColorSpinorField<Float> dst(geomP);
+
+  double maxDev = 0.0;
+  for(int f=0;f<2*N_DIM_;f++){
+    DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+    DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+    disp.doVectorDisplacement(dstRef, *src[0], dir, sign);
+    dispRecon.doVectorDisplacement(dst, *src[0], dir, sign);
+    maxDev = std::max(maxDev, maxDeviation(dstRef, dst));
+  }
+  deleteFields(src);
+
+  return maxDev;
+}
+
+
+//- With every dimension partitioned onto the process itself, the boundary sites come from the halo exchange: the
+//- displacements must reproduce those of the periodic local lattice bit by bit, blocking and overlapping, and with
+//- the messages split in chunks. Each displacement sends the face of one vector, in ceil(face/maxMsgLen) messages
+template <typename Float>
+static bool checkHaloExchange(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, long long &nMsg, long long &nBytes){
+
+  const HostGeom geomL = selfGeom(geom, false);
+  const HostGeom geomP = selfGeom(geom, true);
+  DisplaceHost<Float> dispL(geomL, gauge, cpuPrec);
+  DisplaceHost<Float> dispP(geomP, gauge, cpuPrec);
+
+  std::vector<HostColorSpinorField<Float>*> srcL = newFields<Float>(geomL, 1, true), dstL = newFields<Float>(geomL, 1);
+  std::vector<HostColorSpinorField<Float>*> srcP = newFields<Float>(geomP, 1), dstP = newFields<Float>(geomP, 1);
+  srcP[0]->copy(*srcL[0]);
+
+  HostHaloExchange<Float> &halo = dispP.getHalo();
+  long long nMsgExpect = 0, nBytesExpect = 0;
+  int nMismatch = 0;
+  for(int split=0;split<2;split++)
+    for(int overlap=0;overlap<2;overlap++){
+      dispP.setOverlapComms(overlap ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE);
+      for(int f=0;f<2*N_DIM_;f++){
+	DisplaceDir  dir  = static_cast<DisplaceDir>(f/2);
+	DisplaceSign sign = (f%2 == 0) ? DispSignPlus : DispSignMinus;
+	const long long faceLen = static_cast<long long>(geom.faceVolume[f/2]) * SPINOR_SITE_LEN_;
+	const long long maxMsgLen = split ? faceLen/3 + 1 : INT_MAX;
+	halo.setMaxMessageLength(maxMsgLen);
+	dispL.doVectorDisplacement(*dstL[0], *srcL[0], dir, sign);
+	dispP.doVectorDisplacement(*dstP[0], *srcP[0], dir, sign);
+	nMismatch += countMismatch(dstL, dstP);
+	nMsgExpect += (faceLen + maxMsgLen - 1) / maxMsgLen;
+	nBytesExpect += faceLen * sizeof(std::complex<Float>);
+      }
+    }
+  nMsg = halo.Messages();
+  nBytes = halo.MessageBytes();
+
+  deleteFields(srcL);
+  deleteFields(dstL);
+  deleteFields(srcP);
+  deleteFields(dstP);
+
+  return nMismatch == 0 && nMsg == nMsgExpect && nBytes == nBytesExpect;
+}
+
+
+template <typename Float>
+static void hostDisplaceTest(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec){
+
+  const double tol = hostTolerance<Float>();
+
+  DisplaceHost<Float> disp(geom, gauge, cpuPrec);
+
+  HostColorSpinorField<Float> src(geom);
+  HostColorSpinorField<Float> tmp(geom);
+  HostColorSpinorField<Float> dst(geom);
+  fillRandom(src);
+
+  double devBlk = 0.0, devOvl = 0.0;
+  DisplaceProfile blk = runDisplacements<Float>(disp, src, tmp, dst, MUGIQ_BOOL_FALSE, host_niter, devBlk);
+  DisplaceProfile ovl = runDisplacements<Float>(disp, src, tmp, dst, MUGIQ_BOOL_TRUE,  host_niter, devOvl);
+
+  blk.print("Blocking halo exchange");
+  ovl.print("Overlapping halo exchange");
+  printfQuda("Communication hidden behind the interior stencil: %e sec (%.1f%%)\n",
+	     blk.wait - ovl.wait, blk.wait > 0 ? 100.0 * (blk.wait - ovl.wait) / blk.wait : 0.0);
+
+  printfQuda("Max deviation of U^\\dag U V from V: blocking = %e , overlapping = %e\n", devBlk, devOvl);
+  if(devBlk > tol || devOvl > tol) errorQuda("Host displacement check FAILED (tolerance = %e)\n", tol);
+
+  long long nMsg = 0, nBytes = 0;
+  const bool haloPass = checkHaloExchange<Float>(geom, gauge, cpuPrec, nMsg, nBytes);
+  reportCheck(haloPass, "halo exchange",
+	      "Displacements through the halo exchange are bit-identical to the local ones, in " + std::to_string(nMsg) +
+	      " messages of " + std::to_string(nBytes) + " bytes, whole and split");
+
+  reportCheck(checkNbrTable<Float>(geom, gauge, cpuPrec), "displacement neighbour-table",
+	      "Neighbour-table displacements are bit-identical to the coordinate-based ones, local and through the halo");
+
+  const int nVec = 2*disp.BatchSize() + 1;
+  long long nMsgSingle = 0, nMsgBatch = 0;
+  const bool batchPass = checkBatch<Float>(geom, gauge, cpuPrec, nVec, nMsgSingle, nMsgBatch);
+  reportCheck(batchPass, "batched displacement",
+	      "Batched displacements of " + std::to_string(nVec) + " vectors (batch size " + std::to_string(disp.BatchSize()) +
+	      ") are bit-identical to the single-vector ones, in " + std::to_string(nMsgBatch) + " messages instead of " +
+	      std::to_string(nMsgSingle));
+
+  int nHop = 0;
+  long long nHopNaive = 0;
+  const bool triePass = checkPathTrie<Float>(disp, geom, nHop, nHopNaive);
+  reportCheck(triePass, "displacement path trie",
+	      "Displacement path trie walk is bit-identical to the straight displacements, in " + std::to_string(nHop) +
+	      " hops per vector instead of " + std::to_string(nHopNaive));
+
+  long long nMsgHop = 0, nMsgLine = 0;
+  size_t lineBytes = 0;
+  const double devLine = checkWilsonLines<Float>(geom, gauge, cpuPrec, disp.BatchSize(), nMsgHop, nMsgLine, lineBytes);
+  reportDeviation(devLine, tol, "Wilson-line displacement", "deviation of the Wilson-line displacements from the hop-by-hop ones");
+  printfQuda("Wilson-line tables of %.1f MB, the displacements of all lengths take %lld messages instead of %lld\n",
+	     lineBytes / (1024.0*1024.0), nMsgLine, nMsgHop);
+
+  //- The reconstruction from 8 parameters divides by 1 - |U(0,0)|^2, which amplifies the rounding errors
+  for(QudaReconstructType recon : {QUDA_RECONSTRUCT_12, QUDA_RECONSTRUCT_8}){
+    const std::string reconStr = std::to_string(recon == QUDA_RECONSTRUCT_12 ? 12 : 8);
+    int linkLen = 0, linkLenRecon = 0;
+    const double devRecon = checkRecon<Float>(geom, gauge, cpuPrec, recon, linkLen, linkLenRecon);
+    reportDeviation(devRecon, 10*tol, "compressed-link displacement",
+		    "deviation of the displacements with reconstruct-" + reconStr + " links from the uncompressed ones");
+    if(2*linkLenRecon != static_cast<int>(recon)) errorQuda("Host compressed-link displacement check FAILED\n");
+    printfQuda("Reconstruct-%s links take %d reals instead of %d\n", reconStr.c_str(), 2*linkLenRecon, 2*linkLen);
+  }
+
+  reportCheck(checkSymmetric<Float>(geom, gauge, cpuPrec, disp.BatchSize()), "fused +/- displacement",
+	      "Fused +/- displacements and symmetric derivatives are bit-identical to the separate displacements");
+
+  reportCheck(checkStar<Float>(geom, gauge, cpuPrec, disp.BatchSize()), "star-stencil",
+	      "Star-stencil neighbours are bit-identical to the one-hop displacements");
+
+  double bytesCopy = 0.0, bytesRotate = 0.0;
+  reportCheck(checkPingPong<Float>(disp, geom, disp.BatchSize(), bytesCopy, bytesRotate), "in-place hop",
+	      "In-place hops with rotated buffers are bit-identical to the zero-and-copy ones, without copies");
+  printfQuda("Modelled traffic per hop and vector: %.2f MB with zeroing and copies, %.2f MB with rotated buffers (%.1fx less)\n",
+	     bytesCopy / (1024.0*1024.0), bytesRotate / (1024.0*1024.0), bytesRotate > 0 ? bytesCopy / bytesRotate : 0.0);
+
+  printfQuda("Host displacement check PASSED\n");
+}
+
+
+int main(int argc, char **argv)
+{
+  return hostTestMain(argc, argv, hostDisplaceTest<double>, hostDisplaceTest<float>);
+}
@@ -0,0 +1,544 @@
+#include "host_test_mugiq.h"
+#include <eig_host.h>
+#include <dirac_host.h>
+#include <lanczos_host.h>
+
+/*
+ * Checks of the host (CPU) eigensolver side: the batched prolongation, eigenvalues and deflation projection must
+ * agree with the vector-by-vector references, and apply the operator to whole blocks. The dense eigensolver must
+ * give the eigenpairs of the Galerkin coarse operator of a small lattice, and the star-stencil Wilson-clover
+ * operator must agree with a reference from the fused +/- displacements, the full gamma matrices and the unpacked
+ * clover term. The thick-restart Lanczos must find the eigenpairs of the dense solver, with fewer operator
+ * applications when accelerated by a Chebyshev polynomial in a tight Krylov space.
+ */
+
+
+//- Prolongation of one vector by one level from the site coordinates, reference of the batched host prolongator.
+//- The blocking follows from the extents and spins of the two levels
+template <typename Float>
+static void prolongateRef(HostProlongator<Float> &P, int lev, HostColorSpinorField<Float> &out, const HostColorSpinorField<Float> &in){
+  const HostGeom &g = P.Geom(lev);
+  const HostGeom &gc = P.Geom(lev+1);
+  const int nS = P.Nspin(lev), nC = P.Ncolor(lev), nV = P.Ncolor(lev+1);
+  const int spinBlock = nS / P.Nspin(lev+1);
+  const std::complex<Float> *V = P.NullVectors(lev);
+  for(int i=0;i<g.volume;i++){
+    int x[N_DIM_], xc[N_DIM_];
+    const int pty = i / g.volumeCB;
+    g.getCoords(x, i - pty*g.volumeCB, pty);
+    for(int d=0;d<N_DIM_;d++) xc[d] = x[d] / (g.lL[d] / gc.lL[d]);
+    const std::complex<Float> *c = in.Site(gc.siteIndex(xc));
+    for(int s=0;s<nS;s++)
+      for(int col=0;col<nC;col++){
+	std::complex<Float> sum = 0.0;
+	for(int v=0;v<nV;v++) sum += V[((static_cast<long long>(i)*nS + s)*nC + col)*nV + v] * c[(s/spinBlock)*nV + v];
+	out.Site(i)[s*nC + col] = sum;
+      }
+  }
+}
+
+
+//- Restriction of one vector by one level from the site coordinates, the adjoint of prolongateRef
+template <typename Float>
+static void restrictRef(HostProlongator<Float> &P, int lev, HostColorSpinorField<Float> &out, const HostColorSpinorField<Float> &in){
+  const HostGeom &g = P.Geom(lev);
+  const HostGeom &gc = P.Geom(lev+1);
+  const int nS = P.Nspin(lev), nC = P.Ncolor(lev), nV = P.Ncolor(lev+1);
+  const int spinBlock = nS / P.Nspin(lev+1);
+  const std::complex<Float> *V = P.NullVectors(lev);
+  out.zero();
+  for(int i=0;i<g.volume;i++){
+    int x[N_DIM_], xc[N_DIM_];
+    const int pty = i / g.volumeCB;
+    g.getCoords(x, i - pty*g.volumeCB, pty);
+    for(int d=0;d<N_DIM_;d++) xc[d] = x[d] / (g.lL[d] / gc.lL[d]);
+    std::complex<Float> *c = out.Site(gc.siteIndex(xc));
+    for(int s=0;s<nS;s++)
+      for(int col=0;col<nC;col++)
+	for(int v=0;v<nV;v++)
+	  c[(s/spinBlock)*nV + v] += std::conj(V[((static_cast<long long>(i)*nS + s)*nC + col)*nV + v]) * in.Site(i)[s*nC + col];
+  }
+}
+
+
+//- The batched prolongation through a two-level chain must agree with the vector-by-vector one
+template <typename Float>
+static double checkProlongation(const HostGeom &geom, int nVec){
+
+  HostProlongator<Float> *P = randomProlongator<Float>(geom);
+  const int nLevel = P->NLevel();
+
+  std::vector<HostColorSpinorField<Float>*> coarse = newFields<Float>(P->Geom(nLevel), nVec, true, P->Nspin(nLevel), P->Ncolor(nLevel));
+  std::vector<HostColorSpinorField<Float>*> fine = newFields<Float>(geom, nVec), fineRef = newFields<Float>(geom, nVec);
+  HostColorSpinorField<Float> midRef(P->Geom(1), P->Nspin(1), P->Ncolor(1));
+  for(int i=0;i<nVec;i++){
+    prolongateRef(*P, 1, midRef, *coarse[i]);
+    prolongateRef(*P, 0, *fineRef[i], midRef);
+  }
+
+  P->prolongate(fine, coarse);
+  double dev = 0.0;
+  for(int i=0;i<nVec;i++) dev = std::max(dev, maxDeviation(*fine[i], *fineRef[i]));
+
+  deleteFields(coarse);
+  deleteFields(fine);
+  deleteFields(fineRef);
+  delete P;
+
+  return dev;
+}
+
+
+//- The batched eigenvalues and residuals must agree with those of one vector at a time: apply, inner product, norm,
+//- axpby and norm, each with its own global reduction. The operator must be applied once per block of nBatch vectors
+template <typename Float>
+static double checkEvalsBlock(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nEv, long long &nApply){
+
+  HostLaplaceOperator<Float> op(geom, gauge, cpuPrec, 0.1);
+  HostCountingOperator<Float> opCount(op);
+
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(geom, nEv, true);
+
+  std::vector<std::complex<double>> lambdaRef(nEv), lambda;
+  std::vector<double> resRef(nEv), res;
+  HostColorSpinorField<Float> w(geom);
+  std::vector<HostColorSpinorField<Float>*> w1(1, &w);
+
+  for(int n=0;n<nEv;n++){
+    std::vector<HostColorSpinorField<Float>*> v1(1, eVecs[n]);
+    op.apply(w1, v1);
+    std::complex<double> dot = 0.0;
+    for(long long i=0;i<w.Length();i++) dot += std::conj(std::complex<double>(eVecs[n]->V()[i])) * std::complex<double>(w.V()[i]);
+    MPI_Allreduce(MPI_IN_PLACE, &dot, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    double nrm = eVecs[n]->norm2Local();
+    MPI_Allreduce(MPI_IN_PLACE, &nrm, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    lambdaRef[n] = dot / std::sqrt(nrm);
+    const std::complex<Float> lam(lambdaRef[n]);
+    for(long long i=0;i<w.Length();i++) w.V()[i] = lam * eVecs[n]->V()[i] - w.V()[i];
+    double r2 = w.norm2Local();
+    MPI_Allreduce(MPI_IN_PLACE, &r2, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    resRef[n] = std::sqrt(r2);
+  }
+
+  computeEvalsHost<Float>(opCount, eVecs, lambda, res);
+  nApply = opCount.nApply;
+
+  double dev = 0.0;
+  for(int n=0;n<nEv;n++){
+    dev = std::max(dev, std::abs(lambda[n] - lambdaRef[n]) / std::abs(lambdaRef[n]));
+    dev = std::max(dev, std::abs(res[n] - resRef[n]) / resRef[n]);
+  }
+  if(opCount.nVec != nEv) dev = std::max(dev, 1.0);
+
+  deleteFields(eVecs);
+
+  return dev;
+}
+
+
+//- The multi-source host projection must agree with a source-by-source one from the coordinate-based transfer
+//- operators and plain inner products, and with compressed eigenvectors with the projection of the decoded ones.
+//- The operator must be applied once per block of PROJECT_BATCH_HOST_ sources
+template <typename Float>
+static double checkProjection(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int nSrc, long long &nApply){
+
+  HostLaplaceOperator<Float> op(geom, gauge, cpuPrec, 0.1);
+  HostCountingOperator<Float> opCount(op);
+  HostProlongator<Float> *P = randomProlongator<Float>(geom);
+  const int nLevel = P->NLevel();
+  const HostGeom &gC = P->Geom(nLevel);
+
+  const int nEv = 7;
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(gC, nEv, true, P->Nspin(nLevel), P->Ncolor(nLevel));
+  std::vector<std::complex<double>> evals;
+  for(int i=0;i<nEv;i++) evals.push_back(std::complex<double>(1.0 + i, 0.5 - 0.1*i));
+
+  std::vector<HostColorSpinorField<Float>*> in = newFields<Float>(geom, nSrc, true);
+  std::vector<HostColorSpinorField<Float>*> out = newFields<Float>(geom, nSrc), outRef = newFields<Float>(geom, nSrc);
+
+  HostColorSpinorField<Float> Min(geom), mid(P->Geom(1), P->Nspin(1), P->Ncolor(1));
+  HostColorSpinorField<Float> Mc(gC, P->Nspin(nLevel), P->Ncolor(nLevel));
+  for(int j=0;j<nSrc;j++){
+    std::vector<HostColorSpinorField<Float>*> o1(1, &Min), i1(1, in[j]);
+    op.apply(o1, i1);
+    restrictRef(*P, 0, mid, Min);
+    restrictRef(*P, 1, Mc, mid);
+    std::vector<std::complex<double>> sRef(nEv);
+    for(int i=0;i<nEv;i++){
+      std::complex<double> d = 0.0;
+      for(long long e=0;e<Mc.Length();e++) d += std::conj(std::complex<double>(eVecs[i]->V()[e])) * std::complex<double>(Mc.V()[e]);
+      sRef[i] = d;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, sRef.data(), 2*nEv, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    Mc.zero();
+    for(int i=0;i<nEv;i++){
+      const std::complex<Float> a(sRef[i] / evals[i]);
+      for(long long e=0;e<Mc.Length();e++) Mc.V()[e] += a * eVecs[i]->V()[e];
+    }
+    prolongateRef(*P, 1, mid, Mc);
+    prolongateRef(*P, 0, *outRef[j], mid);
+  }
+
+  {
+    HostProjector<Float> proj(opCount, P, eVecs, evals);
+    proj.projectVectors(out, in);
+  }
+  nApply = opCount.nApply;
+  double dev[2] = {0.0, 0.0};
+  for(int j=0;j<nSrc;j++){
+    dev[0] = std::max(dev[0], maxDeviation(*out[j], *outRef[j]));
+    for(long long e=0;e<outRef[j]->Length();e++) dev[1] = std::max(dev[1], (double)std::abs(outRef[j]->V()[e]));
+  }
+  if(opCount.nVec != nSrc) dev[0] = std::max(dev[0], 1.0);
+
+  //- With compressed eigenvectors, decoded on the fly, the projection must agree with the one of the decoded fields
+  std::vector<HostCompressedField<Float>*> eVecsC;
+  std::vector<HostColorSpinorField<Float>*> eVecsD = newFields<Float>(gC, nEv, false, P->Nspin(nLevel), P->Ncolor(nLevel));
+  for(int i=0;i<nEv;i++){
+    eVecsC.push_back(new HostCompressedField<Float>(gC, MUGIQ_EVEC_COMPRESS_HALF, P->Nspin(nLevel), P->Ncolor(nLevel)));
+    eVecsC[i]->encode(*eVecs[i]);
+    eVecsC[i]->decode(*eVecsD[i]);
+  }
+  {
+    HostProjector<Float> projC(op, P, eVecsC, evals), projD(op, P, eVecsD, evals);
+    projC.projectVectors(out, in);
+    projD.projectVectors(outRef, in);
+    for(int j=0;j<nSrc;j++) dev[0] = std::max(dev[0], maxDeviation(*out[j], *outRef[j]));
+  }
+  for(auto v: eVecsC) delete v;
+  deleteFields(eVecsD);
+
+  deleteFields(eVecs);
+  deleteFields(in);
+  deleteFields(out);
+  deleteFields(outRef);
+  delete P;
+
+  double devGlobal[2];
+  MPI_Allreduce(dev, devGlobal, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return devGlobal[1] > 0 ? devGlobal[0] / devGlobal[1] : devGlobal[0];
+}
+
+
+//- The dense eigenpairs of a small coarse operator must be orthonormal, in ascending order, agree with the Rayleigh
+//- quotients of the eigenvectors and have small residuals, all relative to the largest eigenvalue
+template <typename Float>
+static double checkDenseEigsolve(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int &nEv, long long &dim){
+
+  HostLaplaceOperator<Float> op(geom, gauge, cpuPrec, 0.1);
+  HostProlongator<Float> *P = randomProlongator<Float>(geom);
+  HostGalerkinOperator<Float> opC(op, *P);
+
+  int nRanks = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+  const HostGeom &gC = opC.Geom();
+  dim = static_cast<long long>(gC.volume) * opC.Nspin() * opC.Ncolor() * nRanks;
+  nEv = static_cast<int>(dim / 4);
+  //- Without LAPACK the dense solver is only selected for small operators, larger lattices skip the check
+  if(!denseEigSelected(nEv, dim)){
+    nEv = 0;
+    delete P;
+    return 0.0;
+  }
+
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(gC, nEv, false, opC.Nspin(), opC.Ncolor());
+  std::vector<double> evals;
+  eigsolveDenseHost(opC, eVecs, evals, MUGIQ_SPECTRUM_SR);
+
+  std::vector<std::complex<double>> lambda;
+  std::vector<double> res;
+  computeEvalsHost(opC, eVecs, lambda, res);
+
+  std::vector<std::complex<double>> gram(static_cast<size_t>(nEv) * nEv, 0.0);
+  for(int i=0;i<nEv;i++)
+    for(int j=0;j<nEv;j++)
+      for(long long e=0;e<eVecs[i]->Length();e++)
+	gram[i*nEv + j] += std::conj(std::complex<double>(eVecs[i]->V()[e])) * std::complex<double>(eVecs[j]->V()[e]);
+  MPI_Allreduce(MPI_IN_PLACE, gram.data(), 2*nEv*nEv, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  double evMax = 0.0, dev = 0.0;
+  for(int i=0;i<nEv;i++) evMax = std::max(evMax, std::abs(evals[i]));
+  for(int i=0;i<nEv;i++){
+    dev = std::max(dev, std::abs(lambda[i] - evals[i]) / evMax);
+    dev = std::max(dev, res[i] / evMax);
+    if(i > 0 && evals[i] < evals[i-1]) dev = std::max(dev, (evals[i-1] - evals[i]) / evMax);
+    for(int j=0;j<nEv;j++) dev = std::max(dev, std::abs(gram[i*nEv + j] - (i == j ? 1.0 : 0.0)));
+  }
+
+  deleteFields(eVecs);
+  delete P;
+
+  return dev;
+}
+
+
+//- Gamma matrices of the DeGrand-Rossi basis as full 4x4 matrices, gammaDR[mu][row][col]
+static const std::complex<double> I_(0.0, 1.0);
+static const std::complex<double> gammaDR[N_DIM_][N_SPIN_][N_SPIN_] = {
+  {{0, 0, 0, I_}, {0, 0, I_, 0}, {0, -I_, 0, 0}, {-I_, 0, 0, 0}},
+  {{0, 0, 0, -1}, {0, 0, 1, 0}, {0, 1, 0, 0}, {-1, 0, 0, 0}},
+  {{0, 0, I_, 0}, {0, 0, 0, -I_}, {-I_, 0, 0, 0}, {0, I_, 0, 0}},
+  {{0, 0, 1, 0}, {0, 0, 0, 1}, {1, 0, 0, 0}, {0, 1, 0, 0}}};
+
+
+//- Wilson-clover operator from the fused +/- displacements, the full gamma matrices and the unpacked clover term,
+//- reference of the star-stencil host operator
+template <typename Float>
+static void wilsonCloverRef(HostWilsonCloverOperator<Float> &op, const std::vector<Float> &clover,
+			    std::vector<HostColorSpinorField<Float>*> &out, std::vector<HostColorSpinorField<Float>*> &in,
+			    std::vector<HostColorSpinorField<Float>*> &dP, std::vector<HostColorSpinorField<Float>*> &dM, bool dagger){
+
+  const HostGeom &geom = op.Geom();
+  const double sgn = dagger ? -1.0 : 1.0;
+  for(size_t j=0;j<in.size();j++)
+    for(int i=0;i<geom.volume;i++){
+      const std::complex<Float> *x = in[j]->Site(i);
+      std::complex<Float> *y = out[j]->Site(i);
+      for(int a=0;a<SPINOR_SITE_LEN_;a++){
+	if(clover.empty()){ y[a] = x[a]; continue; }
+	//- Element (a,b) of the clover term: zero across the chiral blocks, diagonal, lower triangle or its conjugate
+	std::complex<double> sum = 0.0;
+	const int b0 = (a / 6) * 6;
+	const Float *cl = clover.data() + static_cast<size_t>(i)*CLOVER_SITE_LEN_ + (a / 6)*36;
+	for(int b=b0;b<b0+6;b++){
+	  const int ia = a - b0, ib = b - b0;
+	  std::complex<double> A;
+	  if(ia == ib) A = cl[ia];
+	  else if(ia > ib) A = std::complex<double>(cl[6 + 2*(ia*(ia-1)/2 + ib)], cl[6 + 2*(ia*(ia-1)/2 + ib) + 1]);
+	  else A = std::conj(std::complex<double>(cl[6 + 2*(ib*(ib-1)/2 + ia)], cl[6 + 2*(ib*(ib-1)/2 + ia) + 1]));
+	  sum += A * std::complex<double>(x[b]);
+	}
+	y[a] = std::complex<Float>(sum);
+      }
+    }
+
+  for(int mu=0;mu<N_DIM_;mu++){
+    op.getDisplace().doSymmetricDisplacement(dP, dM, in, static_cast<DisplaceDir>(mu), DISPLACE_SYM_PAIR);
+    for(size_t j=0;j<in.size();j++)
+      for(int i=0;i<geom.volume;i++)
+	for(int s=0;s<N_SPIN_;s++)
+	  for(int c=0;c<N_COLOR_;c++){
+	    std::complex<double> h = 0.0;
+	    for(int t=0;t<N_SPIN_;t++){
+	      const std::complex<double> g = sgn * gammaDR[mu][s][t];
+	      const std::complex<double> wp(dP[j]->Site(i)[SPINOR_SITE_IDX(t,c)]), wm(dM[j]->Site(i)[SPINOR_SITE_IDX(t,c)]);
+	      h += ((s == t ? 1.0 : 0.0) - g) * wp + ((s == t ? 1.0 : 0.0) + g) * wm;
+	    }
+	    out[j]->Site(i)[SPINOR_SITE_IDX(s,c)] -= std::complex<Float>(static_cast<double>(op.Kappa()) * h);
+	  }
+  }
+}
+
+
+//- The star-stencil Wilson-clover operator must agree with the reference, be the adjoint of its dagger, reduce to
+//- 1 - 8 kappa on constant vectors of the free field, and give real eigenvalues of gamma_5 M; the gamma matrices of the
+//- reference must satisfy the Clifford algebra, with gamma_5 = gamma_x gamma_y gamma_z gamma_t = diag(1,1,-1,-1).
+//- The operator acts on the self-partitioned lattice, so that the neighbours of the boundary sites come from the halos
+template <typename Float>
+static double checkWilsonClover(const HostGeom &geomIn, void *gauge[], QudaPrecision cpuPrec){
+
+  const HostGeom geom = selfGeom(geomIn, true);
+
+  double dev = 0.0;
+  for(int mu=0;mu<N_DIM_;mu++)
+    for(int nu=0;nu<N_DIM_;nu++)
+      for(int a=0;a<N_SPIN_;a++)
+	for(int b=0;b<N_SPIN_;b++){
+	  std::complex<double> ac = 0.0;
+	  for(int t=0;t<N_SPIN_;t++) ac += gammaDR[mu][a][t]*gammaDR[nu][t][b] + gammaDR[nu][a][t]*gammaDR[mu][t][b];
+	  dev = std::max(dev, std::abs(ac - (mu == nu && a == b ? 2.0 : 0.0)));
+	}
+  for(int a=0;a<N_SPIN_;a++)
+    for(int b=0;b<N_SPIN_;b++){
+      std::complex<double> g5 = 0.0;
+      for(int t=0;t<N_SPIN_;t++)
+	for(int u=0;u<N_SPIN_;u++)
+	  for(int v=0;v<N_SPIN_;v++) g5 += gammaDR[0][a][t]*gammaDR[1][t][u]*gammaDR[2][u][v]*gammaDR[3][v][b];
+      dev = std::max(dev, std::abs(g5 - (a == b ? (a < 2 ? 1.0 : -1.0) : 0.0)));
+    }
+
+  //- Random clover term with a dominant diagonal
+  std::vector<Float> clover(static_cast<size_t>(geom.volume) * CLOVER_SITE_LEN_);
+  for(size_t i=0;i<clover.size();i++) clover[i] = (i % 36 < 6) ? 1.0 + 0.2*(rand() / (double)RAND_MAX) : 0.05*(rand() / (double)RAND_MAX - 0.5);
+  const double kappa = 0.12;
+  const QudaPrecision prec = (sizeof(Float) == sizeof(double)) ? QUDA_DOUBLE_PRECISION : QUDA_SINGLE_PRECISION;
+  HostWilsonCloverOperator<Float> op(geom, gauge, cpuPrec, kappa);
+  op.loadClover(clover.data(), prec);
+
+  const int nVec = op.getDisplace().BatchSize() + 1;
+  std::vector<HostColorSpinorField<Float>*> x = newFields<Float>(geom, nVec, true), y = newFields<Float>(geom, nVec, true);
+  std::vector<HostColorSpinorField<Float>*> z = newFields<Float>(geom, nVec), ref = newFields<Float>(geom, nVec);
+  std::vector<HostColorSpinorField<Float>*> dP = newFields<Float>(geom, nVec), dM = newFields<Float>(geom, nVec);
+
+  double scale = 0.0;
+  for(int dagger=0;dagger<2;dagger++){
+    op.applyM(z, x, dagger);
+    wilsonCloverRef(op, clover, ref, x, dP, dM, dagger);
+    for(int j=0;j<nVec;j++){
+      dev = std::max(dev, maxDeviation(*z[j], *ref[j]));
+      for(long long e=0;e<ref[j]->Length();e++) scale = std::max(scale, (double)std::abs(ref[j]->V()[e]));
+    }
+  }
+
+  //- (x, M y) = (Mdag x, y)
+  op.applyM(z, y, false);
+  op.applyM(ref, x, true);
+  double adj[2] = {0.0, 0.0};
+  for(int j=0;j<nVec;j++){
+    std::complex<double> d[2] = {0.0, 0.0};
+    for(long long e=0;e<x[j]->Length();e++){
+      d[0] += std::conj(std::complex<double>(x[j]->V()[e])) * std::complex<double>(z[j]->V()[e]);
+      d[1] += std::conj(std::complex<double>(ref[j]->V()[e])) * std::complex<double>(y[j]->V()[e]);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, d, 4, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    adj[0] = std::max(adj[0], std::abs(d[0] - d[1]));
+    adj[1] = std::max(adj[1], std::abs(d[0]));
+  }
+
+  //- Eigenvalues of gamma_5 M, which is Hermitian
+  op.setOperator(MUGIQ_EIG_OPERATOR_M, MUGIQ_BOOL_TRUE);
+  std::vector<std::complex<double>> lambda;
+  std::vector<double> res;
+  computeEvalsHost(op, x, lambda, res);
+  double imLambda = 0.0;
+  for(auto l: lambda) imLambda = std::max(imLambda, std::abs(l.imag()) / std::abs(l));
+  op.setOperator(MUGIQ_EIG_OPERATOR_M);
+
+  //- Free field
+  std::vector<Float> unit[N_DIM_];
+  void *unitPtr[N_DIM_];
+  for(int mu=0;mu<N_DIM_;mu++){
+    unit[mu].assign(static_cast<size_t>(geom.volume) * 2*GAUGE_SITE_LEN_, 0.0);
+    for(int i=0;i<geom.volume;i++)
+      for(int c=0;c<N_COLOR_;c++) unit[mu][static_cast<size_t>(i)*2*GAUGE_SITE_LEN_ + 2*GAUGE_SITE_IDX(c,c)] = 1.0;
+    unitPtr[mu] = unit[mu].data();
+  }
+  HostWilsonCloverOperator<Float> free(geom, unitPtr, prec, kappa);
+  std::complex<Float> cst[SPINOR_SITE_LEN_];
+  for(int a=0;a<SPINOR_SITE_LEN_;a++) cst[a] = std::complex<Float>(0.1*a, 1.0 - 0.05*a);
+  for(int i=0;i<geom.volume;i++) std::copy(cst, cst + SPINOR_SITE_LEN_, x[0]->Site(i));
+  std::vector<HostColorSpinorField<Float>*> x0(1, x[0]), z0(1, z[0]);
+  free.apply(z0, x0);
+  for(int i=0;i<geom.volume;i++)
+    for(int a=0;a<SPINOR_SITE_LEN_;a++)
+      dev = std::max(dev, std::abs(std::complex<double>(z[0]->Site(i)[a]) - (1.0 - 8*kappa) * std::complex<double>(cst[a])));
+
+  for(auto v: {&x, &y, &z, &ref, &dP, &dM}) deleteFields(*v);
+
+  dev = std::max(dev / std::max(scale, 1.0), std::max(adj[0] / adj[1], imLambda));
+  double devGlobal = 0.0;
+  MPI_Allreduce(&dev, &devGlobal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return devGlobal;
+}
+
+
+//- The thick-restart Lanczos, plain and with Chebyshev acceleration, must find the smallest eigenvalues of a small
+//- coarse operator given by the dense solver, with small residuals, relative to the largest eigenvalue. The Krylov
+//- space holds 1.5 nEv vectors, where the polynomials of even and odd degree must take fewer operator applications
+//- than plain Lanczos
+template <typename Float>
+static double checkLanczos(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, double lanczosTol,
+			   const int polyDeg[3], long long nOp[3], int nRestart[3]){
+
+  HostLaplaceOperator<Float> op(geom, gauge, cpuPrec, 0.1);
+  HostProlongator<Float> *P = randomProlongator<Float>(geom);
+  HostGalerkinOperator<Float> opC(op, *P);
+  const HostGeom &gC = opC.Geom();
+
+  int nRanks = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+  const int dim = gC.volume * opC.Nspin() * opC.Ncolor() * nRanks;
+  std::vector<HostColorSpinorField<Float>*> all = newFields<Float>(gC, dim, false, opC.Nspin(), opC.Ncolor());
+  std::vector<double> evalsDense;
+  eigsolveDenseHost(opC, all, evalsDense, MUGIQ_SPECTRUM_SR);
+  deleteFields(all);
+  const double evMax = std::max(std::abs(evalsDense.front()), std::abs(evalsDense.back()));
+
+  HostLanczosParam param;
+  param.nEv = 8;
+  param.nKr = param.nEv + param.nEv/2;
+  param.tol = lanczosTol;
+  param.spectrum = MUGIQ_SPECTRUM_SR;
+  param.a_min = evalsDense[2*param.nEv];
+  param.a_max = 1.05 * evalsDense.back();
+
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(gC, param.nEv, false, opC.Nspin(), opC.Ncolor());
+
+  double dev = 0.0;
+  for(int p=0;p<3;p++){
+    param.use_poly_acc = polyDeg[p] ? MUGIQ_BOOL_TRUE : MUGIQ_BOOL_FALSE;
+    param.poly_acc_deg = polyDeg[p];
+
+    HostLanczos<Float> lanczos(opC, param);
+    std::vector<double> evals, res;
+    lanczos.solve(eVecs, evals, res);
+    nOp[p] = lanczos.OpApplications();
+    nRestart[p] = lanczos.Restarts();
+    if(lanczos.Converged() < param.nEv) dev = std::max(dev, 1.0);
+    for(int i=0;i<param.nEv;i++){
+      dev = std::max(dev, std::abs(evals[i] - evalsDense[i]) / evMax);
+      dev = std::max(dev, res[i] / evMax);
+    }
+  }
+
+  deleteFields(eVecs);
+  delete P;
+
+  return dev;
+}
+
+
+template <typename Float>
+static void hostEigTest(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec){
+
+  const double tol = hostTolerance<Float>();
+
+  const double devProlong = checkProlongation<Float>(geom, DISPLACE_BATCH_HOST_);
+  reportDeviation(devProlong, tol, "batched prolongation", "deviation of the batched host prolongation from the vector-by-vector one");
+
+  const int nEv = 2*EVALS_BATCH_HOST_ + 3;
+  long long nApply = 0;
+  const double devEvals = checkEvalsBlock<Float>(geom, gauge, cpuPrec, nEv, nApply);
+  reportDeviation(devEvals, tol, "batched eigenvalue",
+		  "relative deviation of the batched eigenvalues and residuals from the vector-by-vector ones");
+  reportCheck(nApply == (nEv + EVALS_BATCH_HOST_ - 1) / EVALS_BATCH_HOST_, "batched eigenvalue",
+	      "The eigenvalues of " + std::to_string(nEv) + " vectors took " + std::to_string(nApply) + " operator applications");
+
+  const int nSrc = PROJECT_BATCH_HOST_ + 3;
+  const double devProj = checkProjection<Float>(geom, gauge, cpuPrec, nSrc, nApply);
+  reportDeviation(devProj, tol, "multi-source projection", "relative deviation of the multi-source projection from the source-by-source reference");
+  reportCheck(nApply == (nSrc + PROJECT_BATCH_HOST_ - 1) / PROJECT_BATCH_HOST_, "multi-source projection",
+	      "The projection of " + std::to_string(nSrc) + " sources took " + std::to_string(nApply) + " operator applications");
+
+  int nEvDense = 0;
+  long long dimDense = 0;
+  const double devDense = checkDenseEigsolve<Float>(geom, gauge, cpuPrec, nEvDense, dimDense);
+  if(nEvDense == 0) printfQuda("The dense solver is not selected for dimension %lld, its check is skipped\n", dimDense);
+  //- The operator is applied in the precision of the fields, the eigenvectors are rounded to it
+  else reportDeviation(devDense, 10*tol, "dense eigensolver", "relative deviation of the dense eigenpairs (" +
+		       std::to_string(nEvDense) + " of dimension " + std::to_string(dimDense) + ") from eigenpairs");
+
+  const double devWilson = checkWilsonClover<Float>(geom, gauge, cpuPrec);
+  reportDeviation(devWilson, 10*tol, "Wilson-clover operator",
+		  "relative deviation of the host Wilson-clover operator from the reference and its identities");
+
+  const double lanczosTol = (sizeof(Float) == sizeof(double)) ? 1e-10 : 1e-4;
+  const int polyDeg[3] = {0, 4, 3};
+  long long nOpLanczos[3] = {0, 0, 0};
+  int nRestartLanczos[3] = {0, 0, 0};
+  const double devLanczos = checkLanczos<Float>(geom, gauge, cpuPrec, lanczosTol, polyDeg, nOpLanczos, nRestartLanczos);
+  reportDeviation(devLanczos, 10*lanczosTol, "thick-restart Lanczos", "relative deviation of the Lanczos eigenpairs from the dense ones");
+  reportCheck(nOpLanczos[1] < nOpLanczos[0] && nOpLanczos[2] < nOpLanczos[0], "Chebyshev-accelerated Lanczos",
+	      "Lanczos operator applications (restarts): " + std::to_string(nOpLanczos[0]) + " (" + std::to_string(nRestartLanczos[0]) +
+	      ") plain, " + std::to_string(nOpLanczos[1]) + " (" + std::to_string(nRestartLanczos[1]) + ") and " +
+	      std::to_string(nOpLanczos[2]) + " (" + std::to_string(nRestartLanczos[2]) + ") with Chebyshev acceleration of degree " +
+	      std::to_string(polyDeg[1]) + " and " + std::to_string(polyDeg[2]));
+
+  printfQuda("Host eigensolver check PASSED\n");
+}
+
+
+int main(int argc, char **argv)
+{
+  return hostTestMain(argc, argv, hostEigTest<double>, hostEigTest<float>);
+}
@@ -0,0 +1,314 @@
+#include "host_test_mugiq.h"
+#include <loop_host.h>
+
+/*
+ * Checks of the host (CPU) loop: the eigenvector-major loop must reproduce the entry-major one, where every trace
+ * displaces each eigenvector from scratch, with fewer displacements, and the loop sessions must take their
+ * eigenpairs from the cache of the same configuration without an eigensolve, or stream its eigenvectors through a
+ * small ring without changing the loop. Compressed eigenvectors decoded on the fly must give exactly what the decoded
+ * fields give, in the loop, the prolongation and the inner products.
+ */
+
+
+//- The eigenvector-major loop, where each eigenvector walks all the displacements once, must reproduce the former
+//- entry-major order, where every trace displaces each eigenvector from scratch. Returns the relative deviation, and
+//- the displacements of a vector each order performs
+template <typename Float>
+static double checkLoopOrder(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, long long &nDispEvMajor,
+			     long long &nDispEntryMajor){
+
+  MugiqLoopParam loopParams = hostLoopParams({"+x", "-t", "+y", "-y"}, {1, 1, 1, 1}, {3, 2, 1, 1});
+  loopParams.disp_path  = {"+x+y-x"};
+  loopParams.disp_deriv = {"z"};
+
+  LoopHost<Float> loop(&loopParams, geom);
+  loop.loadGauge(gauge, cpuPrec);
+
+  const int nEv = DISPLACE_BATCH_HOST_ + 1;
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(geom, nEv, true);
+  std::vector<double> sigma;
+  for(int n=0;n<nEv;n++) sigma.push_back(1.0 + n);
+
+  DisplaceProfile &prof = loop.getDisplace()->getProfile();
+  prof.reset();
+  loop.computeLoop(eVecs, sigma);
+  nDispEvMajor = prof.nCall;
+  const std::vector<std::complex<Float>> evMajor = loop.getPosData();
+
+  prof.reset();
+  loop.computeLoopReference(eVecs, sigma);
+  nDispEntryMajor = prof.nCall;
+
+  const std::vector<std::complex<Float>> &entryMajor = loop.getPosData();
+  double dev[2] = {0.0, 0.0};
+  for(size_t i=0;i<evMajor.size();i++){
+    dev[0] = std::max(dev[0], (double)std::abs(evMajor[i] - entryMajor[i]));
+    dev[1] = std::max(dev[1], (double)std::abs(entryMajor[i]));
+  }
+  double devGlobal[2];
+  MPI_Allreduce(dev, devGlobal, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  deleteFields(eVecs);
+
+  return devGlobal[1] > 0 ? devGlobal[0] / devGlobal[1] : devGlobal[0];
+}
+
+
+//- Eigenpair source of the loop sessions, random vectors counting its calls
+template <typename Float>
+static HostEigenSource<Float> randomEigenSource(int &nSolve){
+  return [&nSolve](void *[], std::vector<HostColorSpinorField<Float>*> &ev, std::vector<double> &sg){
+    nSolve++;
+    for(size_t n=0;n<ev.size();n++){
+      fillRandom(*ev[n]);
+      sg[n] = 1.0 + n;
+    }
+  };
+}
+
+
+//- A loop session that takes its eigenpairs from the cache must reproduce the loop of the session that saved them,
+//- without calling the eigensolver, and the cache of another configuration must not be used
+template <typename Float>
+static double checkEvecCache(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, int &nSolve){
+
+  MugiqLoopParam loopParams = hostLoopParams({"+x"}, {1}, {2});
+  loopParams.evecCacheFile = "host_evec_cache";
+
+  const int nEv = 4;
+  nSolve = 0;
+  HostEigenSource<Float> source = randomEigenSource<Float>(nSolve);
+
+  auto runSession = [&](MuGiqEvecCacheMode mode, void *g[]){
+    loopParams.evecCacheMode = mode;
+    LoopSessionHost<Float> *backend = new LoopSessionHost<Float>(&loopParams, geom, cpuPrec, nEv, source);
+    LoopSession session(backend);
+    session.processConfig(g, "", "");
+    return backend->getLoop()->getPosData();
+  };
+
+  const std::vector<std::complex<Float>> saved = runSession(MUGIQ_EVEC_CACHE_SAVE, gauge);
+  const std::vector<std::complex<Float>> loaded = runSession(MUGIQ_EVEC_CACHE_LOAD, gauge);
+  double dev = 0.0;
+  for(size_t i=0;i<saved.size();i++) dev = std::max(dev, (double)std::abs(saved[i] - loaded[i]));
+
+  //- A configuration differing in one bit of one link
+  const size_t linkBytes = static_cast<size_t>(geom.volume) * 2 * GAUGE_SITE_LEN_ * static_cast<size_t>(cpuPrec);
+  std::vector<char> other[N_DIM_];
+  void *otherGauge[N_DIM_];
+  for(int d=0;d<N_DIM_;d++){
+    other[d].assign(static_cast<char*>(gauge[d]), static_cast<char*>(gauge[d]) + linkBytes);
+    otherGauge[d] = other[d].data();
+  }
+  if(comm_rank() == 0) other[0][0] ^= 1;
+  runSession(MUGIQ_EVEC_CACHE_LOAD, otherGauge);
+
+  std::remove(evecCacheFileName(loopParams.evecCacheFile, comm_rank()).c_str());
+
+  double devGlobal = 0.0;
+  MPI_Allreduce(&dev, &devGlobal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return devGlobal;
+}
+
+
+//- A loop session that streams its eigenvectors from the cache through a small ring must give the loop of the session
+//- that saved them bit by bit, with momentum projection. A bare pass over the cache must read each vector once
+template <typename Float>
+static double checkEvecStream(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, EvecStreamProfile &prof,
+			      long long &passBytes){
+
+  MugiqLoopParam loopParams = hostLoopParams({"+x", "-t"}, {1, 1}, {2, 1});
+  loopParams.doMomProj = MUGIQ_BOOL_TRUE;
+  loopParams.evecCacheFile = "host_evec_stream";
+
+  const int nEv = 10;
+  int nSolve = 0;
+  HostEigenSource<Float> source = randomEigenSource<Float>(nSolve);
+
+  auto runSession = [&](MuGiqEvecCacheMode mode, int ring){
+    loopParams.evecCacheMode = mode;
+    loopParams.evecStreamRing = ring;
+    LoopSessionHost<Float> *backend = new LoopSessionHost<Float>(&loopParams, geom, cpuPrec, nEv, source);
+    LoopSession session(backend);
+    session.processConfig(gauge, "", "");
+    return backend->getLoop()->getMomData();
+  };
+
+  const std::vector<std::complex<Float>> resident = runSession(MUGIQ_EVEC_CACHE_SAVE, 0);
+  const std::vector<std::complex<Float>> streamed = runSession(MUGIQ_EVEC_CACHE_LOAD, 3);
+  double dev = 0.0;
+  for(size_t i=0;i<resident.size();i++) dev = std::max(dev, (double)std::abs(resident[i] - streamed[i]));
+
+  //- A bare pass, the consumer only reads the vectors
+  const std::string fname = evecCacheFileName(loopParams.evecCacheFile, comm_rank());
+  int totalL[N_DIM_];
+  for(int d=0;d<N_DIM_;d++) totalL[d] = geom.lL[d] * comm_dim(d);
+  const long long vecBytes = static_cast<long long>(geom.volume) * SPINOR_SITE_LEN_ * sizeof(std::complex<Float>);
+  const EvecCacheHeader expect(geom.lL, totalL, geom.commCoord, 0, static_cast<int>(sizeof(Float)),
+			       static_cast<int>(QUDA_SPACE_SPIN_COLOR_FIELD_ORDER), nEv, vecBytes,
+			       gaugeChecksumMugiq(gauge, cpuPrec, geom.volume, geom.comm));
+  {
+    HostEvecStream<Float> stream(geom, fname, expect, 4);
+    double sum = 0.0;
+    stream.start(0, nEv);
+    for(int n=0;n<nEv;n++){
+      const HostColorSpinorField<Float> *v = stream.acquire(n);
+      for(long long i=0;i<static_cast<long long>(geom.volume)*SPINOR_SITE_LEN_;i++) sum += std::norm(v->V()[i]);
+      stream.release(n);
+    }
+    stream.finish();
+    prof = stream.Profile();
+    if(!(sum > 0.0) || prof.bytes != nEv*vecBytes) dev = 1.0;
+  }
+  passBytes = nEv*vecBytes;
+
+  std::remove(fname.c_str());
+
+  double devGlobal = 0.0;
+  MPI_Allreduce(&dev, &devGlobal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return devGlobal;
+}
+
+
+//- Accuracy of the compressed eigenvectors: relative error of the decoded fields and of the loop computed from them,
+//- with respect to the uncompressed ones. Decoding on the fly, in the loop, the prolongation and the inner products,
+//- must give exactly what the decoded fields give, and the storage must take the bytes of the format and of the
+//- per-site scales; the number of such mismatches is returned
+template <typename Float>
+static int checkEvecCompression(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec, MuGiqEvecCompression comp,
+				double &devField, double &devLoop, double &ratio){
+
+  MugiqLoopParam loopParams = hostLoopParams({"+x", "-t"}, {1, 1}, {2, 1});
+  loopParams.doMomProj = MUGIQ_BOOL_TRUE;
+  loopParams.disp_deriv = {"z"};
+
+  LoopHost<Float> loop(&loopParams, geom);
+  loop.loadGauge(gauge, cpuPrec);
+
+  const int nEv = DISPLACE_BATCH_HOST_ + 1;
+  std::vector<HostColorSpinorField<Float>*> eVecs = newFields<Float>(geom, nEv, true), decoded = newFields<Float>(geom, nEv);
+  std::vector<HostCompressedField<Float>*> packed;
+  std::vector<double> sigma;
+  double dev[4] = {0.0, 0.0, 0.0, 0.0};
+  for(int n=0;n<nEv;n++){
+    packed.push_back(new HostCompressedField<Float>(geom, comp));
+    packed[n]->encode(*eVecs[n]);
+    packed[n]->decode(*decoded[n]);
+    sigma.push_back(1.0 + n);
+
+    dev[0] = std::max(dev[0], maxDeviation(*decoded[n], *eVecs[n]));
+    for(long long i=0;i<eVecs[n]->Length();i++) dev[1] = std::max(dev[1], (double)std::abs(eVecs[n]->V()[i]));
+  }
+  ratio = static_cast<double>(packed[0]->Bytes()) / eVecs[0]->Bytes();
+
+  int mismatch = 0;
+  const size_t scaleBytes = (comp == MUGIQ_EVEC_COMPRESS_BF16) ? 0 : geom.volume * sizeof(float);
+  if(packed[0]->Bytes() != 2 * eVecs[0]->Length() * evecCompressBytes(comp) + scaleBytes) mismatch++;
+
+  loop.computeLoop(eVecs, sigma);
+  const std::vector<std::complex<Float>> exact = loop.getMomData();
+  loop.computeLoop(decoded, sigma);
+  const std::vector<std::complex<Float>> ref = loop.getMomData();
+  loop.computeLoopCompressed(packed, sigma);
+  const std::vector<std::complex<Float>> &onTheFly = loop.getMomData();
+  for(size_t i=0;i<exact.size();i++){
+    if(onTheFly[i] != ref[i]) mismatch++;
+    dev[2] = std::max(dev[2], (double)std::abs(onTheFly[i] - exact[i]));
+    dev[3] = std::max(dev[3], (double)std::abs(exact[i]));
+  }
+
+  //- Inner products and axpy, as in the projection onto the eigenvectors
+  HostColorSpinorField<Float> y(geom), yRef(geom);
+  fillRandom(y);
+  yRef.copy(y);
+  for(int n=0;n<nEv;n++){
+    const std::complex<double> d = packed[n]->cDotLocal(*eVecs[0]);
+    double re = 0.0, im = 0.0;
+    for(int i=0;i<geom.volume;i++)
+      for(int c=0;c<SPINOR_SITE_LEN_;c++){
+	const std::complex<double> p = std::conj(std::complex<double>(decoded[n]->Site(i)[c])) * std::complex<double>(eVecs[0]->Site(i)[c]);
+	re += p.real();
+	im += p.imag();
+      }
+    if(std::abs(d - std::complex<double>(re, im)) > 1e-10 * std::abs(d)) mismatch++;
+
+    const std::complex<Float> a(0.5, -0.25);
+    packed[n]->caxpy(a, y);
+    for(long long i=0;i<yRef.Length();i++) yRef.V()[i] += a * decoded[n]->V()[i];
+  }
+  if(maxDeviation(y, yRef) != 0.0) mismatch++;
+
+  //- Prolongation of compressed coarse vectors, decoded as they are read
+  HostProlongator<Float> *P = randomProlongator<Float>(geom);
+  const int nLevel = P->NLevel();
+  const HostGeom &gC = P->Geom(nLevel);
+  HostColorSpinorField<Float> coarse(gC, P->Nspin(nLevel), P->Ncolor(nLevel)), coarseDec(gC, P->Nspin(nLevel), P->Ncolor(nLevel));
+  HostCompressedField<Float> coarsePacked(gC, comp, P->Nspin(nLevel), P->Ncolor(nLevel));
+  fillRandom(coarse);
+  coarsePacked.encode(coarse);
+  coarsePacked.decode(coarseDec);
+  std::vector<HostColorSpinorField<Float>*> fine(1, eVecs[0]), fineRef(1, decoded[0]), cDec(1, &coarseDec);
+  std::vector<HostCompressedField<Float>*> cPacked(1, &coarsePacked);
+  P->prolongate(fine, cPacked);
+  P->prolongate(fineRef, cDec);
+  if(maxDeviation(*fine[0], *fineRef[0]) != 0.0) mismatch++;
+  delete P;
+
+  deleteFields(eVecs);
+  deleteFields(decoded);
+  for(auto v: packed) delete v;
+
+  double devGlobal[4];
+  MPI_Allreduce(dev, devGlobal, 4, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  devField = devGlobal[1] > 0 ? devGlobal[0] / devGlobal[1] : devGlobal[0];
+  devLoop  = devGlobal[3] > 0 ? devGlobal[2] / devGlobal[3] : devGlobal[2];
+
+  int mismatchGlobal = 0;
+  MPI_Allreduce(&mismatch, &mismatchGlobal, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  return mismatchGlobal;
+}
+
+
+template <typename Float>
+static void hostLoopTest(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec){
+
+  long long nDispEvMajor = 0, nDispEntryMajor = 0;
+  const double devOrder = checkLoopOrder<Float>(geom, gauge, cpuPrec, nDispEvMajor, nDispEntryMajor);
+  reportDeviation(devOrder, hostTolerance<Float>(), "loop-order", "relative deviation of the eigenvector-major loop from the entry-major one");
+  reportCheck(nDispEvMajor < nDispEntryMajor, "loop-order",
+	      "The eigenvector-major loop performs " + std::to_string(nDispEvMajor) + " displacements instead of " +
+	      std::to_string(nDispEntryMajor));
+
+  //- Save, load and a different configuration: the eigenpairs must be computed exactly twice
+  int nSolve = 0;
+  const double devCache = checkEvecCache<Float>(geom, gauge, cpuPrec, nSolve);
+  reportDeviation(devCache, 0.0, "eigenvector cache", "deviation of the loop with cached eigenpairs from the one that saved them");
+  reportCheck(nSolve == 2, "eigenvector cache",
+	      "Three sessions, the second loading the cache of the first, took " + std::to_string(nSolve) + " eigensolves");
+
+  EvecStreamProfile streamProf;
+  long long passBytes = 0;
+  const double devStream = checkEvecStream<Float>(geom, gauge, cpuPrec, streamProf, passBytes);
+  reportDeviation(devStream, 0.0, "eigenvector streaming", "deviation of the loop with streamed eigenvectors from the resident one");
+  streamProf.print("Eigenvector streaming");
+  printfQuda("A pass through a ring of 4 vectors read the %lld bytes of the eigenvectors once\n", passBytes);
+
+  //- The bounds are loose multiples of the rounding of each format
+  const MuGiqEvecCompression comps[] = {MUGIQ_EVEC_COMPRESS_HALF, MUGIQ_EVEC_COMPRESS_QUARTER, MUGIQ_EVEC_COMPRESS_BF16};
+  const double compTol[] = {1e-4, 1e-2, 1e-2};
+  for(int ic=0;ic<3;ic++){
+    double devField = 0.0, devLoop = 0.0, ratio = 0.0;
+    const int mismatch = checkEvecCompression<Float>(geom, gauge, cpuPrec, comps[ic], devField, devLoop, ratio);
+    printfQuda("Compression %-7s: storage %.3f of %s, max relative deviation of the fields %e, of the loop %e, %d on-the-fly mismatches\n",
+	       evecCompressName(comps[ic]), ratio, sizeof(Float) == sizeof(double) ? "double" : "single", devField, devLoop, mismatch);
+    if(mismatch != 0 || devLoop > compTol[ic]) errorQuda("Host eigenvector compression check FAILED\n");
+  }
+
+  printfQuda("Host loop check PASSED\n");
+}
+
+
+int main(int argc, char **argv)
+{
+  return hostTestMain(argc, argv, hostLoopTest<double>, hostLoopTest<float>);
+}
@@ -0,0 +1,317 @@
+#ifndef _HOST_TEST_MUGIQ_H
+#define _HOST_TEST_MUGIQ_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <string>
+
+#include <util_quda.h>
+#include <test_util.h>
+#include <test_params.h>
+#include <test_params_mugiq.h>
+#include "misc.h"
+
+#include <mpi.h>
+
+#include <mugiq.h>
+#include <displace_host.h>
+#include <prolong_host.h>
+#include <host_operator_mugiq.h>
+
+/*
+ * Fixtures shared by the tests of the host (CPU) code path: blocks of random fields, bit-by-bit and rounding-level
+ * comparisons, the report of each check, and the set-up of the communications and the gauge field
+ */
+
+
+template <typename Float>
+static void fillRandom(HostColorSpinorField<Float> &x){
+  std::complex<Float> *v = x.V();
+  for(long long i=0;i<x.Length();i++)
+    v[i] = std::complex<Float>(rand() / (Float)RAND_MAX - 0.5, rand() / (Float)RAND_MAX - 0.5);
+}
+
+
+//- Block of n fields on geom, random if requested
+template <typename Float>
+static std::vector<HostColorSpinorField<Float>*> newFields(const HostGeom &geom, int n, bool random = false,
+							   int nSpin = N_SPIN_, int nColor = N_COLOR_){
+  std::vector<HostColorSpinorField<Float>*> x;
+  for(int i=0;i<n;i++){
+    x.push_back(new HostColorSpinorField<Float>(geom, nSpin, nColor));
+    if(random) fillRandom(*x.back());
+  }
+  return x;
+}
+
+
+template <typename Float>
+static void deleteFields(std::vector<HostColorSpinorField<Float>*> &x){
+  for(auto v: x) delete v;
+  x.clear();
+}
+
+
+template <typename Float>
+static double maxDeviation(const HostColorSpinorField<Float> &x, const HostColorSpinorField<Float> &y){
+  double dev = 0.0;
+  for(long long i=0;i<x.Length();i++) dev = std::max(dev, (double)std::abs(x.V()[i] - y.V()[i]));
+  double devGlobal = 0.0;
+  MPI_Allreduce(&dev, &devGlobal, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return devGlobal;
+}
+
+
+//- Number of fields of x, summed over the processes, that differ from those of y in any bit
+template <typename Float>
+static int countMismatch(const std::vector<HostColorSpinorField<Float>*> &x, const std::vector<HostColorSpinorField<Float>*> &y){
+  int n = 0;
+  for(size_t i=0;i<x.size();i++) n += memcmp(x[i]->V(), y[i]->V(), x[i]->Bytes()) ? 1 : 0;
+  int nGlobal = 0;
+  MPI_Allreduce(&n, &nGlobal, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  return nGlobal;
+}
+
+
+//- Tolerance of the checks that agree up to rounding, in the precision of the fields
+template <typename Float>
+static double hostTolerance(){ return (sizeof(Float) == sizeof(double)) ? 1e-12 : 1e-5; }
+
+
+//- Report a check that must hold exactly, the test fails otherwise
+inline void reportCheck(bool pass, const std::string &name, const std::string &what){
+  if(!pass) errorQuda("Host %s check FAILED\n", name.c_str());
+  printfQuda("%s\n", what.c_str());
+}
+
+
+//- Report the max deviation of a check from its reference, the test fails when it exceeds tol
+inline void reportDeviation(double dev, double tol, const std::string &name, const std::string &what){
+  printfQuda("Max %s: %e\n", what.c_str(), dev);
+  if(dev > tol) errorQuda("Host %s check FAILED (tolerance = %e)\n", name.c_str(), tol);
+}
+
+
+//- The local lattice of this process on its own, periodic, or with every dimension partitioned and the process its
+//- own neighbour: the halo exchange then wraps the lattice around, and the partitioned code paths run on one process
+inline HostGeom selfGeom(const HostGeom &geom, bool partitioned){
+  int commDim[N_DIM_], commCoord[N_DIM_], nbrRank[N_DIM_][2];
+  for(int d=0;d<N_DIM_;d++){
+    commDim[d] = partitioned ? 1 : 0;
+    commCoord[d] = 0;
+    nbrRank[d][0] = nbrRank[d][1] = 0;
+  }
+  return HostGeom(geom.lL, commDim, commCoord, nbrRank, MPI_COMM_SELF);
+}
+
+
+//- Covariant Laplacian with a mass term, out = (m + 2*N_DIM_) in - sum_d (U_d(x) in(x+d) + U_d^dag(x-d) in(x-d)),
+//- a Hermitian test operator built from the fused host displacements
+template <typename Float>
+class HostLaplaceOperator : public HostOperator<Float> {
+
+  const HostGeom &geom;
+  DisplaceHost<Float> disp;
+  Float mass;
+  std::vector<HostColorSpinorField<Float>*> plus, minus;
+
+public:
+
+  HostLaplaceOperator(const HostGeom &geom_, void *gauge[], QudaPrecision cpuPrec, Float mass_) :
+    geom(geom_), disp(geom_, gauge, cpuPrec), mass(mass_) {}
+
+  ~HostLaplaceOperator(){
+    deleteFields(plus);
+    deleteFields(minus);
+  }
+
+  const HostGeom& Geom() const { return geom; }
+
+  void apply(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in){
+    const size_t k = in.size();
+    while(plus.size() < k){
+      plus.push_back(new HostColorSpinorField<Float>(geom));
+      minus.push_back(new HostColorSpinorField<Float>(geom));
+    }
+    std::vector<HostColorSpinorField<Float>*> src(in), dP(plus.begin(), plus.begin()+k), dM(minus.begin(), minus.begin()+k);
+    for(size_t j=0;j<k;j++)
+      for(long long i=0;i<in[j]->Length();i++) out[j]->V()[i] = (mass + 2*N_DIM_) * in[j]->V()[i];
+    for(int d=0;d<N_DIM_;d++){
+      disp.doSymmetricDisplacement(dP, dM, src, static_cast<DisplaceDir>(d), DISPLACE_SYM_PAIR);
+      for(size_t j=0;j<k;j++)
+	for(long long i=0;i<in[j]->Length();i++) out[j]->V()[i] -= dP[j]->V()[i] + dM[j]->V()[i];
+    }
+  }
+};
+
+
+//- Operator counting the applications of another one: the calls, i.e. the blocks, and the vectors
+template <typename Float>
+class HostCountingOperator : public HostOperator<Float> {
+
+  HostOperator<Float> &op;
+
+public:
+
+  long long nApply;
+  long long nVec;
+
+  HostCountingOperator(HostOperator<Float> &op_) : op(op_), nApply(0), nVec(0) {}
+
+  const HostGeom& Geom() const { return op.Geom(); }
+  int Nspin() const { return op.Nspin(); }
+  int Ncolor() const { return op.Ncolor(); }
+
+  void apply(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in){
+    nApply++;
+    nVec += in.size();
+    op.apply(out, in);
+  }
+};
+
+
+//- Two-level prolongator with random null vectors, blocking by 2 the dimensions divisible by 4
+template <typename Float>
+static HostProlongator<Float>* randomProlongator(const HostGeom &geom){
+  const int nLevel = 2;
+  int geoBlock[nLevel][N_DIM_];
+  int lL[N_DIM_];
+  for(int d=0;d<N_DIM_;d++) lL[d] = geom.lL[d];
+  for(int lev=0;lev<nLevel;lev++)
+    for(int d=0;d<N_DIM_;d++){
+      geoBlock[lev][d] = (lL[d] % 4 == 0) ? 2 : 1;
+      lL[d] /= geoBlock[lev][d];
+    }
+  const int spinBlock[nLevel] = {2, 1};
+  const int nNull[nLevel] = {6, 4};
+  HostProlongator<Float> *P = new HostProlongator<Float>(geom, nLevel, geoBlock, spinBlock, nNull);
+  for(int lev=0;lev<nLevel;lev++){
+    HostColorSpinorField<Float> Vrand(P->Geom(lev), P->Nspin(lev), P->Ncolor(lev)*nNull[lev], P->NullVectors(lev));
+    fillRandom(Vrand);
+  }
+  return P;
+}
+
+
+//- Galerkin coarse operator R A P on the coarsest lattice of a prolongator, Hermitian when A is
+template <typename Float>
+class HostGalerkinOperator : public HostOperator<Float> {
+
+  HostOperator<Float> &op;
+  HostProlongator<Float> &P;
+  std::vector<std::vector<HostColorSpinorField<Float>*>> tmp;  // tmp[lev][j], lev = 0 the fine lattice
+
+public:
+
+  HostGalerkinOperator(HostOperator<Float> &op_, HostProlongator<Float> &P_) : op(op_), P(P_), tmp(P_.NLevel()) {}
+
+  ~HostGalerkinOperator(){
+    for(auto &lev: tmp) deleteFields(lev);
+  }
+
+  const HostGeom& Geom() const { return P.Geom(P.NLevel()); }
+  int Nspin() const { return P.Nspin(P.NLevel()); }
+  int Ncolor() const { return P.Ncolor(P.NLevel()); }
+
+  void apply(std::vector<HostColorSpinorField<Float>*> &out, const std::vector<HostColorSpinorField<Float>*> &in){
+    const size_t k = in.size();
+    const int nLevel = P.NLevel();
+    for(int lev=0;lev<nLevel;lev++)
+      while(tmp[lev].size() < 2*k) tmp[lev].push_back(new HostColorSpinorField<Float>(P.Geom(lev), P.Nspin(lev), P.Ncolor(lev)));
+
+    std::vector<HostColorSpinorField<Float>*> fine(tmp[0].begin(), tmp[0].begin()+k), Af(tmp[0].begin()+k, tmp[0].begin()+2*k);
+    P.prolongate(fine, in);
+    op.apply(Af, fine);
+    std::vector<HostColorSpinorField<Float>*> src = Af;
+    for(int lev=0;lev<nLevel;lev++){
+      std::vector<HostColorSpinorField<Float>*> dst;
+      if(lev == nLevel-1) dst = out;
+      else dst.assign(tmp[lev+1].begin(), tmp[lev+1].begin()+k);
+      P.restrictVectors(dst, src, lev);
+      src = dst;
+    }
+  }
+};
+
+
+//- Loop parameters of the host checks, zero momentum and no output files, with the straight displacement entries
+//- dispStr[i]:dispStart[i],dispStop[i]
+inline MugiqLoopParam hostLoopParams(const std::vector<std::string> &dispStr, const std::vector<int> &dispStart,
+				     const std::vector<int> &dispStop){
+  MugiqLoopParam loopParams;
+  loopParams.Nmom = 1;
+  loopParams.momMatrix = {{0,0,0}};
+  loopParams.FTSign = LOOP_FT_SIGN_MINUS;
+  loopParams.writeMomSpaceHDF5 = MUGIQ_BOOL_FALSE;
+  loopParams.writePosSpaceHDF5 = MUGIQ_BOOL_FALSE;
+  loopParams.doMomProj = MUGIQ_BOOL_FALSE;
+  loopParams.doNonLocal = MUGIQ_BOOL_TRUE;
+  loopParams.disp_str   = dispStr;
+  loopParams.disp_start = dispStart;
+  loopParams.disp_stop  = dispStop;
+  for(size_t i=0;i<dispStr.size();i++)
+    loopParams.disp_entry.push_back(dispStr[i] + ":" + std::to_string(dispStart[i]) + "," + std::to_string(dispStop[i]));
+  return loopParams;
+}
+
+
+typedef void (*HostTestFunc)(const HostGeom &geom, void *gauge[], QudaPrecision cpuPrec);
+
+//- Parse the options, set up the communications and the gauge field (loaded, or a random/unit SU(3) field), and run
+//- the test in the precision given by --prec
+inline int hostTestMain(int argc, char **argv, HostTestFunc testDouble, HostTestFunc testSingle){
+
+  // Parse QUDA and MuGiq command line options
+  auto app = make_app();
+  add_host_option_mugiq(app);
+
+  try {
+    app->parse(argc, argv);
+  } catch (const CLI::ParseError &e) {
+    return app->exit(e);
+  }
+
+  // initialize QMP/MPI, QUDA comms grid and RNG (test_util.cpp)
+  initComms(argc, argv, gridsize_from_cmdline);
+
+  // call srand() with a rank-dependent seed
+  initRand();
+
+  QudaGaugeParam gauge_param = newQudaGaugeParam();
+  setGaugeParam(gauge_param);
+  setDims(gauge_param.X);
+
+  // Load the gauge field
+  size_t gSize = (gauge_param.cpu_prec == QUDA_DOUBLE_PRECISION) ? sizeof(double) : sizeof(float);
+
+  void *gauge[4];
+  for (int dir = 0; dir < 4; dir++) { gauge[dir] = malloc(V * gaugeSiteSize * gSize); }
+
+  if (strcmp(latfile, "")) { // load in the command line supplied gauge field
+    read_gauge_field(latfile, gauge, gauge_param.cpu_prec, gauge_param.X, argc, argv);
+    construct_gauge_field(gauge, 2, gauge_param.cpu_prec, &gauge_param);
+  } else { // else generate an SU(3) field
+    construct_gauge_field(gauge, unit_gauge ? 0 : 1, gauge_param.cpu_prec, &gauge_param);
+  }
+
+  HostGeom geom(gauge_param.X);
+  geom.print();
+
+  if(prec == QUDA_DOUBLE_PRECISION)
+    testDouble(geom, gauge, gauge_param.cpu_prec);
+  else if(prec == QUDA_SINGLE_PRECISION)
+    testSingle(geom, gauge, gauge_param.cpu_prec);
+  else
+    errorQuda("Unsupported precision %d.\n", static_cast<int>(prec));
+
+  // finalize the communications layer
+  finalizeComms();
+
+  for (int dir = 0; dir < 4; dir++) free(gauge[dir]);
+
+  return 0;
+}
+
+#endif // _HOST_TEST_MUGIQ_H
@@ -23,6 +23,9 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 #include <mugiq.h>
+#include <grid_planner_mugiq.h>
+#include <farm_mugiq.h>
+#include <disp_path_mugiq.h>
 
 double kappa5; // Derived, not given. Used in matVec checks.
 
@@ -656,7 +659,17 @@ void setLoopParam(MugiqLoopParam &loopParams, QudaGaugeParam &gParam){
 
   loopParams.fname_mom_h5 = fname_mom_h5;
   loopParams.fname_pos_h5 = fname_pos_h5;
+
+  //- Eigenvector cache
+  if(loop_evec_cache != MUGIQ_EVEC_CACHE_NONE && loop_evec_cache_filename.size()==0)
+    errorQuda("Got --loop-evec-cache but no filename was given. Set option --loop-evec-cache-filename\n");
+  loopParams.evecCacheMode = loop_evec_cache;
+  loopParams.evecCacheFile = loop_evec_cache_filename;
   //------------------------------
+
+  //- MuGiq-specific eigensolve parameters
+  loopParams.eigOptions.denseRatio = mugiq_dense_ratio;
+  loopParams.eigOptions.hostEigsolver = mugiq_host_eigsolver;
   
   
   if(!loopParams.doNonLocal){
@@ -664,9 +677,9 @@ void setLoopParam(MugiqLoopParam &loopParams, QudaGaugeParam &gParam){
   }
   else{
     int des_size = disp_entry_string.size();
-    if(des_size == 0)
-      errorQuda("Got option '--loop-do-nonlocal yes' but option --displace-entry-string is not set!\n");
-    else{
+    if(des_size == 0 && disp_path_string.size() == 0 && disp_deriv_string.size() == 0)
+      errorQuda("Got option '--loop-do-nonlocal yes' but none of the options --displace-entry-string, --displace-path-string, --displace-derivative-string is set!\n");
+    if(des_size > 0){
       //- Parse displacement entries
       char disp_entry_char[des_size+1];
       strcpy(disp_entry_char, disp_entry_string.c_str());
@@ -715,6 +728,31 @@ void setLoopParam(MugiqLoopParam &loopParams, QudaGaugeParam &gParam){
 	
       }//-for displacements   
     }
+
+    if(disp_path_string.size() > 0){
+      //- Parse displacement paths
+      std::vector<std::string> displace_paths = ParseDispEntry(disp_path_string, ';');
+      printfQuda("Will perform the following displacement paths:\n");
+      for(int ip=0;ip<static_cast<int>(displace_paths.size());ip++){
+	std::vector<DisplaceFlag> hops;
+	if(!parseDispPath(displace_paths.at(ip), hops))
+	  errorQuda("Displacement path %d has the Wrong format. Example of good paths: +z+z+x-z , +x+y-x\n", ip);
+	loopParams.disp_path.push_back(displace_paths.at(ip));
+	printfQuda("  %d %s: %zu hops\n", ip, displace_paths.at(ip).c_str(), hops.size());
+      }
+    }
+
+    if(disp_deriv_string.size() > 0){
+      //- Parse symmetric covariant derivatives
+      std::vector<std::string> displace_derivs = ParseDispEntry(disp_deriv_string, ';');
+      printfQuda("Will perform the following symmetric covariant derivatives:\n");
+      for(int id=0;id<static_cast<int>(displace_derivs.size());id++){
+	if(parseDisplaceDir(displace_derivs.at(id)) == DispDirNone)
+	  errorQuda("Derivative %d has the Wrong format. Example of good derivatives: z , t\n", id);
+	loopParams.disp_deriv.push_back(displace_derivs.at(id));
+	printfQuda("  %d %s\n", id, displace_derivs.at(id).c_str());
+      }
+    }
   }
 
   
@@ -747,6 +785,59 @@ void setLoopParam(MugiqLoopParam &loopParams, QudaGaugeParam &gParam){
 
 }
 
+//- Estimate the communication cost of the candidate process grids for the loop workload and,
+//- if requested, replace the grid given in --gridsize with the cheapest one.
+//- This runs before the communications are initialized, so it returns the report instead of printing it
+std::string planLoopProcessGrid(){
+
+  GridPlanWorkload w;
+  const int localDim[4] = {xdim, ydim, zdim, tdim};
+  w.nProcs = 1;
+  for(int d=0;d<4;d++){
+    w.L[d] = localDim[d] * gridsize_from_cmdline[d];
+    w.nProcs *= gridsize_from_cmdline[d];
+  }
+  w.nEv = eig_nEv;
+  w.setPrecision(cuda_prec == QUDA_DOUBLE_PRECISION ? sizeof(double) : sizeof(float));
+  w.alpha = loop_grid_plan_alpha;
+  w.beta  = loop_grid_plan_beta;
+
+  if(loop_doNonLocal && !w.addDisplaceEntries(disp_entry_string))
+    return std::string("Grid planner: Could not parse the displacement entries, will keep the user grid\n");
+  if(loop_doNonLocal && !w.addDisplacePaths(disp_path_string))
+    return std::string("Grid planner: Could not parse the displacement paths, will keep the user grid\n");
+  if(loop_doNonLocal && !w.addDisplaceDerivatives(disp_deriv_string))
+    return std::string("Grid planner: Could not parse the derivatives, will keep the user grid\n");
+
+  //- Number of momenta, the file is parsed and checked properly in setLoopParam
+  std::ifstream momFile(mugiq_mom_filename);
+  std::string line;
+  int Nmom = 0;
+  while(getline(momFile, line)){
+    int m[3];
+    std::istringstream iss(line);
+    if(iss >> m[0] >> m[1] >> m[2]) Nmom++;
+  }
+  w.Nmom = std::max(Nmom, 1);
+
+  std::vector<GridPlanCost> plans = planProcessGrid(w);
+  std::string report = gridPlanReport(w, plans, gridsize_from_cmdline, 5);
+
+  if(loop_grid_plan == MUGIQ_GRID_PLAN_APPLY && !plans.empty()){
+    for(int d=0;d<4;d++) gridsize_from_cmdline[d] = plans[0].grid[d];
+    xdim = plans[0].lL[0];
+    ydim = plans[0].lL[1];
+    zdim = plans[0].lL[2];
+    tdim = plans[0].lL[3];
+    char applied[256];
+    snprintf(applied, sizeof(applied), "Grid planner: Will run on process grid %dx%dx%dx%d with local lattice %dx%dx%dx%d\n",
+	     plans[0].grid[0], plans[0].grid[1], plans[0].grid[2], plans[0].grid[3], xdim, ydim, zdim, tdim);
+    report += applied;
+  }
+
+  return report;
+}
+
 
 int main(int argc, char **argv)
 {
@@ -776,9 +867,28 @@ int main(int argc, char **argv)
   if (link_recon_sloppy == QUDA_RECONSTRUCT_INVALID) link_recon_sloppy = link_recon;
   if (link_recon_precondition == QUDA_RECONSTRUCT_INVALID) link_recon_precondition = link_recon_sloppy;
 
+
+  //- Select the process grid from the loop workload, it must take place before the communications are set up
+  std::string gridPlanStr;
+  if(mugiq_task == MUGIQ_COMPUTE_LOOP && loop_grid_plan != MUGIQ_GRID_PLAN_NONE) gridPlanStr = planLoopProcessGrid();
   
-  // initialize QMP/MPI, QUDA comms grid and RNG (test_util.cpp)
-  initComms(argc, argv, gridsize_from_cmdline);
+  //- In farming mode the QUDA comms grid (--gridsize) is built on the communicator of the group
+  FarmComm *farm = nullptr;
+  if(loop_farm_groups > 1){
+#if defined(MPI_COMMS)
+    if(mugiq_task != MUGIQ_COMPUTE_LOOP) errorQuda("Farming is only supported with --mugiq-task computeLoop\n");
+    if(loop_farm_task_list.empty()) errorQuda("Got option --loop-farm-groups %d but option --loop-farm-task-list is not set!\n", loop_farm_groups);
+    farm = initFarmCommsMuGiq(loop_farm_groups, &argc, &argv, gridsize_from_cmdline);
+#else
+    errorQuda("Farming (--loop-farm-groups > 1) requires QUDA built with MPI communications\n");
+#endif
+  }
+  else{
+    // initialize QMP/MPI, QUDA comms grid and RNG (test_util.cpp)
+    initComms(argc, argv, gridsize_from_cmdline);
+  }
+
+  if(!gridPlanStr.empty()) printfQuda("%s", gridPlanStr.c_str());
 
   // call srand() with a rank-dependent seed
   initRand();
@@ -846,17 +956,6 @@ int main(int argc, char **argv)
 
   for (int dir = 0; dir < 4; dir++) { gauge[dir] = malloc(V * gaugeSiteSize * gSize); }
 
-  if (strcmp(latfile, "")) { // load in the command line supplied gauge field
-    read_gauge_field(latfile, gauge, gauge_param.cpu_prec, gauge_param.X, argc, argv);
-    construct_gauge_field(gauge, 2, gauge_param.cpu_prec, &gauge_param);
-  } else { // else generate an SU(3) field
-    if (unit_gauge) {
-      construct_gauge_field(gauge, 0, gauge_param.cpu_prec, &gauge_param);
-    } else {
-      construct_gauge_field(gauge, 1, gauge_param.cpu_prec, &gauge_param);
-    }
-  }
-
   if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) {
     double norm = 0.1; // clover components are rands in the range (-norm, norm)
     double diag = 1.0; // constant added to the diagonal
@@ -875,76 +974,138 @@ int main(int argc, char **argv)
     eig_inv_param.return_clover_inverse = 1;
   }
 
+  //- Host links and clover term of the host eigensolver, the clover term is returned by QUDA when it is computed
+  for (int dir = 0; dir < 4; dir++) loopParams.eigOptions.hostGauge[dir] = gauge[dir];
+  loopParams.eigOptions.hostClover = clover;
+  loopParams.eigOptions.hostPrec = gauge_param.cpu_prec;
+
   // initialize the QUDA library
   initQuda(device);
 
-  // load the gauge field
-  loadGaugeQuda((void *)gauge, &gauge_param);
-  
-  // this line ensure that if we need to construct the clover inverse
-  // (in either the smoother or the solver) we do so
-  if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) {    
-    printfQuda("Loading Clover term\n");
-    if((mugiq_use_mg == MUGIQ_BOOL_TRUE) &&
-       (mg_param.smoother_solve_type[0] == QUDA_DIRECT_PC_SOLVE ||
-    	solve_type == QUDA_DIRECT_PC_SOLVE)) eig_inv_param.solve_type = QUDA_DIRECT_PC_SOLVE;    
-    loadCloverQuda(clover, clover_inv, &eig_inv_param);
+  //- Additional gauge field for loop non-local currents, if applicable
+  void *loop_gauge[4] = {nullptr,nullptr,nullptr,nullptr};
+  if(loopParams.doNonLocal){
+    if(!strcmp(loop_gauge_filename, "") && farm == nullptr)
+      errorQuda("Got option '--loop-do-nonlocal yes' but option --loop-gauge-filename is not set!\n");
+    for (int dir = 0; dir < 4; dir++){
+      loop_gauge[dir] = malloc(V * gaugeSiteSize * gSize);
+      if(!loop_gauge[dir]) errorQuda("Cannot allocate loop_gauge[%d]\n",dir);
+      memset(loop_gauge[dir], 0, V * gaugeSiteSize * gSize);
+      loopParams.gauge[dir] = loop_gauge[dir];
+    }
   }
-  eig_inv_param.solve_type = (eig_inv_param.solution_type == QUDA_MAT_SOLUTION ? QUDA_DIRECT_SOLVE : QUDA_DIRECT_PC_SOLVE);
 
-  double plaq[3];
-  plaqQuda(plaq);
-  printfQuda("Computing the plaquette...\n");
-  printfQuda("Computed plaquette is %e (spatial = %e, temporal = %e)\n", plaq[0], plaq[1], plaq[2]);
+  //- In farming mode the loop session is kept across the configurations of the group, and so it is across the
+  //- --loop-session-configs configurations without farming
+  LoopSession *session = nullptr;
 
+  //- Load a gauge configuration, compute the loop on it and free the fields on the device
+  auto computeLoopConfig = [&](const char *gaugeFile, const char *loopGaugeFile){
 
-  //-Read the additional gauge field for loop non-local currents, if applicable
-  void *loop_gauge[4] = {nullptr,nullptr,nullptr,nullptr};
-  if(loopParams.doNonLocal){    
-    if (strcmp(loop_gauge_filename, "")) { // load in the command line supplied gauge field for the loop
-      for (int dir = 0; dir < 4; dir++){
-	loop_gauge[dir] = malloc(V * gaugeSiteSize * gSize);
-	if(!loop_gauge[dir]) errorQuda("Cannot allocate loop_gauge[%d]\n",dir);
-	memset(loop_gauge[dir], 0, V * gaugeSiteSize * gSize);
-      }      
-      read_gauge_field(loop_gauge_filename, loop_gauge, gauge_param.cpu_prec, gauge_param.X, argc, argv);
-      construct_gauge_field(loop_gauge, 2, gauge_param.cpu_prec, &gauge_param);
+    if (strcmp(gaugeFile, "")) { // load in the command line supplied gauge field
+      read_gauge_field(gaugeFile, gauge, gauge_param.cpu_prec, gauge_param.X, argc, argv);
+      construct_gauge_field(gauge, 2, gauge_param.cpu_prec, &gauge_param);
+    } else { // else generate an SU(3) field
+      if (unit_gauge) {
+        construct_gauge_field(gauge, 0, gauge_param.cpu_prec, &gauge_param);
+      } else {
+        construct_gauge_field(gauge, 1, gauge_param.cpu_prec, &gauge_param);
+      }
+    }
 
-      for (int dir = 0; dir < 4; dir++) loopParams.gauge[dir] = loop_gauge[dir];
+    // load the gauge field
+    loadGaugeQuda((void *)gauge, &gauge_param);
+  
+    // this line ensure that if we need to construct the clover inverse
+    // (in either the smoother or the solver) we do so
+    if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) {    
+      printfQuda("Loading Clover term\n");
+      if((mugiq_use_mg == MUGIQ_BOOL_TRUE) &&
+         (mg_param.smoother_solve_type[0] == QUDA_DIRECT_PC_SOLVE ||
+      	solve_type == QUDA_DIRECT_PC_SOLVE)) eig_inv_param.solve_type = QUDA_DIRECT_PC_SOLVE;    
+      loadCloverQuda(clover, clover_inv, &eig_inv_param);
     }
-    else{
-      errorQuda("Got option '--loop-do-nonlocal yes' but option --loop-gauge-filename is not set!\n");
+    eig_inv_param.solve_type = (eig_inv_param.solution_type == QUDA_MAT_SOLUTION ? QUDA_DIRECT_SOLVE : QUDA_DIRECT_PC_SOLVE);
+
+    double plaq[3];
+    plaqQuda(plaq);
+    printfQuda("Computing the plaquette...\n");
+    printfQuda("Computed plaquette is %e (spatial = %e, temporal = %e)\n", plaq[0], plaq[1], plaq[2]);
+
+
+    //-Read the additional gauge field for loop non-local currents, if applicable
+    if(loopParams.doNonLocal){
+      read_gauge_field(loopGaugeFile, loop_gauge, gauge_param.cpu_prec, gauge_param.X, argc, argv);
+      construct_gauge_field(loop_gauge, 2, gauge_param.cpu_prec, &gauge_param);
     }
-  }
   
 
-  // Call the interface function to compute the loop
-  double time = -((double)clock());
-
-  if(mugiq_task == MUGIQ_COMPUTE_LOOP){
-    if(cuda_prec == QUDA_DOUBLE_PRECISION)
-      computeLoop<double>(mg_param, eig_param, loopParams, compute_coarse, mugiq_use_mg);
-    else if(cuda_prec == QUDA_SINGLE_PRECISION)
-      computeLoop<float>(mg_param, eig_param, loopParams, compute_coarse, mugiq_use_mg);
-    else
-      errorQuda("Unsupported precision %d.\n", static_cast<int>(cuda_prec));
-  }
-  else if(mugiq_task == MUGIQ_TASK_INVALID) errorQuda("Option --mugiq-task not set! (supported option are computeLoop)\n");
-  else errorQuda("Unsupported option for --mugiq-task! (supported option is computeLoopU\n");
+    // Call the interface function to compute the loop
+    double time = -((double)clock());
+
+    if(mugiq_task == MUGIQ_COMPUTE_LOOP && (farm != nullptr || loop_session_configs > 1)){
+      if(session == nullptr){
+        if(cuda_prec == QUDA_DOUBLE_PRECISION)
+          session = newLoopSessionMuGiq<double>(&mg_param, &eig_param, &loopParams, compute_coarse, mugiq_use_mg);
+        else if(cuda_prec == QUDA_SINGLE_PRECISION)
+          session = newLoopSessionMuGiq<float>(&mg_param, &eig_param, &loopParams, compute_coarse, mugiq_use_mg);
+        else
+          errorQuda("Unsupported precision %d.\n", static_cast<int>(cuda_prec));
+      }
+      computeLoopSessionMuGiq(session, &loopParams);
+    }
+    else if(mugiq_task == MUGIQ_COMPUTE_LOOP){
+      if(cuda_prec == QUDA_DOUBLE_PRECISION)
+        computeLoop<double>(mg_param, eig_param, loopParams, compute_coarse, mugiq_use_mg);
+      else if(cuda_prec == QUDA_SINGLE_PRECISION)
+        computeLoop<float>(mg_param, eig_param, loopParams, compute_coarse, mugiq_use_mg);
+      else
+        errorQuda("Unsupported precision %d.\n", static_cast<int>(cuda_prec));
+    }
+    else if(mugiq_task == MUGIQ_TASK_INVALID) errorQuda("Option --mugiq-task not set! (supported option are computeLoop)\n");
+    else errorQuda("Unsupported option for --mugiq-task! (supported option is computeLoopU\n");
     
-  time += (double)clock();
-  printfQuda("Time for solution = %f\n", time / CLOCKS_PER_SEC);
-  //----------------------------------------------------------------------------
+    time += (double)clock();
+    printfQuda("Time for solution = %f\n", time / CLOCKS_PER_SEC);
+    //----------------------------------------------------------------------------
   
 
-  freeGaugeQuda();
-  if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) { freeCloverQuda(); }
+    freeGaugeQuda();
+    if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) { freeCloverQuda(); }
+  };
+
+
+  if(farm == nullptr && loop_session_configs > 1){
+    //- Each configuration writes its own files, the eigensolver and the loop environment are reused
+    const std::string fnameMom = loopParams.fname_mom_h5;
+    const std::string fnamePos = loopParams.fname_pos_h5;
+    for(int c=0;c<loop_session_configs;c++){
+      const std::string tag = "cfg" + std::to_string(c);
+      loopParams.fname_mom_h5 = farmFileName(fnameMom, tag);
+      loopParams.fname_pos_h5 = farmFileName(fnamePos, tag);
+      computeLoopConfig(latfile, loop_gauge_filename);
+    }
+    destroyLoopSessionMuGiq(session);
+  }
+  else if(farm == nullptr) computeLoopConfig(latfile, loop_gauge_filename);
+  else{
+    //- The groups take configurations from the queue until it is empty, each one writes its own files
+    const std::string fnameMom = loopParams.fname_mom_h5;
+    const std::string fnamePos = loopParams.fname_pos_h5;
+    runFarmMuGiq(*farm, loop_farm_task_list, [&](const FarmTask &task){
+	loopParams.fname_mom_h5 = farmFileName(fnameMom, task.tag);
+	loopParams.fname_pos_h5 = farmFileName(fnamePos, task.tag);
+	computeLoopConfig(task.gaugeFile.c_str(), task.loopGaugeFile.c_str());
+      });
+    if(session) destroyLoopSessionMuGiq(session);
+  }
 
   // finalize the QUDA library
   endQuda();
 
-  // finalize the communications layer
-  finalizeComms();
+  // finalize the communications layer, QUDA uses the group communicator of the farm until here
+  if(farm) finalizeFarmCommsMuGiq(farm);
+  else finalizeComms();
 
   if (dslash_type == QUDA_CLOVER_WILSON_DSLASH || dslash_type == QUDA_TWISTED_CLOVER_DSLASH) {
     if (clover) free(clover);
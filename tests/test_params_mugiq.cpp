@@ -8,6 +8,9 @@
 
 MuGiqTask mugiq_task = MUGIQ_TASK_INVALID;
 MuGiqBool mugiq_use_mg = MUGIQ_BOOL_INVALID;
+double mugiq_dense_ratio = -1.0;
+MuGiqBool mugiq_check_host = MUGIQ_BOOL_FALSE;
+MuGiqBool mugiq_host_eigsolver = MUGIQ_BOOL_FALSE;
 
 char mugiq_mom_filename[1024] = "momenta.txt";
 LoopFTSign loop_ft_sign = LOOP_FT_SIGN_INVALID;
@@ -20,8 +23,21 @@ MuGiqBool compute_coarse = MUGIQ_BOOL_TRUE;
 char loop_gauge_filename[1024] = "";
 
 std::string disp_entry_string;
+std::string disp_path_string;
+std::string disp_deriv_string;
 std::string fname_mom_h5;
 std::string fname_pos_h5;
+MuGiqGridPlan loop_grid_plan = MUGIQ_GRID_PLAN_NONE;
+double loop_grid_plan_alpha = 2.0e-6;
+double loop_grid_plan_beta = 1.0e-10;
+int loop_farm_groups = 1;
+int loop_session_configs = 1;
+std::string loop_farm_task_list;
+MuGiqEvecCacheMode loop_evec_cache = MUGIQ_EVEC_CACHE_NONE;
+std::string loop_evec_cache_filename;
+
+int host_niter = 10;
+MuGiqBool host_overlap_comms = MUGIQ_BOOL_TRUE;
 
 
 namespace {
@@ -35,6 +51,12 @@ namespace {
   CLI::TransformPairs<MuGiqBool> mugiq_compute_coarse_map {{"yes", MUGIQ_BOOL_TRUE},
 							   {"no", MUGIQ_BOOL_FALSE}};
 
+  CLI::TransformPairs<MuGiqBool> mugiq_check_host_map {{"yes", MUGIQ_BOOL_TRUE},
+						       {"no", MUGIQ_BOOL_FALSE}};
+
+  CLI::TransformPairs<MuGiqBool> mugiq_host_eigsolver_map {{"yes", MUGIQ_BOOL_TRUE},
+							   {"no", MUGIQ_BOOL_FALSE}};
+
   CLI::TransformPairs<LoopFTSign> loop_ft_sign_map {{"plus", LOOP_FT_SIGN_PLUS},
 						    {"minus", LOOP_FT_SIGN_MINUS}};
 
@@ -53,6 +75,17 @@ namespace {
 
   CLI::TransformPairs<MuGiqBool> loop_doNonLocal_map {{"yes",  MUGIQ_BOOL_TRUE},
 						      {"no" ,  MUGIQ_BOOL_FALSE}};
+
+  CLI::TransformPairs<MuGiqGridPlan> loop_grid_plan_map {{"none",   MUGIQ_GRID_PLAN_NONE},
+							 {"report", MUGIQ_GRID_PLAN_REPORT},
+							 {"apply",  MUGIQ_GRID_PLAN_APPLY}};
+
+  CLI::TransformPairs<MuGiqEvecCacheMode> loop_evec_cache_map {{"none", MUGIQ_EVEC_CACHE_NONE},
+								{"save", MUGIQ_EVEC_CACHE_SAVE},
+								{"load", MUGIQ_EVEC_CACHE_LOAD}};
+
+  CLI::TransformPairs<MuGiqBool> host_overlap_comms_map {{"yes",  MUGIQ_BOOL_TRUE},
+							 {"no" ,  MUGIQ_BOOL_FALSE}};
   
 }
 
@@ -70,6 +103,15 @@ void add_eigen_option_mugiq(std::shared_ptr<QUDAApp> app)
 
   opgroup->add_option("--mugiq-compute-coarse", compute_coarse,
 		      "Whether to compute eigenpairs of coarse Dirac operator, options are yes/no (default yes)")->transform(CLI::QUDACheckedTransformer(mugiq_compute_coarse_map));  
+
+  opgroup->add_option("--mugiq-dense-ratio", mugiq_dense_ratio,
+		      "Use the dense eigensolver when nEv exceeds this fraction of the operator dimension, for Hermitian operators small enough (default 0.1)");
+
+  opgroup->add_option("--mugiq-host-eigsolver", mugiq_host_eigsolver,
+		      "Whether to compute the eigenpairs of the fine MdagM/MMdag, their eigenvalues and the projection on the host (CPU) Wilson-clover operator, with the thick-restart Lanczos (default no, options are yes/no)")->transform(CLI::QUDACheckedTransformer(mugiq_host_eigsolver_map));
+
+  opgroup->add_option("--mugiq-check-host", mugiq_check_host,
+		      "Whether to check the eigensolve on the host Wilson-clover operator against the device one, needs --mugiq-use-mg no (default no, options are yes/no)")->transform(CLI::QUDACheckedTransformer(mugiq_check_host_map));
 }
 
 
@@ -103,16 +145,58 @@ void add_loop_option_mugiq(std::shared_ptr<QUDAApp> app)
   opgroup->add_option("--displace-entry-string", disp_entry_string,
 		      "Set displacement entries in the form, e.g: +z:1,8;-x:3;+y:2,5.");
 
+  opgroup->add_option("--displace-path-string", disp_path_string,
+		      "Set general displacement paths, one loop trace each, in the form, e.g: +z+z+x-z;+x+y-x.");
+
+  opgroup->add_option("--displace-derivative-string", disp_deriv_string,
+		      "Set symmetric covariant derivatives, one loop trace each, in the form, e.g: z;t.");
+
   opgroup->add_option("--loop-mom-space-filename", fname_mom_h5,
 		      "Complete path to the HDF5 filename for the momentum-space loop data");
 
   opgroup->add_option("--loop-pos-space-filename", fname_pos_h5,
 		      "Complete path to the HDF5 filename for the position-space loop data");
+
+  opgroup->add_option("--loop-grid-plan", loop_grid_plan,
+		      "Whether to estimate the communication cost of all process grids for the loop workload and report it, or run on the cheapest one (default none, options are none/report/apply)")->transform(CLI::QUDACheckedTransformer(loop_grid_plan_map));
+
+  opgroup->add_option("--loop-grid-plan-alpha", loop_grid_plan_alpha,
+		      "Latency per message in seconds, used by the grid planner (default 2e-6)");
+
+  opgroup->add_option("--loop-grid-plan-beta", loop_grid_plan_beta,
+		      "Inverse bandwidth in seconds per byte, used by the grid planner (default 1e-10)");
+
+  opgroup->add_option("--loop-farm-groups", loop_farm_groups,
+		      "Number of process groups the gauge configurations are farmed out to, --gridsize refers to a single group (default 1)");
+
+  opgroup->add_option("--loop-farm-task-list", loop_farm_task_list,
+		      "File with the gauge configurations to process in farming mode, one per line: <gauge file> [<loop gauge file>]");
+
+  opgroup->add_option("--loop-session-configs", loop_session_configs,
+		      "Number of configurations processed by one loop session without farming, each one is read from --load-gauge or a new random field (default 1)");
+
+  opgroup->add_option("--loop-evec-cache", loop_evec_cache,
+		      "Whether to save the eigenpairs to the on-disk cache, or load them from it if a cache of the same configuration is present and compute and save them otherwise (default none, options are none/save/load)")->transform(CLI::QUDACheckedTransformer(loop_evec_cache_map));
+
+  opgroup->add_option("--loop-evec-cache-filename", loop_evec_cache_filename,
+		      "Base name of the eigenvector cache files, one per rank: <base>_rankNNNNN.evc");
   
 }
 
 
 
+// Options for the host (CPU) kernels
+void add_host_option_mugiq(std::shared_ptr<QUDAApp> app)
+{
+  auto opgroup = app->add_option_group("Host-MuGiq", "Options for the host (CPU) kernels within MuGiq");
+
+  opgroup->add_option("--host-niter", host_niter, "Number of repetitions of each host kernel in the benchmarks (default 10)");
+
+  opgroup->add_option("--host-overlap-comms", host_overlap_comms,
+		      "Whether to overlap the halo exchange with the interior computation (default yes, options are yes/no)")->transform(CLI::QUDACheckedTransformer(host_overlap_comms_map));
+}
+
+
 /*
 std::shared_ptr<MUGIQApp> make_mugiq_app(std::string app_description, std::string app_name)
 {
@@ -11,11 +11,15 @@
 
 void add_eigen_option_mugiq(std::shared_ptr<QUDAApp> app);
 void add_loop_option_mugiq(std::shared_ptr<QUDAApp> app);
+void add_host_option_mugiq(std::shared_ptr<QUDAApp> app);
 
 
 //- External variables used in tests
 extern MuGiqTask mugiq_task;
 extern MuGiqBool mugiq_use_mg;
+extern double mugiq_dense_ratio;
+extern MuGiqBool mugiq_check_host;
+extern MuGiqBool mugiq_host_eigsolver;
 
 extern char mugiq_mom_filename[1024];
 extern LoopFTSign loop_ft_sign;
@@ -27,8 +31,20 @@ extern MuGiqBool loop_doNonLocal;
 extern MuGiqBool compute_coarse;
 extern char loop_gauge_filename[1024];
 extern std::string disp_entry_string;
+extern std::string disp_path_string;
+extern std::string disp_deriv_string;
 extern std::string fname_mom_h5;
 extern std::string fname_pos_h5;
+extern MuGiqGridPlan loop_grid_plan;
+extern double loop_grid_plan_alpha;
+extern double loop_grid_plan_beta;
+extern int loop_farm_groups;
+extern int loop_session_configs;
+extern std::string loop_farm_task_list;
+extern MuGiqEvecCacheMode loop_evec_cache;
+extern std::string loop_evec_cache_filename;
+extern int host_niter;
+extern MuGiqBool host_overlap_comms;
 
 
 